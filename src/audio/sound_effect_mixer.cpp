@@ -0,0 +1,43 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "sound_effect_mixer.hpp"
+
+#include <algorithm>
+
+using std::shared_ptr;
+using std::size_t;
+
+using srb2::audio::Sample;
+using srb2::audio::SoundEffectMixer;
+using srb2::audio::SoundEffectPlayer;
+
+size_t SoundEffectMixer::generate(tcb::span<Sample<2>> buffer)
+{
+	std::fill(buffer.begin(), buffer.end(), Sample<2> {});
+
+	for (auto& channel : channels_)
+	{
+		if (!channel->finished())
+		{
+			channel->mix(buffer);
+		}
+	}
+
+	// because we initialized the out-buffer, we always generate size samples
+	return buffer.size();
+}
+
+void SoundEffectMixer::add_channel(const shared_ptr<SoundEffectPlayer>& channel)
+{
+	channels_.push_back(channel);
+}
+
+SoundEffectMixer::~SoundEffectMixer() = default;
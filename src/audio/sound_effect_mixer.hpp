@@ -0,0 +1,43 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_AUDIO_SOUND_EFFECT_MIXER_HPP__
+#define __SRB2_AUDIO_SOUND_EFFECT_MIXER_HPP__
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <tcb/span.hpp>
+
+#include "sound_effect_player.hpp"
+#include "source.hpp"
+
+namespace srb2::audio
+{
+
+/// Mixes sound effect channels straight into the output block. Unlike Mixer, there is no
+/// per-channel intermediate buffer, and idle channels cost nothing.
+class SoundEffectMixer : public Source<2>
+{
+public:
+	virtual std::size_t generate(tcb::span<Sample<2>> buffer) override final;
+
+	virtual ~SoundEffectMixer() final;
+
+	void add_channel(const std::shared_ptr<SoundEffectPlayer>& channel);
+
+private:
+	std::vector<std::shared_ptr<SoundEffectPlayer>> channels_;
+};
+
+} // namespace srb2::audio
+
+#endif // __SRB2_AUDIO_SOUND_EFFECT_MIXER_HPP__
@@ -11,9 +11,18 @@
 #include "sound_effect_player.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <memory>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SRB2_AUDIO_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SRB2_AUDIO_NEON
+#include <arm_neon.h>
+#endif
+
 using std::shared_ptr;
 using std::size_t;
 
@@ -21,46 +30,131 @@ using srb2::audio::Sample;
 using srb2::audio::SoundEffectPlayer;
 using srb2::audio::Source;
 
+namespace
+{
+
+static_assert(sizeof(Sample<1>) == sizeof(float), "mono samples must be tightly packed floats");
+static_assert(sizeof(Sample<2>) == 2 * sizeof(float), "stereo samples must be tightly packed floats");
+
+constexpr const std::uint64_t kUnityStep = std::uint64_t {1} << 32;
+
+// Pitched chunks are resampled into a scratch block of this many samples before panning
+constexpr const size_t kResampleBlock = 256;
+
+/// dst[i] += {src[i] * left, src[i] * right}
+void mix_mono_into_stereo(float* dst, const float* src, size_t count, float left, float right)
+{
+	size_t i = 0;
+
+#if defined(SRB2_AUDIO_SSE2)
+	const __m128 gains = _mm_setr_ps(left, right, left, right);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 mono = _mm_loadu_ps(src + i);
+		__m128 lo = _mm_mul_ps(_mm_unpacklo_ps(mono, mono), gains);
+		__m128 hi = _mm_mul_ps(_mm_unpackhi_ps(mono, mono), gains);
+		_mm_storeu_ps(dst + i * 2, _mm_add_ps(_mm_loadu_ps(dst + i * 2), lo));
+		_mm_storeu_ps(dst + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(dst + i * 2 + 4), hi));
+	}
+#elif defined(SRB2_AUDIO_NEON)
+	const float gain_lanes[4] = {left, right, left, right};
+	const float32x4_t gains = vld1q_f32(gain_lanes);
+	for (; i + 4 <= count; i += 4)
+	{
+		float32x4x2_t mono = vzipq_f32(vld1q_f32(src + i), vld1q_f32(src + i));
+		vst1q_f32(dst + i * 2, vmlaq_f32(vld1q_f32(dst + i * 2), mono.val[0], gains));
+		vst1q_f32(dst + i * 2 + 4, vmlaq_f32(vld1q_f32(dst + i * 2 + 4), mono.val[1], gains));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		dst[i * 2] += src[i] * left;
+		dst[i * 2 + 1] += src[i] * right;
+	}
+}
+
+} // namespace
+
 size_t SoundEffectPlayer::generate(tcb::span<Sample<2>> buffer)
+{
+	std::fill(buffer.begin(), buffer.end(), Sample<2> {});
+	return mix(buffer);
+}
+
+size_t SoundEffectPlayer::mix(tcb::span<Sample<2>> buffer)
 {
 	if (!chunk_)
 		return 0;
-	if (position_ >= chunk_->samples.size())
+
+	const size_t length = chunk_->samples.size();
+	if (position_ >= length)
 	{
 		return 0;
 	}
 
+	// Pan gains only change between blocks
+	const float sep_pan = ((sep_ + 1.f) / 2.f) * (3.14159f / 2.f);
+	const float left_scale = volume_ * std::cos(sep_pan);
+	const float right_scale = volume_ * std::sin(sep_pan);
+
+	const float* source = &chunk_->samples.data()->amplitudes[0];
+	float* out = &buffer.data()->amplitudes[0];
+
+	if (step_ == kUnityStep && position_frac_ == 0)
+	{
+		size_t written = std::min(buffer.size(), length - position_);
+		mix_mono_into_stereo(out, source + position_, written, left_scale, right_scale);
+		position_ += written;
+		return written;
+	}
+
+	// Pitched playback: linear interpolation at a fractional step
+	std::array<float, kResampleBlock> resampled;
 	size_t written = 0;
-	for (; position_ < chunk_->samples.size() && written < buffer.size(); position_++)
+	while (written < buffer.size() && position_ < length)
 	{
-		float mono_sample = chunk_->samples[position_].amplitudes[0];
+		const size_t block = std::min(buffer.size() - written, kResampleBlock);
+		size_t i = 0;
+
+		for (; i < block && position_ < length; i++)
+		{
+			const float a = source[position_];
+			const float b = position_ + 1 < length ? source[position_ + 1] : 0.f;
+			const float t = static_cast<float>(position_frac_) * (1.f / 4294967296.f);
+			resampled[i] = a + (b - a) * t;
 
-		float sep_pan = ((sep_ + 1.f) / 2.f) * (3.14159 / 2.f);
+			const std::uint64_t advance = static_cast<std::uint64_t>(position_frac_) + step_;
+			position_ += static_cast<size_t>(advance >> 32);
+			position_frac_ = static_cast<std::uint32_t>(advance);
+		}
 
-		float left_scale = std::cos(sep_pan);
-		float right_scale = std::sin(sep_pan);
-		buffer[written] = {mono_sample * volume_ * left_scale, mono_sample * volume_ * right_scale};
-		written += 1;
+		mix_mono_into_stereo(out + written * 2, resampled.data(), i, left_scale, right_scale);
+		written += i;
 	}
+
 	return written;
 }
 
-void SoundEffectPlayer::start(const SoundChunk* chunk, float volume, float sep)
+void SoundEffectPlayer::start(const SoundChunk* chunk, float volume, float sep, float pitch)
 {
-	this->update(volume, sep);
+	this->update(volume, sep, pitch);
 	position_ = 0;
+	position_frac_ = 0;
 	chunk_ = chunk;
 }
 
-void SoundEffectPlayer::update(float volume, float sep)
+void SoundEffectPlayer::update(float volume, float sep, float pitch)
 {
 	volume_ = volume;
 	sep_ = sep;
+	step_ = static_cast<std::uint64_t>(std::clamp(pitch, 1.f / 256.f, 256.f) * 4294967296.0);
 }
 
 void SoundEffectPlayer::reset()
 {
 	position_ = 0;
+	position_frac_ = 0;
 	chunk_ = nullptr;
 }
 
@@ -12,6 +12,7 @@
 #define __SRB2_AUDIO_SOUND_EFFECT_PLAYER_HPP__
 
 #include <cstddef>
+#include <cstdint>
 
 #include <tcb/span.hpp>
 
@@ -26,22 +27,29 @@ class SoundEffectPlayer : public Source<2>
 public:
 	virtual std::size_t generate(tcb::span<Sample<2>> buffer) override final;
 
+	/// Add this channel into buffer instead of overwriting it. Returns the number of samples mixed.
+	std::size_t mix(tcb::span<Sample<2>> buffer);
+
 	virtual ~SoundEffectPlayer() final;
 
-	void start(const SoundChunk* chunk, float volume, float sep);
-	void update(float volume, float sep);
+	/// pitch is a playback rate; 1 plays the chunk as loaded, 2 an octave up
+	void start(const SoundChunk* chunk, float volume, float sep, float pitch = 1.f);
+	void update(float volume, float sep, float pitch = 1.f);
 	void reset();
 	bool finished() const;
 
 	bool is_playing_chunk(const SoundChunk* chunk) const;
 
 private:
-	float volume_;
-	float sep_;
+	float volume_ {0.f};
+	float sep_ {0.f};
 
-	std::size_t position_;
+	// 32.32 fixed point read position and step, so pitched playback does not drift
+	std::size_t position_ {0};
+	std::uint32_t position_frac_ {0};
+	std::uint64_t step_ {std::uint64_t {1} << 32};
 
-	const SoundChunk* chunk_;
+	const SoundChunk* chunk_ {nullptr};
 };
 
 } // namespace srb2::audio
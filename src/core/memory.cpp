@@ -10,7 +10,12 @@
 
 #include "memory.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <new>
 
 #include "../z_zone.h"
@@ -69,3 +74,474 @@ void Z_Frame_Reset()
 {
 	g_frame_memory.reset();
 }
+
+struct zpoolchunk_s
+{
+	zpoolchunk_t* next;
+	size_t blocks;
+};
+
+namespace
+{
+
+constexpr size_t kPoolAlignment = alignof(std::max_align_t);
+constexpr size_t kPoolChunkBytes = 128 * 1024;
+constexpr size_t kPoolChunkHeader = (sizeof(zpoolchunk_t) + kPoolAlignment - 1) & ~(kPoolAlignment - 1);
+
+size_t pool_stride(const zpool_t* pool) noexcept
+{
+	return (pool->block_size + kPoolAlignment - 1) & ~(kPoolAlignment - 1);
+}
+
+std::byte* chunk_block(zpoolchunk_t* chunk, size_t stride, size_t index) noexcept
+{
+	return reinterpret_cast<std::byte*>(chunk) + kPoolChunkHeader + stride * index;
+}
+
+void*& block_link(const zpool_t* pool, void* block) noexcept
+{
+	return *reinterpret_cast<void**>(static_cast<std::byte*>(block) + pool->link_offset);
+}
+
+} // namespace
+
+void* Z_Pool_Alloc(zpool_t* pool)
+{
+	const size_t stride = pool_stride(pool);
+	void* block;
+
+	if (pool->free_list)
+	{
+		block = pool->free_list;
+		pool->free_list = block_link(pool, block);
+	}
+	else
+	{
+		if (pool->current == nullptr || pool->bump == pool->current->blocks)
+		{
+			// Move on to the next chunk, reusing the ones from before the last reset first
+			zpoolchunk_t* next = pool->current ? pool->current->next : pool->chunks;
+			if (next == nullptr)
+			{
+				size_t blocks = std::max<size_t>(16, (kPoolChunkBytes - kPoolChunkHeader) / stride);
+				next = static_cast<zpoolchunk_t*>(Z_Malloc(kPoolChunkHeader + stride * blocks, PU_STATIC, nullptr));
+				next->next = nullptr;
+				next->blocks = blocks;
+				pool->capacity += blocks;
+
+				if (pool->current)
+				{
+					pool->current->next = next;
+				}
+				else
+				{
+					pool->chunks = next;
+				}
+			}
+			pool->current = next;
+			pool->bump = 0;
+		}
+
+		block = chunk_block(pool->current, stride, pool->bump++);
+	}
+
+	pool->live++;
+	std::memset(block, 0, pool->block_size);
+	return block;
+}
+
+void Z_Pool_Free(zpool_t* pool, void* block)
+{
+	block_link(pool, block) = pool->free_list;
+	pool->free_list = block;
+	pool->live--;
+}
+
+void Z_Pool_Reset(zpool_t* pool)
+{
+	pool->free_list = nullptr;
+	pool->current = nullptr;
+	pool->bump = 0;
+	pool->live = 0;
+}
+
+struct zslabchunk_s
+{
+	zslabchunk_t* next;
+};
+
+namespace
+{
+
+constexpr size_t kSlabChunkBytes = 64 * 1024;
+constexpr size_t kSlabChunkHeader = (sizeof(zslabchunk_t) + ZSLABS_GRANULARITY - 1) & ~(ZSLABS_GRANULARITY - 1);
+constexpr size_t kSlabMaxBlock = ZSLABS_GRANULARITY * ZSLABS_CLASSES;
+
+size_t slab_class(size_t size) noexcept
+{
+	return (size - 1) / ZSLABS_GRANULARITY;
+}
+
+void*& slab_link(void* block) noexcept
+{
+	return *static_cast<void**>(block);
+}
+
+void* slab_alloc(zslabs_t* heap, size_t size)
+{
+	heap->allocs++;
+
+	if (size > kSlabMaxBlock)
+	{
+		heap->large_bytes += size;
+		return Z_Malloc(size, heap->tag, nullptr);
+	}
+
+	const size_t cls = slab_class(size);
+	const size_t block_size = (cls + 1) * ZSLABS_GRANULARITY;
+	heap->small_bytes += block_size;
+
+	if (heap->free_lists[cls])
+	{
+		void* block = heap->free_lists[cls];
+		heap->free_lists[cls] = slab_link(block);
+		return block;
+	}
+
+	if (heap->bump_left < block_size)
+	{
+		// The end of the old chunk still fits a smaller block
+		if (heap->bump_left > 0)
+		{
+			const size_t tail_cls = slab_class(heap->bump_left);
+			slab_link(heap->bump) = heap->free_lists[tail_cls];
+			heap->free_lists[tail_cls] = heap->bump;
+		}
+
+		zslabchunk_t* chunk = static_cast<zslabchunk_t*>(Z_Malloc(kSlabChunkBytes, heap->tag, nullptr));
+		chunk->next = heap->chunks;
+		heap->chunks = chunk;
+		heap->bump = reinterpret_cast<std::byte*>(chunk) + kSlabChunkHeader;
+		heap->bump_left = kSlabChunkBytes - kSlabChunkHeader;
+		heap->reserved += kSlabChunkBytes;
+	}
+
+	void* block = heap->bump;
+	heap->bump = static_cast<std::byte*>(heap->bump) + block_size;
+	heap->bump_left -= block_size;
+	return block;
+}
+
+void slab_free(zslabs_t* heap, void* block, size_t size)
+{
+	if (size > kSlabMaxBlock)
+	{
+		heap->large_bytes -= size;
+		Z_Free(block);
+		return;
+	}
+
+	const size_t cls = slab_class(size);
+	heap->small_bytes -= (cls + 1) * ZSLABS_GRANULARITY;
+	slab_link(block) = heap->free_lists[cls];
+	heap->free_lists[cls] = block;
+}
+
+} // namespace
+
+void* Z_Slabs_Realloc(zslabs_t* heap, void* ptr, size_t old_size, size_t new_size)
+{
+	if (new_size == 0)
+	{
+		if (ptr)
+		{
+			slab_free(heap, ptr, old_size);
+		}
+		return nullptr;
+	}
+
+	if (ptr == nullptr)
+	{
+		return slab_alloc(heap, new_size);
+	}
+
+	const bool old_small = old_size <= kSlabMaxBlock;
+	const bool new_small = new_size <= kSlabMaxBlock;
+
+	if (old_small && new_small && slab_class(old_size) == slab_class(new_size))
+	{
+		return ptr;
+	}
+
+	if (!old_small && !new_small)
+	{
+		heap->large_bytes = heap->large_bytes - old_size + new_size;
+		return Z_Realloc(ptr, new_size, heap->tag, nullptr);
+	}
+
+	void* moved = slab_alloc(heap, new_size);
+	std::memcpy(moved, ptr, std::min(old_size, new_size));
+	slab_free(heap, ptr, old_size);
+	return moved;
+}
+
+void Z_Slabs_Release(zslabs_t* heap)
+{
+	while (heap->chunks)
+	{
+		zslabchunk_t* next = heap->chunks->next;
+		Z_Free(heap->chunks);
+		heap->chunks = next;
+	}
+
+	const int tag = heap->tag;
+	*heap = {};
+	heap->tag = tag;
+}
+
+namespace
+{
+
+constexpr size_t kArenaAlignment = alignof(std::max_align_t);
+constexpr size_t kArenaChunkBytes = 256 * 1024;
+
+struct ArenaChunk
+{
+	ArenaChunk* prev;
+	ArenaChunk* next;
+	size_t base; // Arena height at the start of this chunk
+	size_t size;
+};
+
+constexpr size_t kArenaChunkHeader = (sizeof(ArenaChunk) + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+
+std::atomic<size_t> g_arena_allocs {0};
+std::atomic<size_t> g_arena_bytes {0};
+std::atomic<size_t> g_arena_peak {0};
+std::atomic<size_t> g_arena_reserved {0};
+
+// Chunks come from malloc rather than the zone, which may only be used on the main thread.
+// Chunks past current_ are free and reused before new ones are allocated.
+class ThreadArena
+{
+	ArenaChunk* first_ = nullptr;
+	ArenaChunk* current_ = nullptr;
+	size_t used_ = 0;
+
+	static std::byte* chunk_data(ArenaChunk* chunk) noexcept
+	{
+		return reinterpret_cast<std::byte*>(chunk) + kArenaChunkHeader;
+	}
+
+	static size_t align(size_t size) noexcept
+	{
+		return std::max<size_t>((size + kArenaAlignment - 1) & ~(kArenaAlignment - 1), kArenaAlignment);
+	}
+
+	bool next_chunk(size_t size);
+	void free_chunk(ArenaChunk* chunk) noexcept;
+
+public:
+	ThreadArena() = default;
+	~ThreadArena();
+
+	ThreadArena(const ThreadArena&) = delete;
+	ThreadArena& operator=(const ThreadArena&) = delete;
+
+	size_t height() const noexcept { return current_ ? current_->base + used_ : 0; }
+
+	void* allocate(size_t size);
+	void* reallocate(void* ptr, size_t old_size, size_t new_size);
+	void release(size_t mark) noexcept;
+};
+
+thread_local ThreadArena t_arena;
+
+void ThreadArena::free_chunk(ArenaChunk* chunk) noexcept
+{
+	if (chunk->prev)
+	{
+		chunk->prev->next = chunk->next;
+	}
+	else
+	{
+		first_ = chunk->next;
+	}
+	if (chunk->next)
+	{
+		chunk->next->prev = chunk->prev;
+	}
+
+	g_arena_reserved.fetch_sub(chunk->size, std::memory_order_relaxed);
+	std::free(chunk);
+}
+
+ThreadArena::~ThreadArena()
+{
+	while (first_)
+	{
+		free_chunk(first_);
+	}
+}
+
+bool ThreadArena::next_chunk(size_t size)
+{
+	ArenaChunk* next = current_ ? current_->next : first_;
+
+	if (next == nullptr || next->size < size)
+	{
+		// Oversized requests get a chunk of their own, which is freed again once released
+		size_t chunk_size = std::max(kArenaChunkBytes, size);
+		ArenaChunk* chunk = static_cast<ArenaChunk*>(std::malloc(kArenaChunkHeader + chunk_size));
+		if (chunk == nullptr)
+		{
+			return false;
+		}
+		g_arena_reserved.fetch_add(chunk_size, std::memory_order_relaxed);
+
+		chunk->size = chunk_size;
+		chunk->prev = current_;
+		chunk->next = next;
+		if (next)
+		{
+			next->prev = chunk;
+		}
+		if (current_)
+		{
+			current_->next = chunk;
+		}
+		else
+		{
+			first_ = chunk;
+		}
+		next = chunk;
+	}
+
+	next->base = current_ ? current_->base + current_->size : 0;
+	current_ = next;
+	used_ = 0;
+	return true;
+}
+
+void* ThreadArena::allocate(size_t size)
+{
+	const size_t aligned_size = align(size);
+
+	if ((current_ == nullptr || used_ + aligned_size > current_->size) && !next_chunk(aligned_size))
+	{
+		return nullptr;
+	}
+
+	void* ptr = chunk_data(current_) + used_;
+	used_ += aligned_size;
+
+	g_arena_allocs.fetch_add(1, std::memory_order_relaxed);
+	g_arena_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	size_t now = height();
+	size_t peak = g_arena_peak.load(std::memory_order_relaxed);
+	while (now > peak && !g_arena_peak.compare_exchange_weak(peak, now, std::memory_order_relaxed))
+		;
+
+	return ptr;
+}
+
+void* ThreadArena::reallocate(void* ptr, size_t old_size, size_t new_size)
+{
+	if (ptr == nullptr)
+	{
+		return allocate(new_size);
+	}
+
+	// The most recent allocation can simply move the top
+	std::byte* block = static_cast<std::byte*>(ptr);
+	if (current_ && block + align(old_size) == chunk_data(current_) + used_
+		&& used_ - align(old_size) + align(new_size) <= current_->size)
+	{
+		used_ = used_ - align(old_size) + align(new_size);
+		g_arena_bytes.fetch_add(new_size > old_size ? new_size - old_size : 0, std::memory_order_relaxed);
+		return ptr;
+	}
+
+	void* moved = allocate(new_size);
+	if (moved)
+	{
+		std::memcpy(moved, ptr, std::min(old_size, new_size));
+	}
+	return moved;
+}
+
+void ThreadArena::release(size_t mark) noexcept
+{
+	if (current_ == nullptr)
+	{
+		return;
+	}
+
+	while (current_->prev && current_->base > mark)
+	{
+		current_ = current_->prev;
+	}
+	used_ = mark > current_->base ? mark - current_->base : 0;
+
+	if (used_ == 0 && current_->size > kArenaChunkBytes)
+	{
+		// Step back so this oversized chunk is free as well; the height stays the same.
+		current_ = current_->prev;
+		used_ = current_ ? current_->size : 0;
+	}
+
+	// Don't keep memory from one huge request around for the life of the thread
+	ArenaChunk* chunk = current_ ? current_->next : first_;
+	while (chunk)
+	{
+		ArenaChunk* next = chunk->next;
+		if (chunk->size > kArenaChunkBytes)
+		{
+			free_chunk(chunk);
+		}
+		chunk = next;
+	}
+}
+
+} // namespace
+
+size_t Z_Arena_Begin(void)
+{
+	return t_arena.height();
+}
+
+void Z_Arena_End(size_t mark)
+{
+	t_arena.release(mark);
+}
+
+void* Z_Arena_Alloc(size_t size)
+{
+	return t_arena.allocate(size);
+}
+
+void* Z_Arena_Realloc(void* ptr, size_t old_size, size_t new_size)
+{
+	return t_arena.reallocate(ptr, old_size, new_size);
+}
+
+void Z_Arena_Reset(void)
+{
+	t_arena.release(0);
+}
+
+void Z_Arena_GetStats(zarenastats_t* stats)
+{
+	stats->allocs = g_arena_allocs.load(std::memory_order_relaxed);
+	stats->bytes = g_arena_bytes.load(std::memory_order_relaxed);
+	stats->peak = g_arena_peak.load(std::memory_order_relaxed);
+	stats->reserved = g_arena_reserved.load(std::memory_order_relaxed);
+}
+
+void Z_Arena_ResetStats(void)
+{
+	g_arena_allocs.store(0, std::memory_order_relaxed);
+	g_arena_bytes.store(0, std::memory_order_relaxed);
+	g_arena_peak.store(0, std::memory_order_relaxed);
+}
@@ -25,8 +25,127 @@ void* Z_Frame_Alloc(size_t size);
 /// @brief Resets per-frame memory. Not thread safe.
 void Z_Frame_Reset(void);
 
+typedef struct zpoolchunk_s zpoolchunk_t;
+
+/// @brief A pool of fixed-size blocks carved out of large contiguous chunks. Blocks are handed out most recently
+/// freed first, so churning objects stay in cache, and Z_Pool_Reset releases every block at once while keeping the
+/// chunks for the next user. Declare pools with ZPOOL_INIT; they allocate their first chunk when first used.
+/// Not thread safe.
+typedef struct zpool_s
+{
+	size_t block_size;
+	/// Offset of a pointer-sized field which holds the free list link while a block is free, so the rest of a
+	/// freed block keeps its contents like it would in a hand-rolled free list.
+	size_t link_offset;
+
+	void* free_list;
+	zpoolchunk_t* chunks;
+	zpoolchunk_t* current;
+	size_t bump;
+
+	size_t live;
+	size_t capacity;
+} zpool_t;
+
+#define ZPOOL_INIT(type, link) {sizeof(type), offsetof(type, link), NULL, NULL, NULL, 0, 0, 0}
+
+/// @brief Allocate a zeroed block from the pool.
+void* Z_Pool_Alloc(zpool_t* pool);
+
+/// @brief Return a block to the pool.
+void Z_Pool_Free(zpool_t* pool, void* block);
+
+/// @brief Free every block in the pool at once. The chunks are kept and reused.
+void Z_Pool_Reset(zpool_t* pool);
+
+#define ZSLABS_GRANULARITY 16
+#define ZSLABS_CLASSES 32 ///< Blocks of up to ZSLABS_GRANULARITY * ZSLABS_CLASSES bytes come from slabs
+
+typedef struct zslabchunk_s zslabchunk_t;
+
+/// @brief A heap for lots of small blocks of varying size. Small blocks are rounded up to a size class and carved
+/// out of large zone chunks, with a free list per class; larger blocks are zone blocks of their own. The caller
+/// passes the size back when freeing, like the Lua allocator interface does, so blocks have no header. Everything
+/// is zone memory with the heap's tag, so it is counted by Z_TagUsage. Declare heaps with ZSLABS_INIT.
+/// Not thread safe.
+typedef struct zslabs_s
+{
+	int tag;
+
+	void* free_lists[ZSLABS_CLASSES];
+	zslabchunk_t* chunks;
+	void* bump;
+	size_t bump_left;
+
+	size_t small_bytes; ///< Bytes of slab blocks in use, rounded up to their size class
+	size_t large_bytes; ///< Bytes of zone blocks in use
+	size_t reserved; ///< Bytes of slab chunks
+	size_t allocs; ///< Allocations since the heap was created
+} zslabs_t;
+
+#define ZSLABS_INIT(tag) {(tag)}
+
+/// @brief Allocate, resize or free a block, with the same rules as a Lua allocator: a new_size of 0 frees ptr, and a
+/// null ptr allocates. Shrinking within a size class never moves the block.
+void* Z_Slabs_Realloc(zslabs_t* heap, void* ptr, size_t old_size, size_t new_size);
+
+/// @brief Free the slab chunks. Only for once every block is gone, like after lua_close.
+void Z_Slabs_Release(zslabs_t* heap);
+
+/// @brief Open a scope on the calling thread's arena, a bump allocator for short-lived scratch memory. Everything
+/// allocated with Z_Arena_Alloc on this thread after this call is released at once by the matching Z_Arena_End.
+/// Scopes nest and must be ended in reverse order. Every thread has its own arena, so this is safe to use from thread
+/// pool workers; each pool task runs in a scope of its own and the main thread's arena is emptied every frame.
+/// @return a mark to pass to Z_Arena_End
+size_t Z_Arena_Begin(void);
+
+/// @brief Release everything allocated on this thread since the Z_Arena_Begin which returned mark.
+void Z_Arena_End(size_t mark);
+
+/// @brief Allocate from the calling thread's arena. The memory is not zeroed and must not be freed.
+/// @return a pointer aligned like libc malloc, or null if allocation fails
+void* Z_Arena_Alloc(size_t size);
+
+/// @brief Grow or shrink a block from Z_Arena_Alloc. The block is extended in place when it is the most recent
+/// allocation, and copied otherwise; the old block stays allocated until its scope ends.
+void* Z_Arena_Realloc(void* ptr, size_t old_size, size_t new_size);
+
+/// @brief Release everything in the calling thread's arena. For the main loop; no scope may be open.
+void Z_Arena_Reset(void);
+
+typedef struct zarenastats_s
+{
+	size_t allocs; ///< Z_Arena_Alloc calls since the last Z_Arena_ResetStats
+	size_t bytes; ///< Bytes allocated since the last Z_Arena_ResetStats
+	size_t peak; ///< Most bytes in use at once by any one thread since the last Z_Arena_ResetStats
+	size_t reserved; ///< Bytes of chunks currently held by all threads' arenas
+} zarenastats_t;
+
+/// @brief Read the arena counters of all threads.
+void Z_Arena_GetStats(zarenastats_t* stats);
+
+void Z_Arena_ResetStats(void);
+
 #ifdef __cplusplus
 } // extern "C"
+
+namespace srb2
+{
+
+/// @brief Holds a Z_Arena_Begin scope for the lifetime of the object.
+class ArenaScope
+{
+	size_t mark_;
+
+public:
+	ArenaScope() noexcept : mark_(Z_Arena_Begin()) {}
+	~ArenaScope() { Z_Arena_End(mark_); }
+
+	ArenaScope(const ArenaScope&) = delete;
+	ArenaScope& operator=(const ArenaScope&) = delete;
+};
+
+} // namespace srb2
 #endif // __cplusplus
 
 #endif // __SRB2_CORE_MEMORY_H__
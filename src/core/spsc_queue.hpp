@@ -0,0 +1,104 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_CORE_SPSC_QUEUE_HPP__
+#define __SRB2_CORE_SPSC_QUEUE_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include "../cxxutil.hpp"
+
+namespace srb2
+{
+
+/// Fixed-capacity, lock-free ring for exactly one producer thread and one consumer thread.
+/// Neither side ever blocks or allocates; try_push fails when the ring is full.
+/// Several threads may take turns as the consumer only if something else (a lock) orders them.
+template <typename T>
+class SpScQueue
+{
+	static_assert(std::is_trivially_copyable_v<T>, "SpScQueue elements are copied in and out of the ring");
+
+	alignas(64) std::atomic<uint64_t> head_; // next slot to read, written by the consumer
+	alignas(64) std::atomic<uint64_t> tail_; // next slot to write, written by the producer
+	alignas(64) uint64_t cached_head_; // producer's last view of head_
+	uint64_t cached_tail_; // consumer's last view of tail_
+
+	uint64_t mask_;
+	std::unique_ptr<T[]> buff_;
+
+public:
+	explicit SpScQueue(size_t capacity) : head_(0), tail_(0), cached_head_(0), cached_tail_(0), mask_(capacity - 1)
+	{
+		SRB2_ASSERT(capacity && (!(capacity & (capacity - 1))) && "Capacity must be a power of 2!");
+		buff_ = std::unique_ptr<T[]>(new T[capacity]);
+	}
+
+	SpScQueue(const SpScQueue&) = delete;
+	SpScQueue& operator=(const SpScQueue&) = delete;
+
+	size_t capacity() const noexcept { return static_cast<size_t>(mask_ + 1); }
+
+	size_t size() const noexcept
+	{
+		uint64_t tail = tail_.load(std::memory_order_acquire);
+		uint64_t head = head_.load(std::memory_order_acquire);
+		return static_cast<size_t>(tail - head);
+	}
+
+	bool empty() const noexcept { return size() == 0; }
+
+	// Producer only
+	bool try_push(const T& v) noexcept
+	{
+		uint64_t tail = tail_.load(std::memory_order_relaxed);
+
+		if (tail - cached_head_ > mask_)
+		{
+			// Looks full from our stale view; refresh it before giving up
+			cached_head_ = head_.load(std::memory_order_acquire);
+			if (tail - cached_head_ > mask_)
+			{
+				return false;
+			}
+		}
+
+		buff_[tail & mask_] = v;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only
+	std::optional<T> pop() noexcept
+	{
+		uint64_t head = head_.load(std::memory_order_relaxed);
+
+		if (head == cached_tail_)
+		{
+			cached_tail_ = tail_.load(std::memory_order_acquire);
+			if (head == cached_tail_)
+			{
+				return std::nullopt;
+			}
+		}
+
+		T v = buff_[head & mask_];
+		head_.store(head + 1, std::memory_order_release);
+		return v;
+	}
+};
+
+} // namespace srb2
+
+#endif // __SRB2_CORE_SPSC_QUEUE_HPP__
@@ -11,7 +11,9 @@
 #include "thread_pool.h"
 
 #include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <cstdlib>
 #include <exception>
 #include <mutex>
 #include <string>
@@ -20,16 +22,35 @@
 #include <fmt/format.h>
 #include <tracy/tracy/Tracy.hpp>
 
+#include "../command.h"
+#include "../console.h"
 #include "../cxxutil.hpp"
 #include "../m_argv.h"
+#include "memory.h"
 
 using namespace srb2;
 
+namespace
+{
+
+// Identifies the deque owned by the calling thread. Threads that are not pool workers own the pool's
+// final (main) deque. The alive flag doubles as pool identity because it survives moves of the pool.
+struct WorkerIdentity
+{
+	const std::atomic<bool>* pool;
+	size_t index;
+};
+
+thread_local WorkerIdentity t_worker {nullptr, 0};
+
+} // namespace
+
 static void do_work(ThreadPool::Task& work)
 {
 	try
 	{
 		ZoneScoped;
+		srb2::ArenaScope arena; // Task scratch memory is released as soon as it returns
 		(work.thunk)(work.raw.data());
 	}
 	catch (...)
@@ -40,17 +61,70 @@ static void do_work(ThreadPool::Task& work)
 	(work.deleter)(work.raw.data());
 	if (work.pseudosema)
 	{
-		work.pseudosema->fetch_sub(1, std::memory_order_relaxed);
+		// Release so the waiter observes everything the task wrote once the count reaches zero
+		work.pseudosema->fetch_sub(1, std::memory_order_acq_rel);
 	}
 }
 
+// Pop one task from our own deque, or steal the oldest task from another one, starting from the adjacent
+// deque so that thieves spread out instead of all hammering the first queue.
+static bool run_one(
+	const std::vector<std::shared_ptr<ThreadPool::Queue>>& queues,
+	size_t own_index,
+	ThreadPool::WorkerStats& stats
+)
+{
+	std::optional<ThreadPool::Task> work = queues[own_index]->pop();
+	if (work)
+	{
+		do_work(*work);
+		stats.tasks_run.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	const size_t count = queues.size();
+	for (size_t i = 1; i < count; i++)
+	{
+		size_t victim = own_index + i;
+		if (victim >= count)
+		{
+			victim -= count;
+		}
+
+		work = queues[victim]->steal();
+		if (work)
+		{
+			do_work(*work);
+			stats.tasks_run.fetch_add(1, std::memory_order_relaxed);
+			stats.tasks_stolen.fetch_add(1, std::memory_order_relaxed);
+
+			// We only want to steal one work item at a time, to prioritize our own queue
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool any_work_pending(const std::vector<std::shared_ptr<ThreadPool::Queue>>& queues)
+{
+	for (auto& q : queues)
+	{
+		if (!q->empty())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 static void pool_executor(
-	int thread_index,
+	size_t thread_index,
 	std::shared_ptr<std::atomic<bool>> pool_alive,
 	std::shared_ptr<std::mutex> worker_ready_mutex,
 	std::shared_ptr<std::condition_variable> worker_ready_condvar,
-	std::shared_ptr<ThreadPool::Queue> my_wq,
-	std::vector<std::shared_ptr<ThreadPool::Queue>> other_wqs
+	std::vector<std::shared_ptr<ThreadPool::Queue>> wqs,
+	std::shared_ptr<ThreadPool::WorkerStats> stats
 )
 {
 	{
@@ -58,53 +132,32 @@ static void pool_executor(
 		tracy::SetThreadName(thread_name.c_str());
 	}
 
+	t_worker = {pool_alive.get(), thread_index};
+
 	int spins = 0;
 	while (true)
 	{
-		std::optional<ThreadPool::Task> work = my_wq->steal();
-		bool did_work = false;
-		if (work)
+		if (run_one(wqs, thread_index, *stats))
 		{
-			do_work(*work);
-
-			did_work = true;
 			spins = 0;
+			continue;
 		}
-		else
+
+		// Spin a few loops to avoid yielding, then wait for the ready lock
+		spins += 1;
+		if (spins > 100)
 		{
-			for (auto& q : other_wqs)
+			std::unique_lock<std::mutex> ready_lock {*worker_ready_mutex};
+			while (!any_work_pending(wqs) && pool_alive->load())
 			{
-				work = q->steal();
-				if (work)
-				{
-					do_work(*work);
-
-					did_work = true;
-					spins = 0;
-
-					// We only want to steal one work item at a time, to prioritize our own queue
-					break;
-				}
+				worker_ready_condvar->wait(ready_lock);
 			}
-		}
 
-		if (!did_work)
-		{
-			// Spin a few loops to avoid yielding, then wait for the ready lock
-			spins += 1;
-			if (spins > 100)
+			if (!pool_alive->load())
 			{
-				std::unique_lock<std::mutex> ready_lock {*worker_ready_mutex};
-				while (my_wq->empty() && pool_alive->load())
-				{
-					worker_ready_condvar->wait(ready_lock);
-				}
-
-				if (!pool_alive->load())
-				{
-					break;
-				}
+				break;
 			}
+			spins = 0;
 		}
 	}
 }
@@ -116,14 +169,17 @@ ThreadPool::ThreadPool()
 
 ThreadPool::ThreadPool(size_t threads)
 {
-	next_queue_index_ = 0;
 	pool_alive_ = std::make_shared<std::atomic<bool>>(true);
 
-	for (size_t i = 0; i < threads; i++)
+	// The extra deque and stats slot belong to the main thread
+	for (size_t i = 0; i < threads + 1; i++)
 	{
-		std::shared_ptr<Queue> wsq = std::make_shared<Queue>(2048);
-		work_queues_.push_back(wsq);
+		work_queues_.push_back(std::make_shared<Queue>(2048));
+		worker_stats_.push_back(std::make_shared<WorkerStats>());
+	}
 
+	for (size_t i = 0; i < threads; i++)
+	{
 		std::shared_ptr<std::mutex> mutex = std::make_shared<std::mutex>();
 		worker_ready_mutexes_.push_back(std::move(mutex));
 		std::shared_ptr<std::condition_variable> condvar = std::make_shared<std::condition_variable>();
@@ -132,26 +188,6 @@ ThreadPool::ThreadPool(size_t threads)
 
 	for (size_t i = 0; i < threads; i++)
 	{
-		std::shared_ptr<Queue> my_queue = work_queues_[i];
-		std::vector<std::shared_ptr<Queue>> other_queues;
-		for (size_t j = 0; j < threads; j++)
-		{
-			// Order the other queues starting from the next adjacent worker
-			// i.e. if this is worker 2 of 8, then other queues is 3, 4, 5, 6, 7, 0, 1
-			// This tries to balance out work stealing behavior
-
-			size_t other_index = j + i;
-			if (other_index >= threads)
-			{
-				other_index -= threads;
-			}
-
-			if (other_index != i)
-			{
-				other_queues.push_back(work_queues_[other_index]);
-			}
-		}
-
 		std::thread thread;
 		try
 		{
@@ -162,14 +198,21 @@ ThreadPool::ThreadPool(size_t threads)
 				pool_alive_,
 				worker_ready_mutexes_[i],
 				worker_ready_condvars_[i],
-				my_queue,
-				other_queues
+				work_queues_,
+				worker_stats_[i]
 			};
 		}
 		catch (const std::system_error& error)
 		{
 			// Safe shutdown and rethrow
 			pool_alive_->store(false);
+			for (size_t j = 0; j < threads_.size(); j++)
+			{
+				{
+					std::lock_guard<std::mutex> lock {*worker_ready_mutexes_[j]};
+				}
+				worker_ready_condvars_[j]->notify_all();
+			}
 			for (auto& t : threads_)
 			{
 				t.join();
@@ -186,6 +229,37 @@ ThreadPool::~ThreadPool() = default;
 
 ThreadPool& ThreadPool::operator=(ThreadPool&&) = default;
 
+void ThreadPool::enqueue(Task&& task)
+{
+	size_t index = current_worker_index();
+	work_queues_[index]->push(std::move(task));
+}
+
+void ThreadPool::help_until_zero(const std::atomic<uint32_t>& counter)
+{
+	ZoneScoped;
+
+	const size_t own = current_worker_index();
+	WorkerStats& stats = *worker_stats_[own];
+
+	int spins = 0;
+	while (counter.load(std::memory_order_acquire) > 0)
+	{
+		if (run_one(work_queues_, own, stats))
+		{
+			spins = 0;
+			continue;
+		}
+
+		// Remaining tasks are running on other threads; back off so we don't starve them of a core
+		spins += 1;
+		if (spins > 64)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
 void ThreadPool::begin_sema()
 {
 	sema_begun_ = true;
@@ -201,14 +275,20 @@ ThreadPool::Sema ThreadPool::end_sema()
 
 void ThreadPool::notify()
 {
-	for (size_t i = 0; i < work_queues_.size(); i++)
+	size_t pending = 0;
+	for (auto& q : work_queues_)
+	{
+		pending += q->size();
+	}
+
+	// Wake as many sleepers as there are tasks; the rest will be stolen by whoever is awake.
+	// Taking the lock closes the window between a worker's emptiness check and its wait.
+	for (size_t i = 0; i < worker_ready_condvars_.size() && pending > 0; i++, pending--)
 	{
-		auto& q = work_queues_[i];
-		size_t count = q->size();
-		if (count > 0)
 		{
-			worker_ready_condvars_[i]->notify_one();
+			std::lock_guard<std::mutex> lock {*worker_ready_mutexes_[i]};
 		}
+		worker_ready_condvars_[i]->notify_one();
 	}
 }
 
@@ -230,15 +310,11 @@ void ThreadPool::wait_idle()
 
 	ZoneScoped;
 
-	for (size_t i = 0; i < work_queues_.size(); i++)
+	const size_t own = current_worker_index();
+	WorkerStats& stats = *worker_stats_[own];
+	while (any_work_pending(work_queues_))
 	{
-		auto& q = work_queues_[i];
-
-		std::optional<Task> work;
-		while ((work = q->pop()).has_value())
-		{
-			do_work(*work);
-		}
+		run_one(work_queues_, own, stats);
 	}
 }
 
@@ -249,23 +325,7 @@ void ThreadPool::wait_sema(const Sema& sema)
 		return;
 	}
 
-	ZoneScoped;
-
-	while (sema.pseudosema_->load(std::memory_order_seq_cst) > 0)
-	{
-		// spin to win
-		for (size_t i = 0; i < work_queues_.size(); i++)
-		{
-			auto& q = work_queues_[i];
-
-			std::optional<Task> work;
-			if ((work = q->pop()).has_value())
-			{
-				do_work(*work);
-				break;
-			}
-		}
-	}
+	help_until_zero(*sema.pseudosema_);
 
 	if (sema.pseudosema_->load(std::memory_order_seq_cst) != 0)
 	{
@@ -284,9 +344,12 @@ void ThreadPool::shutdown()
 
 	pool_alive_->store(false);
 
-	for (auto& condvar : worker_ready_condvars_)
+	for (size_t i = 0; i < worker_ready_condvars_.size(); i++)
 	{
-		condvar->notify_all();
+		{
+			std::lock_guard<std::mutex> lock {*worker_ready_mutexes_[i]};
+		}
+		worker_ready_condvars_[i]->notify_all();
 	}
 	for (auto& t : threads_)
 	{
@@ -294,6 +357,47 @@ void ThreadPool::shutdown()
 	}
 }
 
+size_t ThreadPool::worker_count() const noexcept
+{
+	if (immediate_mode_)
+	{
+		return 1;
+	}
+	return work_queues_.size();
+}
+
+size_t ThreadPool::current_worker_index() const noexcept
+{
+	if (immediate_mode_)
+	{
+		return 0;
+	}
+	if (t_worker.pool == pool_alive_.get())
+	{
+		return t_worker.index;
+	}
+	return work_queues_.size() - 1;
+}
+
+const ThreadPool::WorkerStats& ThreadPool::worker_stats(size_t index) const
+{
+	static const WorkerStats kEmptyStats {};
+	if (index >= worker_stats_.size())
+	{
+		return kEmptyStats;
+	}
+	return *worker_stats_[index];
+}
+
+void ThreadPool::reset_stats() noexcept
+{
+	for (auto& stats : worker_stats_)
+	{
+		stats->tasks_run.store(0, std::memory_order_relaxed);
+		stats->tasks_stolen.store(0, std::memory_order_relaxed);
+	}
+}
+
 std::unique_ptr<ThreadPool> srb2::g_main_threadpool;
 
 void I_ThreadPoolInit(void)
@@ -349,3 +453,107 @@ void I_ThreadPoolWaitIdle(void)
 
 	g_main_threadpool->wait_idle();
 }
+
+// Simulates a software renderer frame: a burst of tasks with a few expensive outliers (think large visplanes
+// or sky columns) scheduled through the sema API, then waited on by the main thread.
+void Command_ThreadPoolBench_f(void)
+{
+	using Clock = std::chrono::steady_clock;
+
+	if (!g_main_threadpool)
+	{
+		return;
+	}
+
+	size_t frames = COM_Argc() > 1 ? std::max(1, atoi(COM_Argv(1))) : 200;
+	size_t tasks = COM_Argc() > 2 ? std::max(1, atoi(COM_Argv(2))) : 512;
+
+	ThreadPool& pool = *g_main_threadpool;
+	const size_t workers = pool.worker_count();
+	std::vector<std::atomic<uint64_t>> busy_ns(workers);
+
+	// Deterministic skewed costs: most tasks are cheap, one in sixteen is 32 times as expensive
+	std::vector<uint32_t> costs(tasks);
+	uint32_t seed = 0x9E3779B9u;
+	for (auto& cost : costs)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		cost = ((seed >> 24) & 15) == 0 ? 32 * 256 : 256;
+	}
+
+	auto spin = [](uint32_t iterations)
+	{
+		volatile uint32_t sink = 0;
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			sink = sink + i;
+		}
+	};
+
+	auto run_frames = [&](bool with_work) -> Clock::duration
+	{
+		Clock::duration total {};
+		for (size_t f = 0; f < frames; f++)
+		{
+			auto start = Clock::now();
+			pool.begin_sema();
+			for (size_t t = 0; t < tasks; t++)
+			{
+				uint32_t cost = with_work ? costs[t] : 0;
+				pool.schedule([&pool, &busy_ns, &spin, cost]() {
+					auto task_start = Clock::now();
+					spin(cost);
+					auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - task_start);
+					busy_ns[pool.current_worker_index()].fetch_add(elapsed.count(), std::memory_order_relaxed);
+				});
+			}
+			ThreadPool::Sema sema = pool.end_sema();
+			pool.notify_sema(sema);
+			pool.wait_sema(sema);
+			total += Clock::now() - start;
+		}
+		return total;
+	};
+
+	// Empty tasks isolate the cost of scheduling, notifying and joining
+	Clock::duration overhead = run_frames(false);
+
+	for (auto& b : busy_ns)
+	{
+		b.store(0);
+	}
+	pool.reset_stats();
+	Clock::duration loaded = run_frames(true);
+
+	auto to_us = [](Clock::duration d) { return std::chrono::duration_cast<std::chrono::microseconds>(d).count(); };
+
+	CONS_Printf("threadpool_bench: %s frames, %s tasks/frame, %s workers\n",
+		sizeu1(frames), sizeu2(tasks), sizeu3(workers));
+	CONS_Printf("  scheduling overhead: %lld us/frame, %lld ns/task\n",
+		static_cast<long long>(to_us(overhead) / frames),
+		static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(overhead).count() / (frames * tasks)));
+	CONS_Printf("  uneven workload:     %lld us/frame\n", static_cast<long long>(to_us(loaded) / frames));
+
+	uint64_t busy_total = 0;
+	uint64_t busy_max = 0;
+	for (size_t i = 0; i < workers; i++)
+	{
+		uint64_t busy = busy_ns[i].load();
+		const ThreadPool::WorkerStats& stats = pool.worker_stats(i);
+		busy_total += busy;
+		busy_max = std::max(busy_max, busy);
+		CONS_Printf("  %s %2s: %6llu tasks, %6llu stolen, %8llu us busy\n",
+			i + 1 == workers ? "main  " : "worker",
+			sizeu1(i),
+			static_cast<unsigned long long>(stats.tasks_run.load()),
+			static_cast<unsigned long long>(stats.tasks_stolen.load()),
+			static_cast<unsigned long long>(busy / 1000));
+	}
+
+	// 100% means every thread did the same amount of work
+	if (busy_total > 0)
+	{
+		CONS_Printf("  load imbalance (max/mean busy): %llu%%\n",
+			static_cast<unsigned long long>(busy_max * 100 * workers / busy_total));
+	}
+}
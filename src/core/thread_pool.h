@@ -15,12 +15,17 @@
 
 #ifdef __cplusplus
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -53,18 +58,32 @@ public:
 		Sema() = default;
 	};
 
+	struct WorkerStats
+	{
+		alignas(64) std::atomic<uint64_t> tasks_run {0};
+		std::atomic<uint64_t> tasks_stolen {0};
+	};
+
 private:
 	std::shared_ptr<std::atomic<bool>> pool_alive_;
 	std::vector<std::shared_ptr<std::mutex>> worker_ready_mutexes_;
 	std::vector<std::shared_ptr<std::condition_variable>> worker_ready_condvars_;
+	// One deque per worker thread, plus a final deque owned by the scheduling (main) thread.
+	// Each deque is only pushed and popped by its owner; every other thread steals from it.
 	std::vector<std::shared_ptr<Queue>> work_queues_;
+	std::vector<std::shared_ptr<WorkerStats>> worker_stats_;
 	std::vector<std::thread> threads_;
-	size_t next_queue_index_ = 0;
 	std::shared_ptr<std::atomic<uint32_t>> cur_sema_;
 
 	bool immediate_mode_ = false;
 	bool sema_begun_ = false;
 
+	template <typename T>
+	static Task make_task(T&& thunk, std::shared_ptr<std::atomic<uint32_t>> sema);
+
+	void enqueue(Task&& task);
+	void help_until_zero(const std::atomic<uint32_t>& counter);
+
 public:
 	ThreadPool();
 	explicit ThreadPool(size_t threads);
@@ -75,6 +94,7 @@ public:
 	ThreadPool& operator=(const ThreadPool&) = delete;
 	ThreadPool& operator=(ThreadPool&&);
 
+	/// Begin/end a sema group. Only the main thread may use these and schedule().
 	void begin_sema();
 	ThreadPool::Sema end_sema();
 
@@ -84,8 +104,23 @@ public:
 	void notify();
 	void notify_sema(const Sema& sema);
 	void wait_idle();
+	/// Block until every task in the sema group has run. The waiting thread executes queued and stolen tasks
+	/// while it waits instead of idling.
 	void wait_sema(const Sema& sema);
 	void shutdown();
+
+	/// Run f(first, last) over [begin, end) split into chunks of at most grain, returning once all chunks ran.
+	/// Safe to call from inside pool tasks; nested forks land on the calling worker's deque to be stolen.
+	template <typename F> void parallel_for(size_t begin, size_t end, size_t grain, F&& f);
+	/// Run every callable concurrently, returning once all of them ran. Safe to call from inside pool tasks.
+	template <typename... Fs> void fork_join(Fs&&... fs);
+
+	/// Number of threads that execute tasks, including the main thread while it waits.
+	size_t worker_count() const noexcept;
+	/// Index of the calling thread in [0, worker_count()). The main thread is the last index.
+	size_t current_worker_index() const noexcept;
+	const WorkerStats& worker_stats(size_t index) const;
+	void reset_stats() noexcept;
 };
 
 extern std::unique_ptr<ThreadPool> g_main_threadpool;
@@ -103,10 +138,22 @@ void callable_destroyer(F* f)
 }
 
 template <typename T>
-void ThreadPool::schedule(T&& thunk)
+ThreadPool::Task ThreadPool::make_task(T&& thunk, std::shared_ptr<std::atomic<uint32_t>> sema)
 {
-	static_assert(sizeof(T) <= sizeof(std::declval<Task>().raw));
+	using U = std::decay_t<T>;
+	static_assert(sizeof(U) <= sizeof(std::declval<Task>().raw));
+
+	Task task;
+	task.thunk = reinterpret_cast<void(*)(void*)>(callable_caller<U>);
+	task.deleter = reinterpret_cast<void(*)(void*)>(callable_destroyer<U>);
+	task.pseudosema = std::move(sema);
+	new (reinterpret_cast<U*>(task.raw.data())) U(std::forward<T>(thunk));
+	return task;
+}
 
+template <typename T>
+void ThreadPool::schedule(T&& thunk)
+{
 	if (immediate_mode_)
 	{
 		(thunk)();
@@ -122,25 +169,65 @@ void ThreadPool::schedule(T&& thunk)
 		cur_sema_->fetch_add(1, std::memory_order_relaxed);
 	}
 
-	size_t qi = next_queue_index_;
+	enqueue(make_task(std::forward<T>(thunk), cur_sema_));
+}
 
+template <typename F>
+void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain, F&& f)
+{
+	if (begin >= end)
 	{
-		std::shared_ptr<Queue> q = work_queues_[qi];
-		Task task;
-		task.thunk = reinterpret_cast<void(*)(void*)>(callable_caller<T>);
-		task.deleter = reinterpret_cast<void(*)(void*)>(callable_destroyer<T>);
-		task.pseudosema = cur_sema_;
-		new (reinterpret_cast<T*>(task.raw.data())) T(std::move(thunk));
-
-		q->push(std::move(task));
+		return;
+	}
+	if (grain == 0)
+	{
+		grain = 1;
 	}
-	// worker_ready_condvars_[qi]->notify_one();
 
-	next_queue_index_ += 1;
-	if (next_queue_index_ >= threads_.size())
+	if (immediate_mode_)
 	{
-		next_queue_index_ = 0;
+		for (size_t first = begin; first < end; first += grain)
+		{
+			f(first, std::min(first + grain, end));
+		}
+		return;
 	}
+
+	// Chunks after the first are pushed to our own deque, in reverse so the owner pops them front to back
+	// while thieves take from the far end. The caller keeps the first chunk for itself.
+	size_t chunks = (end - begin + grain - 1) / grain;
+	auto counter = std::make_shared<std::atomic<uint32_t>>(static_cast<uint32_t>(chunks - 1));
+	auto* fp = &f;
+	for (size_t i = chunks - 1; i > 0; i--)
+	{
+		size_t first = begin + i * grain;
+		size_t last = std::min(first + grain, end);
+		enqueue(make_task([fp, first, last]() { (*fp)(first, last); }, counter));
+	}
+	notify();
+
+	f(begin, std::min(begin + grain, end));
+	help_until_zero(*counter);
+}
+
+template <typename... Fs>
+void ThreadPool::fork_join(Fs&&... fs)
+{
+	static_assert(sizeof...(Fs) > 0);
+
+	std::array<std::function<void()>*, sizeof...(Fs)> callables;
+	std::array<std::function<void()>, sizeof...(Fs)> storage {std::function<void()>(std::ref(fs))...};
+	for (size_t i = 0; i < storage.size(); i++)
+	{
+		callables[i] = &storage[i];
+	}
+
+	parallel_for(0, callables.size(), 1, [&callables](size_t first, size_t last) {
+		for (size_t i = first; i < last; i++)
+		{
+			(*callables[i])();
+		}
+	});
 }
 
 } // namespace srb2
@@ -156,6 +243,9 @@ void I_ThreadPoolShutdown(void);
 void I_ThreadPoolSubmit(srb2cthunk_t thunk, void* data);
 void I_ThreadPoolWaitIdle(void);
 
+/// Debug command: threadpool_bench [frames] [tasks per frame]
+void Command_ThreadPoolBench_f(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -431,6 +431,7 @@ consvar_t cv_pauseifunfocused = Player("pauseifunfocused", "Yes").yes_no();
 extern CV_PossibleValue_t cv_renderer_t[];
 consvar_t cv_renderer = Player("renderer", "Software").flags(CV_NOLUA).values(cv_renderer_t).onchange(SCR_ChangeRenderer);
 consvar_t cv_parallelsoftware = Player("parallelsoftware", "On").on_off();
+consvar_t cv_parallelviews = Player("parallelviews", "Off").on_off();
 
 consvar_t cv_renderview = Player("renderview", "On").values({{0, "Off"}, {1, "On"}, {2, "Force"}}).dont_save();
 consvar_t cv_rollingdemos = Player("rollingdemos", "On").on_off();
@@ -524,6 +525,9 @@ consvar_t cv_kartvoices = Server("tauntvoices", "On").on_off();
 consvar_t cv_kartspeedometer = Server("speedometer", "Percentage").values({{0, "Off"}, {1, "Percentage"}, {2, "Kilometers"}, {3, "Miles"}, {4, "Fracunits"}}); // use tics in display
 consvar_t cv_kicktime = Server("kicktime", "20").values(CV_Unsigned);
 
+// Microseconds of idle time per frame for Lua garbage collection; 0 lets Lua collect as it allocates
+consvar_t cv_lua_gcbudget = Server("lua_gcbudget", "1000").values(CV_Unsigned);
+
 void MasterServer_OnChange(void);
 consvar_t cv_masterserver = Server("masterserver", "https://ms.kartkrew.org/ms/api").onchange(MasterServer_OnChange);
 consvar_t cv_masterserver_nagattempts = Server("masterserver_nagattempts", "5").values(CV_Unsigned);
@@ -540,6 +544,10 @@ consvar_t cv_masterserver_update_rate = Server("masterserver_update_rate", "15")
 consvar_t cv_maxping = Server("maxdelay", "20").min_max(0, 30);
 consvar_t cv_menujam = Server("menujam", "menu").values({{0, "menu"}, {1, "menu2"}, {2, "menu3"}});
 consvar_t cv_menujam_update = Server("menujam_update", "Off").on_off();
+
+// Codec for game states sent to joining players; values match compressor_t
+consvar_t cv_netcompression = Server("netcompression", "Zstd").values({{0, "None"}, {1, "LZF"}, {2, "Zstd"}});
+
 consvar_t cv_netdemosyncquality = Server("netdemo_syncquality", "1").min_max(1, 35);
 consvar_t cv_netdemosize = Server("netdemo_size", "6").values(CV_Natural);
 
@@ -43,7 +43,9 @@
 #include "r_local.h"
 #include "m_argv.h"
 #include "p_setup.h"
-#include "lzf.h"
+#include "p_savedelta.h"
+#include "d_netsnapshot.h"
+#include "m_compress.h"
 #include "lua_script.h"
 #include "lua_hook.h"
 #include "md5.h"
@@ -112,6 +114,7 @@ UINT8 playernode[MAXPLAYERS];
 tic_t jointimeout = (3*TICRATE);
 static boolean sendingsavegame[MAXNETNODES]; // Are we sending the savegame?
 static boolean resendingsavegame[MAXNETNODES]; // Are we resending the savegame?
+static netsnapshot_t *pendingsavegame[MAXNETNODES]; // Savegame still compressing for this node
 static tic_t savegameresendcooldown[MAXNETNODES]; // How long before we can resend again?
 static tic_t freezetimeout[MAXNETNODES]; // Until when can this node freeze the server before getting a timeout?
 
@@ -1248,67 +1251,50 @@ static boolean SV_ResendingSavegameToAnyone(void)
 	return false;
 }
 
+static void SV_SendPendingSaveGames(void);
+
 static void SV_SendSaveGame(INT32 node, boolean resending)
 {
-	size_t length, compressedlen;
-	savebuffer_t save = {0};
-	UINT8 *compressedsave;
-	UINT8 *buffertosend;
-
-	// first save it in a malloced buffer
-	if (P_SaveBufferAlloc(&save, NETSAVEGAMESIZE) == false)
+	// Nodes joining on the same tic share one serialization
+	netsnapshot_t *snapshot = SV_AcquireNetSnapshot(resending);
+	if (!snapshot)
 	{
 		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
 		return;
 	}
 
-	// Leave room for the uncompressed length.
-	save.p += sizeof(UINT32);
+	if (pendingsavegame[node])
+		SV_ReleaseNetSnapshot(pendingsavegame[node]);
+	pendingsavegame[node] = snapshot;
 
-	P_SaveNetGame(&save, resending);
+	// Remember when we started sending the savegame so we can handle timeouts
+	sendingsavegame[node] = true;
+	freezetimeout[node] = I_GetTime() + jointimeout;
 
-	length = save.p - save.buffer;
-	if (length > NETSAVEGAMESIZE)
-	{
-		P_SaveBufferFree(&save);
-		I_Error("Savegame buffer overrun");
-	}
+	SV_SendPendingSaveGames();
+}
 
-	// Allocate space for compressed save: one byte fewer than for the
-	// uncompressed data to ensure that the compression is worthwhile.
-	compressedsave = Z_Malloc(length - 1, PU_STATIC, NULL);
-	if (!compressedsave)
-	{
-		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
-		return;
-	}
+// Queue the savegames which have finished compressing
+static void SV_SendPendingSaveGames(void)
+{
+	INT32 node;
 
-	// Attempt to compress it.
-	if ((compressedlen = lzf_compress(save.buffer + sizeof(UINT32), length - sizeof(UINT32), compressedsave + sizeof(UINT32), length - sizeof(UINT32) - 1)))
+	for (node = 0; node < MAXNETNODES; node++)
 	{
-		// Compressing succeeded; send compressed data
-		P_SaveBufferFree(&save);
+		netsnapshot_t *snapshot = pendingsavegame[node];
+		UINT8 *data;
+		size_t length;
 
-		// State that we're compressed.
-		buffertosend = compressedsave;
-		WRITEUINT32(compressedsave, length - sizeof(UINT32));
-		length = compressedlen + sizeof(UINT32);
-	}
-	else
-	{
-		// Compression failed to make it smaller; send original
-		Z_Free(compressedsave);
-
-		// State that we're not compressed
-		buffertosend = save.buffer;
-		WRITEUINT32(save.buffer, 0);
-	}
+		if (!snapshot || !SV_NetSnapshotReady(snapshot))
+			continue;
 
-	AddRamToSendQueue(node, buffertosend, length, SF_Z_RAM, 0);
+		// The send queue now holds this reference
+		pendingsavegame[node] = NULL;
+		data = SV_NetSnapshotData(snapshot, &length);
+		AddRamToSendQueue(node, data, length, SF_NETSNAPSHOT, 0);
 
-	// Remember when we started sending the savegame so we can handle timeouts
-	sendingsavegame[node] = true;
-	freezetimeout[node] = I_GetTime() + jointimeout + length / 1024; // 1 extra tic for each kilobyte
+		freezetimeout[node] = I_GetTime() + jointimeout + length / 1024; // 1 extra tic for each kilobyte
+	}
 }
 
 #ifdef DUMPCONSISTENCY
@@ -1359,26 +1345,40 @@ static void CL_LoadReceivedSavegame(boolean reloading)
 {
 	savebuffer_t save = {0};
 	size_t length, decompressedlen;
+	compressor_t codec;
 	char tmpsave[256];
+	UINT8 *streamed;
 
 	sprintf(tmpsave, "%s" PATHSEP TMPSAVENAME, srb2home);
 
-	if (P_SaveBufferFromFile(&save, tmpsave) == false)
+	// Usually it was decompressed while it downloaded
+	streamed = CL_TakeStreamedSaveGame(&decompressedlen);
+	if (streamed)
 	{
-		I_Error("Can't read savegame sent");
-		return;
+		CONS_Printf(M_GetText("Loading savegame length %s\n"), sizeu1(decompressedlen));
+		P_SaveBufferFromExisting(&save, streamed, decompressedlen);
 	}
+	else
+	{
+		UINT8 *decompressedbuffer;
 
-	length = save.size;
-	CONS_Printf(M_GetText("Loading savegame length %s\n"), sizeu1(length));
+		if (P_SaveBufferFromFile(&save, tmpsave) == false)
+		{
+			I_Error("Can't read savegame sent");
+			return;
+		}
 
-	// Decompress saved game if necessary.
-	decompressedlen = READUINT32(save.p);
-	if (decompressedlen > 0)
-	{
-		UINT8 *decompressedbuffer = Z_Malloc(decompressedlen, PU_STATIC, NULL);
+		length = save.size;
+		CONS_Printf(M_GetText("Loading savegame length %s\n"), sizeu1(length));
 
-		lzf_decompress(save.p, length - sizeof(UINT32), decompressedbuffer, decompressedlen);
+		if (!M_CompressedBufferInfo(save.buffer, length, &codec, &decompressedlen)
+			|| decompressedlen > NETSAVEGAMESIZE
+			|| !(decompressedbuffer = Z_Malloc(max(decompressedlen, 1), PU_STATIC, NULL))
+			|| M_DecompressBuffer(save.buffer, length, decompressedbuffer, decompressedlen) != decompressedlen)
+		{
+			I_Error("Can't decompress savegame sent");
+			return;
+		}
 
 		P_SaveBufferFree(&save);
 		P_SaveBufferFromExisting(&save, decompressedbuffer, decompressedlen);
@@ -1414,7 +1414,10 @@ static void CL_LoadReceivedSavegame(boolean reloading)
 	}
 
 	// done
-	P_SaveBufferFree(&save);
+	if (streamed)
+		free(streamed);
+	else
+		P_SaveBufferFree(&save);
 
 	if (unlink(tmpsave) == -1)
 	{
@@ -3311,6 +3314,11 @@ static void ResetNode(INT32 node)
 	sendingsavegame[node] = false;
 	resendingsavegame[node] = false;
 	savegameresendcooldown[node] = 0;
+	if (pendingsavegame[node])
+	{
+		SV_ReleaseNetSnapshot(pendingsavegame[node]);
+		pendingsavegame[node] = NULL;
+	}
 
 	bannednode[node].banid = SIZE_MAX;
 	bannednode[node].timeleft = NO_BAN_TIME;
@@ -3333,6 +3341,8 @@ void SV_ResetServer(void)
 	for (i = 0; i < MAXNETNODES; i++)
 		ResetNode(i);
 
+	SV_ClearNetSnapshotCache();
+
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
 		LUA_InvalidatePlayer(&players[i]);
@@ -6597,6 +6607,8 @@ void NetKeepAlive(void)
 
 	Net_AckTicker();
 	HandleNodeTimeouts();
+	if (server)
+		SV_SendPendingSaveGames();
 	FileSendTicker();
 }
 
@@ -6782,6 +6794,8 @@ void NetUpdate(void)
 		M_ScreenshotTicker();
 	}
 
+	if (server)
+		SV_SendPendingSaveGames();
 	FileSendTicker();
 }
 
@@ -6826,7 +6840,17 @@ tic_t GetLag(INT32 node)
 }
 
 #define REWIND_POINT_INTERVAL 4*TICRATE + 16
+// Every this many rewind points, store a full snapshot instead of a delta.
+// Restoring any point decodes at most one delta.
+#define REWIND_KEYFRAME_INTERVAL 8
 rewind_t *rewindhead;
+static UINT8 *rewindscratch; // NETSAVEGAMESIZE, for saving and for rebuilding deltas
+
+static void CL_FreeRewind(rewind_t *rewind)
+{
+	free(rewind->savebuffer);
+	free(rewind);
+}
 
 void CL_ClearRewinds(void)
 {
@@ -6834,24 +6858,72 @@ void CL_ClearRewinds(void)
 	while ((head = rewindhead))
 	{
 		rewindhead = rewindhead->next;
-		free(head);
+		CL_FreeRewind(head);
 	}
+
+	free(rewindscratch);
+	rewindscratch = NULL;
 }
 
 rewind_t *CL_SaveRewindPoint(size_t demopos)
 {
 	savebuffer_t save = {0};
 	rewind_t *rewind;
+	rewind_t *keyframe = NULL;
+	size_t length, deltalength = 0;
+	INT32 sincekeyframe = 0;
 
 	if (rewindhead && rewindhead->leveltime + REWIND_POINT_INTERVAL > leveltime)
 		return NULL;
 
-	rewind = (rewind_t *)malloc(sizeof (rewind_t));
+	if (!rewindscratch && !(rewindscratch = malloc(NETSAVEGAMESIZE)))
+		return NULL;
+
+	rewind = (rewind_t *)calloc(1, sizeof (rewind_t));
 	if (!rewind)
 		return NULL;
 
-	P_SaveBufferFromExisting(&save, rewind->savebuffer, NETSAVEGAMESIZE);
+	P_SaveBufferFromExisting(&save, rewindscratch, NETSAVEGAMESIZE);
 	P_SaveNetGame(&save, false);
+	length = save.p - save.buffer;
+
+	if (rewindhead)
+	{
+		keyframe = rewindhead->keyframe ? rewindhead->keyframe : rewindhead;
+		for (rewind_t *r = rewindhead; r != keyframe; r = r->next)
+			sincekeyframe++;
+	}
+
+	if (keyframe && sincekeyframe + 1 < REWIND_KEYFRAME_INTERVAL)
+	{
+		// A delta bigger than half the snapshot isn't worth the decode; start a new keyframe
+		rewind->savebuffer = malloc(length / 2);
+		if (rewind->savebuffer)
+			deltalength = P_SaveDeltaEncode(keyframe->savebuffer, keyframe->savelength,
+				rewindscratch, length, rewind->savebuffer, length / 2);
+	}
+
+	if (deltalength)
+	{
+		UINT8 *shrunk = realloc(rewind->savebuffer, deltalength);
+		if (shrunk)
+			rewind->savebuffer = shrunk;
+		rewind->savelength = deltalength;
+		rewind->keyframe = keyframe;
+	}
+	else
+	{
+		free(rewind->savebuffer);
+		rewind->savebuffer = malloc(length);
+		if (!rewind->savebuffer)
+		{
+			free(rewind);
+			return NULL;
+		}
+		memcpy(rewind->savebuffer, rewindscratch, length);
+		rewind->savelength = length;
+		rewind->keyframe = NULL;
+	}
 
 	rewind->leveltime = leveltime;
 	rewind->next = rewindhead;
@@ -6866,17 +6938,40 @@ rewind_t *CL_RewindToTime(tic_t time)
 	savebuffer_t save = {0};
 	rewind_t *rewind;
 
+	// Keyframes are older than the points which refer to them, so they outlive them here
 	while (rewindhead && rewindhead->leveltime > time)
 	{
 		rewind = rewindhead->next;
-		free(rewindhead);
+		CL_FreeRewind(rewindhead);
 		rewindhead = rewind;
 	}
 
 	if (!rewindhead)
 		return NULL;
 
-	P_SaveBufferFromExisting(&save, rewindhead->savebuffer, NETSAVEGAMESIZE);
+	if (rewindhead->keyframe)
+	{
+		rewind_t *keyframe = rewindhead->keyframe;
+		size_t length;
+
+		if (!rewindscratch && !(rewindscratch = malloc(NETSAVEGAMESIZE)))
+			return NULL;
+
+		length = P_SaveDeltaDecode(keyframe->savebuffer, keyframe->savelength,
+			rewindhead->savebuffer, rewindhead->savelength, rewindscratch, NETSAVEGAMESIZE);
+		if (!length)
+		{
+			CONS_Alert(CONS_ERROR, "Rewind point at %u is corrupt\n", rewindhead->leveltime);
+			return NULL;
+		}
+
+		P_SaveBufferFromExisting(&save, rewindscratch, length);
+	}
+	else
+	{
+		P_SaveBufferFromExisting(&save, rewindhead->savebuffer, rewindhead->savelength);
+	}
+
 	P_LoadNetGame(&save, false);
 
 	wipegamestate = gamestate; // No fading back in!
@@ -6885,6 +6980,29 @@ rewind_t *CL_RewindToTime(tic_t time)
 	return rewindhead;
 }
 
+void Command_RewindInfo_f(void)
+{
+	rewind_t *rewind;
+	size_t points = 0, keyframes = 0, keyframebytes = 0, deltabytes = 0;
+
+	for (rewind = rewindhead; rewind; rewind = rewind->next)
+	{
+		points++;
+		if (rewind->keyframe)
+			deltabytes += rewind->savelength;
+		else
+		{
+			keyframes++;
+			keyframebytes += rewind->savelength;
+		}
+	}
+
+	CONS_Printf("%s rewind points, %s keyframes\n", sizeu1(points), sizeu2(keyframes));
+	CONS_Printf("  keyframes: %s KiB\n", sizeu1(keyframebytes / 1024));
+	CONS_Printf("  deltas:    %s KiB\n", sizeu1(deltabytes / 1024));
+	CONS_Printf("  without deltas: %s KiB\n", sizeu1(points * NETSAVEGAMESIZE / 1024));
+}
+
 void D_MD5PasswordPass(const UINT8 *buffer, size_t len, const char *salt, void *dest)
 {
 #ifdef NOMD5
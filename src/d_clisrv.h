@@ -556,6 +556,7 @@ extern consvar_t cv_mindelay;
 extern consvar_t cv_netticbuffer, cv_allownewplayer, cv_maxconnections, cv_joindelay;
 extern consvar_t cv_pingtimeout, cv_resynchattempts, cv_blamecfail;
 extern consvar_t cv_maxsend, cv_noticedownload, cv_downloadspeed;
+extern consvar_t cv_netcompression;
 
 #ifdef VANILLAJOINNEXTROUND
 extern consvar_t cv_joinnextround;
@@ -680,7 +681,9 @@ extern boolean hu_stopped;
 //
 
 struct rewind_t {
-	UINT8 savebuffer[NETSAVEGAMESIZE];
+	UINT8 *savebuffer; // full snapshot for keyframes, otherwise a delta against keyframe
+	size_t savelength;
+	rewind_t *keyframe; // NULL if this is a keyframe; always older than this point
 	tic_t leveltime;
 	size_t demopos;
 
@@ -693,6 +696,7 @@ struct rewind_t {
 void CL_ClearRewinds(void);
 rewind_t *CL_SaveRewindPoint(size_t demopos);
 rewind_t *CL_RewindToTime(tic_t time);
+void Command_RewindInfo_f(void);
 
 void HandleSigfail(const char *string);
 
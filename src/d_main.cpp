@@ -52,6 +52,7 @@
 #include "i_threads.h"
 #include "i_video.h"
 #include "m_argv.h"
+#include "m_compress.h"
 #include "k_menu.h"
 #include "m_misc.h"
 #include "p_setup.h"
@@ -586,50 +587,17 @@ static bool D_Display(bool world)
 #endif
 						if (rendermode != render_none)
 						{
-							if (i > 0) // Splitscreen-specific
-							{
-								switch (i)
-								{
-									case 1:
-										if (r_splitscreen > 1)
-										{
-											viewwindowx = viewwidth;
-											viewwindowy = 0;
-										}
-										else
-										{
-											viewwindowx = 0;
-											viewwindowy = viewheight;
-										}
-										M_Memcpy(ylookup, ylookup2, viewheight*sizeof (ylookup[0]));
-										break;
-									case 2:
-										viewwindowx = 0;
-										viewwindowy = viewheight;
-										M_Memcpy(ylookup, ylookup3, viewheight*sizeof (ylookup[0]));
-										break;
-									case 3:
-										viewwindowx = viewwidth;
-										viewwindowy = viewheight;
-										M_Memcpy(ylookup, ylookup4, viewheight*sizeof (ylookup[0]));
-									default:
-										break;
-								}
-
-
-								topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
-							}
-
+							R_SetupRenderView(i);
 							R_RenderPlayerView();
-
-							if (i > 0)
-								M_Memcpy(ylookup, ylookup1, viewheight*sizeof (ylookup[0]));
 						}
 					}
 				}
 
 				if (rendermode == render_soft)
 				{
+					// Views may still be drawing on the thread pool
+					R_FinishRenderViews();
+
 					for (i = 0; i <= r_splitscreen; i++)
 					{
 						R_ApplyViewMorph(i);
@@ -904,6 +872,7 @@ void D_SRB2Loop(void)
 
 		g_dc = {};
 		Z_Frame_Reset();
+		Z_Arena_Reset();
 		srb2::r_debug::clear_frame_list();
 
 		{
@@ -1080,8 +1049,6 @@ void D_SRB2Loop(void)
 			S_TickSoundTest();
 		}
 
-		LUA_Step();
-
 #ifdef HAVE_DISCORDRPC
 		if (! dedicated)
 		{
@@ -1153,6 +1120,14 @@ void D_SRB2Loop(void)
 			skiplaggyworld = false;
 		}
 
+		// Lua garbage collection gets the time left before the frame cap, rather than
+		// running whenever a hook happens to allocate.
+		{
+			INT64 slack = (INT64)capbudget - (INT64)(finishprecise - enterprecise);
+			LUA_Step(slack > 0 ? (precise_t)slack : 0);
+			finishprecise = I_GetPreciseTime();
+		}
+
 		if (!singletics)
 		{
 			INT64 elapsed = (INT64)(finishprecise - enterprecise);
@@ -1750,6 +1725,9 @@ void D_SRB2Main(void)
 	// Load credits_def lump
 	F_LoadCreditsDefinitions();
 
+	// Before any addon can shadow it; both ends of a connection need the same one
+	M_LoadCompressionDictionary();
+
 	// Do it before P_InitMapData because PNG patch
 	// conversion sometimes needs the palette
 	V_ReloadPalette();
@@ -33,6 +33,7 @@
 #include "am_map.h"
 #include "byteptr.h"
 #include "d_netfil.h"
+#include "d_netsnapshot.h"
 #include "p_spec.h"
 #include "m_cheat.h"
 #include "d_clisrv.h"
@@ -73,6 +74,9 @@
 #include "k_bans.h"
 #include "k_director.h"
 #include "k_credits.h"
+#include "core/thread_pool.h"
+#include "r_draw_simd.h"
+#include "i_video.h"
 
 #ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
 #include "m_avrecorder.h"
@@ -241,6 +245,8 @@ CV_PossibleValue_t perfstats_cons_t[] = {
 	{PS_LOGIC, "Logic"},
 	{PS_BOT, "Bots"},
 	{PS_THINKFRAME, "ThinkFrame"},
+	{PS_LUAGC, "LuaGC"},
+	{PS_MOBJHOOKS, "MobjHooks"},
 	{0, NULL}
 };
 
@@ -460,6 +466,18 @@ void D_RegisterServerCommands(void)
 
 	COM_AddDebugCommand("numthinkers", Command_Numthinkers_f);
 	COM_AddDebugCommand("countmobjs", Command_CountMobjs_f);
+	COM_AddDebugCommand("threadpool_bench", Command_ThreadPoolBench_f);
+	COM_AddDebugCommand("drawsimd_test", Command_DrawSIMDTest_f);
+	COM_AddDebugCommand("lumpindex_bench", Command_LumpIndexBench_f);
+	COM_AddDebugCommand("twodee_bench", Command_TwodeeBench_f);
+	COM_AddDebugCommand("rewindinfo", Command_RewindInfo_f);
+	COM_AddDebugCommand("netsnapshotinfo", Command_NetSnapshotInfo_f);
+	COM_AddDebugCommand("netsave_bench", Command_NetSaveBench_f);
+	COM_AddDebugCommand("netsave_dict", Command_NetSaveDict_f);
+	COM_AddDebugCommand("pathfind_bench", Command_PathfindBench_f);
+	COM_AddDebugCommand("lua_allocbench", Command_LuaAllocBench_f);
+	COM_AddDebugCommand("lua_pushbench", Command_LuaPushBench_f);
+	COM_AddDebugCommand("sfxmix_bench", Command_SfxMixBench_f);
 
 #ifdef _DEBUG
 	COM_AddDebugCommand("causecfail", Command_CauseCfail_f);
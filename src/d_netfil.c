@@ -47,8 +47,11 @@
 #include "d_net.h"
 #include "w_wad.h"
 #include "d_netfil.h"
+#include "d_netsnapshot.h"
+#include "m_compress.h"
 #include "z_zone.h"
 #include "byteptr.h"
+#include "p_saveg.h" // NETSAVEGAMESIZE
 #include "p_setup.h"
 #include "m_misc.h"
 #include "k_menu.h"
@@ -246,6 +249,70 @@ void D_ParseFileneeded(INT32 fileneedednum_parm, UINT8 *fileneededstr, UINT16 fi
 	}
 }
 
+// The savegame is decompressed as its fragments arrive, so the client
+// does not wait for the whole download before it can start decoding.
+static boolean savegamestreamwanted;
+static decompressstream_t *savegamestream;
+static UINT8 *savegamestreambuffer; // Fragments which arrived ahead of a gap wait here
+static UINT32 savegamestreamnext; // Next fragment to feed to the decompressor
+
+static void CL_AbortSaveGameStream(void)
+{
+	M_DecompressStreamAbort(savegamestream);
+	savegamestream = NULL;
+	free(savegamestreambuffer);
+	savegamestreambuffer = NULL;
+}
+
+static void CL_StreamSaveGameFragment(fileneeded_t *file, UINT32 fragmentpos, const UINT8 *data, UINT16 size)
+{
+	if (size > file->totalsize - fragmentpos)
+	{
+		CL_AbortSaveGameStream();
+		return;
+	}
+
+	M_Memcpy(savegamestreambuffer + fragmentpos, data, size);
+
+	// Feed everything that is now contiguous
+	while (savegamestreamnext * file->fragmentsize < file->totalsize
+		&& file->receivedfragments[savegamestreamnext])
+	{
+		UINT32 start = savegamestreamnext * file->fragmentsize;
+		UINT32 end = min(start + file->fragmentsize, file->totalsize);
+
+		if (!M_DecompressStreamFeed(savegamestream, savegamestreambuffer + start, end - start))
+		{
+			// Leave it to the whole file, which will report the error
+			CL_AbortSaveGameStream();
+			return;
+		}
+
+		savegamestreamnext++;
+	}
+
+	if (savegamestreamnext * file->fragmentsize >= file->totalsize)
+	{
+		free(savegamestreambuffer);
+		savegamestreambuffer = NULL;
+	}
+}
+
+UINT8 *CL_TakeStreamedSaveGame(size_t *length)
+{
+	UINT8 *data;
+
+	if (!savegamestream || savegamestreambuffer)
+	{
+		CL_AbortSaveGameStream();
+		return NULL;
+	}
+
+	data = M_DecompressStreamFinish(savegamestream, length);
+	savegamestream = NULL;
+	return data;
+}
+
 void CL_PrepareDownloadSaveGame(const char *tmpsave)
 {
 	lastfilenum = -1;
@@ -257,6 +324,9 @@ void CL_PrepareDownloadSaveGame(const char *tmpsave)
 	fileneeded[0].file = NULL;
 	memset(fileneeded[0].md5sum, 0, 16);
 	strcpy(fileneeded[0].filename, tmpsave);
+
+	CL_AbortSaveGameStream();
+	savegamestreamwanted = true;
 }
 
 /** Checks the server to see if we CAN download all the files,
@@ -1083,6 +1153,9 @@ static void SV_EndFileSend(INT32 node)
 			free(p->id.ram);
 		case SF_NOFREERAM: // Nothing to free
 			break;
+		case SF_NETSNAPSHOT: // It's a game state shared by several nodes, drop our reference
+			SV_ReleaseNetSnapshotData(p->id.ram);
+			break;
 	}
 
 	// Remove the file request from the list
@@ -1098,8 +1171,6 @@ static void SV_EndFileSend(INT32 node)
 	filestosend--;
 }
 
-#define FILEFRAGMENTSIZE (software_MAXPACKETLENGTH - (FILETXHEADER + BASEPACKETSIZE))
-
 /** Handles file transmission
   *
   */
@@ -1499,8 +1570,19 @@ void PT_FileFragment(void)
 			file->receivedfragments = calloc(file->totalsize / fragmentsize + 1, sizeof(*file->receivedfragments));
 			if (!file->receivedfragments)
 				I_Error("FileSendTicker: No more memory\n");
+
+			if (savegamestreamwanted && filenum == 0)
+			{
+				savegamestream = M_DecompressStreamBegin(NETSAVEGAMESIZE);
+				savegamestreambuffer = malloc(file->totalsize);
+				savegamestreamnext = 0;
+				if (!savegamestreambuffer)
+					CL_AbortSaveGameStream();
+			}
 		}
 
+		savegamestreamwanted = false;
+
 		lasttimeackpacketsent = I_GetTime();
 	}
 
@@ -1521,6 +1603,9 @@ void PT_FileFragment(void)
 				I_Error("Can't write to %s: %s\n",filename, M_FileError(file->file));
 			file->currentsize += boundedfragmentsize;
 
+			if (savegamestreambuffer && filenum == 0)
+				CL_StreamSaveGameFragment(file, fragmentpos, pak->data, boundedfragmentsize);
+
 			AddFragmentToAckPacket(file->ackpacket, file->iteration, fragmentpos / fragmentsize, filenum);
 
 			// Finished?
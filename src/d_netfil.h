@@ -27,7 +27,8 @@ typedef enum
 	SF_FILE,
 	SF_Z_RAM,
 	SF_RAM,
-	SF_NOFREERAM
+	SF_NOFREERAM,
+	SF_NETSNAPSHOT // Shared with other nodes, release with SV_ReleaseNetSnapshotData
 } freemethod_t;
 
 typedef enum
@@ -89,12 +90,16 @@ extern struct HTTP_login
 UINT8 *PutFileNeeded(UINT16 firstfile);
 void D_ParseFileneeded(INT32 fileneedednum_parm, UINT8 *fileneededstr, UINT16 firstfile);
 void CL_PrepareDownloadSaveGame(const char *tmpsave);
+UINT8 *CL_TakeStreamedSaveGame(size_t *length);
 
 INT32 CL_CheckFiles(void);
 boolean CL_LoadServerFiles(void);
 void AddRamToSendQueue(INT32 node, void *data, size_t size, freemethod_t freemethod,
 	UINT8 fileid);
 
+// Payload of one PT_FILEFRAGMENT packet; needs d_clisrv.h
+#define FILEFRAGMENTSIZE (software_MAXPACKETLENGTH - (FILETXHEADER + BASEPACKETSIZE))
+
 void FileSendTicker(void);
 void PT_FileAck(void);
 void PT_FileReceived(void);
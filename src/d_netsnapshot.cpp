@@ -0,0 +1,438 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  d_netsnapshot.cpp
+/// \brief Shared, compressed game state snapshots for joining nodes
+
+#include "d_netsnapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "command.h"
+#include "console.h"
+#include "core/thread_pool.h"
+#include "d_clisrv.h"
+#include "d_main.h"
+#include "d_netfil.h"
+#include "doomstat.h"
+#include "g_game.h"
+#include "i_system.h"
+#include "m_compress.h"
+#include "m_misc.h"
+#include "p_saveg.h"
+
+struct netsnapshot_s
+{
+	// Main thread only
+	INT32 refcount;
+	tic_t gametic;
+	gamestate_t gamestate;
+	boolean resending;
+	compressor_t codec;
+	netsnapshot_t *next;
+	srb2::ThreadPool::Sema sema;
+	boolean compressing; // until SV_NetSnapshotReady sees it finish
+
+	// Written by the worker before ready is set
+	UINT8 *data; // serialized after COMPRESS_HEADERSIZE bytes, then replaced by the compressed buffer
+	size_t length;
+	size_t rawlength;
+	std::chrono::steady_clock::duration compresstime;
+	std::atomic<bool> ready {false};
+};
+
+static netsnapshot_t *livesnapshots; // every snapshot with references left
+static netsnapshot_t *cachedsnapshot; // holds its own reference
+
+static struct
+{
+	size_t serialized;
+	size_t shared;
+	std::chrono::steady_clock::duration savetime;
+	std::chrono::steady_clock::duration compresstime;
+} snapshotstats;
+
+static void NetSnapshot_Compress(netsnapshot_t *snapshot)
+{
+	auto start = std::chrono::steady_clock::now();
+	size_t cap = M_CompressBufferBound(snapshot->rawlength);
+	UINT8 *compressed = static_cast<UINT8 *>(malloc(cap));
+	size_t length = 0;
+
+	if (compressed)
+	{
+		length = M_CompressBuffer(snapshot->codec, snapshot->data + COMPRESS_HEADERSIZE, snapshot->rawlength, compressed, cap);
+	}
+
+	if (length)
+	{
+		free(snapshot->data);
+		snapshot->data = compressed;
+		snapshot->length = length;
+	}
+	else
+	{
+		// Out of memory; send it as it is
+		free(compressed);
+		M_WriteCompressedHeader(snapshot->data, COMPRESSOR_NONE, snapshot->rawlength);
+		snapshot->length = snapshot->rawlength + COMPRESS_HEADERSIZE;
+	}
+
+	snapshot->compresstime = std::chrono::steady_clock::now() - start;
+	snapshot->ready.store(true, std::memory_order_release);
+}
+
+netsnapshot_t *SV_AcquireNetSnapshot(boolean resending)
+{
+	compressor_t codec = static_cast<compressor_t>(cv_netcompression.value);
+
+	if (cachedsnapshot
+		&& cachedsnapshot->gametic == gametic
+		&& cachedsnapshot->gamestate == gamestate
+		&& cachedsnapshot->resending == resending
+		&& cachedsnapshot->codec == codec)
+	{
+		snapshotstats.shared++;
+		cachedsnapshot->refcount++;
+		return cachedsnapshot;
+	}
+
+	SV_ClearNetSnapshotCache();
+
+	auto start = std::chrono::steady_clock::now();
+	savebuffer_t save = {0};
+
+	// Not the zone: the compression task frees this buffer.
+	save.buffer = save.p = static_cast<UINT8 *>(malloc(NETSAVEGAMESIZE));
+	if (!save.buffer)
+	{
+		return NULL;
+	}
+	save.size = NETSAVEGAMESIZE;
+	save.end = save.buffer + save.size;
+
+	// Leave room for the compression header.
+	save.p += COMPRESS_HEADERSIZE;
+
+	P_SaveNetGame(&save, resending);
+
+	size_t length = save.p - save.buffer;
+	if (length > NETSAVEGAMESIZE)
+	{
+		free(save.buffer);
+		I_Error("Savegame buffer overrun");
+	}
+
+	netsnapshot_t *snapshot = new netsnapshot_t {};
+	snapshot->refcount = 2; // the caller and the cache
+	snapshot->gametic = gametic;
+	snapshot->gamestate = gamestate;
+	snapshot->resending = resending;
+	snapshot->codec = codec;
+	snapshot->data = save.buffer;
+	snapshot->rawlength = length - COMPRESS_HEADERSIZE;
+	snapshot->next = livesnapshots;
+	livesnapshots = snapshot;
+	cachedsnapshot = snapshot;
+
+	snapshotstats.serialized++;
+	snapshotstats.savetime += std::chrono::steady_clock::now() - start;
+
+	snapshot->compressing = true;
+
+	// Inline if there's no worker to hand it to
+	if (!srb2::g_main_threadpool || srb2::g_main_threadpool->worker_count() <= 1)
+	{
+		NetSnapshot_Compress(snapshot);
+		return snapshot;
+	}
+
+	srb2::g_main_threadpool->begin_sema();
+	srb2::g_main_threadpool->schedule([snapshot]() { NetSnapshot_Compress(snapshot); });
+	snapshot->sema = srb2::g_main_threadpool->end_sema();
+	srb2::g_main_threadpool->notify_sema(snapshot->sema);
+
+	return snapshot;
+}
+
+boolean SV_NetSnapshotReady(netsnapshot_t *snapshot)
+{
+	if (!snapshot->ready.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	if (snapshot->compressing)
+	{
+		snapshot->compressing = false;
+		snapshotstats.compresstime += snapshot->compresstime;
+	}
+	return true;
+}
+
+UINT8 *SV_NetSnapshotData(netsnapshot_t *snapshot, size_t *length)
+{
+	*length = snapshot->length;
+	return snapshot->data;
+}
+
+void SV_ReleaseNetSnapshot(netsnapshot_t *snapshot)
+{
+	if (--snapshot->refcount > 0)
+	{
+		// The last joiner is done with it; don't hold on to the buffer until the next join
+		if (snapshot->refcount == 1 && snapshot == cachedsnapshot)
+		{
+			SV_ClearNetSnapshotCache();
+		}
+		return;
+	}
+
+	for (netsnapshot_t **link = &livesnapshots; *link; link = &(*link)->next)
+	{
+		if (*link == snapshot)
+		{
+			*link = snapshot->next;
+			break;
+		}
+	}
+
+	// Still compressing; the task writes to the snapshot
+	if (!snapshot->ready.load(std::memory_order_acquire))
+	{
+		srb2::g_main_threadpool->wait_sema(snapshot->sema);
+	}
+	free(snapshot->data);
+	delete snapshot;
+}
+
+void SV_ReleaseNetSnapshotData(void *data)
+{
+	for (netsnapshot_t *snapshot = livesnapshots; snapshot; snapshot = snapshot->next)
+	{
+		if (snapshot->data == data && snapshot->ready.load(std::memory_order_acquire))
+		{
+			SV_ReleaseNetSnapshot(snapshot);
+			return;
+		}
+	}
+}
+
+void SV_ClearNetSnapshotCache(void)
+{
+	if (cachedsnapshot)
+	{
+		netsnapshot_t *snapshot = cachedsnapshot;
+		cachedsnapshot = NULL;
+		SV_ReleaseNetSnapshot(snapshot);
+	}
+}
+
+void Command_NetSnapshotInfo_f(void)
+{
+	auto to_us = [](std::chrono::steady_clock::duration d)
+	{
+		return static_cast<size_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+	};
+	size_t live = 0;
+
+	for (netsnapshot_t *snapshot = livesnapshots; snapshot; snapshot = snapshot->next)
+	{
+		live++;
+	}
+
+	CONS_Printf("%s snapshots serialized, %s joins shared one\n",
+		sizeu1(snapshotstats.serialized), sizeu2(snapshotstats.shared));
+	CONS_Printf("  serialize (main thread): %s us total\n", sizeu1(to_us(snapshotstats.savetime)));
+	CONS_Printf("  compress (worker):       %s us total\n", sizeu1(to_us(snapshotstats.compresstime)));
+	CONS_Printf("  %s live\n", sizeu1(live));
+
+	if (cachedsnapshot)
+	{
+		if (cachedsnapshot->ready.load(std::memory_order_acquire))
+		{
+			CONS_Printf("  cached: tic %u, %s -> %s bytes\n",
+				cachedsnapshot->gametic, sizeu1(cachedsnapshot->rawlength), sizeu2(cachedsnapshot->length));
+		}
+		else
+		{
+			CONS_Printf("  cached: tic %u, %s bytes (compressing)\n",
+				cachedsnapshot->gametic, sizeu1(cachedsnapshot->rawlength));
+		}
+	}
+}
+
+static std::vector<std::vector<UINT8>> dictsamples;
+
+static std::vector<UINT8> NetSnapshot_Serialize(void)
+{
+	std::vector<UINT8> buffer(NETSAVEGAMESIZE);
+	savebuffer_t save = {0};
+
+	P_SaveBufferFromExisting(&save, buffer.data(), buffer.size());
+	P_SaveNetGame(&save, false);
+	buffer.resize(save.p - save.buffer);
+	return buffer;
+}
+
+// netsave_bench [iterations]
+// Estimates how long a player joining now waits for the game state with
+// each codec: serializing, compressing, sending at downloadspeed and
+// decompressing. Streaming hides decompression behind the download except
+// for the last fragment.
+void Command_NetSaveBench_f(void)
+{
+	using Clock = std::chrono::steady_clock;
+	auto to_us = [](Clock::duration d)
+	{
+		return static_cast<size_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+	};
+
+	const int iterations = COM_Argc() > 1 ? std::max(1, atoi(COM_Argv(1))) : 10;
+	const size_t fragmentsize = FILEFRAGMENTSIZE;
+
+	if (gamestate != GS_LEVEL)
+	{
+		CONS_Printf("Measuring outside a level; join in a busy map for realistic numbers.\n");
+	}
+
+	std::vector<UINT8> raw;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		raw = NetSnapshot_Serialize();
+	}
+	size_t saveus = to_us(Clock::now() - start) / iterations;
+
+	CONS_Printf("Game state: %s bytes, serialized in %s us\n", sizeu1(raw.size()), sizeu2(saveus));
+	CONS_Printf("Transfer at %d fragments of %s bytes per tic\n", cv_downloadspeed.value, sizeu1(fragmentsize));
+
+	std::vector<UINT8> compressed(M_CompressBufferBound(raw.size()));
+	std::vector<UINT8> decompressed(raw.size());
+
+	for (int codec = 0; codec < NUMCOMPRESSORS; codec++)
+	{
+		size_t length = 0;
+		bool ok = true;
+
+		start = Clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			length = M_CompressBuffer(static_cast<compressor_t>(codec), raw.data(), raw.size(),
+				compressed.data(), compressed.size());
+		}
+		size_t compressus = to_us(Clock::now() - start) / iterations;
+
+		start = Clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			ok &= M_DecompressBuffer(compressed.data(), length, decompressed.data(), decompressed.size()) == raw.size();
+		}
+		size_t decompressus = to_us(Clock::now() - start) / iterations;
+
+		// Only the final fragment and the finish are left once the download ends
+		Clock::duration tail {};
+		for (int i = 0; i < iterations; i++)
+		{
+			decompressstream_t *stream = M_DecompressStreamBegin(raw.size());
+			size_t pos = 0;
+			while (length - pos > fragmentsize)
+			{
+				ok &= M_DecompressStreamFeed(stream, compressed.data() + pos, fragmentsize) == true;
+				pos += fragmentsize;
+			}
+
+			size_t rawlength = 0;
+			start = Clock::now();
+			M_DecompressStreamFeed(stream, compressed.data() + pos, length - pos);
+			UINT8 *out = M_DecompressStreamFinish(stream, &rawlength);
+			tail += Clock::now() - start;
+
+			ok &= out && rawlength == raw.size() && memcmp(out, raw.data(), rawlength) == 0;
+			free(out);
+		}
+		size_t tailus = to_us(tail) / iterations;
+
+		size_t fragments = (length + fragmentsize - 1) / fragmentsize;
+		size_t tics = (fragments + cv_downloadspeed.value - 1) / cv_downloadspeed.value;
+		size_t transferus = tics * 1000000 / TICRATE;
+
+		CONS_Printf("%s: %s bytes (%s%%)%s\n", compressornames[codec], sizeu1(length),
+			sizeu2(length * 100 / std::max<size_t>(raw.size(), 1)), ok ? "" : " \x85MISMATCH\x80");
+		CONS_Printf("  compress %s us, decompress %s us (%s us after the last fragment)\n",
+			sizeu1(compressus), sizeu2(decompressus), sizeu3(tailus));
+		CONS_Printf("  transfer %s tics; join %s us, %s us without streaming\n",
+			sizeu1(tics),
+			sizeu2(compressus + transferus + tailus),
+			sizeu3(compressus + transferus + decompressus));
+	}
+}
+
+// netsave_dict sample|train|clear
+// Collects game states and trains the NETSDICT compression dictionary
+// from them, for shipping with the main files.
+void Command_NetSaveDict_f(void)
+{
+	const char *action = COM_Argc() > 1 ? COM_Argv(1) : "";
+
+	// Zstd trains best on many small samples, so each game state is split up
+	static constexpr size_t kSampleSize = 16 * 1024;
+	static constexpr size_t kDictSize = 64 * 1024;
+
+	if (!strcasecmp(action, "sample"))
+	{
+		dictsamples.push_back(NetSnapshot_Serialize());
+		CONS_Printf("%s game states collected\n", sizeu1(dictsamples.size()));
+	}
+	else if (!strcasecmp(action, "clear"))
+	{
+		dictsamples.clear();
+	}
+	else if (!strcasecmp(action, "train"))
+	{
+		std::vector<const UINT8 *> samples;
+		std::vector<size_t> lengths;
+
+		for (const std::vector<UINT8> &state : dictsamples)
+		{
+			for (size_t pos = 0; pos < state.size(); pos += kSampleSize)
+			{
+				samples.push_back(state.data() + pos);
+				lengths.push_back(std::min(kSampleSize, state.size() - pos));
+			}
+		}
+
+		std::vector<UINT8> dict(kDictSize);
+		size_t length = M_TrainCompressionDictionary(samples.data(), lengths.data(), samples.size(),
+			dict.data(), dict.size());
+		if (!length)
+		{
+			return;
+		}
+
+		char path[256];
+		sprintf(path, "%s" PATHSEP "NETSDICT.lmp", srb2home);
+		if (FIL_WriteFile(path, dict.data(), length))
+		{
+			CONS_Printf("Wrote %s bytes to %s\n", sizeu1(length), path);
+		}
+		else
+		{
+			CONS_Alert(CONS_ERROR, "Can't write %s\n", path);
+		}
+	}
+	else
+	{
+		CONS_Printf("netsave_dict <sample|train|clear>: %s game states collected\n", sizeu1(dictsamples.size()));
+	}
+}
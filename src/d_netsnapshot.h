@@ -0,0 +1,52 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  d_netsnapshot.h
+/// \brief Shared, compressed game state snapshots for joining nodes
+
+#ifndef __D_NETSNAPSHOT__
+#define __D_NETSNAPSHOT__
+
+#include "doomtype.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct netsnapshot_s netsnapshot_t;
+
+// Returns a reference to the snapshot of the current game state.
+// Nodes asking within the same tic share one serialization; compression
+// happens on the thread pool, so check SV_NetSnapshotReady before sending.
+// Returns NULL if out of memory.
+netsnapshot_t *SV_AcquireNetSnapshot(boolean resending);
+
+// True once the snapshot has been compressed; never blocks.
+boolean SV_NetSnapshotReady(netsnapshot_t *snapshot);
+
+// The data to send, as made by M_CompressBuffer with cv_netcompression.
+// Only valid once ready.
+UINT8 *SV_NetSnapshotData(netsnapshot_t *snapshot, size_t *length);
+
+void SV_ReleaseNetSnapshot(netsnapshot_t *snapshot);
+
+// Release the reference held by the send queue, given SV_NetSnapshotData.
+void SV_ReleaseNetSnapshotData(void *data);
+
+// Drop the cached snapshot, so the next join serializes again.
+void SV_ClearNetSnapshotCache(void);
+
+void Command_NetSnapshotInfo_f(void);
+void Command_NetSaveBench_f(void);
+void Command_NetSaveDict_f(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
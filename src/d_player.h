@@ -1048,6 +1048,8 @@ struct player_t
 
 	tic_t darkness_start;
 	tic_t darkness_end;
+
+	INT32 luaref; // Registry reference to the Lua userdata, see LUA_PushPlayer (NOT savegame, NOT Lua)
 };
 
 // WARNING FOR ANYONE ABOUT TO ADD SOMETHING TO THE PLAYER STRUCT, G_PlayerReborn WANTS YOU TO SUFFER
@@ -52,7 +52,7 @@ struct thinker_t
 	// killough 11/98: count of how many other objects reference
 	// this one using pointers. Used for garbage collection.
 	INT32 references;
-	boolean cachable;
+	struct zpool_s *pool; // Level pool this was allocated from, or NULL for the zone
 
 #ifdef PARANOIA
 	INT32 debug_mobjtype;
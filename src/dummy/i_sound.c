@@ -29,6 +29,8 @@ void I_StartupSound(void){}
 
 void I_ShutdownSound(void){}
 
+void Command_SfxMixBench_f(void){}
+
 void I_UpdateSound(void){};
 
 //
@@ -171,8 +171,12 @@ demoghost *ghosts = NULL;
 //   - Slope physics changed with a scaling fix
 // - 0x000C (Ring Racers v2.2)
 // - 0x000D (Ring Racers v2.3)
+// - 0x000E
+//   - Distances to the finish line and the next waypoint towards it come
+//     from a precomputed shortest path table instead of A*, which could
+//     settle on a slightly longer path. Older replays still use A*.
 
-#define DEMOVERSION 0x000D
+#define DEMOVERSION 0x000E
 
 boolean G_CompatLevel(UINT16 level)
 {
@@ -2530,6 +2534,7 @@ UINT8 G_CmpDemoTime(char *oldname, char *newname)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		break;
 	// too old, cannot support.
 	default:
@@ -2682,6 +2687,7 @@ void G_LoadDemoInfo(menudemo_t *pdemo, boolean allownonmultiplayer)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		if (P_SaveBufferRemaining(&info) < 64)
 		{
 			goto corrupt;
@@ -3112,6 +3118,7 @@ void G_DoPlayDemoEx(const char *defdemoname, lumpnum_t deflumpnum)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		break;
 	// too old, cannot support.
 	default:
@@ -3577,6 +3584,7 @@ void G_AddGhost(savebuffer_t *buffer, const char *defdemoname)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		break;
 	// too old, cannot support.
 	default:
@@ -3840,6 +3848,7 @@ staffbrief_t *G_GetStaffGhostBrief(UINT8 *buffer)
 		case 0x000A: // 2.0, 2.1
 		case 0x000B: // 2.2 indev (staff ghosts)
 		case 0x000C: // 2.2
+		case 0x000D: // 2.3
 			break;
 
 		// too old, cannot support.
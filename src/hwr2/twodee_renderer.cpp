@@ -11,6 +11,7 @@
 #include "twodee_renderer.hpp"
 
 #include <algorithm>
+#include <cfloat>
 #include <unordered_set>
 
 #include <stb_rect_pack.h>
@@ -38,11 +39,68 @@ TwodeeRenderer& TwodeeRenderer::operator=(TwodeeRenderer&&) = default;
 static constexpr const uint32_t kVboInitSize = 32768;
 static constexpr const uint32_t kIboInitSize = 4096;
 
+// Vertex buffers and the index ring hold this many frames of data before a region is rewritten.
+static constexpr const std::size_t kStreamFrames = 3;
+
+// How many batches back a command may be moved to join one with the same state. Bounds the batching cost
+// on frames with thousands of commands; HUD elements that can merge are rarely further apart than this.
+static constexpr const std::size_t kBatchLookback = 32;
+
+static constexpr const uint32_t kNoBatchCmd = UINT32_MAX;
+
 static TwodeePipelineKey pipeline_key_for_cmd(const Draw2dCmd& cmd)
 {
 	return {hwr2::get_blend_mode(cmd), hwr2::is_draw_lines(cmd)};
 }
 
+static bool same_draw_state(const MergedTwodeeCommand& a, const MergedTwodeeCommand& b) noexcept
+{
+	return a.pipeline_key == b.pipeline_key && a.texture == b.texture && a.colormap == b.colormap;
+}
+
+static bool bounds_overlap(const TwodeeBounds& a, const TwodeeBounds& b) noexcept
+{
+	// Touching edges do not overlap; rasterization never covers a pixel from both sides of a shared edge.
+	return a.xmin < b.xmax && b.xmin < a.xmax && a.ymin < b.ymax && b.ymin < a.ymax;
+}
+
+static TwodeeBounds bounds_union(const TwodeeBounds& a, const TwodeeBounds& b) noexcept
+{
+	return {std::min(a.xmin, b.xmin), std::min(a.ymin, b.ymin), std::max(a.xmax, b.xmax), std::max(a.ymax, b.ymax)};
+}
+
+static TwodeeBounds bounds_for_vertices(const Draw2dList& list, std::size_t first, std::size_t count, bool lines)
+{
+	TwodeeBounds bounds {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for (std::size_t i = first; i < first + count && i < list.vertices.size(); i++)
+	{
+		const TwodeeVertex& v = list.vertices[i];
+		bounds.xmin = std::min(bounds.xmin, v.x);
+		bounds.ymin = std::min(bounds.ymin, v.y);
+		bounds.xmax = std::max(bounds.xmax, v.x);
+		bounds.ymax = std::max(bounds.ymax, v.y);
+	}
+	if (lines)
+	{
+		// Lines are rasterized a pixel wide around their zero-area bounds
+		bounds.xmin -= 1.f;
+		bounds.ymin -= 1.f;
+		bounds.xmax += 1.f;
+		bounds.ymax += 1.f;
+	}
+	return bounds;
+}
+
+static uint32_t round_up_pow2(uint32_t size)
+{
+	uint32_t ret = 1;
+	while (ret < size)
+	{
+		ret <<= 1;
+	}
+	return ret;
+}
+
 static PipelineDesc make_pipeline_desc(TwodeePipelineKey key)
 {
 	constexpr const VertexInputDesc kTwodeeVertexInput = {
@@ -275,6 +333,167 @@ void TwodeeRenderer::initialize(Rhi& rhi, Handle<GraphicsContext> ctx)
 	initialized_ = true;
 }
 
+MergedTwodeeCommand TwodeeRenderer::draw_state_for_cmd(const Draw2dCmd& cmd) const
+{
+	MergedTwodeeCommand state;
+	state.pipeline_key = pipeline_key_for_cmd(cmd);
+
+	// Patches are converted to atlas texture indexes, which have been packed before batching.
+	// Flats are uploaded as individual textures.
+	auto tex_visitor = srb2::Overload {
+		[&](const Draw2dPatchQuad& cmd)
+		{
+			if (cmd.patch != nullptr)
+			{
+				srb2::NotNull<const PatchAtlas*> atlas = patch_atlas_cache_->find_patch(cmd.patch);
+				state.texture = atlas->texture();
+			}
+			state.colormap = cmd.colormap;
+		},
+		[&](const Draw2dVertices& cmd)
+		{
+			if (cmd.flat_lump != LUMPERROR)
+			{
+				state.texture = MergedTwodeeCommandFlatTexture {cmd.flat_lump};
+			}
+			state.colormap = nullptr;
+		}};
+	std::visit(tex_visitor, cmd);
+
+	return state;
+}
+
+void TwodeeRenderer::batch_list(Draw2dList& list)
+{
+	batch_cmds_.clear();
+	batches_.clear();
+
+	// Commands in a list occupy contiguous, ascending ranges of the list's indices.
+	uint32_t first_index = 0;
+	for (auto& cmd : list.cmds)
+	{
+		const uint32_t elements = static_cast<uint32_t>(hwr2::elements(cmd));
+		TwodeeBatchCmd bcmd;
+		bcmd.first_index = first_index;
+		bcmd.elements = elements;
+		bcmd.next = kNoBatchCmd;
+		first_index += elements;
+
+		if (elements == 0)
+		{
+			continue;
+		}
+
+		// Patch quads are clipped and trimmed to their atlas entry before their bounds are taken.
+		auto vtx_visitor = srb2::Overload {
+			[&](const Draw2dPatchQuad& cmd)
+			{
+				rewrite_patch_quad_vertices(list, cmd);
+				bcmd.bounds = bounds_for_vertices(list, cmd.begin_index, 4, false);
+			},
+			[&](const Draw2dVertices& cmd)
+			{
+				bcmd.bounds = bounds_for_vertices(list, cmd.begin_element, cmd.elements, cmd.lines);
+			}};
+		std::visit(vtx_visitor, cmd);
+		bcmd.state = draw_state_for_cmd(cmd);
+
+		stats_.cmds += 1;
+		if (batch_cmds_.empty() || !same_draw_state(batch_cmds_.back().state, bcmd.state))
+		{
+			stats_.unmerged_draws += 1;
+		}
+
+		const uint32_t cmd_index = static_cast<uint32_t>(batch_cmds_.size());
+		batch_cmds_.push_back(std::move(bcmd));
+		const TwodeeBatchCmd& added = batch_cmds_.back();
+
+		// Walk back to the most recent batch with the same state. The command may only be drawn that early if it
+		// does not overlap anything drawn by the batches in between, otherwise blending order would change.
+		std::size_t target = batches_.size();
+		const std::size_t lookback_end = batches_.size() > kBatchLookback ? batches_.size() - kBatchLookback : 0;
+		for (std::size_t b = batches_.size(); b > lookback_end; b--)
+		{
+			TwodeeBatch& batch = batches_[b - 1];
+			if (same_draw_state(batch_cmds_[batch.first].state, added.state))
+			{
+				target = b - 1;
+				break;
+			}
+			if (bounds_overlap(batch.bounds, added.bounds))
+			{
+				break;
+			}
+		}
+
+		if (target == batches_.size())
+		{
+			batches_.push_back({cmd_index, cmd_index, added.bounds});
+		}
+		else
+		{
+			TwodeeBatch& batch = batches_[target];
+			batch_cmds_[batch.last].next = cmd_index;
+			batch.last = cmd_index;
+			batch.bounds = bounds_union(batch.bounds, added.bounds);
+		}
+	}
+}
+
+Handle<Buffer> TwodeeRenderer::acquire_vbo(Rhi& rhi, std::size_t list_index, uint32_t size)
+{
+	const std::size_t slot = list_index * kStreamFrames + stream_frame_;
+	if (slot >= vbos_.size())
+	{
+		vbos_.resize(slot + 1);
+	}
+
+	// Get the existing buffer object. Recreate it if it doesn't exist, or needs to be bigger.
+	auto& [vbo, vbo_size] = vbos_[slot];
+	if (vbo == kNullHandle || size > vbo_size)
+	{
+		if (vbo != kNullHandle)
+		{
+			rhi.destroy_buffer(vbo);
+		}
+		vbo_size = round_up_pow2(std::max(kVboInitSize, size));
+		vbo = rhi.create_buffer({static_cast<uint32_t>(vbo_size), BufferType::kVertexBuffer, BufferUsage::kDynamic});
+	}
+	return vbo;
+}
+
+uint32_t TwodeeRenderer::stream_indices(Rhi& rhi, Handle<GraphicsContext> ctx)
+{
+	tcb::span<const std::byte> index_data = tcb::as_bytes(tcb::span(merged_indices_));
+	const uint32_t size = static_cast<uint32_t>(index_data.size());
+	if (size == 0)
+	{
+		return 0;
+	}
+
+	if (ibo_ == kNullHandle || size * kStreamFrames > ibo_size_)
+	{
+		if (ibo_ != kNullHandle)
+		{
+			rhi.destroy_buffer(ibo_);
+		}
+		ibo_size_ = round_up_pow2(std::max<uint32_t>(kIboInitSize, size * kStreamFrames));
+		ibo_ = rhi.create_buffer({ibo_size_, BufferType::kIndexBuffer, BufferUsage::kDynamic});
+		ibo_cursor_ = 0;
+	}
+	else if (ibo_cursor_ + size > ibo_size_)
+	{
+		ibo_cursor_ = 0;
+	}
+
+	const uint32_t offset = ibo_cursor_;
+	rhi.update_buffer(ctx, ibo_, offset, index_data);
+	// Keep each frame's range 4-byte aligned
+	ibo_cursor_ += (size + 3) & ~3u;
+
+	return offset / sizeof(uint16_t);
+}
+
 void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee)
 {
 	if (!initialized_)
@@ -311,194 +530,60 @@ void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee
 	}
 	patch_atlas_cache_->pack(rhi, ctx);
 
+	// Stage 2 - batch each list's commands by draw state and gather the batches' indices contiguously
+	stream_frame_ = (stream_frame_ + 1) % kStreamFrames;
+	merged_indices_.clear();
+
 	size_t list_index = 0;
 	for (auto& list : twodee)
 	{
-		Handle<Buffer> vbo;
-		uint32_t vertex_data_size = tcb::as_bytes(tcb::span(list.vertices)).size();
-		uint32_t needed_vbo_size = std::max(
-			kVboInitSize,
-			((static_cast<uint32_t>(vertex_data_size) + kVboInitSize - 1) / kVboInitSize) * kVboInitSize
-		);
+		batch_list(list);
 
-		// Get the existing buffer objects. Recreate them if they don't exist, or needs to be bigger.
-
-		if (list_index >= vbos_.size())
-		{
-			vbo = rhi.create_buffer({needed_vbo_size, BufferType::kVertexBuffer, BufferUsage::kDynamic});
-			vbos_.push_back({vbo, needed_vbo_size});
-		}
-		else
-		{
-			uint32_t existing_size = std::get<1>(vbos_[list_index]);
-			if (needed_vbo_size > existing_size)
-			{
-				rhi.destroy_buffer(std::get<0>(vbos_[list_index]));
-				vbo = rhi.create_buffer({needed_vbo_size, BufferType::kVertexBuffer, BufferUsage::kDynamic});
-				vbos_[list_index] = {vbo, needed_vbo_size};
-			}
-			vbo = std::get<0>(vbos_[list_index]);
-		}
-
-		Handle<Buffer> ibo;
-		uint32_t index_data_size = tcb::as_bytes(tcb::span(list.indices)).size();
-		uint32_t needed_ibo_size = std::max(
-			kIboInitSize,
-			((static_cast<uint32_t>(index_data_size) + kIboInitSize - 1) / kIboInitSize) * kIboInitSize
-		);
-
-		if (list_index >= ibos_.size())
-		{
-			ibo = rhi.create_buffer({needed_ibo_size, BufferType::kIndexBuffer, BufferUsage::kDynamic});
-			ibos_.push_back({ibo, needed_ibo_size});
-		}
-		else
-		{
-			uint32_t existing_size = std::get<1>(ibos_[list_index]);
-			if (needed_ibo_size > existing_size)
-			{
-				rhi.destroy_buffer(std::get<0>(ibos_[list_index]));
-				ibo = rhi.create_buffer({needed_ibo_size, BufferType::kIndexBuffer, BufferUsage::kDynamic});
-				ibos_[list_index] = {ibo, needed_ibo_size};
-			}
-			ibo = std::get<0>(ibos_[list_index]);
-		}
+		uint32_t vertex_data_size = tcb::as_bytes(tcb::span(list.vertices)).size();
 
-		// Create a merged command list
 		MergedTwodeeCommandList merged_list;
-		merged_list.vbo = vbo;
-		merged_list.vbo_size = needed_vbo_size;
-		merged_list.ibo = ibo;
-		merged_list.ibo_size = needed_ibo_size;
-
-		MergedTwodeeCommand new_cmd;
-		new_cmd.index_offset = 0;
-		new_cmd.elements = 0;
-		new_cmd.colormap = nullptr;
-		// safety: a command list is required to have at least 1 command
-		new_cmd.pipeline_key = pipeline_key_for_cmd(list.cmds[0]);
-		merged_list.cmds.push_back(std::move(new_cmd));
+		merged_list.vbo = acquire_vbo(rhi, list_index, vertex_data_size);
+		merged_list.vbo_size = std::get<1>(vbos_[list_index * kStreamFrames + stream_frame_]);
 
-		for (auto& cmd : list.cmds)
+		for (auto& batch : batches_)
 		{
-			auto& merged_cmd = *merged_list.cmds.rbegin();
-			bool new_cmd_needed = false;
-			TwodeePipelineKey pk = pipeline_key_for_cmd(cmd);
-			new_cmd_needed = new_cmd_needed || (pk != merged_cmd.pipeline_key);
-
-			// We need to split the merged commands based on the kind of texture
-			// Patches are converted to atlas texture indexes, which we've just packed the patch rects for
-			// Flats are uploaded as individual textures.
-			auto tex_visitor = srb2::Overload {
-				[&](const Draw2dPatchQuad& cmd)
-				{
-					if (cmd.patch == nullptr)
-					{
-						new_cmd_needed = new_cmd_needed || (merged_cmd.texture != std::nullopt);
-					}
-					else
-					{
-						srb2::NotNull<const PatchAtlas*> atlas = patch_atlas_cache_->find_patch(cmd.patch);
-						std::optional<MergedTwodeeCommand::Texture> atlas_index_texture = atlas->texture();
-						new_cmd_needed = new_cmd_needed || (merged_cmd.texture != atlas_index_texture);
-					}
-
-					new_cmd_needed = new_cmd_needed || (merged_cmd.colormap != cmd.colormap);
-				},
-				[&](const Draw2dVertices& cmd)
-				{
-					if (cmd.flat_lump == LUMPERROR)
-					{
-						new_cmd_needed |= (merged_cmd.texture != std::nullopt);
-					}
-					else
-					{
-						std::optional<MergedTwodeeCommand::Texture> flat_tex = MergedTwodeeCommandFlatTexture {cmd.flat_lump};
-						new_cmd_needed |= (merged_cmd.texture != flat_tex);
-					}
-
-					new_cmd_needed = new_cmd_needed || (merged_cmd.colormap != nullptr);
-				}};
-			std::visit(tex_visitor, cmd);
-
-			if (new_cmd_needed)
+			MergedTwodeeCommand merged_cmd = batch_cmds_[batch.first].state;
+			merged_cmd.index_offset = static_cast<uint32_t>(merged_indices_.size());
+			for (uint32_t c = batch.first; c != kNoBatchCmd; c = batch_cmds_[c].next)
 			{
-				MergedTwodeeCommand the_new_one;
-				the_new_one.index_offset = merged_cmd.index_offset + merged_cmd.elements;
-
-				// Map to the merged version of the texture variant. Yay...!
-				auto tex_visitor_again = srb2::Overload {
-					[&](const Draw2dPatchQuad& cmd)
-					{
-						if (cmd.patch != nullptr)
-						{
-							srb2::NotNull<const PatchAtlas*> atlas = patch_atlas_cache_->find_patch(cmd.patch);
-							the_new_one.texture = atlas->texture();
-						}
-						else
-						{
-							the_new_one.texture = std::nullopt;
-						}
-						the_new_one.colormap = cmd.colormap;
-					},
-					[&](const Draw2dVertices& cmd)
-					{
-						if (cmd.flat_lump != LUMPERROR)
-						{
-							flat_manager_->find_or_create_indexed(rhi, ctx, cmd.flat_lump);
-							std::optional<MergedTwodeeCommand::Texture> t = MergedTwodeeCommandFlatTexture {cmd.flat_lump};
-							the_new_one.texture = t;
-						}
-						else
-						{
-							the_new_one.texture = std::nullopt;
-						}
-
-						the_new_one.colormap = nullptr;
-					}};
-				std::visit(tex_visitor_again, cmd);
-				the_new_one.pipeline_key = pipeline_key_for_cmd(cmd);
-				merged_list.cmds.push_back(std::move(the_new_one));
-			}
-
-			// There may or may not be a new current command; update its element count
-			auto& new_merged_cmd = *merged_list.cmds.rbegin();
-			// We know for sure that all commands in a command list have a contiguous range of elements in the IBO
-			// So we can draw them in batch if the pipeline key and textures match
-			new_merged_cmd.elements += hwr2::elements(cmd);
-
-			// Perform coordinate transformations
-			{
-				auto vtx_transform_visitor = srb2::Overload {
-					[&](const Draw2dPatchQuad& cmd) { rewrite_patch_quad_vertices(list, cmd); },
-					[&](const Draw2dVertices& cmd) {}};
-				std::visit(vtx_transform_visitor, cmd);
+				auto first = list.indices.begin() + batch_cmds_[c].first_index;
+				merged_indices_.insert(merged_indices_.end(), first, first + batch_cmds_[c].elements);
 			}
+			merged_cmd.elements = static_cast<uint32_t>(merged_indices_.size()) - merged_cmd.index_offset;
+			merged_list.cmds.push_back(std::move(merged_cmd));
 		}
 
 		cmd_lists_.push_back(std::move(merged_list));
-
 		list_index++;
 	}
 
 	Handle<Texture> palette_tex = palette_manager_->palette();
 
 	// Update the buffers for each list
+	const uint32_t index_base = stream_indices(rhi, ctx);
 	auto ctx_list_itr = twodee.begin();
 	for (size_t i = 0; i < cmd_lists_.size() && ctx_list_itr != twodee.end(); i++)
 	{
 		auto& merged_list = cmd_lists_[i];
 		auto& orig_list = *ctx_list_itr;
 
+		merged_list.ibo = ibo_;
+		merged_list.ibo_size = ibo_size_;
+
 		tcb::span<const std::byte> vertex_data = tcb::as_bytes(tcb::span(orig_list.vertices));
-		tcb::span<const std::byte> index_data = tcb::as_bytes(tcb::span(orig_list.indices));
 		rhi.update_buffer(ctx, merged_list.vbo, 0, vertex_data);
-		rhi.update_buffer(ctx, merged_list.ibo, 0, index_data);
 
 		// Update the binding sets for each individual merged command
 		VertexAttributeBufferBinding vbos[] = {{0, merged_list.vbo}};
 		for (auto& mcmd : merged_list.cmds)
 		{
+			mcmd.index_offset += index_base;
+
 			TextureBinding tx[3];
 			auto tex_visitor = srb2::Overload {
 				[&](Handle<Texture> texture)
@@ -531,6 +616,7 @@ void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee
 				SRB2_ASSERT(colormap_h != kNullHandle);
 			}
 			tx[2] = {SamplerName::kSampler2, colormap_h};
+
 			mcmd.binding_set =
 				rhi.create_binding_set(ctx, pipelines_[mcmd.pipeline_key], {tcb::span(vbos), tcb::span(tx)});
 		}
@@ -560,6 +646,10 @@ void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee
 	Handle<UniformSet> us_2 = rhi.create_uniform_set(ctx, {tcb::span(g2_uniforms)});
 
 	// Presumably, we're already in a renderpass when flush is called
+	// Only rebind what changed between draws. A pipeline change invalidates the uniform and binding sets, and
+	// binding a binding set unbinds the index buffer.
+	std::optional<TwodeePipelineKey> bound_pipeline;
+	Handle<BindingSet> bound_binding_set;
 	for (auto& list : cmd_lists_)
 	{
 		for (auto& cmd : list.cmds)
@@ -570,15 +660,26 @@ void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee
 				// This shouldn't happen, but, just in case...
 				continue;
 			}
-			SRB2_ASSERT(pipelines_.find(cmd.pipeline_key) != pipelines_.end());
-			Handle<Pipeline> pl = pipelines_[cmd.pipeline_key];
-			rhi.bind_pipeline(ctx, pl);
-			rhi.set_viewport(ctx, {0, 0, static_cast<uint32_t>(vid.width), static_cast<uint32_t>(vid.height)});
-			rhi.bind_uniform_set(ctx, 0, us_1);
-			rhi.bind_uniform_set(ctx, 1, us_2);
-			rhi.bind_binding_set(ctx, cmd.binding_set);
-			rhi.bind_index_buffer(ctx, list.ibo);
+
+			if (bound_pipeline != cmd.pipeline_key)
+			{
+				SRB2_ASSERT(pipelines_.find(cmd.pipeline_key) != pipelines_.end());
+				Handle<Pipeline> pl = pipelines_[cmd.pipeline_key];
+				rhi.bind_pipeline(ctx, pl);
+				rhi.set_viewport(ctx, {0, 0, static_cast<uint32_t>(vid.width), static_cast<uint32_t>(vid.height)});
+				rhi.bind_uniform_set(ctx, 0, us_1);
+				rhi.bind_uniform_set(ctx, 1, us_2);
+				bound_pipeline = cmd.pipeline_key;
+				bound_binding_set = kNullHandle;
+			}
+			if (bound_binding_set != cmd.binding_set)
+			{
+				rhi.bind_binding_set(ctx, cmd.binding_set);
+				rhi.bind_index_buffer(ctx, list.ibo);
+				bound_binding_set = cmd.binding_set;
+			}
 			rhi.draw_indexed(ctx, cmd.elements, cmd.index_offset);
+			stats_.draws += 1;
 		}
 	}
 
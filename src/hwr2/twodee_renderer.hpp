@@ -68,7 +68,7 @@ struct MergedTwodeeCommand
 	TwodeePipelineKey pipeline_key = {};
 	rhi::Handle<rhi::BindingSet> binding_set = {};
 	std::optional<Texture> texture;
-	const uint8_t* colormap;
+	const uint8_t* colormap = nullptr;
 	uint32_t index_offset = 0;
 	uint32_t elements = 0;
 };
@@ -83,6 +83,43 @@ struct MergedTwodeeCommandList
 	std::vector<MergedTwodeeCommand> cmds;
 };
 
+/// @brief Screen-space bounding box of a command, used to decide whether two commands may be reordered.
+struct TwodeeBounds
+{
+	float xmin;
+	float ymin;
+	float xmax;
+	float ymax;
+};
+
+/// @brief A Draw2dCmd reduced to what the batcher needs: its draw state and its range in the list's indices.
+struct TwodeeBatchCmd
+{
+	MergedTwodeeCommand state;
+	TwodeeBounds bounds;
+	uint32_t first_index;
+	uint32_t elements;
+	uint32_t next; // next command in the same batch, or UINT32_MAX
+};
+
+/// @brief A run of commands sharing one draw state, drawn with a single draw call.
+struct TwodeeBatch
+{
+	uint32_t first;
+	uint32_t last;
+	TwodeeBounds bounds;
+};
+
+struct TwodeeRendererStats
+{
+	/// @brief Draw2dCmds submitted.
+	uint32_t cmds = 0;
+	/// @brief Draws issued if only adjacent commands with the same state were merged.
+	uint32_t unmerged_draws = 0;
+	/// @brief Draws actually issued after batching.
+	uint32_t draws = 0;
+};
+
 class TwodeeRenderer final
 {
 	bool initialized_ = false;
@@ -92,14 +129,30 @@ class TwodeeRenderer final
 	FlatTextureManager* flat_manager_;
 	PatchAtlasCache* patch_atlas_cache_;
 	std::vector<MergedTwodeeCommandList> cmd_lists_;
+	std::vector<TwodeeBatchCmd> batch_cmds_;
+	std::vector<TwodeeBatch> batches_;
+	std::vector<uint16_t> merged_indices_;
+
+	// Vertex buffers are rotated between frames per list so a buffer is not rewritten while still in flight.
+	// Indices for every list are streamed into one ring buffer.
 	std::vector<std::tuple<rhi::Handle<rhi::Buffer>, std::size_t>> vbos_;
-	std::vector<std::tuple<rhi::Handle<rhi::Buffer>, std::size_t>> ibos_;
+	rhi::Handle<rhi::Buffer> ibo_;
+	uint32_t ibo_size_ = 0;
+	uint32_t ibo_cursor_ = 0;
+	std::size_t stream_frame_ = 0;
+
+	TwodeeRendererStats stats_;
 	rhi::Handle<rhi::RenderPass> render_pass_;
 	rhi::Handle<rhi::Texture> output_;
 	rhi::Handle<rhi::Texture> default_tex_;
 	std::unordered_map<TwodeePipelineKey, rhi::Handle<rhi::Pipeline>> pipelines_;
 
 	void rewrite_patch_quad_vertices(Draw2dList& list, const Draw2dPatchQuad& cmd) const;
+	MergedTwodeeCommand draw_state_for_cmd(const Draw2dCmd& cmd) const;
+	void batch_list(Draw2dList& list);
+
+	rhi::Handle<rhi::Buffer> acquire_vbo(rhi::Rhi& rhi, std::size_t list_index, uint32_t size);
+	uint32_t stream_indices(rhi::Rhi& rhi, rhi::Handle<rhi::GraphicsContext> ctx);
 
 	void initialize(rhi::Rhi& rhi, rhi::Handle<rhi::GraphicsContext> ctx);
 
@@ -119,6 +172,10 @@ public:
 	/// @param rhi
 	/// @param ctx
 	void flush(rhi::Rhi& rhi, rhi::Handle<rhi::GraphicsContext> ctx, Twodee& twodee);
+
+	/// @brief Counters accumulated by every flush since the last reset.
+	const TwodeeRendererStats& stats() const noexcept { return stats_; }
+	void reset_stats() noexcept { stats_ = {}; }
 };
 
 } // namespace srb2::hwr2
@@ -56,6 +56,13 @@ void I_StartupSound(void);
 */
 void I_ShutdownSound(void);
 
+/**	\brief Debug command: sfxmix_bench [channels] [seconds]
+
+	Mixes synthetic sound effects through a sound effect mixer of its own,
+	without an audio device, and reports the time taken per sample.
+*/
+void Command_SfxMixBench_f(void);
+
 /** \brief Update instance of AVRecorder for audio capture.
 */
 void I_UpdateAudioRecorder(void);
@@ -171,6 +171,15 @@ UINT32 I_GetRefreshRate(void);
 
 void I_CaptureVideoFrame(void);
 
+/**	\brief Debug command: twodee_bench [frames] [capture]
+
+	Captures the next capture 2D frames and replays them frames times through
+	the 2D renderer against the null RHI backend, reporting CPU time, draw calls
+	and uploads per frame. Runs headless with -nullrhi, which installs the null
+	RHI as the system RHI instead of creating a window and GL context.
+*/
+void Command_TwodeeBench_f(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
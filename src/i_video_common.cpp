@@ -12,12 +12,14 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <vector>
 
 #include <imgui.h>
 #include <tracy/tracy/Tracy.hpp>
 
 #include "command.h"
+#include "console.h"
 #include "cxxutil.hpp"
 #include "f_finale.h"
 #include "m_fixed.h"
@@ -25,6 +27,8 @@
 #include "hwr2/hardware_state.hpp"
 #include "hwr2/patch_atlas.hpp"
 #include "hwr2/twodee.hpp"
+#include "r_main.h"
+#include "rhi/null/null_rhi.hpp"
 #include "v_video.h"
 
 // KILL THIS WHEN WE KILL OLD OGL SUPPORT PLEASE
@@ -174,6 +178,16 @@ static void new_twodee_frame()
 {
 	g_2d = Twodee();
 	Patch_ResetFreedThisFrame();
+
+	// Publish the previous frame's 2D batching counters; the overlay is drawn before this frame flushes.
+	if (g_hw_state.twodee_renderer)
+	{
+		const TwodeeRendererStats& stats = g_hw_state.twodee_renderer->stats();
+		ps_2d_numcmds = stats.cmds;
+		ps_2d_numunmerged = stats.unmerged_draws;
+		ps_2d_numdraws = stats.draws;
+		g_hw_state.twodee_renderer->reset_stats();
+	}
 }
 
 static void new_imgui_frame()
@@ -210,6 +224,152 @@ void I_CaptureVideoFrame()
 	hw_state->screen_capture->capture(*rhi, ctx);
 }
 
+// twodee_bench: capture real 2D frames from I_FinishUpdate, then replay them through a private TwodeeRenderer
+// against the null backend so only the CPU side of 2D submission is measured.
+static size_t g_twodee_bench_frames = 0;
+static size_t g_twodee_bench_capture = 0;
+static std::vector<Twodee> g_twodee_bench_captured;
+
+static void run_twodee_bench(const std::vector<Twodee>& captured, size_t frames)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const uint32_t width = static_cast<uint32_t>(vid.width);
+	const uint32_t height = static_cast<uint32_t>(vid.height);
+
+	NullRhi rhi {width, height};
+	PaletteManager palette_manager;
+	FlatTextureManager flat_manager;
+	PatchAtlasCache patch_atlas_cache {2048, 3};
+	TwodeeRenderer twodee_renderer {&palette_manager, &flat_manager, &patch_atlas_cache};
+
+	RenderPassDesc pass_desc {};
+	pass_desc.use_depth_stencil = false;
+	pass_desc.color_load_op = AttachmentLoadOp::kClear;
+	pass_desc.color_store_op = AttachmentStoreOp::kStore;
+	pass_desc.depth_load_op = AttachmentLoadOp::kDontCare;
+	pass_desc.depth_store_op = AttachmentStoreOp::kDontCare;
+	pass_desc.stencil_load_op = AttachmentLoadOp::kDontCare;
+	pass_desc.stencil_store_op = AttachmentStoreOp::kDontCare;
+	Handle<RenderPass> pass = rhi.create_render_pass(pass_desc);
+	Handle<Texture> target = rhi.create_texture({
+		TextureFormat::kRGBA,
+		width,
+		height,
+		TextureWrapMode::kClamp,
+		TextureWrapMode::kClamp,
+		TextureFilterMode::kNearest,
+		TextureFilterMode::kNearest
+	});
+
+	// Flushing consumes the Twodee, so each replay works on a copy made outside the timed region.
+	auto replay = [&](const Twodee& frame) -> Clock::duration
+	{
+		Twodee twodee = frame;
+		auto start = Clock::now();
+		Handle<GraphicsContext> ctx = rhi.begin_graphics();
+		palette_manager.update(rhi, ctx);
+		rhi.begin_render_pass(ctx, {pass, target, std::nullopt, glm::vec4(0.f, 0.f, 0.f, 1.f)});
+		twodee_renderer.flush(rhi, ctx, twodee);
+		rhi.end_render_pass(ctx);
+		rhi.end_graphics(ctx);
+		palette_manager.destroy_per_frame_resources(rhi);
+		rhi.finish();
+		return Clock::now() - start;
+	};
+
+	// The first pass over the captured frames creates the pipelines and fills the patch atlas.
+	Clock::duration warmup {};
+	for (const Twodee& frame : captured)
+	{
+		warmup += replay(frame);
+	}
+	const NullRhiStats cold = rhi.stats();
+
+	rhi.reset_stats();
+	twodee_renderer.reset_stats();
+	rhi.set_recording(true);
+	Clock::duration total {};
+	Clock::duration worst {};
+	for (size_t f = 0; f < frames; f++)
+	{
+		Clock::duration elapsed = replay(captured[f % captured.size()]);
+		total += elapsed;
+		worst = std::max(worst, elapsed);
+	}
+	rhi.set_recording(false);
+	const NullRhiStats& warm = rhi.stats();
+
+	auto to_us = [](Clock::duration d) { return std::chrono::duration_cast<std::chrono::microseconds>(d).count(); };
+	auto per_frame = [frames](uint64_t n) { return static_cast<double>(n) / frames; };
+
+	CONS_Printf("twodee_bench: %s captured frames replayed %s times at %sx%s\n",
+		sizeu1(captured.size()), sizeu2(frames), sizeu3(width), sizeu4(height));
+	CONS_Printf("  first pass: %lld us/frame, %u textures uploaded (%llu KiB), %u resources created\n",
+		static_cast<long long>(to_us(warmup) / static_cast<long long>(captured.size())),
+		cold.texture_uploads,
+		static_cast<unsigned long long>(cold.texture_upload_bytes / 1024),
+		cold.resources_created);
+	CONS_Printf("  cpu time:   %lld us/frame, %lld us worst\n",
+		static_cast<long long>(to_us(total) / static_cast<long long>(frames)),
+		static_cast<long long>(to_us(worst)));
+	CONS_Printf("  draws:      %.1f/frame (%.0f elements), %.1f pipeline binds (%.1f changes)\n",
+		per_frame(warm.draws), per_frame(warm.elements), per_frame(warm.pipeline_binds), per_frame(warm.pipeline_changes));
+	CONS_Printf("  batching:   %.1f commands, %.1f draws unmerged, %.1f draws merged per frame\n",
+		per_frame(twodee_renderer.stats().cmds),
+		per_frame(twodee_renderer.stats().unmerged_draws),
+		per_frame(twodee_renderer.stats().draws));
+	CONS_Printf("  bindings:   %.1f binding sets, %.1f uniform sets, %.1f index buffers per frame\n",
+		per_frame(warm.binding_set_binds), per_frame(warm.uniform_set_binds), per_frame(warm.index_buffer_binds));
+	CONS_Printf("  uploads:    %.1f textures (%.1f KiB), %.1f buffers (%.1f KiB) per frame\n",
+		per_frame(warm.texture_uploads), per_frame(warm.texture_upload_bytes) / 1024.0,
+		per_frame(warm.buffer_uploads), per_frame(warm.buffer_upload_bytes) / 1024.0);
+	CONS_Printf("  commands:   %.1f per frame\n", per_frame(rhi.log().size()));
+
+	if (cold.validation_errors + warm.validation_errors > 0)
+	{
+		CONS_Alert(CONS_WARNING, "twodee_bench: %u validation errors\n", cold.validation_errors + warm.validation_errors);
+		for (const std::string& message : rhi.validation_messages())
+		{
+			CONS_Printf("  %s\n", message.c_str());
+		}
+	}
+}
+
+void Command_TwodeeBench_f(void)
+{
+	if (rendermode != render_soft || sys::get_rhi(sys::g_current_rhi) == nullptr)
+	{
+		CONS_Printf("twodee_bench: only available in the software renderer (use -nullrhi to run without a window)\n");
+		return;
+	}
+
+	g_twodee_bench_frames = COM_Argc() > 1 ? std::max(1, atoi(COM_Argv(1))) : 1000;
+	g_twodee_bench_capture = COM_Argc() > 2 ? std::max(1, atoi(COM_Argv(2))) : 35;
+	g_twodee_bench_captured.clear();
+	g_twodee_bench_captured.reserve(g_twodee_bench_capture);
+	CONS_Printf("twodee_bench: capturing the next %s frames\n", sizeu1(g_twodee_bench_capture));
+}
+
+static void twodee_bench_capture(const Twodee& twodee)
+{
+	if (g_twodee_bench_capture == 0)
+	{
+		return;
+	}
+
+	g_twodee_bench_captured.push_back(twodee);
+	if (g_twodee_bench_captured.size() < g_twodee_bench_capture)
+	{
+		return;
+	}
+
+	run_twodee_bench(g_twodee_bench_captured, g_twodee_bench_frames);
+	g_twodee_bench_capture = 0;
+	g_twodee_bench_captured.clear();
+	g_twodee_bench_captured.shrink_to_fit();
+}
+
 void I_StartDisplayUpdate(void)
 {
 	if (rendermode == render_none)
@@ -281,6 +441,8 @@ void I_FinishUpdate(void)
 
 	if (ctx != kNullHandle)
 	{
+		twodee_bench_capture(g_2d);
+
 		// better hope the drawing code left the context in a render pass, I guess
 		g_hw_state.twodee_renderer->flush(*rhi, ctx, g_2d);
 		rhi->end_render_pass(ctx);
@@ -394,7 +394,7 @@ boolean K_BHeapPush(bheap_t *const heap, void *const item, UINT32 value, updatei
 		if (heap->count >= heap->capacity)
 		{
 			size_t newarraycapacity = heap->capacity * 2;
-			heap->array = Z_Realloc(heap->array, newarraycapacity, PU_STATIC, NULL);
+			heap->array = Z_Realloc(heap->array, newarraycapacity * sizeof(bheapitem_t), PU_STATIC, NULL);
 
 			if (heap->array == NULL)
 			{
@@ -574,6 +574,32 @@ size_t K_BHeapContains(bheap_t *const heap, void *const data, size_t index)
 	return heapindexwithdata;
 }
 
+/*--------------------------------------------------
+	boolean K_BHeapClear(bheap_t *const heap)
+
+		See header file for description.
+--------------------------------------------------*/
+boolean K_BHeapClear(bheap_t *const heap)
+{
+	boolean clearsuccess = false;
+
+	if (heap == NULL)
+	{
+		CONS_Debug(DBG_GAMELOGIC, "NULL heap in K_BHeapClear.\n");
+	}
+	else if (!K_BHeapValid(heap))
+	{
+		CONS_Debug(DBG_GAMELOGIC, "Uninitialised heap in K_BHeapClear.\n");
+	}
+	else
+	{
+		heap->count  = 0U;
+		clearsuccess = true;
+	}
+
+	return clearsuccess;
+}
+
 boolean K_BHeapFree(bheap_t *const heap)
 {
 	boolean freesuccess = false;
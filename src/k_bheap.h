@@ -139,6 +139,21 @@ boolean K_UpdateBHeapItemValue(bheapitem_t *const item, const UINT32 newvalue);
 size_t K_BHeapContains(bheap_t *const heap, void *const data, size_t index);
 
 
+/*--------------------------------------------------
+	boolean K_BHeapClear(bheap_t *const heap)
+
+		Removes every item from the binary heap, keeping its memory to be filled again.
+
+	Input Arguments:-
+		heap - The heap to clear
+
+	Return:-
+		True if the heap was cleared successfully, false if the heap wasn't valid
+--------------------------------------------------*/
+
+boolean K_BHeapClear(bheap_t *const heap);
+
+
 /*--------------------------------------------------
 	boolean K_BHeapFree(bheap_t *const heap)
 
@@ -15,11 +15,26 @@
 #include "doomdef.h"
 #include "z_zone.h"
 #include "k_bheap.h"
+#include "core/memory.h"
 
 static const size_t DEFAULT_NODEARRAY_CAPACITY = 8U;
 static const size_t DEFAULT_OPENSET_CAPACITY   = 8U;
 static const size_t DEFAULT_CLOSEDSET_CAPACITY = 8U;
 
+// A node of an indexed search, kept at the index of its node data.
+// It is only part of the current search if seen matches pathfindgeneration.
+typedef struct
+{
+	pathfindnode_t node;
+	UINT32         seen;
+	boolean        closed;
+} pathfindslot_t;
+
+static pathfindslot_t *pathfindslots     = NULL;
+static size_t         numpathfindslots   = 0U;
+static UINT32         pathfindgeneration = 0U;
+static bheap_t        pathfindopenset    = {0};
+
 
 /*--------------------------------------------------
 	static UINT32 K_NodeGetFScore(const pathfindnode_t *const node)
@@ -232,7 +247,11 @@ static boolean K_ReconstructPath(path_t *const path, pathfindnode_t *const desti
 		// If the path we're placing our new path into already has data, free it
 		if (path->array != NULL)
 		{
-			Z_Free(path->array);
+			if (path->scoped == false)
+			{
+				Z_Free(path->array);
+			}
+			path->array = NULL;
 			path->numnodes = 0U;
 			path->totaldist = 0U;
 		}
@@ -247,7 +266,14 @@ static boolean K_ReconstructPath(path_t *const path, pathfindnode_t *const desti
 		{
 			// Allocate memory for the path
 			path->numnodes  = numnodes;
-			path->array     = Z_Calloc(numnodes * sizeof(pathfindnode_t), PU_STATIC, NULL);
+			if (path->scoped == true)
+			{
+				path->array = Z_Arena_Alloc(numnodes * sizeof(pathfindnode_t));
+			}
+			else
+			{
+				path->array = Z_Calloc(numnodes * sizeof(pathfindnode_t), PU_STATIC, NULL);
+			}
 			path->totaldist = destinationnode->gscore;
 			if (path->array == NULL)
 			{
@@ -278,6 +304,204 @@ static boolean K_ReconstructPath(path_t *const path, pathfindnode_t *const desti
 	return reconstructsuccess;
 }
 
+/*--------------------------------------------------
+	static boolean K_PathfindAStarIndexed(path_t *const path, pathfindsetup_t *const pathfindsetup)
+
+		A* using the dense node indices from pathfindsetup->getnodeindex. Every node lives in the slot at its index,
+		so finding a node or checking the closed set is a single lookup. The slots and the openset are kept between
+		searches so nothing is allocated per search, and starting a new generation clears every slot at once.
+
+	Input Arguments:-
+		path          - The return location of the found path
+		pathfindsetup - The information regarding pathfinding setup, see pathfindsetup_t
+
+	Return:-
+		True if a path was found, false if it wasn't.
+--------------------------------------------------*/
+static boolean K_PathfindAStarIndexed(path_t *const path, pathfindsetup_t *const pathfindsetup)
+{
+	boolean        pathfindsuccess         = false;
+	pathfindnode_t startnode               = {0};
+	pathfindslot_t *slot                   = NULL;
+	pathfindnode_t *currentnode            = NULL;
+	pathfindnode_t *connectingnode         = NULL;
+	bheapitem_t    poppedbheapitem         = {0};
+	void           **connectingnodesdata   = NULL;
+	void           *checknodedata          = NULL;
+	UINT32         *connectingnodecosts    = NULL;
+	size_t         numconnectingnodes      = 0U;
+	size_t         connectingnodeheapindex = 0U;
+	size_t         nodeindex               = 0U;
+	size_t         i                       = 0U;
+	UINT32         tentativegscore         = 0U;
+
+	// Grow the slots to fit the graph
+	if (pathfindsetup->numnodeindices > numpathfindslots)
+	{
+		pathfindslots = Z_Realloc(pathfindslots, pathfindsetup->numnodeindices * sizeof(pathfindslot_t), PU_STATIC, NULL);
+		if (pathfindslots == NULL)
+		{
+			I_Error("K_PathfindAStar: Out of memory allocating node slots.");
+		}
+		memset(&pathfindslots[numpathfindslots], 0,
+			(pathfindsetup->numnodeindices - numpathfindslots) * sizeof(pathfindslot_t));
+		numpathfindslots = pathfindsetup->numnodeindices;
+	}
+
+	if (pathfindopenset.array == NULL)
+	{
+		if (pathfindsetup->opensetcapacity == 0U)
+		{
+			pathfindsetup->opensetcapacity = DEFAULT_OPENSET_CAPACITY;
+		}
+		K_BHeapInit(&pathfindopenset, pathfindsetup->opensetcapacity);
+	}
+	else
+	{
+		K_BHeapClear(&pathfindopenset);
+	}
+
+	// Slots stamped by any earlier search are now unseen
+	pathfindgeneration++;
+	if (pathfindgeneration == 0U)
+	{
+		// Wrapped around, so very old stamps could match again
+		memset(pathfindslots, 0, numpathfindslots * sizeof(pathfindslot_t));
+		pathfindgeneration = 1U;
+	}
+
+	// Create the first node and add it to the open set, the start can be outside of the graph
+	nodeindex = pathfindsetup->getnodeindex(pathfindsetup->startnodedata);
+	if (nodeindex < pathfindsetup->numnodeindices)
+	{
+		slot         = &pathfindslots[nodeindex];
+		slot->seen   = pathfindgeneration;
+		slot->closed = false;
+		currentnode  = &slot->node;
+	}
+	else
+	{
+		currentnode = &startnode;
+	}
+
+	currentnode->heapindex = SIZE_MAX;
+	currentnode->nodedata  = pathfindsetup->startnodedata;
+	currentnode->camefrom  = NULL;
+	currentnode->gscore    = 0U;
+	currentnode->hscore    = pathfindsetup->getheuristic(currentnode->nodedata, pathfindsetup->endnodedata);
+	K_BHeapPush(&pathfindopenset, currentnode, K_NodeGetFScore(currentnode), K_NodeUpdateHeapIndex);
+
+	while (pathfindopenset.count > 0U)
+	{
+		// pop the best node off of the openset
+		K_BHeapPop(&pathfindopenset, &poppedbheapitem);
+		currentnode = (pathfindnode_t*)poppedbheapitem.data;
+
+		if (pathfindsetup->getfinished(currentnode, pathfindsetup) == true)
+		{
+			pathfindsuccess = K_ReconstructPath(path, currentnode);
+			break;
+		}
+
+		// Place the node we just popped into the closed set, a start outside of the graph can't be reached again
+		if (currentnode != &startnode)
+		{
+			((pathfindslot_t *)currentnode)->closed = true;
+		}
+
+		// Get the needed data for the next nodes from the current node
+		connectingnodesdata = pathfindsetup->getconnectednodes(currentnode->nodedata, &numconnectingnodes);
+		connectingnodecosts = pathfindsetup->getconnectioncosts(currentnode->nodedata);
+
+		if (connectingnodesdata == NULL)
+		{
+			CONS_Debug(DBG_GAMELOGIC, "K_PathfindAStar: A Node returned NULL connecting node data.\n");
+			continue;
+		}
+		else if (connectingnodecosts == NULL)
+		{
+			CONS_Debug(DBG_GAMELOGIC, "K_PathfindAStar: A Node returned NULL connecting node costs.\n");
+			continue;
+		}
+
+		for (i = 0; i < numconnectingnodes; i++)
+		{
+			checknodedata = connectingnodesdata[i];
+
+			if (checknodedata == NULL)
+			{
+				CONS_Debug(DBG_GAMELOGIC, "K_PathfindAStar: A Node has a NULL connecting node.\n");
+				continue;
+			}
+
+			// skip this node if it isn't traversable
+			if (pathfindsetup->gettraversable(checknodedata, currentnode->nodedata) == false)
+			{
+				continue;
+			}
+
+			nodeindex = pathfindsetup->getnodeindex(checknodedata);
+			if (nodeindex >= pathfindsetup->numnodeindices)
+			{
+				CONS_Debug(DBG_GAMELOGIC, "K_PathfindAStar: A Node has no index in the graph.\n");
+				continue;
+			}
+
+			// Figure out what the gscore of this route for the connecting node is
+			tentativegscore = currentnode->gscore + connectingnodecosts[i];
+
+			slot           = &pathfindslots[nodeindex];
+			connectingnode = &slot->node;
+
+			if (slot->seen == pathfindgeneration)
+			{
+				// The connecting node has been seen before, so it must be in either the closedset (skip it)
+				// or the openset (re-evaluate it's gscore)
+				if (slot->closed == true)
+				{
+					continue;
+				}
+				else if (tentativegscore < connectingnode->gscore)
+				{
+					connectingnode->gscore   = tentativegscore;
+					connectingnode->camefrom = currentnode;
+
+					connectingnodeheapindex =
+						K_BHeapContains(&pathfindopenset, connectingnode, connectingnode->heapindex);
+					if (connectingnodeheapindex != SIZE_MAX)
+					{
+						K_UpdateBHeapItemValue(
+							&pathfindopenset.array[connectingnodeheapindex], K_NodeGetFScore(connectingnode));
+					}
+					else
+					{
+						// SOMEHOW the node is not in either the closed set OR the open set
+						CONS_Debug(DBG_GAMELOGIC, "K_PathfindAStar: A Node is not in either set.\n");
+					}
+				}
+			}
+			else
+			{
+				// Node hasn't been seen so far in this search
+				slot->seen   = pathfindgeneration;
+				slot->closed = false;
+
+				connectingnode->heapindex = SIZE_MAX;
+				connectingnode->nodedata  = checknodedata;
+				connectingnode->camefrom  = currentnode;
+				connectingnode->gscore    = tentativegscore;
+				connectingnode->hscore    = pathfindsetup->getheuristic(checknodedata, pathfindsetup->endnodedata);
+				K_BHeapPush(&pathfindopenset, connectingnode, K_NodeGetFScore(connectingnode), K_NodeUpdateHeapIndex);
+			}
+		}
+	}
+
+	// update openset capacity if it changed
+	pathfindsetup->opensetcapacity = pathfindopenset.capacity;
+
+	return pathfindsuccess;
+}
+
 /*--------------------------------------------------
 	boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup)
 
@@ -314,12 +538,17 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 			K_ReconstructPath(path, &singlenode);
 			pathfindsuccess = true;
 		}
+		else if (pathfindsetup->getnodeindex != NULL)
+		{
+			pathfindsuccess = K_PathfindAStarIndexed(path, pathfindsetup);
+		}
 		else
 		{
 			bheap_t        openset                 = {0};
 			bheapitem_t    poppedbheapitem         = {0};
 			pathfindnode_t *nodesarray             = NULL;
 			pathfindnode_t **closedset             = NULL;
+			size_t         arenamark               = 0U;
 			pathfindnode_t *newnode                = NULL;
 			pathfindnode_t *currentnode            = NULL;
 			pathfindnode_t *connectingnode         = NULL;
@@ -348,12 +577,15 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 			}
 
 			// Allocate the necessary memory
-			nodesarray = Z_Calloc(pathfindsetup->nodesarraycapacity * sizeof(pathfindnode_t), PU_STATIC, NULL);
+			// The working arrays only live for this search, so they come from the thread's arena. A scoped path is
+			// allocated after them, so they are left for the caller's scope to release along with it.
+			arenamark = Z_Arena_Begin();
+			nodesarray = Z_Arena_Alloc(pathfindsetup->nodesarraycapacity * sizeof(pathfindnode_t));
 			if (nodesarray == NULL)
 			{
 				I_Error("K_PathfindAStar: Out of memory allocating nodes array.");
 			}
-			closedset = Z_Calloc(pathfindsetup->closedsetcapacity * sizeof(pathfindnode_t*), PU_STATIC, NULL);
+			closedset = Z_Arena_Alloc(pathfindsetup->closedsetcapacity * sizeof(pathfindnode_t*));
 			if (closedset == NULL)
 			{
 				I_Error("K_PathfindAStar: Out of memory allocating closed set.");
@@ -394,9 +626,10 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 				if (closedsetcount >= pathfindsetup->closedsetcapacity)
 				{
 					// Need to reallocate closedset to fit another node
+					closedset = Z_Arena_Realloc(closedset,
+						pathfindsetup->closedsetcapacity * sizeof(pathfindnode_t*),
+						pathfindsetup->closedsetcapacity * 2 * sizeof(pathfindnode_t*));
 					pathfindsetup->closedsetcapacity = pathfindsetup->closedsetcapacity * 2;
-					closedset =
-						Z_Realloc(closedset, pathfindsetup->closedsetcapacity * sizeof(pathfindnode_t*), PU_STATIC, NULL);
 					if (closedset == NULL)
 					{
 						I_Error("K_PathfindAStar: Out of memory reallocating closed set.");
@@ -478,8 +711,10 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 								if (nodesarraycount >= pathfindsetup->nodesarraycapacity)
 								{
 									pathfindnode_t *nodesarrayrealloc = NULL;
+									nodesarrayrealloc = Z_Arena_Realloc(nodesarray,
+										pathfindsetup->nodesarraycapacity * sizeof(pathfindnode_t),
+										pathfindsetup->nodesarraycapacity * 2 * sizeof(pathfindnode_t));
 									pathfindsetup->nodesarraycapacity = pathfindsetup->nodesarraycapacity * 2;
-									nodesarrayrealloc = Z_Realloc(nodesarray, pathfindsetup->nodesarraycapacity * sizeof(pathfindnode_t), PU_STATIC, NULL);
 
 									if (nodesarrayrealloc == NULL)
 									{
@@ -534,8 +769,10 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 
 			// Clean up the memory
 			K_BHeapFree(&openset);
-			Z_Free(closedset);
-			Z_Free(nodesarray);
+			if (path->scoped == false)
+			{
+				Z_Arena_End(arenamark);
+			}
 		}
 	}
 
@@ -36,6 +36,9 @@ typedef boolean(*getnodetraversablefunc)(void*, void*);
 // function pointer for getting if a node is our pathfinding end point
 typedef boolean(*getpathfindfinishedfunc)(void*, void*);
 
+// function pointer for getting a node's dense index in its graph, from 0 to numnodeindices - 1
+typedef size_t(*getnodeindexfunc)(void*);
+
 
 // A pathfindnode contains information about a node from the pathfinding
 // heapindex is only used within the pathfinding algorithm itself, and is always 0 after it is completed
@@ -48,10 +51,13 @@ struct pathfindnode_t {
 };
 
 // Contains the final created path after pathfinding is completed
+// If scoped is set, the caller holds a Z_Arena_Begin scope for as long as it uses the path, and array comes from
+// that arena along with the search's working memory instead of the zone. It must not be Z_Free'd.
 struct path_t {
 	size_t numnodes;
 	pathfindnode_t *array;
 	UINT32 totaldist;
+	boolean scoped;
 };
 
 // Contains info about the pathfinding used to setup the algorithm
@@ -59,6 +65,9 @@ struct path_t {
 // should be setup by the caller before starting pathfinding
 // base capacities will be 8 if they aren't setup, missing callback functions will cause an error.
 // Can be accessed after the pathfinding is complete to get the final capacities of them
+// getnodeindex is optional. With it, nodes are looked up by index in tables kept between searches instead of being
+// searched for, which is much faster on large graphs. Only the start node may be outside of the graph, in which case
+// getnodeindex should return SIZE_MAX for it. The tables are shared, so indexed searches are main thread only.
 struct pathfindsetup_t {
 	size_t opensetcapacity;
 	size_t closedsetcapacity;
@@ -71,6 +80,8 @@ struct pathfindsetup_t {
 	getnodeheuristicfunc getheuristic;
 	getnodetraversablefunc gettraversable;
 	getpathfindfinishedfunc getfinished;
+	getnodeindexfunc getnodeindex;
+	size_t numnodeindices;
 };
 
 
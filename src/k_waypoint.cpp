@@ -19,11 +19,18 @@
 #include "r_local.h"
 #include "z_zone.h"
 #include "g_game.h"
+#include "g_demo.h"
+#include "command.h"
 #include "p_slopes.h"
 
 #include "cxxutil.hpp"
+#include "core/memory.h"
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <utility>
 #include <vector>
 
 #include <fmt/format.h>
@@ -53,6 +60,27 @@ static size_t baseopensetsize    = OPENSET_BASE_SIZE;
 static size_t baseclosedsetsize  = CLOSEDSET_BASE_SIZE;
 static size_t basenodesarraysize = NODESARRAY_BASE_SIZE;
 
+static boolean pathfindindexed = true; // Only cleared by pathfind_bench, to time the unindexed search
+
+// Distance from each waypoint to the finish line without shortcuts, and the next waypoint on the way there.
+// Indexed like waypointheap. finishenabled is the enabled state of each waypoint the table was found with.
+static UINT32     *finishdistances = NULL;
+static waypoint_t **finishnexthops = NULL;
+static boolean    *finishenabled   = NULL;
+
+// Uniform grid over the horizontal waypoint positions, in map units, for nearest waypoint searches.
+// Each cell lists its waypoints in heap order, so ties can be broken the same way as a loop over the heap.
+#define WAYPOINTGRID_MINCELLSIZE (256)
+
+static INT32  waypointgridx         = 0;
+static INT32  waypointgridy         = 0;
+static INT32  waypointgridcellsize  = 0;
+static INT32  waypointgridwidth     = 0;
+static INT32  waypointgridheight    = 0;
+static INT32  waypointgridmaxradius = 0;    // Largest waypoint radius in map units
+static size_t *waypointgridcells    = NULL; // Start of each cell in waypointgridindices, plus the end
+static size_t *waypointgridindices  = NULL;
+
 
 /*--------------------------------------------------
 	waypoint_t *K_GetFinishLineWaypoint(void)
@@ -300,42 +328,280 @@ INT32 K_GetTrackComplexity(void)
 }
 
 /*--------------------------------------------------
-	waypoint_t *K_GetClosestWaypointToMobj(mobj_t *const mobj)
+	static INT32 K_WaypointGridColumn(INT32 x)
+
+		Gets the waypoint grid column containing a position, clamped to the grid.
+
+	Input Arguments:-
+		x - The x position in map units
+
+	Return:-
+		The column index
+--------------------------------------------------*/
+static INT32 K_WaypointGridColumn(INT32 x)
+{
+	return std::clamp((x - waypointgridx) / waypointgridcellsize, 0, waypointgridwidth - 1);
+}
+
+/*--------------------------------------------------
+	static INT32 K_WaypointGridRow(INT32 y)
+
+		Gets the waypoint grid row containing a position, clamped to the grid.
+
+	Input Arguments:-
+		y - The y position in map units
+
+	Return:-
+		The row index
+--------------------------------------------------*/
+static INT32 K_WaypointGridRow(INT32 y)
+{
+	return std::clamp((y - waypointgridy) / waypointgridcellsize, 0, waypointgridheight - 1);
+}
+
+/*--------------------------------------------------
+	static void K_BuildWaypointGrid(void)
+
+		Sorts every waypoint into the cells of the waypoint grid. Waypoints never move horizontally once the map
+		is loaded, so this only needs doing once.
+--------------------------------------------------*/
+static void K_BuildWaypointGrid(void)
+{
+	INT32 minx = INT32_MAX;
+	INT32 miny = INT32_MAX;
+	INT32 maxx = INT32_MIN;
+	INT32 maxy = INT32_MIN;
+	size_t i;
+
+	waypointgridmaxradius = 0;
+
+	for (i = 0; i < numwaypoints; i++)
+	{
+		const mobj_t *const waypointmobj = waypointheap[i].mobj;
+
+		minx = std::min(minx, waypointmobj->x / FRACUNIT);
+		miny = std::min(miny, waypointmobj->y / FRACUNIT);
+		maxx = std::max(maxx, waypointmobj->x / FRACUNIT);
+		maxy = std::max(maxy, waypointmobj->y / FRACUNIT);
+		waypointgridmaxradius = std::max(waypointgridmaxradius, waypointmobj->radius / FRACUNIT);
+	}
+
+	// Aim for a couple of waypoints in each cell.
+	waypointgridcellsize = WAYPOINTGRID_MINCELLSIZE;
+	while ((size_t)((maxx - minx) / waypointgridcellsize + 1) * (size_t)((maxy - miny) / waypointgridcellsize + 1)
+		> std::max<size_t>(numwaypoints / 2, 1))
+	{
+		waypointgridcellsize *= 2;
+	}
+
+	waypointgridx      = minx;
+	waypointgridy      = miny;
+	waypointgridwidth  = (maxx - minx) / waypointgridcellsize + 1;
+	waypointgridheight = (maxy - miny) / waypointgridcellsize + 1;
+
+	const size_t numcells = (size_t)waypointgridwidth * (size_t)waypointgridheight;
+	std::vector<size_t> cellofwaypoint(numwaypoints);
+
+	waypointgridcells = static_cast<size_t*>(Z_Calloc((numcells + 1) * sizeof(size_t), PU_LEVEL, NULL));
+	waypointgridindices = static_cast<size_t*>(Z_Malloc(numwaypoints * sizeof(size_t), PU_LEVEL, NULL));
+
+	// Counting sort, which keeps the waypoints of each cell in heap order
+	for (i = 0; i < numwaypoints; i++)
+	{
+		const mobj_t *const waypointmobj = waypointheap[i].mobj;
+
+		cellofwaypoint[i] = (size_t)K_WaypointGridRow(waypointmobj->y / FRACUNIT) * waypointgridwidth
+			+ K_WaypointGridColumn(waypointmobj->x / FRACUNIT);
+		waypointgridcells[cellofwaypoint[i] + 1]++;
+	}
+
+	for (i = 0; i < numcells; i++)
+	{
+		waypointgridcells[i + 1] += waypointgridcells[i];
+	}
+
+	std::vector<size_t> cellfill(waypointgridcells, waypointgridcells + numcells);
+
+	for (i = 0; i < numwaypoints; i++)
+	{
+		waypointgridindices[cellfill[cellofwaypoint[i]]++] = i;
+	}
+}
+
+/*--------------------------------------------------
+	static size_t K_CollectWaypointsInRadius(INT32 x, INT32 y, INT32 radius, size_t *results)
+
+		Finds the heap indices of every waypoint horizontally within a radius, by the same approximate distance as
+		the rest of this file.
+
+	Input Arguments:-
+		x       - The x position in map units
+		y       - The y position in map units
+		radius  - The radius in map units
+		results - Room for the indices, which needs to fit numwaypoints
+
+	Return:-
+		The number of waypoints found. Their indices are in ascending order.
+--------------------------------------------------*/
+static size_t K_CollectWaypointsInRadius(INT32 x, INT32 y, INT32 radius, size_t *const results)
+{
+	size_t numresults = 0U;
+
+	if (waypointgridcells == NULL || radius < 0)
+	{
+		return 0U;
+	}
+
+	const INT32 mincol = K_WaypointGridColumn(x - radius);
+	const INT32 maxcol = K_WaypointGridColumn(x + radius);
+	const INT32 minrow = K_WaypointGridRow(y - radius);
+	const INT32 maxrow = K_WaypointGridRow(y + radius);
+
+	for (INT32 row = minrow; row <= maxrow; row++)
+	{
+		const size_t rowstart = (size_t)row * waypointgridwidth;
+
+		for (size_t j = waypointgridcells[rowstart + mincol]; j < waypointgridcells[rowstart + maxcol + 1]; j++)
+		{
+			const mobj_t *const waypointmobj = waypointheap[waypointgridindices[j]].mobj;
+
+			if (P_AproxDistance(x - (waypointmobj->x / FRACUNIT), y - (waypointmobj->y / FRACUNIT)) <= radius)
+			{
+				results[numresults++] = waypointgridindices[j];
+			}
+		}
+	}
+
+	std::sort(results, results + numresults);
+	return numresults;
+}
+
+/*--------------------------------------------------
+	size_t K_GetWaypointsInRadius(fixed_t x, fixed_t y, fixed_t radius, waypoint_t **results, size_t maxresults)
 
 		See header file for description.
 --------------------------------------------------*/
-waypoint_t *K_GetClosestWaypointToMobj(mobj_t *const mobj)
+size_t K_GetWaypointsInRadius(fixed_t x, fixed_t y, fixed_t radius, waypoint_t **results, size_t maxresults)
 {
-	waypoint_t *closestwaypoint = NULL;
+	if (numwaypoints == 0U)
+	{
+		return 0U;
+	}
 
-	if ((mobj == NULL) || P_MobjWasRemoved(mobj))
+	srb2::ArenaScope arena;
+	size_t *indices = static_cast<size_t*>(Z_Arena_Alloc(numwaypoints * sizeof(size_t)));
+	const size_t numfound = K_CollectWaypointsInRadius(x / FRACUNIT, y / FRACUNIT, radius / FRACUNIT, indices);
+
+	for (size_t i = 0U; i < std::min(numfound, maxresults); i++)
 	{
-		CONS_Debug(DBG_GAMELOGIC, "NULL mobj in K_GetClosestWaypointToMobj.\n");
+		results[i] = &waypointheap[indices[i]];
 	}
-	else
+
+	return numfound;
+}
+
+/*--------------------------------------------------
+	size_t K_GetNearestWaypoints(fixed_t x, fixed_t y, fixed_t z, waypoint_t **results, size_t count)
+
+		See header file for description.
+--------------------------------------------------*/
+size_t K_GetNearestWaypoints(fixed_t x, fixed_t y, fixed_t z, waypoint_t **results, size_t count)
+{
+	if (waypointgridcells == NULL || count == 0U)
 	{
-		size_t     i              = 0U;
-		waypoint_t *checkwaypoint = NULL;
-		fixed_t    closestdist    = INT32_MAX;
-		fixed_t    checkdist      = INT32_MAX;
+		return 0U;
+	}
+
+	// Closest first, then by heap index, like picking the first of equally close waypoints in the heap.
+	std::vector<std::pair<fixed_t, size_t>> nearest;
+	nearest.reserve(count + 1);
+
+	const INT32 ux   = x / FRACUNIT;
+	const INT32 uy   = y / FRACUNIT;
+	const INT32 uz   = z / FRACUNIT;
+	const INT32 ccol = K_WaypointGridColumn(ux);
+	const INT32 crow = K_WaypointGridRow(uy);
 
-		for (i = 0; i < numwaypoints; i++)
+	// Search rings of cells outwards. Anything in ring r is more than (r - 1) cells away on one axis,
+	// which the approximate distance never comes in under, so stop once that is further than the worst result.
+	for (INT32 r = 0; r < std::max(waypointgridwidth, waypointgridheight); r++)
+	{
+		if (nearest.size() == count && (r - 1) * waypointgridcellsize > nearest.back().first)
 		{
-			checkwaypoint = &waypointheap[i];
+			break;
+		}
 
-			checkdist = P_AproxDistance(
-				(mobj->x / FRACUNIT) - (checkwaypoint->mobj->x / FRACUNIT),
-				(mobj->y / FRACUNIT) - (checkwaypoint->mobj->y / FRACUNIT));
-			checkdist = P_AproxDistance(checkdist, (mobj->z / FRACUNIT) - (checkwaypoint->mobj->z / FRACUNIT));
+		for (INT32 row = crow - r; row <= crow + r; row++)
+		{
+			if (row < 0 || row >= waypointgridheight)
+			{
+				continue;
+			}
+
+			// Only the edges of the ring, unless this is its top or bottom row
+			const INT32 step = (r == 0 || row == crow - r || row == crow + r) ? 1 : 2 * r;
 
-			if (checkdist < closestdist)
+			for (INT32 col = ccol - r; col <= ccol + r; col += step)
 			{
-				closestwaypoint = checkwaypoint;
-				closestdist = checkdist;
+				if (col < 0 || col >= waypointgridwidth)
+				{
+					continue;
+				}
+
+				const size_t cell = (size_t)row * waypointgridwidth + col;
+
+				for (size_t j = waypointgridcells[cell]; j < waypointgridcells[cell + 1]; j++)
+				{
+					const mobj_t *const waypointmobj = waypointheap[waypointgridindices[j]].mobj;
+					fixed_t checkdist = P_AproxDistance(
+						ux - (waypointmobj->x / FRACUNIT),
+						uy - (waypointmobj->y / FRACUNIT));
+					checkdist = P_AproxDistance(checkdist, uz - (waypointmobj->z / FRACUNIT));
+
+					const std::pair<fixed_t, size_t> candidate(checkdist, waypointgridindices[j]);
+
+					if (nearest.size() == count && !(candidate < nearest.back()))
+					{
+						continue;
+					}
+
+					nearest.insert(std::upper_bound(nearest.begin(), nearest.end(), candidate), candidate);
+
+					if (nearest.size() > count)
+					{
+						nearest.pop_back();
+					}
+				}
 			}
 		}
 	}
 
+	for (size_t i = 0U; i < nearest.size(); i++)
+	{
+		results[i] = &waypointheap[nearest[i].second];
+	}
+
+	return nearest.size();
+}
+
+/*--------------------------------------------------
+	waypoint_t *K_GetClosestWaypointToMobj(mobj_t *const mobj)
+
+		See header file for description.
+--------------------------------------------------*/
+waypoint_t *K_GetClosestWaypointToMobj(mobj_t *const mobj)
+{
+	waypoint_t *closestwaypoint = NULL;
+
+	if ((mobj == NULL) || P_MobjWasRemoved(mobj))
+	{
+		CONS_Debug(DBG_GAMELOGIC, "NULL mobj in K_GetClosestWaypointToMobj.\n");
+	}
+	else
+	{
+		K_GetNearestWaypoints(mobj->x, mobj->y, mobj->z, &closestwaypoint, 1);
+	}
+
 	return closestwaypoint;
 }
 
@@ -353,10 +619,7 @@ static void K_CompareOverlappingWaypoint
 		waypoint_t **const bestwaypoint,
 		fixed_t     *const bestfindist)
 {
-	const boolean useshortcuts = false;
-	const boolean huntbackwards = false;
-	boolean pathfindsuccess = false;
-	path_t pathtofinish = {0};
+	UINT32 disttofinish = UINT32_MAX;
 
 	if (K_GetWaypointIsShortcut(*bestwaypoint) == false
 		&& K_GetWaypointIsShortcut(checkwaypoint) == true)
@@ -365,18 +628,15 @@ static void K_CompareOverlappingWaypoint
 		return;
 	}
 
-	pathfindsuccess =
-		K_PathfindToWaypoint(checkwaypoint, finishline, &pathtofinish, useshortcuts, huntbackwards);
+	disttofinish = K_GetWaypointDistanceToFinish(checkwaypoint);
 
-	if (pathfindsuccess == true)
+	if (disttofinish != UINT32_MAX)
 	{
-		if ((INT32)(pathtofinish.totaldist) < *bestfindist)
+		if ((INT32)(disttofinish) < *bestfindist)
 		{
 			*bestwaypoint = checkwaypoint;
-			*bestfindist = pathtofinish.totaldist;
+			*bestfindist = disttofinish;
 		}
-
-		Z_Free(pathtofinish.array);
 	}
 }
 
@@ -494,9 +754,34 @@ waypoint_t *K_GetBestWaypointForMobj(mobj_t *const mobj, waypoint_t *const hint)
 			sort_waypoint(hint);
 		}
 
-		for (size_t i = 0U; i < numwaypoints; i++)
+		// Only waypoints within the largest radius can be overlapped, and once a visible one that close has been
+		// found, nothing further away can be picked over it. So checking just those, still in heap order, picks
+		// the same waypoint as checking the whole heap.
+		srb2::ArenaScope arena;
+		size_t *nearby = static_cast<size_t*>(Z_Arena_Alloc(std::max<size_t>(numwaypoints, 1) * sizeof(size_t)));
+		const size_t numnearby = K_CollectWaypointsInRadius(
+			mobj->x / FRACUNIT, mobj->y / FRACUNIT, waypointgridmaxradius, nearby);
+
+		for (size_t i = 0U; i < numnearby; i++)
 		{
-			sort_waypoint(&waypointheap[i]);
+			sort_waypoint(&waypointheap[nearby[i]]);
+		}
+
+		if (closestdist > waypointgridmaxradius && bestfindist == INT32_MAX)
+		{
+			// Nothing nearby could be seen, so the result depends on the far away waypoints too.
+			bestwaypoint = NULL;
+			closestdist = INT32_MAX;
+
+			if (hint != NULL)
+			{
+				sort_waypoint(hint);
+			}
+
+			for (size_t i = 0U; i < numwaypoints; i++)
+			{
+				sort_waypoint(&waypointheap[i]);
+			}
 		}
 	}
 
@@ -1094,6 +1379,31 @@ static UINT32 K_WaypointPathfindGetHeuristic(void *data1, void *data2)
 	return nodeheuristic;
 }
 
+/*--------------------------------------------------
+	static size_t K_WaypointPathfindGetIndex(void *data)
+
+		Gets the index of a waypoint in the waypointheap. For pathfinding only.
+
+	Input Arguments:-
+		data - Should point to a waypoint_t to get the index of
+
+	Return:-
+		The index of the waypoint, or SIZE_MAX if it isn't in the waypointheap
+--------------------------------------------------*/
+static size_t K_WaypointPathfindGetIndex(void *data)
+{
+	// Compare as integers, the waypoint can be a copy on the stack like fakefinishline in K_CalculateCircuitLength
+	const uintptr_t offset = (uintptr_t)data - (uintptr_t)waypointheap;
+	size_t waypointindex = SIZE_MAX;
+
+	if (offset < numwaypoints * sizeof(waypoint_t))
+	{
+		waypointindex = offset / sizeof(waypoint_t);
+	}
+
+	return waypointindex;
+}
+
 /*--------------------------------------------------
 	static boolean K_WaypointPathfindTraversableAllEnabled(void *data)
 
@@ -1294,6 +1604,398 @@ static boolean K_WaypointPathfindReachedGScoreSpawnable(void *data, void *setupD
 	return (scoreReached && spawnable);
 }
 
+/*--------------------------------------------------
+	static boolean K_FinishDistanceEdgeAllowed(waypoint_t *const from, waypoint_t *const to)
+
+		Checks if the way to the finish line can go from one waypoint to the next. Follows the same rules as
+		pathfinding without shortcuts, so the table agrees with K_PathfindToWaypoint.
+
+	Input Arguments:-
+		from - The waypoint being left
+		to   - One of its next waypoints
+
+	Return:-
+		True if the step can be taken, false otherwise.
+--------------------------------------------------*/
+static boolean K_FinishDistanceEdgeAllowed(waypoint_t *const from, waypoint_t *const to)
+{
+	return K_WaypointPathfindTraversableNoShortcuts(to, from);
+}
+
+using FinishDistanceQueue =
+	std::priority_queue<std::pair<UINT32, size_t>, std::vector<std::pair<UINT32, size_t>>, std::greater<>>;
+
+/*--------------------------------------------------
+	static void K_RelaxFinishDistances(FinishDistanceQueue &queue)
+
+		Dijkstra's algorithm backwards from the finish line. Spreads the distances of the queued waypoints to the
+		waypoints before them, until no distance can be lowered.
+
+	Input Arguments:-
+		queue - The waypoints whose distances were just lowered, with those distances
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_RelaxFinishDistances(FinishDistanceQueue &queue)
+{
+	while (!queue.empty())
+	{
+		const auto [distance, index] = queue.top();
+		queue.pop();
+
+		if (distance != finishdistances[index])
+		{
+			// Lowered again since this was queued
+			continue;
+		}
+
+		waypoint_t *const waypoint = &waypointheap[index];
+
+		for (size_t i = 0U; i < waypoint->numprevwaypoints; i++)
+		{
+			waypoint_t *const prevwaypoint = waypoint->prevwaypoints[i];
+			const size_t previndex = K_WaypointPathfindGetIndex(prevwaypoint);
+			const UINT32 prevdistance = distance + waypoint->prevwaypointdistances[i];
+
+			if (previndex < numwaypoints && prevdistance < finishdistances[previndex]
+				&& K_FinishDistanceEdgeAllowed(prevwaypoint, waypoint) == true)
+			{
+				finishdistances[previndex] = prevdistance;
+				queue.emplace(prevdistance, previndex);
+			}
+		}
+	}
+}
+
+/*--------------------------------------------------
+	static void K_UpdateFinishNextHops(void)
+
+		Picks the next waypoint toward the finish line for every waypoint from the distances.
+		Only depends on the distances and not how they were found, so every game picks the same ones however the
+		table was updated. Waypoints with the same distance are settled closest to the finish line first, so zero
+		length connections can't form a loop.
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_UpdateFinishNextHops(void)
+{
+	std::vector<size_t> order(numwaypoints);
+	std::vector<bool> settled(numwaypoints, false);
+
+	for (size_t i = 0U; i < numwaypoints; i++)
+	{
+		order[i] = i;
+		finishnexthops[i] = NULL;
+	}
+
+	std::sort(order.begin(), order.end(),
+		[](size_t a, size_t b) { return std::make_pair(finishdistances[a], a) < std::make_pair(finishdistances[b], b); });
+
+	size_t groupstart = 0U;
+	while (groupstart < numwaypoints && finishdistances[order[groupstart]] != UINT32_MAX)
+	{
+		const UINT32 groupdistance = finishdistances[order[groupstart]];
+		size_t groupend = groupstart;
+		boolean changed = true;
+
+		while (groupend < numwaypoints && finishdistances[order[groupend]] == groupdistance)
+		{
+			groupend++;
+		}
+
+		while (changed == true)
+		{
+			changed = false;
+
+			for (size_t i = groupstart; i < groupend; i++)
+			{
+				const size_t index = order[i];
+				waypoint_t *const waypoint = &waypointheap[index];
+
+				if (settled[index] == true)
+				{
+					continue;
+				}
+
+				if (waypoint == finishline)
+				{
+					settled[index] = true;
+					changed = true;
+					continue;
+				}
+
+				// The first next waypoint that is on a shortest way to the finish line
+				for (size_t j = 0U; j < waypoint->numnextwaypoints; j++)
+				{
+					waypoint_t *const nextwaypoint = waypoint->nextwaypoints[j];
+					const size_t nextindex = K_WaypointPathfindGetIndex(nextwaypoint);
+
+					if (nextindex < numwaypoints && settled[nextindex] == true
+						&& finishdistances[nextindex] + waypoint->nextwaypointdistances[j] == groupdistance
+						&& K_FinishDistanceEdgeAllowed(waypoint, nextwaypoint) == true)
+					{
+						finishnexthops[index] = nextwaypoint;
+						settled[index] = true;
+						changed = true;
+						break;
+					}
+				}
+			}
+		}
+
+		groupstart = groupend;
+	}
+}
+
+/*--------------------------------------------------
+	static void K_BuildFinishDistances(void)
+
+		Finds the distance to the finish line from every waypoint from scratch.
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_BuildFinishDistances(void)
+{
+	FinishDistanceQueue queue;
+	const size_t finishindex = K_WaypointPathfindGetIndex(finishline);
+
+	for (size_t i = 0U; i < numwaypoints; i++)
+	{
+		finishdistances[i] = UINT32_MAX;
+		finishenabled[i] = K_GetWaypointIsEnabled(&waypointheap[i]);
+	}
+
+	finishdistances[finishindex] = 0U;
+	queue.emplace(0U, finishindex);
+	K_RelaxFinishDistances(queue);
+	K_UpdateFinishNextHops();
+}
+
+/*--------------------------------------------------
+	static void K_FinishDistancesWaypointEnabled(size_t index)
+
+		Updates the table after a waypoint was enabled. Only the waypoints that can now get to the finish line
+		sooner through it change.
+
+	Input Arguments:-
+		index - The index of the waypoint that was enabled
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_FinishDistancesWaypointEnabled(size_t index)
+{
+	FinishDistanceQueue queue;
+
+	// Steps onto a waypoint are what it being enabled allows, so lowering its own distance is not possible.
+	// Requeue it so the steps onto it are tried.
+	if (finishdistances[index] != UINT32_MAX)
+	{
+		queue.emplace(finishdistances[index], index);
+		K_RelaxFinishDistances(queue);
+	}
+}
+
+/*--------------------------------------------------
+	static void K_FinishDistancesWaypointDisabled(size_t index)
+
+		Updates the table after a waypoint was disabled. Only the waypoints whose way to the finish line went
+		through it change, and they are found again from the waypoints around them.
+
+	Input Arguments:-
+		index - The index of the waypoint that was disabled
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_FinishDistancesWaypointDisabled(size_t index)
+{
+	enum : UINT8 { UNKNOWN, THROUGH, AROUND };
+
+	FinishDistanceQueue queue;
+	std::vector<UINT8> state(numwaypoints, UNKNOWN);
+	std::vector<size_t> chain;
+
+	// Follow each waypoint's next hops to see if they lead through the disabled waypoint
+	state[index] = THROUGH;
+	for (size_t i = 0U; i < numwaypoints; i++)
+	{
+		size_t check = i;
+		UINT8 result = AROUND;
+
+		chain.clear();
+		while (state[check] == UNKNOWN)
+		{
+			chain.push_back(check);
+			if (finishnexthops[check] == NULL)
+			{
+				break;
+			}
+			check = K_WaypointPathfindGetIndex(finishnexthops[check]);
+		}
+
+		if (state[check] != UNKNOWN)
+		{
+			result = state[check];
+		}
+
+		for (size_t waypointindex : chain)
+		{
+			state[waypointindex] = result;
+		}
+	}
+	state[index] = AROUND; // Its own way to the finish line doesn't step onto it
+
+	for (size_t i = 0U; i < numwaypoints; i++)
+	{
+		if (state[i] == THROUGH)
+		{
+			finishdistances[i] = UINT32_MAX;
+		}
+	}
+
+	// Start again from the best step onto a waypoint which was not affected
+	for (size_t i = 0U; i < numwaypoints; i++)
+	{
+		waypoint_t *const waypoint = &waypointheap[i];
+
+		if (state[i] != THROUGH)
+		{
+			continue;
+		}
+
+		for (size_t j = 0U; j < waypoint->numnextwaypoints; j++)
+		{
+			waypoint_t *const nextwaypoint = waypoint->nextwaypoints[j];
+			const size_t nextindex = K_WaypointPathfindGetIndex(nextwaypoint);
+
+			if (nextindex < numwaypoints && state[nextindex] == AROUND && finishdistances[nextindex] != UINT32_MAX
+				&& finishdistances[nextindex] + waypoint->nextwaypointdistances[j] < finishdistances[i]
+				&& K_FinishDistanceEdgeAllowed(waypoint, nextwaypoint) == true)
+			{
+				finishdistances[i] = finishdistances[nextindex] + waypoint->nextwaypointdistances[j];
+			}
+		}
+
+		if (finishdistances[i] != UINT32_MAX)
+		{
+			queue.emplace(finishdistances[i], i);
+		}
+	}
+
+	K_RelaxFinishDistances(queue);
+}
+
+/*--------------------------------------------------
+	void K_UpdateFinishDistances(void)
+
+		See header file for description.
+--------------------------------------------------*/
+void K_UpdateFinishDistances(void)
+{
+	size_t changedindex = SIZE_MAX;
+	size_t numchanged = 0U;
+
+	if (finishdistances == NULL)
+	{
+		return;
+	}
+
+	for (size_t i = 0U; i < numwaypoints; i++)
+	{
+		const boolean enabled = K_GetWaypointIsEnabled(&waypointheap[i]);
+
+		if (enabled != finishenabled[i])
+		{
+			finishenabled[i] = enabled;
+			changedindex = i;
+			numchanged++;
+		}
+	}
+
+	if (numchanged == 0U)
+	{
+		return;
+	}
+	else if (numchanged > 1U)
+	{
+		// Every waypoint's update assumes the rest are as the table was found with
+		K_BuildFinishDistances();
+		return;
+	}
+
+	if (finishenabled[changedindex] == true)
+	{
+		K_FinishDistancesWaypointEnabled(changedindex);
+	}
+	else
+	{
+		K_FinishDistancesWaypointDisabled(changedindex);
+	}
+
+	K_UpdateFinishNextHops();
+}
+
+/*--------------------------------------------------
+	UINT32 K_GetWaypointDistanceToFinish(waypoint_t *waypoint)
+
+		See header file for description.
+--------------------------------------------------*/
+UINT32 K_GetWaypointDistanceToFinish(waypoint_t *waypoint)
+{
+	const size_t index = K_WaypointPathfindGetIndex(waypoint);
+
+	// Older replays were recorded with the distances A* found, which the table doesn't always match
+	if (G_CompatLevel(0x000D))
+	{
+		srb2::ArenaScope arena;
+		path_t pathtofinish = {0};
+
+		pathtofinish.scoped = true;
+
+		if (finishline == NULL
+			|| K_PathfindToWaypoint(waypoint, finishline, &pathtofinish, false, false) == false)
+		{
+			return UINT32_MAX;
+		}
+
+		return pathtofinish.totaldist;
+	}
+
+	if (finishdistances == NULL || index >= numwaypoints)
+	{
+		return UINT32_MAX;
+	}
+
+	return finishdistances[index];
+}
+
+/*--------------------------------------------------
+	waypoint_t *K_GetWaypointNextToFinish(waypoint_t *waypoint)
+
+		See header file for description.
+--------------------------------------------------*/
+waypoint_t *K_GetWaypointNextToFinish(waypoint_t *waypoint)
+{
+	const size_t index = K_WaypointPathfindGetIndex(waypoint);
+
+	// Let older replays take the path A* picks
+	if (G_CompatLevel(0x000D))
+	{
+		return NULL;
+	}
+
+	if (finishnexthops == NULL || index >= numwaypoints)
+	{
+		return NULL;
+	}
+
+	return finishnexthops[index];
+}
+
 /*--------------------------------------------------
 	boolean K_PathfindToWaypoint(
 		waypoint_t *const sourcewaypoint,
@@ -1365,6 +2067,8 @@ boolean K_PathfindToWaypoint(
 		pathfindsetup.getheuristic       = heuristicfunc;
 		pathfindsetup.gettraversable     = traversablefunc;
 		pathfindsetup.getfinished        = finishedfunc;
+		pathfindsetup.getnodeindex       = pathfindindexed ? K_WaypointPathfindGetIndex : NULL;
+		pathfindsetup.numnodeindices     = numwaypoints;
 
 		pathfound = K_PathfindAStar(returnpath, &pathfindsetup);
 
@@ -1441,6 +2145,8 @@ boolean K_PathfindThruCircuit(
 		pathfindsetup.getheuristic       = heuristicfunc;
 		pathfindsetup.gettraversable     = traversablefunc;
 		pathfindsetup.getfinished        = finishedfunc;
+		pathfindsetup.getnodeindex       = pathfindindexed ? K_WaypointPathfindGetIndex : NULL;
+		pathfindsetup.numnodeindices     = numwaypoints;
 
 		pathfound = K_PathfindAStar(returnpath, &pathfindsetup);
 
@@ -1517,6 +2223,8 @@ boolean K_PathfindThruCircuitSpawnable(
 		pathfindsetup.getheuristic       = heuristicfunc;
 		pathfindsetup.gettraversable     = traversablefunc;
 		pathfindsetup.getfinished        = finishedfunc;
+		pathfindsetup.getnodeindex       = pathfindindexed ? K_WaypointPathfindGetIndex : NULL;
+		pathfindsetup.numnodeindices     = numwaypoints;
 
 		pathfound = K_PathfindAStar(returnpath, &pathfindsetup);
 
@@ -1583,8 +2291,15 @@ waypoint_t *K_GetNextWaypointToDestination(
 		{
 			nextwaypoint = sourcewaypoint->prevwaypoints[0];
 		}
+		else if ((huntbackwards == false) && (useshortcuts == false) && (destinationwaypoint == finishline)
+			&& (K_GetWaypointNextToFinish(sourcewaypoint) != NULL))
+		{
+			// The table of distances to the finish line already knows the way
+			nextwaypoint = K_GetWaypointNextToFinish(sourcewaypoint);
+		}
 		else
 		{
+			srb2::ArenaScope           arena;
 			path_t                     pathtowaypoint  = {0};
 			pathfindsetup_t            pathfindsetup   = {0};
 			boolean                    pathfindsuccess = false;
@@ -1605,6 +2320,7 @@ waypoint_t *K_GetNextWaypointToDestination(
 				traversablefunc = K_WaypointPathfindTraversableAllEnabled;
 			}
 
+			pathtowaypoint.scoped            = true;
 			pathfindsetup.opensetcapacity    = K_GetOpensetBaseSize();
 			pathfindsetup.closedsetcapacity  = K_GetClosedsetBaseSize();
 			pathfindsetup.nodesarraycapacity = K_GetNodesArrayBaseSize();
@@ -1615,6 +2331,8 @@ waypoint_t *K_GetNextWaypointToDestination(
 			pathfindsetup.getheuristic       = heuristicfunc;
 			pathfindsetup.gettraversable     = traversablefunc;
 			pathfindsetup.getfinished        = finishedfunc;
+			pathfindsetup.getnodeindex       = pathfindindexed ? K_WaypointPathfindGetIndex : NULL;
+			pathfindsetup.numnodeindices     = numwaypoints;
 
 			pathfindsuccess = K_PathfindAStar(&pathtowaypoint, &pathfindsetup);
 
@@ -1635,8 +2353,6 @@ waypoint_t *K_GetNextWaypointToDestination(
 					CONS_Debug(DBG_GAMELOGIC, "Only one waypoint pathfound in K_GetNextWaypointToDestination.\n");
 					nextwaypoint = (waypoint_t*)pathtowaypoint.array[0].nodedata;
 				}
-
-				Z_Free(pathtowaypoint.array);
 			}
 			else
 			{
@@ -1982,8 +2698,10 @@ static UINT32 K_SetupCircuitLength(void)
 	// line places people correctly relative to each other
 	if ((mapheaderinfo[gamemap - 1]->levelflags & LF_SECTIONRACE) == LF_SECTIONRACE)
 	{
+		srb2::ArenaScope arena;
 		path_t bestsprintpath = {0};
-		auto sprint_finally = srb2::finally([&bestsprintpath]() { Z_Free(bestsprintpath.array); });
+
+		bestsprintpath.scoped = true;
 
 		const boolean useshortcuts = false;
 		const boolean huntbackwards = true;
@@ -2007,8 +2725,10 @@ static UINT32 K_SetupCircuitLength(void)
 		// Create a fake finishline waypoint, then try and pathfind to the finishline from it
 		waypoint_t    fakefinishline  = *finishline;
 
+		srb2::ArenaScope arena;
 		path_t        bestcircuitpath = {0};
-		auto circuit_finally = srb2::finally([&bestcircuitpath]() { Z_Free(bestcircuitpath.array); });
+
+		bestcircuitpath.scoped = true;
 
 		const boolean useshortcuts    = false;
 		const boolean huntbackwards   = false;
@@ -2309,6 +3029,19 @@ static void K_FreeWaypoints(void)
 		Z_Free(waypointheap);
 	}
 
+	if (finishdistances != NULL)
+	{
+		Z_Free(finishdistances);
+		Z_Free(finishnexthops);
+		Z_Free(finishenabled);
+	}
+
+	if (waypointgridcells != NULL)
+	{
+		Z_Free(waypointgridcells);
+		Z_Free(waypointgridindices);
+	}
+
 	K_ClearWaypoints();
 }
 
@@ -2449,8 +3182,10 @@ static INT32 K_CalculateTrackComplexity(void)
 	const boolean useshortcuts = false;
 
 	boolean pathfindsuccess = false;
+	srb2::ArenaScope arena;
 	path_t path = {0};
 
+	path.scoped = true;
 	trackcomplexity = BASE_TRACK_COMPLEXITY;
 
 	if (startingwaypoint == NULL || finishline == NULL)
@@ -2466,8 +3201,6 @@ static INT32 K_CalculateTrackComplexity(void)
 
 	if (pathfindsuccess == true)
 	{
-		auto path_finally = srb2::finally([&path]() { Z_Free(path.array); });
-
 		for (size_t i = 1; i < path.numnodes-1; i++)
 		{
 			waypoint_t *const start = (waypoint_t *)path.array[ i - 1 ].nodedata;
@@ -2775,6 +3508,12 @@ boolean K_SetupWaypointList(void)
 					finishline = firstwaypoint;
 				}
 
+				finishdistances = static_cast<UINT32*>(Z_Malloc(numwaypoints * sizeof(UINT32), PU_LEVEL, NULL));
+				finishnexthops = static_cast<waypoint_t**>(Z_Malloc(numwaypoints * sizeof(waypoint_t*), PU_LEVEL, NULL));
+				finishenabled = static_cast<boolean*>(Z_Malloc(numwaypoints * sizeof(boolean), PU_LEVEL, NULL));
+				K_BuildFinishDistances();
+				K_BuildWaypointGrid();
+
 				if (K_SetupCircuitLength() == 0)
 				{
 					CONS_Alert(CONS_ERROR, "Circuit track waypoints do not form a circuit.\n");
@@ -2808,6 +3547,11 @@ void K_ClearWaypoints(void)
 	numwaypointmobjs = 0U;
 	circuitlength    = 0U;
 	trackcomplexity  = 0U;
+	finishdistances  = NULL;
+	finishnexthops   = NULL;
+	finishenabled    = NULL;
+	waypointgridcells   = NULL;
+	waypointgridindices = NULL;
 }
 
 /*--------------------------------------------------
@@ -2988,3 +3732,79 @@ void K_AdjustWaypointsParameters (void)
 		}
 	}
 }
+
+// Times random waypoint to finish line queries with and without indexed pathfinding, on the loaded map.
+void Command_PathfindBench_f(void)
+{
+	using Clock = std::chrono::steady_clock;
+
+	if (numwaypoints == 0U || finishline == NULL)
+	{
+		CONS_Printf("pathfind_bench: no waypoints, load a race map first\n");
+		return;
+	}
+
+	size_t queries = COM_Argc() > 1 ? std::max(1, atoi(COM_Argv(1))) : 10000;
+
+	// The same deterministic sources for both runs
+	std::vector<waypoint_t *> sources(queries);
+	uint32_t seed = 0x2545F491u;
+	for (auto& source : sources)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		source = &waypointheap[(seed >> 8) % numwaypoints];
+	}
+
+	struct Result
+	{
+		Clock::duration time;
+		size_t found;
+		UINT64 totaldist;
+	};
+
+	auto run = [&sources](boolean indexed) -> Result
+	{
+		Result result {};
+		auto start = Clock::now();
+
+		pathfindindexed = indexed;
+		for (waypoint_t *source : sources)
+		{
+			srb2::ArenaScope arena;
+			path_t path = {0};
+
+			path.scoped = true;
+			if (K_PathfindToWaypoint(source, finishline, &path, false, false))
+			{
+				result.found++;
+				result.totaldist += path.totaldist;
+			}
+		}
+		pathfindindexed = true;
+
+		result.time = Clock::now() - start;
+		return result;
+	};
+
+	// Warm up the base sizes and the indexed tables so neither run pays for growing them
+	run(true);
+
+	Result linear = run(false);
+	Result indexed = run(true);
+
+	auto to_us = [](Clock::duration d) { return std::chrono::duration_cast<std::chrono::microseconds>(d).count(); };
+
+	CONS_Printf("pathfind_bench: %s queries, %s waypoints, %s paths found\n",
+		sizeu1(queries), sizeu2(numwaypoints), sizeu3(indexed.found));
+	CONS_Printf("  linear:  %8lld us, %6lld ns/query\n",
+		static_cast<long long>(to_us(linear.time)),
+		static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(linear.time).count() / queries));
+	CONS_Printf("  indexed: %8lld us, %6lld ns/query\n",
+		static_cast<long long>(to_us(indexed.time)),
+		static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(indexed.time).count() / queries));
+
+	if (linear.found != indexed.found || linear.totaldist != indexed.totaldist)
+	{
+		CONS_Alert(CONS_WARNING, "pathfind_bench: indexed paths differ from linear paths!\n");
+	}
+}
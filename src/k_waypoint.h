@@ -189,6 +189,50 @@ waypoint_t *K_GetWaypointFromID(INT32 waypointID);
 UINT32 K_GetCircuitLength(void);
 
 
+/*--------------------------------------------------
+	UINT32 K_GetWaypointDistanceToFinish(waypoint_t *waypoint)
+
+		Returns the distance from a waypoint to the finish line without using shortcuts, the same as the totaldist
+		of K_PathfindToWaypoint. Looked up from a table made when the waypoints are set up, except when playing
+		back replays older than 0x000E, which still pathfind like they were recorded.
+
+	Input Arguments:-
+		waypoint - The waypoint to get the distance from
+
+	Return:-
+		The distance, UINT32_MAX if the finish line can't be reached from the waypoint.
+--------------------------------------------------*/
+
+UINT32 K_GetWaypointDistanceToFinish(waypoint_t *waypoint);
+
+
+/*--------------------------------------------------
+	waypoint_t *K_GetWaypointNextToFinish(waypoint_t *waypoint)
+
+		Returns the next waypoint on the shortest way to the finish line without using shortcuts.
+
+	Input Arguments:-
+		waypoint - The waypoint to get the next waypoint from
+
+	Return:-
+		The next waypoint, NULL for the finish line, if it can't be reached from the waypoint, or when playing back
+		replays older than 0x000E.
+--------------------------------------------------*/
+
+waypoint_t *K_GetWaypointNextToFinish(waypoint_t *waypoint);
+
+
+/*--------------------------------------------------
+	void K_UpdateFinishDistances(void)
+
+		Brings the distances to the finish line up to date with waypoints that were enabled or disabled since the
+		last call. A single change only updates the waypoints affected by it. Called every tic before players
+		think, and right after anything which toggles waypoints itself.
+--------------------------------------------------*/
+
+void K_UpdateFinishDistances(void);
+
+
 /*--------------------------------------------------
 	INT32 K_GetTrackComplexity(void)
 
@@ -236,6 +280,44 @@ waypoint_t *K_GetClosestWaypointToMobj(mobj_t *const mobj);
 waypoint_t *K_GetBestWaypointForMobj(mobj_t *const mobj, waypoint_t *const hint);
 
 
+/*--------------------------------------------------
+	size_t K_GetWaypointsInRadius(fixed_t x, fixed_t y, fixed_t radius, waypoint_t **results, size_t maxresults)
+
+		Finds every waypoint horizontally within a radius of a position, using a grid built when the map loads.
+		Distances are measured in whole map units with P_AproxDistance, like K_GetClosestWaypointToMobj.
+
+	Input Arguments:-
+		x          - x position to search around
+		y          - y position to search around
+		radius     - How far to search
+		results    - Array to fill with the waypoints found, in heap index order
+		maxresults - Size of the results array
+
+	Return:-
+		The number of waypoints in the radius, which can be more than maxresults
+--------------------------------------------------*/
+size_t K_GetWaypointsInRadius(fixed_t x, fixed_t y, fixed_t radius, waypoint_t **results, size_t maxresults);
+
+
+/*--------------------------------------------------
+	size_t K_GetNearestWaypoints(fixed_t x, fixed_t y, fixed_t z, waypoint_t **results, size_t count)
+
+		Finds the waypoints closest to a position, using the same distance as K_GetClosestWaypointToMobj.
+		Equally close waypoints are ordered by heap index, so every game gets the same results.
+
+	Input Arguments:-
+		x       - x position to search around
+		y       - y position to search around
+		z       - z position to search around
+		results - Array to fill with the waypoints found, closest first
+		count   - How many waypoints to find, and the size of the results array
+
+	Return:-
+		The number of waypoints found, which is only less than count when the map has fewer waypoints
+--------------------------------------------------*/
+size_t K_GetNearestWaypoints(fixed_t x, fixed_t y, fixed_t z, waypoint_t **results, size_t count);
+
+
 /*--------------------------------------------------
 	boolean K_PathfindToWaypoint(
 		waypoint_t *const sourcewaypoint,
@@ -472,6 +554,9 @@ void K_ClearWaypoints(void);
 
 void K_AdjustWaypointsParameters (void);
 
+/// Debug command: pathfind_bench [queries]
+void Command_PathfindBench_f(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -595,7 +595,7 @@ static int lib_pSpawnMobj(lua_State *L)
 	INLEVEL
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnMobj(x, y, z, type), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnMobj(x, y, z, type));
 	return 1;
 }
 
@@ -612,7 +612,7 @@ static int lib_pSpawnMobjFromMobj(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnMobjFromMobj(actor, x, y, z, type), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnMobjFromMobj(actor, x, y, z, type));
 	return 1;
 }
 
@@ -629,7 +629,7 @@ static int lib_pSpawnMobjFromMobjUnscaled(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnMobjFromMobjUnscaled(actor, x, y, z, type), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnMobjFromMobjUnscaled(actor, x, y, z, type));
 	return 1;
 }
 
@@ -700,7 +700,7 @@ static int lib_pSpawnMissile(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnMissile(source, dest, type), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnMissile(source, dest, type));
 	return 1;
 }
 
@@ -718,7 +718,7 @@ static int lib_pSpawnXYZMissile(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnXYZMissile(source, dest, type, x, y, z), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnXYZMissile(source, dest, type, x, y, z));
 	return 1;
 }
 
@@ -738,7 +738,7 @@ static int lib_pSpawnPointMissile(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnPointMissile(source, xa, ya, za, type, x, y, z), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnPointMissile(source, xa, ya, za, type, x, y, z));
 	return 1;
 }
 
@@ -756,7 +756,7 @@ static int lib_pSpawnAlteredDirectionMissile(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnAlteredDirectionMissile(source, type, x, y, z, shiftingAngle), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnAlteredDirectionMissile(source, type, x, y, z, shiftingAngle));
 	return 1;
 }
 
@@ -787,7 +787,7 @@ static int lib_pSPMAngle(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SPMAngle(source, type, angle, allowaim, flags2), META_MOBJ);
+	LUA_PushMobj(L, P_SPMAngle(source, type, angle, allowaim, flags2));
 	return 1;
 }
 
@@ -802,7 +802,7 @@ static int lib_pSpawnPlayerMissile(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnPlayerMissile(source, type, flags2), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnPlayerMissile(source, type, flags2));
 	return 1;
 }
 
@@ -848,7 +848,7 @@ static int lib_pGetClosestAxis(lua_State *L)
 	INLEVEL
 	if (!source)
 		return LUA_ErrInvalid(L, "mobj_t");
-	LUA_PushUserdata(L, P_GetClosestAxis(source), META_MOBJ);
+	LUA_PushMobj(L, P_GetClosestAxis(source));
 	return 1;
 }
 
@@ -1193,7 +1193,7 @@ static int lib_pSpawnGhostMobj(lua_State *L)
 	INLEVEL
 	if (!mobj)
 		return LUA_ErrInvalid(L, "mobj_t");
-	LUA_PushUserdata(L, P_SpawnGhostMobj(mobj), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnGhostMobj(mobj));
 	return 1;
 }
 
@@ -1205,7 +1205,7 @@ static int lib_pSpawnFakeShadow(lua_State *L)
 	INLEVEL
 	if (!mobj)
 		return LUA_ErrInvalid(L, "mobj_t");
-	LUA_PushUserdata(L, P_SpawnFakeShadow(mobj, offset), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnFakeShadow(mobj, offset));
 	return 1;
 }
 
@@ -1324,7 +1324,7 @@ static int lib_pCheckPosition(lua_State *L)
 	if (!thing)
 		return LUA_ErrInvalid(L, "mobj_t");
 	lua_pushboolean(L, P_CheckPosition(thing, x, y, NULL));
-	LUA_PushUserdata(L, g_tm.thing, META_MOBJ);
+	LUA_PushMobj(L, g_tm.thing);
 	P_RestoreTMStruct(ptm);
 	return 2;
 }
@@ -1341,7 +1341,7 @@ static int lib_pTryMove(lua_State *L)
 	if (!thing)
 		return LUA_ErrInvalid(L, "mobj_t");
 	lua_pushboolean(L, P_TryMove(thing, x, y, allowdropoff, NULL));
-	LUA_PushUserdata(L, g_tm.thing, META_MOBJ);
+	LUA_PushMobj(L, g_tm.thing);
 	P_RestoreTMStruct(ptm);
 	return 2;
 }
@@ -1356,7 +1356,7 @@ static int lib_pMove(lua_State *L)
 	if (!actor)
 		return LUA_ErrInvalid(L, "mobj_t");
 	lua_pushboolean(L, P_Move(actor, speed));
-	LUA_PushUserdata(L, g_tm.thing, META_MOBJ);
+	LUA_PushMobj(L, g_tm.thing);
 	P_RestoreTMStruct(ptm);
 	return 2;
 }
@@ -1374,7 +1374,7 @@ static int lib_pTeleportMove(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	LUA_Deprecated(L, "P_TeleportMove", "P_SetOrigin\" or \"P_MoveOrigin");
 	lua_pushboolean(L, P_MoveOrigin(thing, x, y, z));
-	LUA_PushUserdata(L, g_tm.thing, META_MOBJ);
+	LUA_PushMobj(L, g_tm.thing);
 	P_RestoreTMStruct(ptm);
 	return 2;
 }
@@ -1391,7 +1391,7 @@ static int lib_pSetOrigin(lua_State *L)
 	if (!thing)
 		return LUA_ErrInvalid(L, "mobj_t");
 	lua_pushboolean(L, P_SetOrigin(thing, x, y, z));
-	LUA_PushUserdata(L, g_tm.thing, META_MOBJ);
+	LUA_PushMobj(L, g_tm.thing);
 	P_RestoreTMStruct(ptm);
 	return 2;
 }
@@ -1408,7 +1408,7 @@ static int lib_pMoveOrigin(lua_State *L)
 	if (!thing)
 		return LUA_ErrInvalid(L, "mobj_t");
 	lua_pushboolean(L, P_MoveOrigin(thing, x, y, z));
-	LUA_PushUserdata(L, g_tm.thing, META_MOBJ);
+	LUA_PushMobj(L, g_tm.thing);
 	P_RestoreTMStruct(ptm);
 	return 2;
 }
@@ -1747,7 +1747,7 @@ static int lib_pMobjTouchingSectorSpecial(lua_State *L)
 	INLEVEL
 	if (!mo)
 		return LUA_ErrInvalid(L, "mobj_t");
-	LUA_PushUserdata(L, P_MobjTouchingSectorSpecial(mo, section, number), META_SECTOR);
+	LUA_PushSector(L, P_MobjTouchingSectorSpecial(mo, section, number));
 	return 1;
 }
 
@@ -1759,7 +1759,7 @@ static int lib_pMobjTouchingSectorSpecialFlag(lua_State *L)
 	INLEVEL
 	if (!mo)
 		return LUA_ErrInvalid(L, "mobj_t");
-	LUA_PushUserdata(L, P_MobjTouchingSectorSpecialFlag(mo, flag), META_SECTOR);
+	LUA_PushSector(L, P_MobjTouchingSectorSpecialFlag(mo, flag));
 	return 1;
 }
 
@@ -1772,7 +1772,7 @@ static int lib_pPlayerTouchingSectorSpecial(lua_State *L)
 	INLEVEL
 	if (!player)
 		return LUA_ErrInvalid(L, "player_t");
-	LUA_PushUserdata(L, P_PlayerTouchingSectorSpecial(player, section, number), META_SECTOR);
+	LUA_PushSector(L, P_PlayerTouchingSectorSpecial(player, section, number));
 	return 1;
 }
 
@@ -1784,7 +1784,7 @@ static int lib_pPlayerTouchingSectorSpecialFlag(lua_State *L)
 	INLEVEL
 	if (!player)
 		return LUA_ErrInvalid(L, "player_t");
-	LUA_PushUserdata(L, P_PlayerTouchingSectorSpecialFlag(player, flag), META_SECTOR);
+	LUA_PushSector(L, P_PlayerTouchingSectorSpecialFlag(player, flag));
 	return 1;
 }
 
@@ -3327,12 +3327,14 @@ static int lib_kFindJawzTarget(lua_State *L)
 {
 	mobj_t *actor = *((mobj_t **)luaL_checkudata(L, 1, META_MOBJ));
 	player_t *source = *((player_t **)luaL_checkudata(L, 2, META_PLAYER));
+	mobj_t *target;
 	//HUDSAFE
 	if (!actor)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (!source)
 		return LUA_ErrInvalid(L, "player_t");
-	LUA_PushUserdata(L, K_FindJawzTarget(actor, source, ANGLE_45), META_PLAYER);
+	target = K_FindJawzTarget(actor, source, ANGLE_45);
+	LUA_PushPlayer(L, target ? target->player : NULL);
 	return 1;
 }
 
@@ -3555,7 +3557,7 @@ static int lib_vsGetArena(lua_State *L)
 {
 	INT32 bossindex = luaL_checkinteger(L, 1);
 	//HUDSAFE
-	LUA_PushUserdata(L, VS_GetArena(bossindex), META_MOBJ);
+	LUA_PushMobj(L, VS_GetArena(bossindex));
 	return 1;
 }
 
@@ -97,7 +97,7 @@ void Got_Luacmd(const UINT8 **cp, INT32 playernum)
 		return;
 	}
 
-	LUA_PushUserdata(gL, &players[playernum], META_PLAYER);
+	LUA_PushPlayer(gL, &players[playernum]);
 	for (i = 1; i < argc; i++)
 	{
 		strlcpy(buf, argv[i], 255);
@@ -202,7 +202,7 @@ void COM_Lua_f(void)
 		CONS_Alert(CONS_WARNING, "lua command stack overflow (%d, need %s more)\n", lua_gettop(gL), sizeu1(COM_Argc() + 1));
 		return;
 	}
-	LUA_PushUserdata(gL, &players[playernum], META_PLAYER);
+	LUA_PushPlayer(gL, &players[playernum]);
 	for (i = 1; i < COM_Argc(); i++)
 		lua_pushstring(gL, COM_Argv(i));
 	LUA_Call(gL, (int)COM_Argc(), 0, 1); // COM_Argc is 1-based, so this will cover the player we passed too.
@@ -118,6 +118,16 @@ ENUM (STRING_HOOK);
 
 extern boolean hook_cmd_running;
 
+/*
+A bit per mobj type for each mobj hook, set when calling the hook on that type
+would run anything. Generic hooks (no type given) set every bit. Hot call sites
+test this first, so unhooked types never get as far as LUA_HookMobj.
+*/
+extern bitarray_t mobjHookTypes[MOBJ_HOOK(MAX)][BIT_ARRAY_SIZE(NUMMOBJTYPES)];
+
+/* LUA_MobjHooked(mobj, MobjThinker) */
+#define LUA_MobjHooked(mobj, name) in_bit_array(mobjHookTypes[MOBJ_HOOK(name)], (mobj)->type)
+
 void LUA_HookVoid(int hook);
 void LUA_HookHUD(huddrawlist_h, int hook);
 
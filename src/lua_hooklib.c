@@ -60,6 +60,8 @@ static hook_t hookIds[HOOK(MAX)];
 static hook_t hudHookIds[HUD_HOOK(MAX)];
 static hook_t mobjHookIds[NUMMOBJTYPES][MOBJ_HOOK(MAX)];
 
+bitarray_t mobjHookTypes[MOBJ_HOOK(MAX)][BIT_ARRAY_SIZE(NUMMOBJTYPES)];
+
 // Lua tables are used to lookup string hook ids.
 static stringhook_t stringHooks[STRING_HOOK(MAX)];
 
@@ -74,11 +76,7 @@ static int errorRef;
 
 static boolean mobj_hook_available(int hook_type, mobjtype_t mobj_type)
 {
-	return
-		(
-				mobjHookIds [MT_NULL] [hook_type].numHooks > 0 ||
-				mobjHookIds[mobj_type][hook_type].numHooks > 0
-		);
+	return in_bit_array(mobjHookTypes[hook_type], mobj_type);
 }
 
 static int hook_in_list
@@ -167,6 +165,11 @@ static void add_mobj_hook(lua_State *L, int hook_type)
 	luaL_argcheck(L, mobj_type < NUMMOBJTYPES, 3, "invalid mobjtype_t");
 
 	add_hook(&mobjHookIds[mobj_type][hook_type]);
+
+	if (mobj_type == MT_NULL)
+		memset(mobjHookTypes[hook_type], 0xFF, sizeof mobjHookTypes[hook_type]);
+	else
+		set_bit_array(mobjHookTypes[hook_type], mobj_type);
 }
 
 static void add_hud_hook(lua_State *L, int idx)
@@ -557,6 +560,7 @@ static int call_hooks
 		calls += call_mobj_type_hooks(hook, hook->mobj_type);
 
 		ps_lua_mobjhooks += calls;
+		ps_lua_mobjhooktypes[hook->mobj_type] += calls;
 	}
 	else
 		calls += call_mapped(hook, &hookIds[hook->hook_type]);
@@ -604,7 +608,7 @@ int LUA_HookMobj(mobj_t *mobj, int hook_type)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, false, hook_type, mobj->type))
 	{
-		LUA_PushUserdata(gL, mobj, META_MOBJ);
+		LUA_PushMobj(gL, mobj);
 		call_hooks(&hook, 1, res_true);
 	}
 	return hook.status;
@@ -615,8 +619,8 @@ int LUA_Hook2Mobj(mobj_t *t1, mobj_t *t2, int hook_type)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, 0, hook_type, t1->type))
 	{
-		LUA_PushUserdata(gL, t1, META_MOBJ);
-		LUA_PushUserdata(gL, t2, META_MOBJ);
+		LUA_PushMobj(gL, t1);
+		LUA_PushMobj(gL, t2);
 		call_hooks(&hook, 1, res_force);
 	}
 	return hook.status;
@@ -654,7 +658,7 @@ int LUA_HookPlayer(player_t *player, int hook_type)
 	Hook_State hook;
 	if (prepare_hook(&hook, false, hook_type))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
+		LUA_PushPlayer(gL, player);
 		call_hooks(&hook, 1, res_true);
 	}
 	return hook.status;
@@ -665,7 +669,7 @@ int LUA_HookTiccmd(player_t *player, ticcmd_t *cmd, int hook_type)
 	Hook_State hook;
 	if (prepare_hook(&hook, false, hook_type))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
+		LUA_PushPlayer(gL, player);
 		LUA_PushUserdata(gL, cmd, META_TICCMD);
 
 		if (hook_type == HOOK(PlayerCmd))
@@ -750,7 +754,7 @@ int LUA_HookMobjLineCollide(mobj_t *mobj, line_t *line)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, 0, MOBJ_HOOK(MobjLineCollide), mobj->type))
 	{
-		LUA_PushUserdata(gL, mobj, META_MOBJ);
+		LUA_PushMobj(gL, mobj);
 		LUA_PushUserdata(gL, line, META_LINE);
 		call_hooks(&hook, 1, res_force);
 	}
@@ -762,8 +766,8 @@ int LUA_HookTouchSpecial(mobj_t *special, mobj_t *toucher)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, false, MOBJ_HOOK(TouchSpecial), special->type))
 	{
-		LUA_PushUserdata(gL, special, META_MOBJ);
-		LUA_PushUserdata(gL, toucher, META_MOBJ);
+		LUA_PushMobj(gL, special);
+		LUA_PushMobj(gL, toucher);
 		call_hooks(&hook, 1, res_true);
 	}
 	return hook.status;
@@ -782,9 +786,9 @@ static int damage_hook
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, 0, hook_type, target->type))
 	{
-		LUA_PushUserdata(gL, target, META_MOBJ);
-		LUA_PushUserdata(gL, inflictor, META_MOBJ);
-		LUA_PushUserdata(gL, source, META_MOBJ);
+		LUA_PushMobj(gL, target);
+		LUA_PushMobj(gL, inflictor);
+		LUA_PushMobj(gL, source);
 		if (hook_type != MOBJ_HOOK(MobjDeath))
 			lua_pushinteger(gL, damage);
 		lua_pushinteger(gL, damagetype);
@@ -816,8 +820,8 @@ int LUA_HookMobjMoveBlocked(mobj_t *t1, mobj_t *t2, line_t *line)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, 0, MOBJ_HOOK(MobjMoveBlocked), t1->type))
 	{
-		LUA_PushUserdata(gL, t1, META_MOBJ);
-		LUA_PushUserdata(gL, t2, META_MOBJ);
+		LUA_PushMobj(gL, t1);
+		LUA_PushMobj(gL, t2);
 		LUA_PushUserdata(gL, line, META_LINE);
 		call_hooks(&hook, 1, res_true);
 	}
@@ -847,7 +851,7 @@ int LUA_HookPlayerMsg(int source, int target, int flags, char *msg, int mute)
 	Hook_State hook;
 	if (prepare_hook(&hook, false, HOOK(PlayerMsg)))
 	{
-		LUA_PushUserdata(gL, &players[source], META_PLAYER); // Source player
+		LUA_PushPlayer(gL, &players[source]); // Source player
 		if (flags & 2 /*HU_CSAY*/) { // csay TODO: make HU_CSAY accessible outside hu_stuff.c
 			lua_pushinteger(gL, 3); // type
 			lua_pushnil(gL); // target
@@ -859,7 +863,7 @@ int LUA_HookPlayerMsg(int source, int target, int flags, char *msg, int mute)
 			lua_pushnil(gL); // target
 		} else { // sayto
 			lua_pushinteger(gL, 2); // type
-			LUA_PushUserdata(gL, &players[target-1], META_PLAYER); // target
+			LUA_PushPlayer(gL, &players[target-1]); // target
 		}
 		lua_pushstring(gL, msg); // msg
 		lua_pushboolean(gL, mute); // the message was supposed to be eaten by spamprotecc.
@@ -874,9 +878,9 @@ int LUA_HookHurtMsg(player_t *player, mobj_t *inflictor, mobj_t *source, UINT8 d
 	Hook_State hook;
 	if (prepare_hook(&hook, false, HOOK(HurtMsg)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
-		LUA_PushUserdata(gL, inflictor, META_MOBJ);
-		LUA_PushUserdata(gL, source, META_MOBJ);
+		LUA_PushPlayer(gL, player);
+		LUA_PushMobj(gL, inflictor);
+		LUA_PushMobj(gL, source);
 		lua_pushinteger(gL, damagetype);
 		call_hooks(&hook, 1, res_true);
 	}
@@ -919,7 +923,7 @@ int LUA_HookMapThingSpawn(mobj_t *mobj, mapthing_t *mthing)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, false, MOBJ_HOOK(MapThingSpawn), mobj->type))
 	{
-		LUA_PushUserdata(gL, mobj, META_MOBJ);
+		LUA_PushMobj(gL, mobj);
 		LUA_PushUserdata(gL, mthing, META_MAPTHING);
 		call_hooks(&hook, 1, res_true);
 	}
@@ -931,8 +935,8 @@ int LUA_HookFollowMobj(player_t *player, mobj_t *mobj)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, false, MOBJ_HOOK(FollowMobj), mobj->type))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
-		LUA_PushUserdata(gL, mobj, META_MOBJ);
+		LUA_PushPlayer(gL, player);
+		LUA_PushMobj(gL, mobj);
 		call_hooks(&hook, 1, res_true);
 	}
 	return hook.status;
@@ -943,8 +947,8 @@ int LUA_HookPlayerCanDamage(player_t *player, mobj_t *mobj)
 	Hook_State hook;
 	if (prepare_hook(&hook, 0, HOOK(PlayerCanDamage)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
-		LUA_PushUserdata(gL, mobj, META_MOBJ);
+		LUA_PushPlayer(gL, player);
+		LUA_PushMobj(gL, mobj);
 		call_hooks(&hook, 1, res_force);
 	}
 	return hook.status;
@@ -955,7 +959,7 @@ void LUA_HookPlayerQuit(player_t *plr, kickreason_t reason)
 	Hook_State hook;
 	if (prepare_hook(&hook, 0, HOOK(PlayerQuit)))
 	{
-		LUA_PushUserdata(gL, plr, META_PLAYER); // Player that quit
+		LUA_PushPlayer(gL, plr); // Player that quit
 		lua_pushinteger(gL, reason); // Reason for quitting
 		call_hooks(&hook, 0, res_none);
 	}
@@ -966,7 +970,7 @@ int LUA_HookTeamSwitch(player_t *player, int newteam, boolean fromspectators, bo
 	Hook_State hook;
 	if (prepare_hook(&hook, true, HOOK(TeamSwitch)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
+		LUA_PushPlayer(gL, player);
 		lua_pushinteger(gL, newteam);
 		lua_pushboolean(gL, fromspectators);
 		lua_pushboolean(gL, tryingautobalance);
@@ -981,8 +985,8 @@ int LUA_HookViewpointSwitch(player_t *player, player_t *newdisplayplayer, boolea
 	Hook_State hook;
 	if (prepare_hook(&hook, 0, HOOK(ViewpointSwitch)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
-		LUA_PushUserdata(gL, newdisplayplayer, META_PLAYER);
+		LUA_PushPlayer(gL, player);
+		LUA_PushPlayer(gL, newdisplayplayer);
 		lua_pushboolean(gL, forced);
 
 		hud_running = true; // local hook
@@ -997,8 +1001,8 @@ int LUA_HookSeenPlayer(player_t *player, player_t *seenfriend)
 	Hook_State hook;
 	if (prepare_hook(&hook, true, HOOK(SeenPlayer)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
-		LUA_PushUserdata(gL, seenfriend, META_PLAYER);
+		LUA_PushPlayer(gL, player);
+		LUA_PushPlayer(gL, seenfriend);
 
 		hud_running = true; // local hook
 		call_hooks(&hook, 1, res_false);
@@ -1327,14 +1327,14 @@ void LUA_SetHudHook(int hook, huddrawlist_h list)
 		case HUD_HOOK(game):
 			camnum = R_GetViewNumber();
 
-			LUA_PushUserdata(gL, stplyr, META_PLAYER);
+			LUA_PushPlayer(gL, stplyr);
 			LUA_PushUserdata(gL, &camera[camnum], META_CAMERA);
 
 			camnum++; // for compatibility
 			break;
 
 		case HUD_HOOK(titlecard):
-			LUA_PushUserdata(gL, stplyr, META_PLAYER);
+			LUA_PushPlayer(gL, stplyr);
 			lua_pushinteger(gL, lt_ticker);
 			lua_pushinteger(gL, (lt_endtime + TICRATE));
 			break;
@@ -430,7 +430,7 @@ static int lib_iterateSectorThinglist(lua_State *L)
 
 	if (thing)
 	{
-		LUA_PushUserdata(L, thing, META_MOBJ);
+		LUA_PushMobj(L, thing);
 		return 1;
 	}
 	return 0;
@@ -703,18 +703,18 @@ static int sector_get(lua_State *L)
 		return 1;
 	case sector_thinglist: // thinglist
 		lua_pushcfunction(L, lib_iterateSectorThinglist);
-		LUA_PushUserdata(L, sector->thinglist, META_MOBJ);
+		LUA_PushMobj(L, sector->thinglist);
 		lua_pushcclosure(L, sector_iterate, 2); // push lib_iterateSectorThinglist and sector->thinglist as upvalues for the function
 		return 1;
 	case sector_heightsec: // heightsec - fake floor heights
 		if (sector->heightsec < 0)
 			return 0;
-		LUA_PushUserdata(L, &sectors[sector->heightsec], META_SECTOR);
+		LUA_PushSector(L, &sectors[sector->heightsec]);
 		return 1;
 	case sector_camsec: // camsec - camera clipping heights
 		if (sector->camsec < 0)
 			return 0;
-		LUA_PushUserdata(L, &sectors[sector->camsec], META_SECTOR);
+		LUA_PushSector(L, &sectors[sector->camsec]);
 		return 1;
 	case sector_lines: // lines
 		LUA_PushUserdata(L, &sector->lines, META_SECTORLINES); // push the address of the "lines" member in the struct, to allow our hacks in sectorlines_get/_num to work
@@ -912,7 +912,7 @@ static int subsector_get(lua_State *L)
 		lua_pushboolean(L, 1);
 		return 1;
 	case subsector_sector:
-		LUA_PushUserdata(L, subsector->sector, META_SECTOR);
+		LUA_PushSector(L, subsector->sector);
 		return 1;
 	case subsector_numlines:
 		lua_pushinteger(L, subsector->numlines);
@@ -1077,10 +1077,10 @@ static int line_get(lua_State *L)
 		}
 		return 1;
 	case line_frontsector:
-		LUA_PushUserdata(L, line->frontsector, META_SECTOR);
+		LUA_PushSector(L, line->frontsector);
 		return 1;
 	case line_backsector:
-		LUA_PushUserdata(L, line->backsector, META_SECTOR);
+		LUA_PushSector(L, line->backsector);
 		return 1;
 	case line_polyobj:
 		LUA_PushUserdata(L, line->polyobj, META_POLYOBJ);
@@ -1173,7 +1173,7 @@ static int side_get(lua_State *L)
 		LUA_PushUserdata(L, side->line, META_LINE);
 		return 1;
 	case side_sector:
-		LUA_PushUserdata(L, side->sector, META_SECTOR);
+		LUA_PushSector(L, side->sector);
 		return 1;
 	case side_special:
 		lua_pushinteger(L, side->special);
@@ -1335,10 +1335,10 @@ static int seg_get(lua_State *L)
 		LUA_PushUserdata(L, seg->linedef, META_LINE);
 		return 1;
 	case seg_frontsector:
-		LUA_PushUserdata(L, seg->frontsector, META_SECTOR);
+		LUA_PushSector(L, seg->frontsector);
 		return 1;
 	case seg_backsector:
-		LUA_PushUserdata(L, seg->backsector, META_SECTOR);
+		LUA_PushSector(L, seg->backsector);
 		return 1;
 	case seg_polyseg:
 		LUA_PushUserdata(L, seg->polyseg, META_POLYOBJ);
@@ -1585,7 +1585,7 @@ static int lib_iterateSectors(lua_State *L)
 		i = (size_t)(*((sector_t **)luaL_checkudata(L, 1, META_SECTOR)) - sectors)+1;
 	if (i < numsectors)
 	{
-		LUA_PushUserdata(L, &sectors[i], META_SECTOR);
+		LUA_PushSector(L, &sectors[i]);
 		return 1;
 	}
 	return 0;
@@ -1599,7 +1599,7 @@ static int lib_getSector(lua_State *L)
 		size_t i = lua_tointeger(L, 2);
 		if (i >= numsectors)
 			return 0;
-		LUA_PushUserdata(L, &sectors[i], META_SECTOR);
+		LUA_PushSector(L, &sectors[i]);
 		return 1;
 	}
 	return 0;
@@ -2046,7 +2046,7 @@ static int ffloor_get(lua_State *L)
 		LUA_PushUserdata(L, *ffloor->b_slope, META_SLOPE);
 		return 1;
 	case ffloor_sector:
-		LUA_PushUserdata(L, &sectors[ffloor->secnum], META_SECTOR);
+		LUA_PushSector(L, &sectors[ffloor->secnum]);
 		return 1;
 	case ffloor_fofflags:
 		lua_pushinteger(L, ffloor->fofflags);
@@ -2058,7 +2058,7 @@ static int ffloor_get(lua_State *L)
 		LUA_PushUserdata(L, ffloor->master, META_LINE);
 		return 1;
 	case ffloor_target:
-		LUA_PushUserdata(L, ffloor->target, META_SECTOR);
+		LUA_PushSector(L, ffloor->target);
 		return 1;
 	case ffloor_next:
 		LUA_PushUserdata(L, ffloor->next, META_FFLOOR);
@@ -2613,7 +2613,7 @@ static int activator_get(lua_State *L)
 			return 1;
 
 		case activator_mo:
-			LUA_PushUserdata(L, activator->mo, META_MOBJ);
+			LUA_PushMobj(L, activator->mo);
 			return 1;
 
 		case activator_line:
@@ -2625,7 +2625,7 @@ static int activator_get(lua_State *L)
 			return 1;
 
 		case activator_sector:
-			LUA_PushUserdata(L, activator->sector, META_SECTOR);
+			LUA_PushSector(L, activator->sector);
 			return 1;
 
 		case activator_po:
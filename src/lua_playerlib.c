@@ -53,7 +53,7 @@ static int lib_iteratePlayers(lua_State *L)
 	{
 		if (!playeringame[i])
 			continue;
-		LUA_PushUserdata(L, &players[i], META_PLAYER);
+		LUA_PushPlayer(L, &players[i]);
 		return 1;
 	}
 
@@ -73,7 +73,7 @@ static int lib_getPlayer(lua_State *L)
 			return LUA_PushServerPlayer(L);
 		if (!playeringame[i])
 			return 0;
-		LUA_PushUserdata(L, &players[i], META_PLAYER);
+		LUA_PushPlayer(L, &players[i]);
 		return 1;
 	}
 
@@ -133,7 +133,7 @@ static int lib_iterateDisplayplayers(lua_State *L)
 		if (i > r_splitscreen || !playeringame[displayplayers[i]])
 			return 0;	// Stop! There are no more players for us to go through. There will never be a player gap in displayplayers.
 
-		LUA_PushUserdata(L, &players[displayplayers[i]], META_PLAYER);
+		LUA_PushPlayer(L, &players[displayplayers[i]]);
 		lua_pushinteger(L, i);	// push this to recall what number we were on for the next function call. I suppose this also means you can retrieve the splitscreen player number with 'for p, n in displayplayers.iterate'!
 		return 2;
 	}
@@ -153,7 +153,7 @@ static int lib_getDisplayplayers(lua_State *L)
 			return 0;
 		if (!playeringame[displayplayers[i]])
 			return 0;
-		LUA_PushUserdata(L, &players[displayplayers[i]], META_PLAYER);
+		LUA_PushPlayer(L, &players[displayplayers[i]]);
 		return 1;
 	}
 
@@ -191,7 +191,7 @@ static int player_get(lua_State *L)
 	else if (fastcmp(field,"name"))
 		lua_pushstring(L, player_names[plr-players]);
 	else if (fastcmp(field,"mo"))
-		LUA_PushUserdata(L, plr->mo, META_MOBJ);
+		LUA_PushMobj(L, plr->mo);
 	else if (fastcmp(field,"cmd"))
 		LUA_PushUserdata(L, &plr->cmd, META_TICCMD);
 	else if (fastcmp(field,"oldcmd"))
@@ -530,7 +530,7 @@ static int player_get(lua_State *L)
 	else if (fastcmp(field,"followercolor"))
 		lua_pushinteger(L, plr->followercolor);
 	else if (fastcmp(field,"follower"))
-		LUA_PushUserdata(L, plr->follower, META_MOBJ);
+		LUA_PushMobj(L, plr->follower);
 	//
 
 	// rideroids
@@ -616,7 +616,7 @@ static int player_get(lua_State *L)
 	else if (fastcmp(field,"followitem"))
 		lua_pushinteger(L, plr->followitem);
 	else if (fastcmp(field,"followmobj"))
-		LUA_PushUserdata(L, plr->followmobj, META_MOBJ);
+		LUA_PushMobj(L, plr->followmobj);
 	else if (fastcmp(field,"lives"))
 		lua_pushinteger(L, plr->lives);
 	else if (fastcmp(field,"xtralife"))
@@ -662,7 +662,7 @@ static int player_get(lua_State *L)
 	else if (fastcmp(field,"onconveyor"))
 		lua_pushinteger(L, plr->onconveyor);
 	else if (fastcmp(field,"awayviewmobj")) // FIXME: struct
-		LUA_PushUserdata(L, plr->awayview.mobj, META_MOBJ);
+		LUA_PushMobj(L, plr->awayview.mobj);
 	else if (fastcmp(field,"awayviewtics")) // FIXME: struct
 		lua_pushinteger(L, plr->awayview.tics);
 
@@ -292,7 +292,7 @@ static int polyobj_get(lua_State *L)
 		LUA_PushUserdata(L, &polyobj->lines, META_POLYOBJLINES); // push the address of the "lines" member in the struct, to allow our hacks to work
 		break;
 	case polyobj_sector: // shortcut that exists only in Lua!
-		LUA_PushUserdata(L, polyobj->lines[0]->backsector, META_SECTOR);
+		LUA_PushSector(L, polyobj->lines[0]->backsector);
 		break;
 	case polyobj_angle:
 		lua_pushangle(L, polyobj->angle);
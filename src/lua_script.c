@@ -39,6 +39,9 @@
 #include "doomstat.h"
 #include "g_state.h"
 #include "m_argv.h"
+#include "i_system.h" // I_GetPreciseTime
+#include "core/memory.h"
+#include "m_perfstats.h"
 
 lua_State *gL = NULL;
 
@@ -63,8 +66,24 @@ static lua_CFunction liblist[] = {
 	NULL
 };
 
-// Lua asks for memory using this.
+// Scripts allocate lots of small tables, strings and closures, so give
+// them size-class slabs instead of a zone block with a header each.
+static zslabs_t lua_heap = ZSLABS_INIT(PU_LUA);
+
+// Garbage collection schedule, see LUA_Step
+extern consvar_t cv_lua_gcbudget;
+static boolean lua_gcstopped = false;
+static INT32 lua_gcestimate = 0; // KB in use after the last full cycle
+static INT32 lua_gclastcount = 0; // KB in use after the last LUA_Step
+
+// Lua asks for memory using this. ud is the state's zslabs_t.
 static void *LUA_Alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+	return Z_Slabs_Realloc(ud, ptr, osize, nsize);
+}
+
+// The old allocator, kept to compare against in lua_allocbench.
+static void *LUA_ZoneAlloc(void *ud, void *ptr, size_t osize, size_t nsize)
 {
 	(void)ud;
 	if (nsize == 0) {
@@ -311,7 +330,7 @@ int LUA_PushGlobals(lua_State *L, const char *word)
 	} else if (fastcmp(word,"consoleplayer")) { // player controlling console (aka local player 1)
 		if (!addedtogame || consoleplayer < 0 || !playeringame[consoleplayer])
 			return 0;
-		LUA_PushUserdata(L, &players[consoleplayer], META_PLAYER);
+		LUA_PushPlayer(L, &players[consoleplayer]);
 		return 1;
 	} else if (fastcmp(word,"isserver")) {
 		lua_pushboolean(L, server);
@@ -323,7 +342,7 @@ int LUA_PushGlobals(lua_State *L, const char *word)
 	} else if (fastcmp(word,"server")) {
 		if ((!multiplayer || !netgame) && !playeringame[serverplayer])
 			return 0;
-		LUA_PushUserdata(L, &players[serverplayer], META_PLAYER);
+		LUA_PushPlayer(L, &players[serverplayer]);
 		return 1;
 	} else if (fastcmp(word,"gravity")) {
 		lua_pushinteger(L, gravity);
@@ -494,11 +513,14 @@ void LUA_ClearState(void)
 	if (gL)
 		lua_close(gL);
 	gL = NULL;
+	Z_Slabs_Release(&lua_heap);
+	lua_gcstopped = false;
+	lua_gcestimate = lua_gclastcount = 0;
 
 	CONS_Printf(M_GetText("Pardon me while I initialize the Lua scripting interface...\n"));
 
 	// allocate state
-	L = lua_newstate(LUA_Alloc, NULL);
+	L = lua_newstate(LUA_Alloc, &lua_heap);
 	lua_atpanic(L, LUA_Panic);
 
 	// open base libraries
@@ -689,13 +711,14 @@ void LUA_DumpFile(const char *filename)
 fixed_t LUA_EvalMath(const char *word)
 {
 	lua_State *L = NULL;
+	zslabs_t heap = ZSLABS_INIT(PU_LUA);
 	char buf[1024], *b;
 	const char *p;
 	fixed_t res = 0;
 
 	// make a new state so SOC can't interefere with scripts
 	// allocate state
-	L = lua_newstate(LUA_Alloc, NULL);
+	L = lua_newstate(LUA_Alloc, &heap);
 	lua_atpanic(L, LUA_Panic);
 
 	// open only enum lib
@@ -732,6 +755,7 @@ fixed_t LUA_EvalMath(const char *word)
 
 	// clean up and return.
 	lua_close(L);
+	Z_Slabs_Release(&heap);
 	return res;
 }
 
@@ -747,8 +771,16 @@ void LUA_PushUserdata(lua_State *L, void *data, const char *meta)
 	}
 }
 
-// Same as LUA_PushUserdata but don't set a metatable yet.
-lpushed_t LUA_RawPushUserdata(lua_State *L, void *data)
+// Userdata for objects which remember a registry reference to it.
+// data must come first, so it still reads as a plain pointer everywhere.
+typedef struct
+{
+	void *data;
+	INT32 ref;
+	size_t refoffset; // where in *data the reference is kept
+} cacheduserdata_t;
+
+static lpushed_t LUA_RawPushUserdataSized(lua_State *L, void *data, size_t size)
 {
 	lpushed_t status = LPUSHED_NIL;
 
@@ -769,7 +801,8 @@ lpushed_t LUA_RawPushUserdata(lua_State *L, void *data)
 		lua_pop(L, 1); // pop the nil
 
 		// create the userdata
-		userdata = lua_newuserdata(L, sizeof(void *));
+		userdata = lua_newuserdata(L, size);
+		memset(userdata, 0, size);
 		*userdata = data;
 
 		// Set it in the registry so we can find it again
@@ -789,11 +822,80 @@ lpushed_t LUA_RawPushUserdata(lua_State *L, void *data)
 	return status;
 }
 
+// Same as LUA_PushUserdata but don't set a metatable yet.
+lpushed_t LUA_RawPushUserdata(lua_State *L, void *data)
+{
+	return LUA_RawPushUserdataSized(L, data, sizeof (void *));
+}
+
+// Like LUA_PushUserdata, but the userdata is also kept in a registry slot,
+// and the slot number in *ref, so next time it only takes a lua_rawgeti.
+static void LUA_PushCachedUserdata(lua_State *L, void *data, INT32 *ref, const char *meta)
+{
+	cacheduserdata_t *userdata;
+	lpushed_t status;
+
+	if (!data) {
+		lua_pushnil(L);
+		return;
+	}
+
+	if (*ref > 0)
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, *ref);
+
+		// The object could have been copied over, or the slot could be
+		// from a Lua state that has since been closed.
+		userdata = lua_touserdata(L, -1);
+		if (lua_type(L, -1) == LUA_TUSERDATA && lua_objlen(L, -1) == sizeof *userdata
+			&& userdata->data == data && userdata->ref == *ref)
+			return;
+
+		lua_pop(L, 1);
+	}
+
+	status = LUA_RawPushUserdataSized(L, data, sizeof *userdata);
+
+	if (status == LPUSHED_NEW)
+	{
+		luaL_getmetatable(L, meta);
+		lua_setmetatable(L, -2);
+	}
+
+	// Userdata made by LUA_PushUserdata has no room for the reference
+	if (lua_objlen(L, -1) != sizeof *userdata)
+		return;
+
+	userdata = lua_touserdata(L, -1);
+	if (status == LPUSHED_NEW)
+	{
+		lua_pushvalue(L, -1);
+		userdata->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+		userdata->refoffset = (UINT8 *)ref - (UINT8 *)data;
+	}
+	*ref = userdata->ref;
+}
+
+void LUA_PushMobj(lua_State *L, mobj_t *mobj)
+{
+	LUA_PushCachedUserdata(L, mobj, mobj ? &mobj->luaref : NULL, META_MOBJ);
+}
+
+void LUA_PushPlayer(lua_State *L, player_t *player)
+{
+	LUA_PushCachedUserdata(L, player, player ? &player->luaref : NULL, META_PLAYER);
+}
+
+void LUA_PushSector(lua_State *L, sector_t *sector)
+{
+	LUA_PushCachedUserdata(L, sector, sector ? &sector->luaref : NULL, META_SECTOR);
+}
+
 int LUA_PushServerPlayer(lua_State *L)
 {
 	if ((!multiplayer || !(netgame || demo.playback)) && !playeringame[serverplayer])
 		return 0;
-	LUA_PushUserdata(L, &players[serverplayer], META_PLAYER);
+	LUA_PushPlayer(L, &players[serverplayer]);
 	return 1;
 }
 
@@ -824,6 +926,15 @@ void LUA_InvalidateUserdata(void *data)
 
 			// invalidate the userdata
 			userdata = lua_touserdata(gL, -1);
+			if (lua_objlen(gL, -1) == sizeof (cacheduserdata_t))
+			{
+				cacheduserdata_t *cached = (cacheduserdata_t *)userdata;
+				INT32 *ref = (INT32 *)((UINT8 *)data + cached->refoffset);
+
+				if (*ref == cached->ref)
+					*ref = 0;
+				luaL_unref(gL, LUA_REGISTRYINDEX, cached->ref);
+			}
 			*userdata = NULL;
 		lua_pop(gL, 1);
 
@@ -1486,10 +1597,10 @@ static UINT8 UnArchiveValue(UINT8 **p, int TABLESINDEX)
 		LUA_PushUserdata(gL, &states[READUINT16(*p)], META_STATE);
 		break;
 	case ARCH_MOBJ:
-		LUA_PushUserdata(gL, P_FindNewPosition(READUINT32(*p)), META_MOBJ);
+		LUA_PushMobj(gL, P_FindNewPosition(READUINT32(*p)));
 		break;
 	case ARCH_PLAYER:
-		LUA_PushUserdata(gL, &players[READUINT8(*p)], META_PLAYER);
+		LUA_PushPlayer(gL, &players[READUINT8(*p)]);
 		break;
 	case ARCH_MAPTHING:
 		LUA_PushUserdata(gL, &mapthings[READUINT16(*p)], META_MAPTHING);
@@ -1507,7 +1618,7 @@ static UINT8 UnArchiveValue(UINT8 **p, int TABLESINDEX)
 		LUA_PushUserdata(gL, &subsectors[READUINT16(*p)], META_SUBSECTOR);
 		break;
 	case ARCH_SECTOR:
-		LUA_PushUserdata(gL, &sectors[READUINT16(*p)], META_SECTOR);
+		LUA_PushSector(gL, &sectors[READUINT16(*p)]);
 		break;
 #ifdef HAVE_LUA_SEGS
 	case ARCH_SEG:
@@ -1629,12 +1740,79 @@ static void UnArchiveTables(UINT8 **p)
 	}
 }
 
-void LUA_Step(void)
+// Collect garbage in the idle time at the end of a frame. While
+// lua_gcbudget is set, Lua's automatic collection stays off so it can't
+// land in the middle of a hook. The collector gets up to that many
+// microseconds of the time left before the frame cap instead, and always
+// at least one step.
+void LUA_Step(precise_t slack)
 {
+	precise_t start, budget;
+	INT32 allocated;
+
+	ps_lua_gc_steps = 0;
+	ps_lua_gc_catchupkb = 0;
+
 	if (!gL)
 		return;
 	lua_settop(gL, 0);
-	lua_gc(gL, LUA_GCSTEP, 1);
+
+	start = I_GetPreciseTime();
+
+	if (cv_lua_gcbudget.value == 0)
+	{
+		// Let Lua collect whenever it allocates
+		if (lua_gcstopped)
+		{
+			lua_gc(gL, LUA_GCRESTART, 0);
+			lua_gcstopped = false;
+		}
+
+		if (lua_gc(gL, LUA_GCSTEP, 1))
+			ps_lua_gc_cycles++;
+		ps_lua_gc_steps = 1;
+	}
+	else
+	{
+		budget = min(slack, (precise_t)cv_lua_gcbudget.value * I_GetPrecisePrecision() / 1000000);
+		allocated = lua_gc(gL, LUA_GCCOUNT, 0) - lua_gclastcount;
+
+		do
+		{
+			if (lua_gc(gL, LUA_GCSTEP, 0))
+			{
+				lua_gcestimate = lua_gc(gL, LUA_GCCOUNT, 0);
+				ps_lua_gc_cycles++;
+			}
+			ps_lua_gc_steps++;
+		} while (I_GetPreciseTime() - start < budget);
+
+		// Past twice the live size, where Lua would be collecting on its
+		// own, make the collector keep pace with allocation even if that
+		// goes over budget. Otherwise the heap could grow forever.
+		if (allocated > 0 && lua_gc(gL, LUA_GCCOUNT, 0) > 2 * lua_gcestimate)
+		{
+			if (lua_gc(gL, LUA_GCSTEP, allocated))
+			{
+				lua_gcestimate = lua_gc(gL, LUA_GCCOUNT, 0);
+				ps_lua_gc_cycles++;
+			}
+			ps_lua_gc_catchupkb = allocated;
+		}
+
+		// Stepping sets the automatic threshold again
+		lua_gc(gL, LUA_GCSTOP, 0);
+		lua_gcstopped = true;
+	}
+
+	lua_gclastcount = lua_gc(gL, LUA_GCCOUNT, 0);
+
+	ps_lua_gc_time = I_GetPreciseTime() - start;
+	ps_lua_heapkb = lua_gclastcount;
+	ps_lua_gcestimatekb = lua_gcestimate;
+	ps_lua_slabkb = (int)(lua_heap.small_bytes >> 10);
+	ps_lua_largekb = (int)(lua_heap.large_bytes >> 10);
+	ps_lua_chunkkb = (int)(lua_heap.reserved >> 10);
 }
 
 void LUA_Archive(savebuffer_t *save, boolean network)
@@ -1762,3 +1940,131 @@ void LUA_PushTaggableObjectArray
 		lua_setmetatable(L, -2);
 	lua_setglobal(L, field);
 }
+
+// Stands in for ThinkFrame hooks on an addon-heavy server: short-lived
+// tables, strings and closures every frame, with a few kept around.
+static const char lua_allocbench_script[] =
+	"local objects = ...\n"
+	"local kept = {}\n"
+	"return function(frame)\n"
+	"	for i = 1, objects do\n"
+	"		local t = {x = i, y = frame, name = \"mo\" .. (i % 64)}\n"
+	"		t.trail = {i, frame, i + frame}\n"
+	"		local get = function() return t.x + frame end\n"
+	"		kept[(i % 256) + 1] = t\n"
+	"		get()\n"
+	"	end\n"
+	"	return \"frame \" .. frame\n"
+	"end\n";
+
+static precise_t LUA_AllocBenchRun(lua_Alloc alloc, void *ud, INT32 frames, INT32 objects)
+{
+	lua_State *L = lua_newstate(alloc, ud);
+	precise_t elapsed;
+	INT32 i;
+
+	lua_atpanic(L, LUA_Panic);
+	luaL_openlibs(L);
+
+	luaL_loadstring(L, lua_allocbench_script);
+	lua_pushinteger(L, objects);
+	lua_call(L, 1, 1);
+
+	elapsed = I_GetPreciseTime();
+	for (i = 0; i < frames; i++)
+	{
+		// Call the hook, then step the collector like LUA_Step does with no budget
+		lua_pushvalue(L, -1);
+		lua_pushinteger(L, i);
+		lua_call(L, 1, 0);
+		lua_gc(L, LUA_GCSTEP, 1);
+	}
+	elapsed = I_GetPreciseTime() - elapsed;
+
+	lua_close(L);
+	return elapsed;
+}
+
+void Command_LuaAllocBench_f(void)
+{
+	INT32 frames = COM_Argc() > 1 ? max(1, atoi(COM_Argv(1))) : 1000;
+	INT32 objects = COM_Argc() > 2 ? max(1, atoi(COM_Argv(2))) : 200;
+	zslabs_t heap = ZSLABS_INIT(PU_LUA);
+	double zoneus, slabus;
+
+	zoneus = (double)LUA_AllocBenchRun(LUA_ZoneAlloc, NULL, frames, objects) * 1000000.0 / I_GetPrecisePrecision();
+	slabus = (double)LUA_AllocBenchRun(LUA_Alloc, &heap, frames, objects) * 1000000.0 / I_GetPrecisePrecision();
+
+	CONS_Printf("lua_allocbench: %d frames, %d objects per frame\n", frames, objects);
+	CONS_Printf("  zone:  %8.0f us, %8.2f us/frame\n", zoneus, zoneus / frames);
+	CONS_Printf("  slabs: %8.0f us, %8.2f us/frame\n", slabus, slabus / frames);
+	CONS_Printf("  %s allocations, %s KB of slab chunks\n", sizeu1(heap.allocs), sizeu2(heap.reserved >> 10));
+
+	Z_Slabs_Release(&heap);
+}
+
+// A MobjThinker hook which only touches its argument, so the time is mostly spent pushing the mobj.
+static const char *lua_pushbench_script =
+	"local pushes = 0\n"
+	"return function(mo)\n"
+	"	pushes = pushes + 1\n"
+	"end\n";
+
+static precise_t LUA_PushBenchRun(mobj_t *mobjs, INT32 count, INT32 tics, boolean cached)
+{
+	lua_State *L = lua_newstate(LUA_ZoneAlloc, NULL);
+	precise_t elapsed;
+	INT32 i, j;
+
+	lua_atpanic(L, LUA_Panic);
+	luaL_openlibs(L);
+
+	lua_newtable(L);
+	lua_setfield(L, LUA_REGISTRYINDEX, LREG_VALID);
+	luaL_newmetatable(L, META_MOBJ);
+	lua_pop(L, 1);
+
+	luaL_loadstring(L, lua_pushbench_script);
+	lua_call(L, 0, 1);
+
+	elapsed = I_GetPreciseTime();
+	for (i = 0; i < tics; i++)
+	{
+		for (j = 0; j < count; j++)
+		{
+			lua_pushvalue(L, -1);
+			if (cached)
+				LUA_PushMobj(L, &mobjs[j]);
+			else
+				LUA_PushUserdata(L, &mobjs[j], META_MOBJ);
+			lua_call(L, 1, 0);
+		}
+	}
+	elapsed = I_GetPreciseTime() - elapsed;
+
+	lua_close(L);
+
+	// The references belonged to the closed state
+	for (j = 0; j < count; j++)
+		mobjs[j].luaref = 0;
+
+	return elapsed;
+}
+
+void Command_LuaPushBench_f(void)
+{
+	INT32 count = COM_Argc() > 1 ? max(1, atoi(COM_Argv(1))) : 2000;
+	INT32 tics = COM_Argc() > 2 ? max(1, atoi(COM_Argv(2))) : 350;
+	mobj_t *mobjs = Z_Calloc(count * sizeof *mobjs, PU_STATIC, NULL);
+	double pushes = (double)count * tics;
+	double registrys, cacheds;
+
+	registrys = (double)LUA_PushBenchRun(mobjs, count, tics, false) / I_GetPrecisePrecision();
+	cacheds = (double)LUA_PushBenchRun(mobjs, count, tics, true) / I_GetPrecisePrecision();
+
+	CONS_Printf("lua_pushbench: %d mobjs, %d tics\n", count, tics);
+	CONS_Printf("  registry table: %8.3f s, %10.0f pushes/s\n", registrys, pushes / registrys);
+	CONS_Printf("  cached ref:     %8.3f s, %10.0f pushes/s\n", cacheds, pushes / cacheds);
+
+	Z_Free(mobjs);
+}
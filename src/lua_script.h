@@ -57,7 +57,7 @@ void LUA_LoadLump(UINT16 wad, UINT16 lump, boolean noresults);
 void LUA_DumpFile(const char *filename);
 #endif
 fixed_t LUA_EvalMath(const char *word);
-void LUA_Step(void);
+void LUA_Step(precise_t slack);
 void LUA_Archive(savebuffer_t *save, boolean network);
 void LUA_UnArchive(savebuffer_t *save, boolean network);
 
@@ -99,6 +99,12 @@ typedef enum {
 void LUA_PushUserdata(lua_State *L, void *data, const char *meta);
 lpushed_t LUA_RawPushUserdata(lua_State *L, void *data);
 
+// Faster versions of LUA_PushUserdata for the most pushed types.
+// The object keeps a reference to its userdata in luaref.
+void LUA_PushMobj(lua_State *L, mobj_t *mobj);
+void LUA_PushPlayer(lua_State *L, player_t *player);
+void LUA_PushSector(lua_State *L, sector_t *sector);
+
 int  LUA_PushServerPlayer(lua_State *L);
 
 void LUA_InvalidateUserdata(void *data);
@@ -110,6 +116,12 @@ void LUA_InvalidatePlayer(player_t *player);
 // Console wrapper
 void COM_Lua_f(void);
 
+/// Debug command: lua_allocbench [frames] [objects per frame]
+void Command_LuaAllocBench_f(void);
+
+/// Debug command: lua_pushbench [mobjs] [tics]
+void Command_LuaPushBench_f(void);
+
 #define LUA_ErrInvalid(L, type) luaL_error(L, "accessed " type " doesn't exist anymore, please check 'valid' before using " type ".");
 
 #define LUA_ErrSetDirectly(L, type, field) luaL_error(L, type " field " LUA_QL(field) " cannot be set directly.")
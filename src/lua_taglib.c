@@ -54,7 +54,10 @@ static INT32 next_element(lua_State *L, const mtag_t tag, const size_t p)
 
 static void push_element(lua_State *L, void *element)
 {
-	if (LUA_RawPushUserdata(L, element) == LPUSHED_NEW)
+	// Sectors carry their own cached userdata
+	if (lua_touserdata(L, up_element_array) == &sectors)
+		LUA_PushSector(L, element);
+	else if (LUA_RawPushUserdata(L, element) == LPUSHED_NEW)
 	{
 		lua_pushvalue(L, up_meta);
 		lua_setmetatable(L, -2);
@@ -46,7 +46,7 @@ static int iterationState_gc(lua_State *L)
 
 #define push_thinker(th) {\
 	if ((th)->function.acp1 == (actionf_p1)P_MobjThinker) \
-		LUA_PushUserdata(L, (th), META_MOBJ); \
+		LUA_PushMobj(L, (mobj_t *)(th)); \
 	else \
 		lua_pushlightuserdata(L, (th)); \
 }
@@ -0,0 +1,412 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_compress.cpp
+/// \brief Pluggable compression for savegames and other buffers sent over the network
+
+#include "m_compress.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <zdict.h>
+#include <zstd.h>
+
+#include "console.h"
+#include "lzf.h"
+#include "w_wad.h"
+#include "z_zone.h"
+
+const char *const compressornames[NUMCOMPRESSORS] = {"None", "LZF", "Zstd"};
+
+// Fast levels; the savegame is on the wire for far longer than it takes to compress.
+static constexpr int kZstdLevel = 3;
+
+// Set once at startup, then only read, so every thread can share them.
+static ZSTD_CDict *zstd_cdict;
+static ZSTD_DDict *zstd_ddict;
+
+void M_LoadCompressionDictionary(void)
+{
+	lumpnum_t lump = W_CheckNumForName("NETSDICT");
+	if (lump == LUMPERROR || zstd_cdict)
+	{
+		return;
+	}
+
+	size_t length = W_LumpLength(lump);
+	void *dict = W_CacheLumpNum(lump, PU_STATIC);
+
+	zstd_cdict = ZSTD_createCDict(dict, length, kZstdLevel);
+	zstd_ddict = ZSTD_createDDict(dict, length);
+	Z_Free(dict);
+
+	if (!zstd_cdict || !zstd_ddict)
+	{
+		ZSTD_freeCDict(zstd_cdict);
+		ZSTD_freeDDict(zstd_ddict);
+		zstd_cdict = NULL;
+		zstd_ddict = NULL;
+		CONS_Alert(CONS_WARNING, "NETSDICT is not a valid compression dictionary\n");
+		return;
+	}
+
+	CONS_Printf("Loaded network compression dictionary %u (%s bytes)\n",
+		ZSTD_getDictID_fromDDict(zstd_ddict), sizeu1(length));
+}
+
+void M_WriteCompressedHeader(UINT8 *out, compressor_t codec, size_t rawlength)
+{
+	out[0] = static_cast<UINT8>(codec);
+	for (int i = 0; i < 4; i++)
+	{
+		out[1 + i] = static_cast<UINT8>(rawlength >> (i * 8));
+	}
+}
+
+boolean M_CompressedBufferInfo(const UINT8 *in, size_t inlength, compressor_t *codec, size_t *rawlength)
+{
+	if (inlength < COMPRESS_HEADERSIZE || in[0] >= NUMCOMPRESSORS)
+	{
+		return false;
+	}
+
+	*codec = static_cast<compressor_t>(in[0]);
+	*rawlength = in[1] | (in[2] << 8) | (in[3] << 16) | (static_cast<size_t>(in[4]) << 24);
+	return true;
+}
+
+static size_t compress_payload(compressor_t codec, const UINT8 *in, size_t inlength, UINT8 *out, size_t outcap)
+{
+	switch (codec)
+	{
+		case COMPRESSOR_LZF:
+			return lzf_compress(in, inlength, out, outcap);
+
+		case COMPRESSOR_ZSTD:
+		{
+			ZSTD_CCtx *cctx = ZSTD_createCCtx();
+			if (!cctx)
+			{
+				return 0;
+			}
+			size_t length = zstd_cdict
+				? ZSTD_compress_usingCDict(cctx, out, outcap, in, inlength, zstd_cdict)
+				: ZSTD_compressCCtx(cctx, out, outcap, in, inlength, kZstdLevel);
+			ZSTD_freeCCtx(cctx);
+			return ZSTD_isError(length) ? 0 : length;
+		}
+
+		default:
+			return 0;
+	}
+}
+
+size_t M_CompressBuffer(compressor_t codec, const UINT8 *in, size_t inlength, UINT8 *out, size_t outcap)
+{
+	if (outcap < COMPRESS_HEADERSIZE)
+	{
+		return 0;
+	}
+
+	// Only worthwhile if it comes out smaller than storing the data.
+	size_t payloadcap = std::min(outcap, inlength + COMPRESS_HEADERSIZE) - COMPRESS_HEADERSIZE;
+	if (payloadcap > 0)
+	{
+		payloadcap--;
+	}
+
+	size_t length = 0;
+	if (codec != COMPRESSOR_NONE && payloadcap > 0)
+	{
+		length = compress_payload(codec, in, inlength, out + COMPRESS_HEADERSIZE, payloadcap);
+	}
+
+	if (length == 0)
+	{
+		if (outcap - COMPRESS_HEADERSIZE < inlength)
+		{
+			return 0;
+		}
+		codec = COMPRESSOR_NONE;
+		memcpy(out + COMPRESS_HEADERSIZE, in, inlength);
+		length = inlength;
+	}
+
+	M_WriteCompressedHeader(out, codec, inlength);
+	return length + COMPRESS_HEADERSIZE;
+}
+
+size_t M_DecompressBuffer(const UINT8 *in, size_t inlength, UINT8 *out, size_t outcap)
+{
+	compressor_t codec;
+	size_t rawlength;
+
+	if (!M_CompressedBufferInfo(in, inlength, &codec, &rawlength) || rawlength > outcap)
+	{
+		return 0;
+	}
+
+	in += COMPRESS_HEADERSIZE;
+	inlength -= COMPRESS_HEADERSIZE;
+
+	switch (codec)
+	{
+		case COMPRESSOR_NONE:
+			if (inlength != rawlength)
+			{
+				return 0;
+			}
+			memcpy(out, in, rawlength);
+			return rawlength;
+
+		case COMPRESSOR_LZF:
+			return lzf_decompress(in, inlength, out, rawlength) == rawlength ? rawlength : 0;
+
+		case COMPRESSOR_ZSTD:
+		{
+			ZSTD_DCtx *dctx = ZSTD_createDCtx();
+			if (!dctx)
+			{
+				return 0;
+			}
+			size_t length = zstd_ddict
+				? ZSTD_decompress_usingDDict(dctx, out, rawlength, in, inlength, zstd_ddict)
+				: ZSTD_decompressDCtx(dctx, out, rawlength, in, inlength);
+			ZSTD_freeDCtx(dctx);
+			return !ZSTD_isError(length) && length == rawlength ? rawlength : 0;
+		}
+
+		default:
+			return 0;
+	}
+}
+
+struct decompressstream_s
+{
+	UINT8 header[COMPRESS_HEADERSIZE];
+	size_t headerlength;
+
+	compressor_t codec;
+	UINT8 *out;
+	size_t rawlength;
+	size_t maxlength;
+	size_t outpos;
+
+	// Codecs without a streaming decoder collect their input here.
+	std::vector<UINT8> pending;
+
+	ZSTD_DCtx *dctx;
+	bool done;
+	bool bad;
+};
+
+decompressstream_t *M_DecompressStreamBegin(size_t maxlength)
+{
+	decompressstream_t *stream = new decompressstream_t {};
+	stream->maxlength = maxlength;
+	return stream;
+}
+
+static bool stream_start(decompressstream_t *stream)
+{
+	// The length comes from the sender; don't let it pick how much we allocate
+	if (!M_CompressedBufferInfo(stream->header, COMPRESS_HEADERSIZE, &stream->codec, &stream->rawlength)
+		|| stream->rawlength > stream->maxlength)
+	{
+		return false;
+	}
+
+	stream->out = static_cast<UINT8 *>(malloc(std::max<size_t>(stream->rawlength, 1)));
+	if (!stream->out)
+	{
+		return false;
+	}
+
+	if (stream->codec == COMPRESSOR_ZSTD)
+	{
+		stream->dctx = ZSTD_createDCtx();
+		if (!stream->dctx)
+		{
+			return false;
+		}
+		if (zstd_ddict)
+		{
+			ZSTD_DCtx_refDDict(stream->dctx, zstd_ddict);
+		}
+	}
+	else if (stream->codec == COMPRESSOR_LZF)
+	{
+		stream->pending.reserve(stream->rawlength);
+	}
+
+	return true;
+}
+
+boolean M_DecompressStreamFeed(decompressstream_t *stream, const UINT8 *in, size_t length)
+{
+	if (stream->bad)
+	{
+		return false;
+	}
+
+	if (stream->headerlength < COMPRESS_HEADERSIZE)
+	{
+		size_t n = std::min(length, COMPRESS_HEADERSIZE - stream->headerlength);
+		memcpy(stream->header + stream->headerlength, in, n);
+		stream->headerlength += n;
+		in += n;
+		length -= n;
+
+		if (stream->headerlength == COMPRESS_HEADERSIZE && !stream_start(stream))
+		{
+			stream->bad = true;
+			return false;
+		}
+	}
+
+	if (length == 0)
+	{
+		return true;
+	}
+
+	switch (stream->codec)
+	{
+		case COMPRESSOR_NONE:
+			if (length > stream->rawlength - stream->outpos)
+			{
+				stream->bad = true;
+				break;
+			}
+			memcpy(stream->out + stream->outpos, in, length);
+			stream->outpos += length;
+			break;
+
+		case COMPRESSOR_LZF:
+			stream->pending.insert(stream->pending.end(), in, in + length);
+			break;
+
+		case COMPRESSOR_ZSTD:
+		{
+			ZSTD_inBuffer input = {in, length, 0};
+			while (input.pos < input.size)
+			{
+				if (stream->done)
+				{
+					// Trailing garbage after the frame
+					stream->bad = true;
+					break;
+				}
+
+				ZSTD_outBuffer output = {stream->out, stream->rawlength, stream->outpos};
+				size_t inpos = input.pos;
+				size_t ret = ZSTD_decompressStream(stream->dctx, &output, &input);
+				bool progress = input.pos != inpos || output.pos != stream->outpos;
+				stream->outpos = output.pos;
+
+				if (ZSTD_isError(ret))
+				{
+					CONS_Debug(DBG_NETPLAY, "Decompression failed: %s\n", ZSTD_getErrorName(ret));
+					stream->bad = true;
+					break;
+				}
+				if (ret == 0)
+				{
+					stream->done = true;
+				}
+				else if (!progress)
+				{
+					// More output than the header promised
+					stream->bad = true;
+					break;
+				}
+			}
+			break;
+		}
+
+		default:
+			stream->bad = true;
+			break;
+	}
+
+	return !stream->bad;
+}
+
+void M_DecompressStreamAbort(decompressstream_t *stream)
+{
+	if (!stream)
+	{
+		return;
+	}
+
+	ZSTD_freeDCtx(stream->dctx);
+	free(stream->out);
+	delete stream;
+}
+
+UINT8 *M_DecompressStreamFinish(decompressstream_t *stream, size_t *rawlength)
+{
+	bool ok = !stream->bad && stream->headerlength == COMPRESS_HEADERSIZE;
+
+	if (ok)
+	{
+		switch (stream->codec)
+		{
+			case COMPRESSOR_NONE:
+				ok = stream->outpos == stream->rawlength;
+				break;
+
+			case COMPRESSOR_LZF:
+				ok = lzf_decompress(stream->pending.data(), stream->pending.size(), stream->out, stream->rawlength)
+					== stream->rawlength;
+				break;
+
+			case COMPRESSOR_ZSTD:
+				ok = stream->done && stream->outpos == stream->rawlength;
+				break;
+
+			default:
+				ok = false;
+				break;
+		}
+	}
+
+	UINT8 *out = NULL;
+	if (ok)
+	{
+		out = stream->out;
+		stream->out = NULL;
+		*rawlength = stream->rawlength;
+	}
+
+	M_DecompressStreamAbort(stream);
+	return out;
+}
+
+size_t M_TrainCompressionDictionary(const UINT8 *const *samples, const size_t *samplelengths, size_t numsamples,
+	UINT8 *out, size_t outcap)
+{
+	// The trainer wants one contiguous buffer.
+	std::vector<UINT8> joined;
+	std::vector<size_t> lengths(samplelengths, samplelengths + numsamples);
+
+	for (size_t i = 0; i < numsamples; i++)
+	{
+		joined.insert(joined.end(), samples[i], samples[i] + samplelengths[i]);
+	}
+
+	size_t length = ZDICT_trainFromBuffer(out, outcap, joined.data(), lengths.data(), static_cast<unsigned>(numsamples));
+	if (ZDICT_isError(length))
+	{
+		CONS_Alert(CONS_ERROR, "Dictionary training failed: %s\n", ZDICT_getErrorName(length));
+		return 0;
+	}
+	return length;
+}
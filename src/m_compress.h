@@ -0,0 +1,83 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_compress.h
+/// \brief Pluggable compression for savegames and other buffers sent over the network
+
+#ifndef __M_COMPRESS__
+#define __M_COMPRESS__
+
+#include "doomtype.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+	COMPRESSOR_NONE,
+	COMPRESSOR_LZF,
+	COMPRESSOR_ZSTD,
+	NUMCOMPRESSORS
+} compressor_t;
+
+extern const char *const compressornames[NUMCOMPRESSORS];
+
+// A compressed buffer starts with a UINT8 compressor_t and the UINT32
+// uncompressed length, so the receiver needs no other information.
+#define COMPRESS_HEADERSIZE 5
+
+// Enough room for any M_CompressBuffer output; incompressible data is stored.
+#define M_CompressBufferBound(length) ((length) + COMPRESS_HEADERSIZE)
+
+// Load the zstd dictionary from the NETSDICT lump of the main files, if any.
+// Call once the main files are loaded. Both ends must have the same one, so
+// addons cannot replace it.
+void M_LoadCompressionDictionary(void);
+
+// Compress in, including the header. Falls back to COMPRESSOR_NONE if the
+// codec does not make it smaller. Safe to call from any thread.
+// Returns the total length, or 0 if outcap is too small.
+size_t M_CompressBuffer(compressor_t codec, const UINT8 *in, size_t inlength, UINT8 *out, size_t outcap);
+
+// Write just the header, for data already stored after COMPRESS_HEADERSIZE bytes.
+void M_WriteCompressedHeader(UINT8 *out, compressor_t codec, size_t rawlength);
+
+// Read the header of a compressed buffer. Returns false if it is malformed.
+boolean M_CompressedBufferInfo(const UINT8 *in, size_t inlength, compressor_t *codec, size_t *rawlength);
+
+// Decompress a whole buffer made by M_CompressBuffer.
+// Returns the uncompressed length, or 0 if corrupt or out is too small.
+size_t M_DecompressBuffer(const UINT8 *in, size_t inlength, UINT8 *out, size_t outcap);
+
+// Incremental decompression, for data which arrives in order a piece at a time.
+// zstd frames are decoded as they are fed; other codecs decode when finished.
+typedef struct decompressstream_s decompressstream_t;
+
+// The stream is corrupt if its header claims more than maxlength bytes.
+decompressstream_t *M_DecompressStreamBegin(size_t maxlength);
+
+// Returns false once the data is known to be corrupt.
+boolean M_DecompressStreamFeed(decompressstream_t *stream, const UINT8 *in, size_t length);
+
+// Frees the stream. Returns the uncompressed data, allocated with malloc,
+// or NULL if the data was incomplete or corrupt.
+UINT8 *M_DecompressStreamFinish(decompressstream_t *stream, size_t *rawlength);
+
+void M_DecompressStreamAbort(decompressstream_t *stream);
+
+// Train a zstd dictionary from samples, for shipping as NETSDICT.
+// Returns the dictionary length, or 0 if training failed.
+size_t M_TrainCompressionDictionary(const UINT8 *const *samples, const size_t *samplelengths, size_t numsamples,
+	UINT8 *out, size_t outcap);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -20,6 +20,7 @@
 #include "z_zone.h"
 #include "p_local.h"
 #include "g_game.h"
+#include "deh_tables.h" // MOBJTYPE_LIST
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -60,6 +61,17 @@ int ps_checkposition_calls = 0;
 
 precise_t ps_lua_thinkframe_time = 0;
 int ps_lua_mobjhooks = 0;
+int ps_lua_mobjhooktypes[NUMMOBJTYPES];
+
+precise_t ps_lua_gc_time = 0;
+int ps_lua_gc_steps = 0;
+int ps_lua_gc_catchupkb = 0;
+int ps_lua_gc_cycles = 0;
+int ps_lua_heapkb = 0;
+int ps_lua_gcestimatekb = 0;
+int ps_lua_slabkb = 0;
+int ps_lua_largekb = 0;
+int ps_lua_chunkkb = 0;
 
 // dynamically allocated resizeable array for thinkframe hook stats
 ps_hookinfo_t *thinkframe_hooks = NULL;
@@ -70,6 +82,8 @@ ps_botinfo_t ps_bots[MAXPLAYERS];
 
 static INT32 draw_row;
 
+extern consvar_t cv_lua_gcbudget;
+
 void PS_SetThinkFrameHookInfo(int index, precise_t time_taken, char* short_src)
 {
 	if (!thinkframe_hooks)
@@ -194,6 +208,7 @@ static void M_DrawRenderStats(void)
 		{"bsptime", "RenderBSPNode: ", &ps_bsptime},
 		{"sprclip", "R_ClipSprites: ", &ps_sw_spritecliptime},
 		{"portals", "Portals+Skybox:", &ps_sw_portaltime},
+		{"walls  ", "Wall columns:  ", &ps_sw_walltime},
 		{"planes ", "R_DrawPlanes:  ", &ps_sw_planetime},
 		{"masked ", "R_DrawMasked:  ", &ps_sw_maskedtime},
 		{"other  ", "Other:         ", &extrarendertime},
@@ -219,6 +234,13 @@ static void M_DrawRenderStats(void)
 		{0}
 	};
 
+	perfstatrow_t twodeecalls_row[] = {
+		{"2d cmds", "2D commands:", &ps_2d_numcmds},
+		{"2d unmg", "2D unmerged:", &ps_2d_numunmerged},
+		{"2d drws", "2D draws:   ", &ps_2d_numdraws},
+		{0}
+	};
+
 	perfstatrow_t batchtime_row[] = {
 		{"batsort", "Batch sort:  ", &ps_hw_batchsorttime},
 		{"batdraw", "Batch render:", &ps_hw_batchdrawtime},
@@ -251,6 +273,8 @@ static void M_DrawRenderStats(void)
 
 	perfstatcol_t    rendercalls_col =  {90, 115, V_BLUEMAP,      rendercalls_row};
 
+	perfstatcol_t    twodeecalls_col = {155, 200, V_PURPLEMAP,    twodeecalls_row};
+
 	perfstatcol_t      batchtime_col =  {90, 115, V_REDMAP,         batchtime_row};
 
 	perfstatcol_t     batchcount_col = {155, 200, V_PURPLEMAP,     batchcount_row};
@@ -294,6 +318,7 @@ static void M_DrawRenderStats(void)
 			extrarendertime -=
 				ps_sw_spritecliptime +
 				ps_sw_portaltime +
+				ps_sw_walltime +
 				ps_sw_planetime +
 				ps_sw_maskedtime;
 
@@ -329,6 +354,13 @@ static void M_DrawRenderStats(void)
 		}
 #endif
 	}
+
+	// The 2D renderer is used for everything but legacy OpenGL, including menus
+	if (rendermode == render_soft)
+	{
+		draw_row = 10;
+		M_DrawPerfCount(&twodeecalls_col);
+	}
 }
 
 static void M_DrawTickStats(void)
@@ -346,6 +378,9 @@ static void M_DrawTickStats(void)
 	int precipcount = 0;
 	int removecount = 0;
 
+	zarenastats_t arenastats;
+	int arenaallocs, arenakb, arenapeakkb, arenareservedkb;
+
 	precise_t extratime =
 		ps_tictime -
 		ps_playerthink_time -
@@ -416,6 +451,14 @@ static void M_DrawTickStats(void)
 		{0}
 	};
 
+	perfstatrow_t arena_row[] = {
+		{"aallocs", "Allocations:    ", &arenaallocs},
+		{"akb    ", "KB allocated:   ", &arenakb},
+		{"apeakkb", "KB peak:        ", &arenapeakkb},
+		{"aresvkb", "KB reserved:    ", &arenareservedkb},
+		{0}
+	};
+
 	perfstatcol_t               tictime_col  =  {20,  20, V_YELLOWMAP,               tictime_row};
 	perfstatcol_t          thinker_time_col  =  {24,  24, V_YELLOWMAP,          thinker_time_row};
 	perfstatcol_t detailed_thinker_time_col  =  {28,  28, V_YELLOWMAP, detailed_thinker_time_row};
@@ -427,6 +470,13 @@ static void M_DrawTickStats(void)
 	perfstatcol_t          nothinkcount_col  =  {98, 123, V_BLUEMAP,            nothinkcount_row};
 	perfstatcol_t detailed_thinkercount_col2 =  {94, 119, V_BLUEMAP,   detailed_thinkercount_row2};
 	perfstatcol_t            misc_calls_col  = {170, 216, V_PURPLEMAP,            misc_calls_row};
+	perfstatcol_t                 arena_col  = {170, 216, V_GREENMAP,                  arena_row};
+
+	Z_Arena_GetStats(&arenastats);
+	arenaallocs = (int)arenastats.allocs;
+	arenakb = (int)(arenastats.bytes / 1024);
+	arenapeakkb = (int)(arenastats.peak / 1024);
+	arenareservedkb = (int)(arenastats.reserved / 1024);
 
 	for (i = 0; i < NUM_THINKERLISTS; i++)
 	{
@@ -488,8 +538,138 @@ static void M_DrawTickStats(void)
 	}
 
 	M_DrawPerfCount(&misc_calls_col);
+
+	// Scratch memory of the thread arenas, counted since the start of the tic
+	if (M_HighResolution())
+	{
+		draw_row += 5;
+		V_DrawSmallString(212, draw_row, V_MONOSPACE | V_GREENMAP, "Arena:");
+		draw_row += 5;
+	}
+	else
+	{
+		draw_row += 8;
+	}
+
+	M_DrawPerfCount(&arena_col);
 }
 
+static void M_DrawLuaGCStats(void)
+{
+	int budget = cv_lua_gcbudget.value;
+
+	perfstatrow_t gctime_row[] = {
+		{"gctime ", "GC time:        ", &ps_lua_gc_time},
+		{0}
+	};
+
+	perfstatrow_t gcwork_row[] = {
+		{"budget ", "Budget:         ", &budget},
+		{"steps  ", "Steps:          ", &ps_lua_gc_steps},
+		{"catchup", "Catch-up KB:    ", &ps_lua_gc_catchupkb},
+		{"cycles ", "Cycles:         ", &ps_lua_gc_cycles},
+		{0}
+	};
+
+	perfstatrow_t heap_row[] = {
+		{"heapkb ", "Heap KB:        ", &ps_lua_heapkb},
+		{"livekb ", "Live KB:        ", &ps_lua_gcestimatekb},
+		{0}
+	};
+
+	perfstatrow_t slab_row[] = {
+		{"slabkb ", "Small KB:       ", &ps_lua_slabkb},
+		{"largekb", "Large KB:       ", &ps_lua_largekb},
+		{"chunkkb", "Chunks KB:      ", &ps_lua_chunkkb},
+		{0}
+	};
+
+	perfstatcol_t gctime_col = {20,  20, V_YELLOWMAP, gctime_row};
+	perfstatcol_t gcwork_col = {24,  24, V_BLUEMAP,   gcwork_row};
+	perfstatcol_t   heap_col = {90, 115, V_GREENMAP,  heap_row};
+	perfstatcol_t   slab_col = {94, 119, V_GREENMAP,  slab_row};
+
+	draw_row = 10;
+	M_DrawPerfTiming(&gctime_col);
+	M_DrawPerfCount(&gcwork_col);
+
+	draw_row = 10;
+	M_DrawPerfCount(&heap_col);
+	M_DrawPerfCount(&slab_col);
+}
+
+#define MOBJHOOK_ROWS 64
+
+static void M_DrawMobjHookStats(void)
+{
+	mobjtype_t top[MOBJHOOK_ROWS];
+	int numtop = 0;
+	int i, j;
+	char s[64];
+
+	// text writing position
+	int x = 2;
+	int y = 4;
+
+	if (G_GamestateUsesLevel() == false)
+		return;
+
+	if (vid.width < 640 || vid.height < 400) // low resolution
+	{
+		// it's not gonna fit very well..
+		V_DrawThinString(30, 30, V_MONOSPACE | V_YELLOWMAP, "Not available for resolutions below 640x400");
+		return;
+	}
+
+	// Keep the busiest types, most calls first
+	for (i = 0; i < NUMMOBJTYPES; i++)
+	{
+		if (ps_lua_mobjhooktypes[i] == 0)
+			continue;
+
+		for (j = numtop; j > 0 && ps_lua_mobjhooktypes[top[j - 1]] < ps_lua_mobjhooktypes[i]; j--)
+		{
+			if (j < MOBJHOOK_ROWS)
+				top[j] = top[j - 1];
+		}
+
+		if (j < MOBJHOOK_ROWS)
+		{
+			top[j] = i;
+			if (numtop < MOBJHOOK_ROWS)
+				numtop++;
+		}
+	}
+
+	snprintf(s, sizeof s, "Mobj hook calls: %d", ps_lua_mobjhooks);
+	V_DrawSmallString(x, y, V_MONOSPACE | V_GRAYMAP, s);
+	y += 8;
+
+	for (i = 0; i < numtop; i++)
+	{
+		const char *name = NULL;
+
+		if (top[i] < MT_FIRSTFREESLOT)
+			name = MOBJTYPE_LIST[top[i]] + 3; // skip MT_
+		else
+			name = FREE_MOBJS[top[i] - MT_FIRSTFREESLOT];
+
+		snprintf(s, sizeof s, "%-19.19s %5d", name ? name : "?", ps_lua_mobjhooktypes[top[i]]);
+		V_DrawSmallString(x, y, V_MONOSPACE | (top[i] < MT_FIRSTFREESLOT ? V_YELLOWMAP : 0), s);
+
+		y += 4;
+		if (y > 192)
+		{
+			y = 12;
+			x += 106;
+			if (x > 214)
+				break;
+		}
+	}
+}
+
+#undef MOBJHOOK_ROWS
+
 void M_DrawPerfStats(void)
 {
 	char s[363];
@@ -504,6 +684,14 @@ void M_DrawPerfStats(void)
 	{
 		M_DrawTickStats();
 	}
+	else if (cv_perfstats.value == PS_LUAGC) // lua garbage collection
+	{
+		M_DrawLuaGCStats();
+	}
+	else if (cv_perfstats.value == PS_MOBJHOOKS) // lua mobj hooks by type
+	{
+		M_DrawMobjHookStats();
+	}
 	else if (cv_perfstats.value == PS_BOT) // bot ticcmd
 	{
 		if (vid.width < 640 || vid.height < 400) // low resolution
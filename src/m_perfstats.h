@@ -28,6 +28,8 @@ typedef enum
 	PS_LOGIC,
 	PS_BOT,
 	PS_THINKFRAME,
+	PS_LUAGC,
+	PS_MOBJHOOKS,
 } ps_types_t;
 
 extern precise_t ps_tictime;
@@ -44,6 +46,18 @@ extern int       ps_checkposition_calls;
 
 extern precise_t ps_lua_thinkframe_time;
 extern int       ps_lua_mobjhooks;
+extern int       ps_lua_mobjhooktypes[NUMMOBJTYPES]; // mobj hook calls by type, this tic
+
+// Set by LUA_Step every frame
+extern precise_t ps_lua_gc_time;
+extern int       ps_lua_gc_steps;
+extern int       ps_lua_gc_catchupkb;
+extern int       ps_lua_gc_cycles;
+extern int       ps_lua_heapkb;
+extern int       ps_lua_gcestimatekb;
+extern int       ps_lua_slabkb;
+extern int       ps_lua_largekb;
+extern int       ps_lua_chunkkb;
 
 struct ps_hookinfo_t
 {
@@ -24,6 +24,7 @@
 #include "r_defs.h"
 #include "p_maputl.h"
 #include "doomstat.h" // MAXSPLITSCREENPLAYERS
+#include "core/memory.h" // zpool_t
 
 #ifdef __cplusplus
 extern "C" {
@@ -78,11 +79,12 @@ typedef enum
 	NUM_THINKERLISTS
 } thinklistnum_t; /**< Thinker lists. */
 extern thinker_t thlist[];
-extern mobj_t *mobjcache;
+extern zpool_t mobjpool, precipmobjpool;
 
 void P_InitThinkers(void);
 void P_InvalidateThinkersWithoutInit(void);
 void P_AddThinker(const thinklistnum_t n, thinker_t *thinker);
+void P_FreeThinker(thinker_t *thinker);
 void P_RemoveThinker(thinker_t *thinker);
 void P_UnlinkThinker(thinker_t *thinker);
 
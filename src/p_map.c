@@ -630,6 +630,7 @@ static BlockItReturn_t PIT_CheckThing(mobj_t *thing)
 			return BMIT_CONTINUE; // the line doesn't cross between either pair of opposite corners
 	}
 
+	if (LUA_MobjHooked(thing, MobjCollide) || LUA_MobjHooked(g_tm.thing, MobjMoveCollide))
 	{
 		UINT8 shouldCollide = LUA_Hook2Mobj(thing, g_tm.thing, MOBJ_HOOK(MobjCollide)); // checks hook for thing's type
 		if (P_MobjWasRemoved(g_tm.thing) || P_MobjWasRemoved(thing))
@@ -1863,6 +1864,7 @@ static BlockItReturn_t PIT_CheckLine(line_t *ld)
 
 	// this line is out of the if so upper and lower textures can be hit by a splat
 
+	if (LUA_MobjHooked(g_tm.thing, MobjLineCollide))
 	{
 		UINT8 shouldCollide = LUA_HookMobjLineCollide(g_tm.thing, ld); // checks hook for thing's type
 		if (P_MobjWasRemoved(g_tm.thing))
@@ -4613,59 +4615,40 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
  Lots of new Boom functions that work faster and add functionality.
 */
 
-static msecnode_t *headsecnode = NULL;
-static mprecipsecnode_t *headprecipsecnode = NULL;
+// Level lifetime, like the mobjs they link
+static zpool_t secnodepool = ZPOOL_INIT(msecnode_t, m_thinglist_next);
+static zpool_t precipsecnodepool = ZPOOL_INIT(mprecipsecnode_t, m_thinglist_next);
 
 void P_Initsecnode(void)
 {
-	headsecnode = NULL;
-	headprecipsecnode = NULL;
+	Z_Pool_Reset(&secnodepool);
+	Z_Pool_Reset(&precipsecnodepool);
 }
 
-// P_GetSecnode() retrieves a node from the freelist. The calling routine
+// P_GetSecnode() retrieves a node from the pool. The calling routine
 // should make sure it sets all fields properly.
 
-static msecnode_t *P_GetSecnode(void)
+static inline msecnode_t *P_GetSecnode(void)
 {
-	msecnode_t *node;
-
-	if (headsecnode)
-	{
-		node = headsecnode;
-		headsecnode = headsecnode->m_thinglist_next;
-	}
-	else
-		node = Z_Calloc(sizeof (*node), PU_LEVEL, NULL);
-	return node;
+	return Z_Pool_Alloc(&secnodepool);
 }
 
-static mprecipsecnode_t *P_GetPrecipSecnode(void)
+static inline mprecipsecnode_t *P_GetPrecipSecnode(void)
 {
-	mprecipsecnode_t *node;
-
-	if (headprecipsecnode)
-	{
-		node = headprecipsecnode;
-		headprecipsecnode = headprecipsecnode->m_thinglist_next;
-	}
-	else
-		node = Z_Calloc(sizeof (*node), PU_LEVEL, NULL);
-	return node;
+	return Z_Pool_Alloc(&precipsecnodepool);
 }
 
-// P_PutSecnode() returns a node to the freelist.
+// P_PutSecnode() returns a node to the pool.
 
 static inline void P_PutSecnode(msecnode_t *node)
 {
-	node->m_thinglist_next = headsecnode;
-	headsecnode = node;
+	Z_Pool_Free(&secnodepool, node);
 }
 
 // Tails 08-25-2002
 static inline void P_PutPrecipSecnode(mprecipsecnode_t *node)
 {
-	node->m_thinglist_next = headprecipsecnode;
-	headprecipsecnode = node;
+	Z_Pool_Free(&precipsecnodepool, node);
 }
 
 // P_AddSecnode() searches the current list to see if this sector is
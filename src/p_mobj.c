@@ -64,7 +64,9 @@ mobj_t *waypointcap = NULL;
 // general purpose.
 mobj_t *trackercap = NULL;
 
-mobj_t *mobjcache = NULL;
+// Level lifetime; reset with the rest of the level in P_SetupLevel
+zpool_t mobjpool = ZPOOL_INIT(mobj_t, hnext);
+zpool_t precipmobjpool = ZPOOL_INIT(precipmobj_t, bnext);
 
 void P_InitCachedActions(void)
 {
@@ -5766,7 +5768,7 @@ static boolean P_ParticleGenSceneryThink(mobj_t *mobj)
 
 static void P_MobjSceneryThink(mobj_t *mobj)
 {
-	if (LUA_HookMobj(mobj, MOBJ_HOOK(MobjThinker)))
+	if (LUA_MobjHooked(mobj, MobjThinker) && LUA_HookMobj(mobj, MOBJ_HOOK(MobjThinker)))
 		return;
 	if (P_MobjWasRemoved(mobj))
 		return;
@@ -10263,7 +10265,9 @@ void P_MobjThinker(mobj_t *mobj)
 	}
 
 	// Check for a Lua thinker first
-	if (!mobj->player)
+	if (!LUA_MobjHooked(mobj, MobjThinker))
+		;
+	else if (!mobj->player)
 	{
 		if (LUA_HookMobj(mobj, MOBJ_HOOK(MobjThinker)) || P_MobjWasRemoved(mobj))
 			return;
@@ -10755,16 +10759,7 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 		type = MT_RAY;
 	}
 
-	if (mobjcache != NULL)
-	{
-		mobj = mobjcache;
-		mobjcache = mobjcache->hnext;
-		memset(mobj, 0, sizeof(*mobj));
-	}
-	else
-	{
-		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
-	}
+	mobj = Z_Pool_Alloc(&mobjpool);
 
 	// this is officially a mobj, declared as soon as possible.
 	mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
@@ -10862,7 +10857,7 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 
 	// DANGER! This can cause P_SpawnMobj to return NULL!
 	// Avoid using P_RemoveMobj on the newly created mobj in "MobjSpawn" Lua hooks!
-	if (LUA_HookMobj(mobj, MOBJ_HOOK(MobjSpawn)))
+	if (LUA_MobjHooked(mobj, MobjSpawn) && LUA_HookMobj(mobj, MOBJ_HOOK(MobjSpawn)))
 	{
 		if (P_MobjWasRemoved(mobj))
 			return NULL;
@@ -11251,7 +11246,7 @@ static precipmobj_t *P_SpawnPrecipMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype
 	const mobjinfo_t *info = &mobjinfo[type];
 	state_t *st;
 	fixed_t start_z = INT32_MIN;
-	precipmobj_t *mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+	precipmobj_t *mobj = Z_Pool_Alloc(&precipmobjpool);
 
 	mobj->type = type;
 	mobj->info = info;
@@ -11349,7 +11344,8 @@ void P_RemoveMobj(mobj_t *mobj)
 		return; // something already removing this mobj.
 
 	mobj->thinker.function.acp1 = (actionf_p1)P_RemoveThinkerDelayed; // shh. no recursing.
-	LUA_HookMobj(mobj, MOBJ_HOOK(MobjRemoved));
+	if (LUA_MobjHooked(mobj, MobjRemoved))
+		LUA_HookMobj(mobj, MOBJ_HOOK(MobjRemoved));
 	mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker; // needed for P_UnsetThingPosition, etc. to work.
 
 	// Rings only, please!
@@ -11535,9 +11531,8 @@ void P_RemoveMobj(mobj_t *mobj)
 		INT32 prevreferences;
 		if (!mobj->thinker.references)
 		{
-			// no references, dump it directly in the mobj cache
-			mobj->hnext = mobjcache;
-			mobjcache = mobj;
+			// no references, give it straight back to the pool
+			Z_Pool_Free(&mobjpool, mobj);
 			return;
 		}
 
@@ -450,6 +450,8 @@ struct mobj_t
 
 	INT32 po_movecount; // Polyobject carrying (NOT savegame, NOT Lua)
 
+	INT32 luaref; // Registry reference to the Lua userdata, see LUA_PushMobj (NOT savegame, NOT Lua)
+
 	// WARNING: New fields must be added separately to savegame and Lua.
 };
 
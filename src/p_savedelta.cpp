@@ -0,0 +1,327 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_savedelta.cpp
+/// \brief Delta encoding of netgame snapshots against a keyframe
+
+#include "p_savedelta.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// A delta is a header followed by a sequence of operations:
+//
+//   varint targetlen, varint baselen, UINT32 base checksum
+//   varint (len << 1) | 0, len literal bytes
+//   varint (len << 1) | 1, zigzag varint (base offset - expected offset)
+//
+// The expected offset is where the previous copy ended, adjusted by any
+// literal bytes since. Records which moved because thinkers ahead of them
+// were spawned or removed therefore cost a small offset, and records which
+// stayed in place cost a zero.
+
+// Blocks of base are indexed at this granularity to find moved records.
+static constexpr size_t kBlockSize = 16;
+
+// A run on the current diagonal shorter than this is cheaper as literals.
+static constexpr size_t kMinDiagonalMatch = 8;
+
+static UINT32 delta_checksum(const UINT8 *data, size_t len)
+{
+	// FNV-1a; only guards against applying a delta to the wrong keyframe
+	UINT32 hash = 2166136261u;
+	for (size_t i = 0; i < len; i++)
+	{
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static UINT32 block_hash(const UINT8 *p)
+{
+	UINT32 a, b, c, d;
+	memcpy(&a, p, 4);
+	memcpy(&b, p + 4, 4);
+	memcpy(&c, p + 8, 4);
+	memcpy(&d, p + 12, 4);
+	UINT32 h = a * 0x9E3779B1u;
+	h = (h ^ (h >> 15) ^ b) * 0x85EBCA77u;
+	h = (h ^ (h >> 13) ^ c) * 0xC2B2AE3Du;
+	h = (h ^ (h >> 16) ^ d) * 0x27D4EB2Fu;
+	return h ^ (h >> 15);
+}
+
+namespace
+{
+
+struct DeltaWriter
+{
+	UINT8 *p;
+	UINT8 *end;
+	bool overflow = false;
+
+	void byte(UINT8 b)
+	{
+		if (p >= end)
+		{
+			overflow = true;
+			return;
+		}
+		*p++ = b;
+	}
+
+	void varint(UINT64 v)
+	{
+		while (v >= 0x80)
+		{
+			byte(static_cast<UINT8>(v | 0x80));
+			v >>= 7;
+		}
+		byte(static_cast<UINT8>(v));
+	}
+
+	void bytes(const UINT8 *src, size_t len)
+	{
+		if (static_cast<size_t>(end - p) < len)
+		{
+			overflow = true;
+			p = end;
+			return;
+		}
+		memcpy(p, src, len);
+		p += len;
+	}
+};
+
+struct DeltaReader
+{
+	const UINT8 *p;
+	const UINT8 *end;
+	bool bad = false;
+
+	UINT64 varint()
+	{
+		UINT64 v = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (p >= end)
+			{
+				bad = true;
+				return 0;
+			}
+			UINT8 b = *p++;
+			v |= static_cast<UINT64>(b & 0x7F) << shift;
+			if (!(b & 0x80))
+			{
+				return v;
+			}
+		}
+		bad = true;
+		return 0;
+	}
+};
+
+} // namespace
+
+static size_t match_length(const UINT8 *a, const UINT8 *b, size_t max)
+{
+	size_t len = 0;
+	while (len < max && a[len] == b[len])
+	{
+		len++;
+	}
+	return len;
+}
+
+size_t P_SaveDeltaEncode(const UINT8 *base, size_t baselen,
+	const UINT8 *target, size_t targetlen,
+	UINT8 *out, size_t outcap)
+{
+	DeltaWriter w {out, out + outcap};
+
+	w.varint(targetlen);
+	w.varint(baselen);
+	UINT32 sum = delta_checksum(base, baselen);
+	for (int i = 0; i < 4; i++)
+	{
+		w.byte(static_cast<UINT8>(sum >> (i * 8)));
+	}
+
+	// Index the start of every block of base; the first occurrence wins so
+	// repeated records match the earliest copy, nearest the expected offset.
+	const size_t numblocks = baselen / kBlockSize;
+	size_t tablesize = 1;
+	while (tablesize < numblocks * 2)
+	{
+		tablesize <<= 1;
+	}
+	std::vector<UINT32> table(tablesize, 0);
+	for (size_t i = 0; i < numblocks; i++)
+	{
+		UINT32 slot = block_hash(base + i * kBlockSize) & (tablesize - 1);
+		while (table[slot] != 0)
+		{
+			if (memcmp(base + (table[slot] - 1), base + i * kBlockSize, kBlockSize) == 0)
+			{
+				break;
+			}
+			slot = (slot + 1) & (tablesize - 1);
+		}
+		if (table[slot] == 0)
+		{
+			table[slot] = static_cast<UINT32>(i * kBlockSize + 1);
+		}
+	}
+
+	size_t t = 0;
+	size_t literal = 0;
+	size_t expected = 0;
+
+	auto emit_literal = [&](size_t end)
+	{
+		if (end > literal)
+		{
+			w.varint(static_cast<UINT64>(end - literal) << 1);
+			w.bytes(target + literal, end - literal);
+		}
+	};
+
+	while (t + kMinDiagonalMatch <= targetlen && !w.overflow)
+	{
+		size_t candidate = SIZE_MAX;
+		size_t len = 0;
+
+		// Most bytes sit on the same diagonal as the previous copy
+		size_t diagonal = expected + (t - literal);
+		if (diagonal + kMinDiagonalMatch <= baselen
+			&& memcmp(base + diagonal, target + t, kMinDiagonalMatch) == 0)
+		{
+			candidate = diagonal;
+		}
+		else if (t + kBlockSize <= targetlen && tablesize > 1)
+		{
+			UINT32 slot = block_hash(target + t) & (tablesize - 1);
+			while (table[slot] != 0)
+			{
+				size_t offset = table[slot] - 1;
+				if (memcmp(base + offset, target + t, kBlockSize) == 0)
+				{
+					candidate = offset;
+					break;
+				}
+				slot = (slot + 1) & (tablesize - 1);
+			}
+		}
+
+		if (candidate == SIZE_MAX)
+		{
+			t++;
+			continue;
+		}
+
+		len = match_length(base + candidate, target + t, std::min(baselen - candidate, targetlen - t));
+
+		// Reclaim pending literal bytes which also match
+		while (t > literal && candidate > 0 && target[t - 1] == base[candidate - 1])
+		{
+			t--;
+			candidate--;
+			len++;
+		}
+
+		emit_literal(t);
+
+		INT64 skew = static_cast<INT64>(candidate) - static_cast<INT64>(expected + (t - literal));
+		w.varint((static_cast<UINT64>(len) << 1) | 1);
+		w.varint((static_cast<UINT64>(skew) << 1) ^ static_cast<UINT64>(skew >> 63));
+
+		t += len;
+		literal = t;
+		expected = candidate + len;
+	}
+
+	emit_literal(targetlen);
+
+	if (w.overflow)
+	{
+		return 0;
+	}
+	return w.p - out;
+}
+
+size_t P_SaveDeltaDecode(const UINT8 *base, size_t baselen,
+	const UINT8 *delta, size_t deltalen,
+	UINT8 *out, size_t outcap)
+{
+	DeltaReader r {delta, delta + deltalen};
+
+	UINT64 targetlen = r.varint();
+	UINT64 encodedbaselen = r.varint();
+	if (r.bad || encodedbaselen != baselen || targetlen > outcap || r.end - r.p < 4)
+	{
+		return 0;
+	}
+
+	UINT32 sum = r.p[0] | (r.p[1] << 8) | (r.p[2] << 16) | (static_cast<UINT32>(r.p[3]) << 24);
+	r.p += 4;
+	if (sum != delta_checksum(base, baselen))
+	{
+		return 0;
+	}
+
+	size_t t = 0;
+	size_t expected = 0;
+	size_t literal = 0; // literal bytes since the last copy
+
+	while (t < targetlen)
+	{
+		UINT64 op = r.varint();
+		if (r.bad)
+		{
+			return 0;
+		}
+		UINT64 len = op >> 1;
+		if (len > targetlen - t)
+		{
+			return 0;
+		}
+
+		if (op & 1)
+		{
+			UINT64 zz = r.varint();
+			if (r.bad)
+			{
+				return 0;
+			}
+			INT64 skew = static_cast<INT64>(zz >> 1) ^ -static_cast<INT64>(zz & 1);
+			INT64 offset = static_cast<INT64>(expected + literal) + skew;
+			if (offset < 0 || static_cast<UINT64>(offset) > baselen || len > baselen - offset)
+			{
+				return 0;
+			}
+			memcpy(out + t, base + offset, len);
+			expected = offset + len;
+			literal = 0;
+		}
+		else
+		{
+			if (static_cast<UINT64>(r.end - r.p) < len)
+			{
+				return 0;
+			}
+			memcpy(out + t, r.p, len);
+			r.p += len;
+			literal += len;
+		}
+		t += len;
+	}
+
+	return t;
+}
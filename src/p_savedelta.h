@@ -0,0 +1,41 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_savedelta.h
+/// \brief Delta encoding of netgame snapshots against a keyframe
+
+#ifndef __P_SAVEDELTA__
+#define __P_SAVEDELTA__
+
+#include "doomtype.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Encode target as a delta against base.
+// Unchanged thinker and sector records are found in base even when
+// earlier records were added or removed, so only changed records cost
+// literal bytes. Returns the delta length, or 0 if it would not fit in
+// outcap (the caller should keep a full snapshot instead).
+size_t P_SaveDeltaEncode(const UINT8 *base, size_t baselen,
+	const UINT8 *target, size_t targetlen,
+	UINT8 *out, size_t outcap);
+
+// Rebuild the snapshot encoded by P_SaveDeltaEncode into out.
+// Returns the snapshot length, or 0 if the delta is malformed, does not
+// belong to base or does not fit in outcap.
+size_t P_SaveDeltaDecode(const UINT8 *base, size_t baselen,
+	const UINT8 *delta, size_t deltalen,
+	UINT8 *out, size_t outcap);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
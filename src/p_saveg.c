@@ -4446,13 +4446,13 @@ static thinker_t* LoadMobjThinker(savebuffer_t *save, actionf_p1 thinker)
 			return NULL;
 		}
 
-		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+		mobj = Z_Pool_Alloc(&mobjpool);
 
 		mobj->spawnpoint = &mapthings[spawnpointnum];
 		mapthings[spawnpointnum].mobj = mobj;
 	}
 	else
-		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+		mobj = Z_Pool_Alloc(&mobjpool);
 
 	// declare this as a valid mobj as soon as possible.
 	mobj->thinker.function.acp1 = thinker;
@@ -5456,7 +5456,7 @@ static void P_NetUnArchiveThinkers(savebuffer_t *save)
 			{
 				(next->prev = currentthinker->prev)->next = next;
 				R_DestroyLevelInterpolators(currentthinker);
-				Z_Free(currentthinker);
+				P_FreeThinker(currentthinker);
 			}
 		}
 	}
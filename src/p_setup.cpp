@@ -14,6 +14,7 @@
 
 #include <algorithm>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <fmt/format.h>
@@ -1438,6 +1439,11 @@ UINT32 sidesPos[UINT16_MAX];
 UINT32 vertexesPos[UINT16_MAX];
 UINT32 sectorsPos[UINT16_MAX];
 
+// Whether the value handed to the parser was quoted, for user properties
+static boolean textmap_valisstring;
+
+static void TextmapAlert(alerttype_t level, const char *message);
+
 // Determine total amount of map data in TEXTMAP.
 static boolean TextmapCount(size_t size)
 {
@@ -1463,7 +1469,7 @@ static boolean TextmapCount(size_t size)
 	// Check if namespace is valid.
 	tkn = M_TokenizerRead(0);
 	if (!fastcmp(tkn, "ringracers"))
-		CONS_Alert(CONS_WARNING, "Invalid namespace '%s', only 'ringracers' is supported. This map may have issues loading.\n", tkn);
+		TextmapAlert(CONS_WARNING, va("Invalid namespace '%s', only 'ringracers' is supported. This map may have issues loading.\n", tkn));
 
 	while ((tkn = M_TokenizerRead(0)) && M_TokenizerGetEndPos() < size)
 	{
@@ -1491,10 +1497,10 @@ static boolean TextmapCount(size_t size)
 			tkn = M_TokenizerRead(0);
 			udmf_version = atoi(tkn);
 			if (udmf_version > UDMF_CURRENT_VERSION)
-				CONS_Alert(CONS_WARNING, "Map is intended for future UDMF version '%d', current supported version is '%d'. This map may have issues loading.\n", udmf_version, UDMF_CURRENT_VERSION);
+				TextmapAlert(CONS_WARNING, va("Map is intended for future UDMF version '%d', current supported version is '%d'. This map may have issues loading.\n", udmf_version, UDMF_CURRENT_VERSION));
 		}
 		else
-			CONS_Alert(CONS_NOTICE, "Unknown field '%s'.\n", tkn);
+			TextmapAlert(CONS_NOTICE, va("Unknown field '%s'.\n", tkn));
 	}
 
 	if (brackets)
@@ -1519,7 +1525,7 @@ static void ParseUserProperty(mapUserProperties_t *user, const char *param, cons
 {
 	if (fastncmp(param, "user_", 5) && strlen(param) > 5)
 	{
-		const boolean valIsString = M_TokenizerJustReadString();
+		const boolean valIsString = textmap_valisstring;
 		const char *key = param + 5;
 		const size_t valLen = strlen(val);
 		UINT8 numberType = PROP_NUM_TYPE_INT;
@@ -2112,6 +2118,345 @@ static void ParseTextmapThingParameter(UINT32 i, const char *param, const char *
 		ParseUserProperty(&mapthings[i].user, param, val);
 }
 
+//  Compiled map cache
+//  - With -mapcache, the fields of every block in a TEXTMAP are kept in
+//    srb2home/cache/<map md5>.map the first time the map loads, along with
+//    the blockmap if the map doesn't have one. Later loads of the same
+//    TEXTMAP feed the fields straight to the parsers, without tokenizing
+//    the lump or building the blockmap again. TextmapCount's warnings are
+//    kept too, and shown again on every load.
+//  - The parsers still run on every load, so textures, flats, colormaps
+//    and tags are looked up against whatever is loaded at the time.
+
+#define MAPCACHEMAGIC "RRMC"
+#define MAPCACHEVERSION 2
+
+// The cache is only ever read by the machine that wrote it, so it's in native byte order.
+struct mapcacheheader_t
+{
+	char magic[4];
+	UINT32 version;
+	UINT8 md5[16];
+	UINT32 textmapsize;
+	INT32 udmfversion;
+
+	UINT32 numvertexes;
+	UINT32 numsectors;
+	UINT32 numlines;
+	UINT32 numsides;
+	UINT32 nummapthings;
+
+	UINT32 numfields;
+	UINT32 numalerts;
+	UINT32 stringsize;
+
+	// Blockmap made by P_CreateBlockMap, count 0 if the map has its own
+	fixed_t bmaporgx;
+	fixed_t bmaporgy;
+	INT32 bmapwidth;
+	INT32 bmapheight;
+	UINT32 blockmapcount;
+};
+
+// Followed by
+//   UINT32 firstfield[blocks + 1], blocks in the order P_LoadTextmap parses them
+//   mapcachefield_t fields[numfields]
+//   mapcachealert_t alerts[numalerts]
+//   INT32 blockmaplump[blockmapcount]
+//   char strings[stringsize]
+struct mapcachefield_t
+{
+	UINT32 param; // offset into strings
+	UINT32 val; // offset into strings, MAPCACHE_QUOTED set if it was a quoted string
+};
+
+#define MAPCACHE_QUOTED 0x80000000
+
+struct mapcachealert_t
+{
+	UINT32 level; // alerttype_t
+	UINT32 message; // offset into strings
+};
+
+struct mapcache_t
+{
+	UINT8 *data;
+	const mapcacheheader_t *header;
+	const UINT32 *firstfield;
+	const mapcachefield_t *fields;
+	const mapcachealert_t *alerts;
+	const INT32 *blockmaplump;
+	const char *strings;
+};
+
+struct mapcachebuilder_t
+{
+	std::string path;
+	UINT8 md5[16];
+	UINT32 textmapsize;
+
+	std::vector<UINT32> firstfield;
+	std::vector<mapcachefield_t> fields;
+	std::vector<mapcachealert_t> alerts;
+	std::vector<INT32> blockmaplump;
+	std::string strings;
+	std::unordered_map<std::string, UINT32> stringoffsets;
+
+	fixed_t bmaporgx;
+	fixed_t bmaporgy;
+	INT32 bmapwidth;
+	INT32 bmapheight;
+};
+
+static mapcache_t mapcache;
+static mapcachebuilder_t *mapcachebuilder;
+
+static std::string P_MapCachePath(const UINT8 *md5)
+{
+	char name[33];
+	INT32 i;
+
+	for (i = 0; i < 16; i++)
+		sprintf(&name[i*2], "%02x", md5[i]);
+
+	return fmt::format("{}" PATHSEP "cache" PATHSEP "{}.map", srb2home, name);
+}
+
+static void P_CloseMapCache(void)
+{
+	Z_Free(mapcache.data);
+	mapcache = {};
+}
+
+// Checks a cache file against the TEXTMAP it was made from, then keeps it loaded
+static boolean P_OpenMapCache(const std::string &path, const UINT8 *md5, size_t textmapsize)
+{
+	FILE *handle = fopen(path.c_str(), "rb");
+	const mapcacheheader_t *header;
+	size_t size, blocks, need;
+	UINT8 *data;
+	UINT32 i;
+
+	if (handle == NULL)
+		return false;
+
+	fseek(handle, 0, SEEK_END);
+	size = (size_t)ftell(handle);
+	fseek(handle, 0, SEEK_SET);
+
+	if (size < sizeof (*header))
+	{
+		fclose(handle);
+		return false;
+	}
+
+	data = static_cast<UINT8*>(Z_Malloc(size, PU_STATIC, NULL));
+	if (fread(data, 1, size, handle) != size)
+	{
+		fclose(handle);
+		Z_Free(data);
+		return false;
+	}
+	fclose(handle);
+
+	header = reinterpret_cast<const mapcacheheader_t*>(data);
+	blocks = (size_t)header->numvertexes + header->numsectors + header->numlines + header->numsides + header->nummapthings;
+	need = sizeof (*header) + (blocks + 1) * sizeof (UINT32)
+		+ (size_t)header->numfields * sizeof (mapcachefield_t)
+		+ (size_t)header->numalerts * sizeof (mapcachealert_t)
+		+ (size_t)header->blockmapcount * sizeof (INT32)
+		+ header->stringsize;
+
+	if (memcmp(header->magic, MAPCACHEMAGIC, 4)
+		|| header->version != MAPCACHEVERSION
+		|| memcmp(header->md5, md5, 16)
+		|| header->textmapsize != textmapsize
+		|| header->numvertexes > UINT16_MAX || header->numsectors > UINT16_MAX || header->numlines > UINT16_MAX
+		|| header->numsides > UINT16_MAX || header->nummapthings > UINT16_MAX
+		|| size != need
+		|| !header->stringsize || data[size - 1] != '\0')
+	{
+		goto invalid;
+	}
+
+	mapcache.data = data;
+	mapcache.header = header;
+	mapcache.firstfield = reinterpret_cast<const UINT32*>(data + sizeof (*header));
+	mapcache.fields = reinterpret_cast<const mapcachefield_t*>(mapcache.firstfield + blocks + 1);
+	mapcache.alerts = reinterpret_cast<const mapcachealert_t*>(mapcache.fields + header->numfields);
+	mapcache.blockmaplump = reinterpret_cast<const INT32*>(mapcache.alerts + header->numalerts);
+	mapcache.strings = reinterpret_cast<const char*>(mapcache.blockmaplump + header->blockmapcount);
+
+	for (i = 0; i < blocks; i++)
+	{
+		if (mapcache.firstfield[i] > mapcache.firstfield[i + 1])
+			goto invalid;
+	}
+
+	if (mapcache.firstfield[0] != 0 || mapcache.firstfield[blocks] != header->numfields)
+		goto invalid;
+
+	for (i = 0; i < header->numfields; i++)
+	{
+		if (mapcache.fields[i].param >= header->stringsize
+			|| (mapcache.fields[i].val & ~MAPCACHE_QUOTED) >= header->stringsize)
+			goto invalid;
+	}
+
+	for (i = 0; i < header->numalerts; i++)
+	{
+		if (mapcache.alerts[i].level > CONS_ERROR || mapcache.alerts[i].message >= header->stringsize)
+			goto invalid;
+	}
+
+	if (header->blockmapcount
+		&& (header->bmapwidth <= 0 || header->bmapheight <= 0
+			|| (size_t)header->bmapwidth * header->bmapheight + 4 > header->blockmapcount))
+	{
+		goto invalid;
+	}
+
+	return true;
+
+invalid:
+	mapcache = {};
+	Z_Free(data);
+	return false;
+}
+
+// Sets up the block counts and positions like TextmapCount would
+static void P_CountCachedTextmap(void)
+{
+	const mapcacheheader_t *header = mapcache.header;
+	UINT32 block = 0;
+	UINT32 i;
+
+	numvertexes = header->numvertexes;
+	numsectors = header->numsectors;
+	numlines = header->numlines;
+	numsides = header->numsides;
+	nummapthings = header->nummapthings;
+	udmf_version = header->udmfversion;
+
+	for (i = 0; i < header->numalerts; i++)
+		CONS_Alert(static_cast<alerttype_t>(mapcache.alerts[i].level), "%s", mapcache.strings + mapcache.alerts[i].message);
+
+	// Positions are block numbers instead of tokenizer positions
+	for (i = 0; i < numvertexes; i++)
+		vertexesPos[i] = block++;
+	for (i = 0; i < numsectors; i++)
+		sectorsPos[i] = block++;
+	for (i = 0; i < numlines; i++)
+		linesPos[i] = block++;
+	for (i = 0; i < numsides; i++)
+		sidesPos[i] = block++;
+	for (i = 0; i < nummapthings; i++)
+		mapthingsPos[i] = block++;
+}
+
+static UINT32 P_MapCacheString(const char *string)
+{
+	auto it = mapcachebuilder->stringoffsets.find(string);
+	UINT32 offset;
+
+	if (it != mapcachebuilder->stringoffsets.end())
+		return it->second;
+
+	offset = (UINT32)mapcachebuilder->strings.size();
+	mapcachebuilder->strings.append(string);
+	mapcachebuilder->strings.push_back('\0');
+	mapcachebuilder->stringoffsets.emplace(string, offset);
+	return offset;
+}
+
+static void P_CacheTextmapField(const char *param, const char *val, boolean quoted)
+{
+	mapcachefield_t field;
+
+	field.param = P_MapCacheString(param);
+	field.val = P_MapCacheString(val) | (quoted ? MAPCACHE_QUOTED : 0);
+	mapcachebuilder->fields.push_back(field);
+}
+
+// Shows an alert from TextmapCount, and keeps it for the cache being built
+static void TextmapAlert(alerttype_t level, const char *message)
+{
+	mapcachealert_t alert;
+
+	CONS_Alert(level, "%s", message);
+
+	if (mapcachebuilder)
+	{
+		alert.level = (UINT32)level;
+		alert.message = P_MapCacheString(message);
+		mapcachebuilder->alerts.push_back(alert);
+	}
+}
+
+static void P_WriteMapCache(void)
+{
+	mapcachebuilder_t *builder = mapcachebuilder;
+	std::string temppath = builder->path + ".tmp";
+	mapcacheheader_t header = {};
+	boolean ok;
+	FILE *handle;
+
+	builder->firstfield.push_back((UINT32)builder->fields.size());
+
+	// Something didn't go through TextmapParse
+	if (builder->firstfield.size() != num_orig_vertexes + numsectors + numlines + numsides + nummapthings + 1
+		|| builder->strings.size() >= MAPCACHE_QUOTED)
+	{
+		return;
+	}
+
+	memcpy(header.magic, MAPCACHEMAGIC, 4);
+	header.version = MAPCACHEVERSION;
+	memcpy(header.md5, builder->md5, 16);
+	header.textmapsize = builder->textmapsize;
+	header.udmfversion = udmf_version;
+	header.numvertexes = (UINT32)num_orig_vertexes;
+	header.numsectors = (UINT32)numsectors;
+	header.numlines = (UINT32)numlines;
+	header.numsides = (UINT32)numsides;
+	header.nummapthings = (UINT32)nummapthings;
+	header.numfields = (UINT32)builder->fields.size();
+	header.numalerts = (UINT32)builder->alerts.size();
+	header.stringsize = (UINT32)builder->strings.size();
+	header.bmaporgx = builder->bmaporgx;
+	header.bmaporgy = builder->bmaporgy;
+	header.bmapwidth = builder->bmapwidth;
+	header.bmapheight = builder->bmapheight;
+	header.blockmapcount = (UINT32)builder->blockmaplump.size();
+
+	I_mkdir(va("%s" PATHSEP "cache", srb2home), 0755);
+
+	handle = fopen(temppath.c_str(), "wb");
+	if (handle == NULL)
+		return;
+
+	ok = (fwrite(&header, sizeof (header), 1, handle) == 1
+		&& fwrite(builder->firstfield.data(), sizeof (UINT32), builder->firstfield.size(), handle) == builder->firstfield.size()
+		&& fwrite(builder->fields.data(), sizeof (mapcachefield_t), builder->fields.size(), handle) == builder->fields.size()
+		&& fwrite(builder->alerts.data(), sizeof (mapcachealert_t), builder->alerts.size(), handle) == builder->alerts.size()
+		&& fwrite(builder->blockmaplump.data(), sizeof (INT32), builder->blockmaplump.size(), handle) == builder->blockmaplump.size()
+		&& fwrite(builder->strings.data(), 1, builder->strings.size(), handle) == builder->strings.size());
+
+	if (fclose(handle) != 0)
+		ok = false;
+
+	if (ok)
+	{
+		remove(builder->path.c_str());
+		ok = (rename(temppath.c_str(), builder->path.c_str()) == 0);
+	}
+
+	if (ok)
+		CONS_Debug(DBG_SETUP, "Wrote compiled map cache %s\n", builder->path.c_str());
+	else
+		remove(temppath.c_str());
+}
+
 /** From a given position table, run a specified parser function through a {}-encapsuled text.
   *
   * \param Position of the data to parse, in the textmap.
@@ -2122,6 +2467,23 @@ static void TextmapParse(UINT32 dataPos, size_t num, void (*parser)(UINT32, cons
 {
 	const char *param, *val;
 
+	if (mapcache.data)
+	{
+		UINT32 i;
+
+		for (i = mapcache.firstfield[dataPos]; i < mapcache.firstfield[dataPos + 1]; i++)
+		{
+			const mapcachefield_t *field = &mapcache.fields[i];
+
+			textmap_valisstring = (field->val & MAPCACHE_QUOTED) != 0;
+			parser(num, mapcache.strings + field->param, mapcache.strings + (field->val & ~MAPCACHE_QUOTED));
+		}
+		return;
+	}
+
+	if (mapcachebuilder)
+		mapcachebuilder->firstfield.push_back((UINT32)mapcachebuilder->fields.size());
+
 	M_TokenizerSetEndPos(dataPos);
 	param = M_TokenizerRead(0);
 	if (!fastcmp(param, "{"))
@@ -2136,6 +2498,11 @@ static void TextmapParse(UINT32 dataPos, size_t num, void (*parser)(UINT32, cons
 		if (fastcmp(param, "}"))
 			break;
 		val = M_TokenizerRead(1);
+		textmap_valisstring = M_TokenizerJustReadString();
+
+		if (mapcachebuilder)
+			P_CacheTextmapField(param, val, textmap_valisstring);
+
 		parser(num, param, val);
 	}
 }
@@ -3483,7 +3850,11 @@ static boolean P_LoadMapData(const virtres_t *virt)
 	virtlump_t *virtvertexes = NULL, *virtsectors = NULL, *virtsidedefs = NULL, *virtlinedefs = NULL, *virtthings = NULL;
 
 	// Count map data.
-	if (udmf) // Count how many entries for each type we got in textmap.
+	if (mapcache.data)
+	{
+		P_CountCachedTextmap();
+	}
+	else if (udmf) // Count how many entries for each type we got in textmap.
 	{
 		virtlump_t *textmap = vres_Find(virt, "TEXTMAP");
 		M_TokenizerOpen((char *)textmap->data, textmap->size);
@@ -3552,7 +3923,8 @@ static boolean P_LoadMapData(const virtres_t *virt)
 	if (udmf)
 	{
 		P_LoadTextmap();
-		M_TokenizerClose();
+		if (!mapcache.data)
+			M_TokenizerClose();
 	}
 	else
 	{
@@ -4137,6 +4509,23 @@ static void P_ReadBlockMapLump(INT16 *wadblockmaplump, size_t count)
 	}
 }
 
+static void P_SetupBlockLinks(void)
+{
+	size_t count;
+
+	// clear out mobj chains
+	count = sizeof (*blocklinks)* bmapwidth*bmapheight;
+	blocklinks = static_cast<mobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+	blockmap = blockmaplump+4;
+
+	// haleyjd 2/22/06: setup polyobject blockmap
+	count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
+	polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+
+	count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
+	precipblocklinks = static_cast<precipmobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+}
+
 // This needs to be a separate function
 // because making both the WAD and PK3 loading code use
 // the same functions is trickier than it looks for blockmap
@@ -4157,18 +4546,59 @@ static boolean P_LoadBlockMap(UINT8 *data, size_t count)
 	bmapwidth = blockmaplump[2];
 	bmapheight = blockmaplump[3];
 
-	// clear out mobj chains
-	count = sizeof (*blocklinks)* bmapwidth*bmapheight;
-	blocklinks = static_cast<mobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
-	blockmap = blockmaplump+4;
+	P_SetupBlockLinks();
+	return true;
+}
 
-	// haleyjd 2/22/06: setup polyobject blockmap
-	count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
-	polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+// The blockmap's origin and size, from every vertex including the ones
+// the nodes added.
+static void P_GetBlockMapBounds(fixed_t *orgx, fixed_t *orgy, INT32 *width, INT32 *height)
+{
+	size_t i;
+	fixed_t minx = INT32_MAX, miny = INT32_MAX, maxx = INT32_MIN, maxy = INT32_MIN;
 
-	count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
-	precipblocklinks = static_cast<precipmobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+	for (i = 0; i < numvertexes; i++)
+	{
+		if (vertexes[i].x>>FRACBITS < minx)
+			minx = vertexes[i].x>>FRACBITS;
+		else if (vertexes[i].x>>FRACBITS > maxx)
+			maxx = vertexes[i].x>>FRACBITS;
+		if (vertexes[i].y>>FRACBITS < miny)
+			miny = vertexes[i].y>>FRACBITS;
+		else if (vertexes[i].y>>FRACBITS > maxy)
+			maxy = vertexes[i].y>>FRACBITS;
+	}
+
+	*orgx = minx << FRACBITS;
+	*orgy = miny << FRACBITS;
+	*width = ((maxx-minx) >> MAPBTOFRAC) + 1;
+	*height = ((maxy-miny) >> MAPBTOFRAC)+ 1;
+}
 
+static boolean P_LoadCachedBlockMap(void)
+{
+	const mapcacheheader_t *header = mapcache.header;
+	fixed_t orgx, orgy;
+	INT32 width, height;
+
+	if (!mapcache.data || !header->blockmapcount)
+		return false;
+
+	// The TEXTMAP is the same, but the nodes it's loaded with may not be
+	P_GetBlockMapBounds(&orgx, &orgy, &width, &height);
+	if (orgx != header->bmaporgx || orgy != header->bmaporgy
+		|| width != header->bmapwidth || height != header->bmapheight)
+		return false;
+
+	blockmaplump = static_cast<INT32*>(Z_Malloc(sizeof (*blockmaplump) * header->blockmapcount, PU_LEVEL, NULL));
+	M_Memcpy(blockmaplump, mapcache.blockmaplump, sizeof (*blockmaplump) * header->blockmapcount);
+
+	bmaporgx = header->bmaporgx;
+	bmaporgy = header->bmaporgy;
+	bmapwidth = header->bmapwidth;
+	bmapheight = header->bmapheight;
+
+	P_SetupBlockLinks();
 	return true;
 }
 
@@ -4237,26 +4667,12 @@ static boolean LineInBlock(fixed_t cx1, fixed_t cy1, fixed_t cx2, fixed_t cy2, f
 static void P_CreateBlockMap(void)
 {
 	size_t i;
-	fixed_t minx = INT32_MAX, miny = INT32_MAX, maxx = INT32_MIN, maxy = INT32_MIN;
-	// First find limits of map
-
-	for (i = 0; i < numvertexes; i++)
-	{
-		if (vertexes[i].x>>FRACBITS < minx)
-			minx = vertexes[i].x>>FRACBITS;
-		else if (vertexes[i].x>>FRACBITS > maxx)
-			maxx = vertexes[i].x>>FRACBITS;
-		if (vertexes[i].y>>FRACBITS < miny)
-			miny = vertexes[i].y>>FRACBITS;
-		else if (vertexes[i].y>>FRACBITS > maxy)
-			maxy = vertexes[i].y>>FRACBITS;
-	}
+	fixed_t minx, miny;
 
-	// Save blockmap parameters
-	bmaporgx = minx << FRACBITS;
-	bmaporgy = miny << FRACBITS;
-	bmapwidth = ((maxx-minx) >> MAPBTOFRAC) + 1;
-	bmapheight = ((maxy-miny) >> MAPBTOFRAC)+ 1;
+	// First find limits of map
+	P_GetBlockMapBounds(&bmaporgx, &bmaporgy, &bmapwidth, &bmapheight);
+	minx = bmaporgx >> FRACBITS;
+	miny = bmaporgy >> FRACBITS;
 
 	// Compute blockmap, which is stored as a 2d array of variable-sized lists.
 	//
@@ -4411,21 +4827,21 @@ static void P_CreateBlockMap(void)
 					blockmaplump[i] = (INT32)tot;
 
 			free(bmap); // Free uncompressed blockmap
+
+			// The line lists only depend on the TEXTMAP, but vertices from the nodes
+			// can move the bounds; P_LoadCachedBlockMap checks them against the nodes it has.
+			if (mapcachebuilder)
+			{
+				mapcachebuilder->blockmaplump.assign(blockmaplump, blockmaplump + ndx);
+				mapcachebuilder->bmaporgx = bmaporgx;
+				mapcachebuilder->bmaporgy = bmaporgy;
+				mapcachebuilder->bmapwidth = bmapwidth;
+				mapcachebuilder->bmapheight = bmapheight;
+			}
 		}
 	}
-	{
-		size_t count = sizeof (*blocklinks) * bmapwidth * bmapheight;
-		// clear out mobj chains (copied from from P_LoadBlockMap)
-		blocklinks = static_cast<mobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
-		blockmap = blockmaplump + 4;
-
-		// haleyjd 2/22/06: setup polyobject blockmap
-		count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
-		polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
 
-		count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
-		precipblocklinks = static_cast<precipmobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
-	}
+	P_SetupBlockLinks();
 }
 
 // PK3 version
@@ -4455,7 +4871,8 @@ static void P_LoadMapLUT(const virtres_t *virt)
 	else
 		rejectmatrix = NULL;
 
-	if (!(virtblockmap && P_LoadBlockMap(virtblockmap->data, virtblockmap->size)))
+	if (!(virtblockmap && P_LoadBlockMap(virtblockmap->data, virtblockmap->size))
+		&& !P_LoadCachedBlockMap())
 		P_CreateBlockMap();
 }
 
@@ -7537,20 +7954,63 @@ static boolean P_LoadMapFromFile(void)
 	TracyCZone(__zone, true);
 
 	virtlump_t *textmap = vres_Find(curmapvirt, "TEXTMAP");
+	precise_t stagestart = I_GetPreciseTime();
+	precise_t md5time, datatime, bsptime, luttime, linktime;
+	boolean cached = false;
 	size_t i;
 
 	udmf = textmap != NULL;
 	udmf_version = 0;
 
+	// The compiled map cache is looked up by it, so it's needed first
+	if (udmf)
+		P_MakeMapMD5(curmapvirt, &mapmd5);
+	md5time = I_GetPreciseTime() - stagestart;
+
+#ifndef NOMD5
+	if (udmf && M_CheckParm("-mapcache"))
+	{
+		std::string path = P_MapCachePath(mapmd5);
+
+		cached = P_OpenMapCache(path, mapmd5, textmap->size);
+		if (!cached)
+		{
+			mapcachebuilder = new mapcachebuilder_t {};
+			mapcachebuilder->path = path;
+			memcpy(mapcachebuilder->md5, mapmd5, 16);
+			mapcachebuilder->textmapsize = (UINT32)textmap->size;
+		}
+	}
+#endif
+
+	stagestart = I_GetPreciseTime();
 	if (!P_LoadMapData(curmapvirt))
 	{
+		P_CloseMapCache();
+		delete mapcachebuilder;
+		mapcachebuilder = NULL;
 		TracyCZoneEnd(__zone);
 		return false;
 	}
+	datatime = I_GetPreciseTime() - stagestart;
 
+	stagestart = I_GetPreciseTime();
 	P_LoadMapBSP(curmapvirt);
+	bsptime = I_GetPreciseTime() - stagestart;
+
+	stagestart = I_GetPreciseTime();
 	P_LoadMapLUT(curmapvirt);
+	luttime = I_GetPreciseTime() - stagestart;
+
+	if (mapcachebuilder)
+	{
+		P_WriteMapCache();
+		delete mapcachebuilder;
+		mapcachebuilder = NULL;
+	}
+	P_CloseMapCache();
 
+	stagestart = I_GetPreciseTime();
 	P_LinkMapData();
 
 	if (!udmf)
@@ -7577,7 +8037,21 @@ static boolean P_LoadMapFromFile(void)
 		if (sectors[i].tags.count)
 			spawnsectors[i].tags.tags = static_cast<mtag_t*>(memcpy(Z_Malloc(sectors[i].tags.count*sizeof(mtag_t), PU_LEVEL, NULL), sectors[i].tags.tags, sectors[i].tags.count*sizeof(mtag_t)));
 
-	P_MakeMapMD5(curmapvirt, &mapmd5);
+	linktime = I_GetPreciseTime() - stagestart;
+
+	if (!udmf)
+	{
+		stagestart = I_GetPreciseTime();
+		P_MakeMapMD5(curmapvirt, &mapmd5);
+		md5time = I_GetPreciseTime() - stagestart;
+	}
+
+	{
+		const double us = 1000000.0 / I_GetPrecisePrecision();
+
+		CONS_Debug(DBG_SETUP, "Map load: MD5 %.0f us, %s %.0f us, BSP %.0f us, blockmap %.0f us, linking %.0f us\n",
+			md5time * us, cached ? "map data (cached)" : "map data", datatime * us, bsptime * us, luttime * us, linktime * us);
+	}
 
 	TracyCZoneEnd(__zone);
 	return true;
@@ -8345,9 +8819,6 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 	if (rendermode != render_none)
 		V_SetPaletteLump("PLAYPAL");
 
-	// Initialize sector node list.
-	P_Initsecnode();
-
 	// Clear CECHO messages
 	HU_ClearCEcho();
 	HU_ClearTitlecardCEcho();
@@ -8607,7 +9078,14 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 	Patch_FreeTag(PU_PATCH_LOWPRIORITY);
 	Patch_FreeTag(PU_PATCH_ROTATED);
 	Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
-	mobjcache = NULL;
+
+	// Whatever was prefetched for the last level and never drawn is just using up the budget
+	W_DropPrefetchedLumps();
+
+	// Mobjs and sector nodes come from their own pools; free them along with the level
+	Z_Pool_Reset(&mobjpool);
+	Z_Pool_Reset(&precipmobjpool);
+	P_Initsecnode();
 
 	R_InitializeLevelInterpolators();
 
@@ -46,6 +46,7 @@
 #include "k_specialstage.h"
 #include "console.h" // CON_LogMessage
 #include "k_respawn.h"
+#include "k_waypoint.h" // K_UpdateFinishDistances
 #include "k_terrain.h"
 #include "k_objects.h"
 #include "acs/interface.h"
@@ -4491,6 +4492,8 @@ boolean P_ProcessSpecial(activator_t *activator, INT16 special, INT32 *args, cha
 						}
 					}
 				}
+
+				K_UpdateFinishDistances();
 			}
 			break;
 
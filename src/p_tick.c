@@ -335,7 +335,12 @@ void P_AddThinker(const thinklistnum_t n, thinker_t *thinker)
 	thlist[n].prev = thinker;
 
 	thinker->references = 0;    // killough 11/98: init reference counter to 0
-	thinker->cachable = n == THINK_MOBJ;
+	if (n == THINK_MOBJ)
+		thinker->pool = &mobjpool;
+	else if (n == THINK_PRECIP)
+		thinker->pool = &precipmobjpool;
+	else
+		thinker->pool = NULL;
 
 #ifdef PARANOIA
 	thinker->debug_mobjtype = MT_NULL;
@@ -441,6 +446,19 @@ void P_RemoveThinkerDelayed(thinker_t *thinker)
 	P_UnlinkThinker(thinker);
 }
 
+//
+// P_FreeThinker()
+//
+// Frees a thinker which is no longer linked, back to where it came from.
+//
+void P_FreeThinker(thinker_t *thinker)
+{
+	if (thinker->pool)
+		Z_Pool_Free(thinker->pool, thinker);
+	else
+		Z_Free(thinker);
+}
+
 //
 // P_UnlinkThinker()
 //
@@ -453,16 +471,7 @@ void P_UnlinkThinker(thinker_t *thinker)
 	I_Assert(thinker->references == 0);
 
 	(next->prev = thinker->prev)->next = next;
-	if (thinker->cachable)
-	{
-		// put cachable thinkers in the mobj cache, so we can avoid allocations
-		((mobj_t *)thinker)->hnext = mobjcache;
-		mobjcache = (mobj_t *)thinker;
-	}
-	else
-	{
-		Z_Free(thinker);
-	}
+	P_FreeThinker(thinker);
 }
 
 //
@@ -936,12 +945,15 @@ void P_Ticker(boolean run)
 		LUA_ResetTicTimers();
 
 		ps_lua_mobjhooks = 0;
+		memset(ps_lua_mobjhooktypes, 0, sizeof ps_lua_mobjhooktypes);
 		ps_checkposition_calls = 0;
+		Z_Arena_ResetStats();
 
 		LUA_HOOK(PreThinkFrame);
 
 		ps_playerthink_time = I_GetPreciseTime();
 
+		K_UpdateFinishDistances();
 		K_UpdateAllPlayerPositions();
 
 		// OK! Now that we got all of that sorted, players can think!
@@ -1192,6 +1192,17 @@ void R_PrecacheLevel(void)
 	// while the sky texture is stored like a wall texture, with a texture name set by the map.
 	texturepresent[skytexture] = 1;
 
+	// Have the patches inflated in the background while the textures get built
+	for (j = 0; j < (unsigned)numtextures; j++)
+	{
+		if (!texturepresent[j] || texturecache[j])
+			continue;
+
+		for (k = 0; k < (size_t)textures[j]->patchcount; k++)
+			W_PrefetchLumpNum(((lumpnum_t)textures[j]->patches[k].wad << 16) | textures[j]->patches[k].lump);
+	}
+	W_StartPrefetch();
+
 	texturememory = 0;
 	for (j = 0; j < (unsigned)numtextures; j++)
 	{
@@ -1215,6 +1226,23 @@ void R_PrecacheLevel(void)
 		if (th->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
 			spritepresent[((mobj_t *)th)->sprite] = 1;
 
+	for (i = 0; i < numsprites; i++)
+	{
+		if (!spritepresent[i])
+			continue;
+
+		for (j = 0; j < sprites[i].numframes; j++)
+		{
+			sf = &sprites[i].spriteframes[j];
+			for (k = 0; k < 16; k++)
+			{
+				if (sf->lumppat[k] != LUMPERROR)
+					W_PrefetchLumpNum(sf->lumppat[k]);
+			}
+		}
+	}
+	W_StartPrefetch();
+
 	spritememory = 0;
 	for (i = 0; i < numsprites; i++)
 	{
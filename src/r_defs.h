@@ -574,6 +574,8 @@ struct sector_t
 
 	// UDMF user-defined custom properties.
 	mapUserProperties_t user;
+
+	INT32 luaref; // Registry reference to the Lua userdata, see LUA_PushSector
 };
 
 //
@@ -31,6 +31,7 @@
 #include "k_color.h" // SRB2kart
 #include "i_threads.h"
 #include "libdivide.h" // used by NPO2 tilted span functions
+#include "r_draw_simd.h"
 #include "hwr2/resource_management.hpp"
 
 #ifdef HWRENDER
@@ -69,10 +70,6 @@ drawspandata_t g_ds;
 */
 INT32 viewwidth, scaledviewwidth, viewheight, viewwindowx, viewwindowy;
 
-/**	\brief pointer to the start of each line of the screen,
-*/
-UINT8 *ylookup[MAXVIDHEIGHT*4];
-
 /**	\brief pointer to the start of each line of the screen, for view1 (splitscreen)
 */
 UINT8 *ylookup1[MAXVIDHEIGHT*4];
@@ -98,6 +95,12 @@ UINT8 *topleft;
 
 UINT8 r8_flatcolor;
 
+/**	\brief per-view framebuffer binding and projection, see renderview_t
+*/
+renderview_t renderviews[MAXSPLITSCREENPLAYERS];
+
+static thread_local const renderview_t *t_renderview = &renderviews[0];
+
 // =========================================================================
 //                      COLUMN DRAWING CODE STUFF
 // =========================================================================
@@ -131,7 +134,6 @@ INT32 dc_numlights = 0, dc_maxlights;
 // =========================================================================
 
 // Vectors for Software's tilted slope drawers
-floatv3_t *ds_su, *ds_sv, *ds_sz;
 float focallengthf[MAXSPLITSCREENPLAYERS];
 float zeroheight;
 
@@ -486,7 +488,7 @@ void R_InitViewBuffer(INT32 width, INT32 height)
 	// Precalculate all row offsets.
 	for (i = 0; i < height; i++)
 	{
-		ylookup[i] = ylookup1[i] = screens[0] + i*vid.width*bytesperpixel;
+		ylookup1[i] = screens[0] + i*vid.width*bytesperpixel;
 		if (r_splitscreen == 1)
 			ylookup2[i] = screens[0] + (i+viewheight)*vid.width*bytesperpixel;
 		else
@@ -494,6 +496,69 @@ void R_InitViewBuffer(INT32 width, INT32 height)
 		ylookup3[i] = screens[0] + (i+viewheight)*vid.width*bytesperpixel;
 		ylookup4[i] = screens[0] + (i+viewheight)*vid.width*bytesperpixel + (viewwidth*bytesperpixel);
 	}
+
+	// Where each splitscreen view lands in the framebuffer
+	for (i = 0; i < MAXSPLITSCREENPLAYERS; i++)
+	{
+		renderview_t *view = &renderviews[i];
+
+		view->viewnum = i;
+		view->windowx = 0;
+		view->windowy = 0;
+
+		switch (i)
+		{
+			case 1:
+				view->ylookup = ylookup2;
+				if (r_splitscreen > 1)
+					view->windowx = viewwidth;
+				else
+					view->windowy = viewheight;
+				break;
+			case 2:
+				view->ylookup = ylookup3;
+				view->windowy = viewheight;
+				break;
+			case 3:
+				view->ylookup = ylookup4;
+				view->windowx = viewwidth;
+				view->windowy = viewheight;
+				break;
+			default:
+				view->ylookup = ylookup1;
+				break;
+		}
+
+		view->topleft = screens[0] + view->windowy*vid.width + view->windowx;
+	}
+}
+
+/**	\brief	Makes a splitscreen view the one drawn into by this thread, and
+	points the view window globals at it for everything else on the main thread.
+
+	\param	viewnum	splitscreen view to bind
+
+	\return	void
+*/
+void R_SetupRenderView(UINT8 viewnum)
+{
+	renderview_t *view = &renderviews[viewnum];
+
+	viewwindowx = view->windowx;
+	viewwindowy = view->windowy;
+	topleft = view->topleft;
+
+	R_SetRenderView(view);
+}
+
+void R_SetRenderView(const renderview_t *view)
+{
+	t_renderview = view;
+}
+
+const renderview_t *R_GetRenderView(void)
+{
+	return t_renderview;
 }
 
 /**	\brief viewborder patches lump numbers
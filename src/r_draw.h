@@ -24,7 +24,6 @@ extern "C" {
 // -------------------------------
 // COMMON STUFF FOR 8bpp AND 16bpp
 // -------------------------------
-extern UINT8 *ylookup[MAXVIDHEIGHT*4];
 extern UINT8 *ylookup1[MAXVIDHEIGHT*4];
 extern UINT8 *ylookup2[MAXVIDHEIGHT*4];
 extern UINT8 *ylookup3[MAXVIDHEIGHT*4];
@@ -33,6 +32,36 @@ extern INT32 columnofs[MAXVIDWIDTH*4];
 extern UINT8 *topleft;
 extern UINT8 r8_flatcolor;
 
+// Everything the drawers need to know about the splitscreen view they're
+// drawing into. Drawer tasks carry the view they were recorded for, so the
+// next view can be set up while they're still running.
+typedef struct
+{
+	UINT8 viewnum;
+	INT32 windowx, windowy;
+	UINT8 *topleft;
+	UINT8 **ylookup;
+	INT32 centerx, centery;
+	fixed_t centeryfrac;
+	fixed_t *yslope;
+	float focallengthf;
+
+	// Copied from the globals when the view is set up, which the next view overwrites
+	INT32 width, height; // viewwidth, viewheight
+	fixed_t fovtan;
+	lighttable_t *colormaps;
+	UINT8 *encoremap;
+	UINT32 highlight; // debugrender_highlight
+	boolean reducevfx;
+} renderview_t;
+
+extern renderview_t renderviews[MAXSPLITSCREENPLAYERS];
+
+// Bind a splitscreen view's window to the framebuffer, for the calling thread
+void R_SetupRenderView(UINT8 viewnum);
+void R_SetRenderView(const renderview_t *view);
+const renderview_t *R_GetRenderView(void);
+
 // -------------------------
 // COLUMN DRAWING CODE STUFF
 // -------------------------
@@ -41,8 +70,6 @@ extern UINT8 r8_flatcolor;
 // SPAN DRAWING CODE STUFF
 // -----------------------
 
-// Vectors for Software's tilted slope drawers
-extern floatv3_t *ds_su, *ds_sv, *ds_sz;
 extern float focallengthf[MAXSPLITSCREENPLAYERS];
 extern float zeroheight;
 
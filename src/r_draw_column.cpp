@@ -21,6 +21,8 @@
 // a has a constant z depth from top to bottom.
 //
 
+#define COLUMNBATCH 32
+
 enum DrawColumnType
 {
 	DC_BASIC			= 0x0000,
@@ -115,6 +117,7 @@ static void R_DrawColumnTemplate(drawcolumndata_t *dc)
 	if constexpr (Type & DrawColumnType::DC_LIGHTLIST)
 	{
 		constexpr DrawColumnType NewType = static_cast<DrawColumnType>(Type & ~DC_LIGHTLIST);
+		const renderview_t *view = R_GetRenderView();
 		INT32 i, realyh, height, bheight = 0, solid = 0;
 		drawcolumndata_t dc_copy = *dc;
 
@@ -147,9 +150,9 @@ static void R_DrawColumnTemplate(drawcolumndata_t *dc)
 			if (height <= dc_copy.yl)
 			{
 				dc_copy.colormap = dc_copy.lightlist[i].rcolormap;
-				dc_copy.fullbright = colormaps;
+				dc_copy.fullbright = view->colormaps;
 
-				if (encoremap)
+				if (view->encoremap)
 				{
 					dc_copy.colormap += COLORMAP_REMAPOFFSET;
 					dc_copy.fullbright += COLORMAP_REMAPOFFSET;
@@ -182,8 +185,8 @@ static void R_DrawColumnTemplate(drawcolumndata_t *dc)
 			}
 
 			dc_copy.colormap = dc_copy.lightlist[i].rcolormap;
-			dc_copy.fullbright = colormaps;
-			if (encoremap)
+			dc_copy.fullbright = view->colormaps;
+			if (view->encoremap)
 			{
 				dc_copy.colormap += COLORMAP_REMAPOFFSET;
 				dc_copy.fullbright += COLORMAP_REMAPOFFSET;
@@ -210,14 +213,15 @@ static void R_DrawColumnTemplate(drawcolumndata_t *dc)
 		// Use columnofs LUT for subwindows?
 
 		//dest = ylookup[dc_yl] + columnofs[dc_x];
-		dest = &topleft[dc->yl * vid.width + dc->x];
+		const renderview_t *view = R_GetRenderView();
+		dest = &view->topleft[dc->yl * vid.width + dc->x];
 
 		count++;
 
 		// Determine scaling, which is the only mapping to be done.
 		fracstep = dc->iscale;
 		//frac = dc_texturemid + (dc_yl - centery)*fracstep;
-		frac = (dc->texturemid + FixedMul((dc->yl << FRACBITS) - centeryfrac, fracstep)) * (!dc->hires);
+		frac = (dc->texturemid + FixedMul((dc->yl << FRACBITS) - view->centeryfrac, fracstep)) * (!dc->hires);
 
 		// Inner loop that does the actual texture mapping, e.g. a DDA-like scaling.
 		// This is as fast as it gets.
@@ -287,22 +291,24 @@ static void R_DrawColumnTemplate(drawcolumndata_t *dc)
 		}
 		else
 		{
-			while ((count -= 2) >= 0) // texture height is a power of 2
-			{
-				*dest = R_DrawColumnPixel<Type>(dc, dest, (frac>>FRACBITS) & heightmask);
+			// texture height is a power of 2: (frac>>FRACBITS) & heightmask, batched through the SIMD kernel
+			UINT32 bits[COLUMNBATCH];
 
-				dest += vid.width;
-				frac += fracstep;
+			while (count > 0)
+			{
+				const INT32 n = std::min(count, COLUMNBATCH);
+				INT32 i;
 
-				*dest = R_DrawColumnPixel<Type>(dc, dest, (frac>>FRACBITS) & heightmask);
+				R_TexelIndices(bits, n, 0, frac, 0, fracstep, 0, FRACBITS, heightmask);
 
-				dest += vid.width;
-				frac += fracstep;
-			}
+				for (i = 0; i < n; i++)
+				{
+					*dest = R_DrawColumnPixel<Type>(dc, dest, bits[i]);
+					dest += vid.width;
+				}
 
-			if (count & 1)
-			{
-				*dest = R_DrawColumnPixel<Type>(dc, dest, (frac>>FRACBITS) & heightmask);
+				frac = (fixed_t)((UINT32)frac + (UINT32)fracstep * n);
+				count -= n;
 			}
 		}
 	}
@@ -348,7 +354,7 @@ void R_DrawFogColumn(drawcolumndata_t *dc)
 	// Use ylookup LUT to avoid multiply with ScreenWidth.
 	// Use columnofs LUT for subwindows?
 	//dest = ylookup[dc_yl] + columnofs[dc_x];
-	dest = &topleft[dc->yl*vid.width + dc->x];
+	dest = &R_GetRenderView()->topleft[dc->yl*vid.width + dc->x];
 
 	// Determine scaling, which is the only mapping to be done.
 	do
@@ -378,7 +384,7 @@ void R_DrawDropShadowColumn(drawcolumndata_t *dc)
 	if (count <= 0) // Zero length, column does not exceed a pixel.
 		return;
 
-	dest = &topleft[dc->yl*vid.width + dc->x];
+	dest = &R_GetRenderView()->topleft[dc->yl*vid.width + dc->x];
 
 	const UINT8 *transmap_offset = dc->transmap + (dc->shadowcolor << 8);
 	while ((count -= 2) >= 0)
@@ -414,7 +420,7 @@ void R_DrawColumn_Flat(drawcolumndata_t *dc)
 	// Use columnofs LUT for subwindows?
 
 	//dest = ylookup[dc_yl] + columnofs[dc_x];
-	dest = &topleft[dc->yl*vid.width + dc->x];
+	dest = &R_GetRenderView()->topleft[dc->yl*vid.width + dc->x];
 
 	count++;
 
@@ -0,0 +1,704 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_draw_simd.cpp
+/// \brief Vectorized kernels for the software span and column drawers
+///        The drawers spend their arithmetic on stepping texture coordinates
+///        and turning them into texel indices. That part is generated here,
+///        a block at a time, with the widest instruction set the CPU has.
+///        Texel, colormap and translucency lookups are byte gathers and stay
+///        in the (scalar) drawer templates in r_draw_span.cpp/r_draw_column.cpp.
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "doomdef.h"
+#include "r_draw_simd.h"
+#include "r_local.h"
+#include "r_textures.h"
+#include "i_video.h"
+#include "v_video.h"
+#include "m_argv.h"
+#include "command.h"
+#include "console.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DRAWSIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define DRAWSIMD_ARM
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang only emit AVX2 (and, on 32-bit x86, SSE2) inside functions
+// that ask for it; MSVC allows the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define DRAWSIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DRAWSIMD_TARGET(isa)
+#endif
+
+// ==========================================================================
+// SCALAR REFERENCE
+// ==========================================================================
+
+static void R_TexelIndices_Scalar(UINT32 *out, size_t count, UINT32 u, UINT32 v, UINT32 du, UINT32 dv, UINT32 xshift, UINT32 yshift, UINT32 ymask)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		out[i] = ((v >> yshift) & ymask) | (u >> xshift);
+		u += du;
+		v += dv;
+	}
+}
+
+static void R_TiltedLighting_Scalar(INT32 *out, size_t count, fixed_t start, fixed_t step)
+{
+	UINT32 light = (UINT32)start;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		INT32 level;
+
+		light += (UINT32)step;
+		level = (INT32)light >> FRACBITS;
+
+		if (level < 0)
+		{
+			level = 0;
+		}
+		else if (level >= MAXLIGHTSCALE)
+		{
+			level = MAXLIGHTSCALE-1;
+		}
+
+		out[i] = level;
+	}
+}
+
+// ==========================================================================
+// SSE2 / AVX2
+// ==========================================================================
+
+#ifdef DRAWSIMD_X86
+
+DRAWSIMD_TARGET("sse2")
+static void R_TexelIndices_SSE2(UINT32 *out, size_t count, UINT32 u, UINT32 v, UINT32 du, UINT32 dv, UINT32 xshift, UINT32 yshift, UINT32 ymask)
+{
+	const __m128i xs = _mm_cvtsi32_si128((int)xshift);
+	const __m128i ys = _mm_cvtsi32_si128((int)yshift);
+	const __m128i mask = _mm_set1_epi32((int)ymask);
+	const __m128i ustep = _mm_set1_epi32((int)(du * 4));
+	const __m128i vstep = _mm_set1_epi32((int)(dv * 4));
+	__m128i uu = _mm_setr_epi32((int)u, (int)(u + du), (int)(u + du*2), (int)(u + du*3));
+	__m128i vv = _mm_setr_epi32((int)v, (int)(v + dv), (int)(v + dv*2), (int)(v + dv*3));
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		__m128i bits = _mm_or_si128(_mm_and_si128(_mm_srl_epi32(vv, ys), mask), _mm_srl_epi32(uu, xs));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(&out[i]), bits);
+		uu = _mm_add_epi32(uu, ustep);
+		vv = _mm_add_epi32(vv, vstep);
+	}
+
+	R_TexelIndices_Scalar(&out[i], count - i, u + du*(UINT32)i, v + dv*(UINT32)i, du, dv, xshift, yshift, ymask);
+}
+
+DRAWSIMD_TARGET("sse2")
+static void R_TiltedLighting_SSE2(INT32 *out, size_t count, fixed_t start, fixed_t step)
+{
+	const UINT32 s = (UINT32)start, d = (UINT32)step;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i maxlight = _mm_set1_epi32(MAXLIGHTSCALE-1);
+	const __m128i lstep = _mm_set1_epi32((int)(d * 4));
+	__m128i light = _mm_setr_epi32((int)(s + d), (int)(s + d*2), (int)(s + d*3), (int)(s + d*4));
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		// SSE2 has no 32-bit min/max, so clamp with compare masks
+		__m128i level = _mm_srai_epi32(light, FRACBITS);
+		level = _mm_andnot_si128(_mm_cmplt_epi32(level, zero), level);
+		__m128i over = _mm_cmpgt_epi32(level, maxlight);
+		level = _mm_or_si128(_mm_and_si128(over, maxlight), _mm_andnot_si128(over, level));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(&out[i]), level);
+		light = _mm_add_epi32(light, lstep);
+	}
+
+	R_TiltedLighting_Scalar(&out[i], count - i, (fixed_t)(s + d*(UINT32)i), step);
+}
+
+DRAWSIMD_TARGET("avx2")
+static void R_TexelIndices_AVX2(UINT32 *out, size_t count, UINT32 u, UINT32 v, UINT32 du, UINT32 dv, UINT32 xshift, UINT32 yshift, UINT32 ymask)
+{
+	const __m128i xs = _mm_cvtsi32_si128((int)xshift);
+	const __m128i ys = _mm_cvtsi32_si128((int)yshift);
+	const __m256i mask = _mm256_set1_epi32((int)ymask);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i ustep = _mm256_set1_epi32((int)(du * 8));
+	const __m256i vstep = _mm256_set1_epi32((int)(dv * 8));
+	__m256i uu = _mm256_add_epi32(_mm256_set1_epi32((int)u), _mm256_mullo_epi32(lanes, _mm256_set1_epi32((int)du)));
+	__m256i vv = _mm256_add_epi32(_mm256_set1_epi32((int)v), _mm256_mullo_epi32(lanes, _mm256_set1_epi32((int)dv)));
+	size_t i;
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		__m256i bits = _mm256_or_si256(_mm256_and_si256(_mm256_srl_epi32(vv, ys), mask), _mm256_srl_epi32(uu, xs));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(&out[i]), bits);
+		uu = _mm256_add_epi32(uu, ustep);
+		vv = _mm256_add_epi32(vv, vstep);
+	}
+
+	R_TexelIndices_Scalar(&out[i], count - i, u + du*(UINT32)i, v + dv*(UINT32)i, du, dv, xshift, yshift, ymask);
+}
+
+DRAWSIMD_TARGET("avx2")
+static void R_TiltedLighting_AVX2(INT32 *out, size_t count, fixed_t start, fixed_t step)
+{
+	const UINT32 s = (UINT32)start, d = (UINT32)step;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i maxlight = _mm256_set1_epi32(MAXLIGHTSCALE-1);
+	const __m256i lanes = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8);
+	const __m256i lstep = _mm256_set1_epi32((int)(d * 8));
+	__m256i light = _mm256_add_epi32(_mm256_set1_epi32((int)s), _mm256_mullo_epi32(lanes, _mm256_set1_epi32((int)d)));
+	size_t i;
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		__m256i level = _mm256_srai_epi32(light, FRACBITS);
+		level = _mm256_min_epi32(_mm256_max_epi32(level, zero), maxlight);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(&out[i]), level);
+		light = _mm256_add_epi32(light, lstep);
+	}
+
+	R_TiltedLighting_Scalar(&out[i], count - i, (fixed_t)(s + d*(UINT32)i), step);
+}
+
+static void R_CPUID(UINT32 leaf, UINT32 subleaf, UINT32 regs[4])
+{
+#ifdef _MSC_VER
+	int r[4];
+	__cpuidex(r, (int)leaf, (int)subleaf);
+	regs[0] = r[0]; regs[1] = r[1]; regs[2] = r[2]; regs[3] = r[3];
+#else
+	if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+	{
+		regs[0] = regs[1] = regs[2] = regs[3] = 0;
+	}
+#endif
+}
+
+static UINT64 R_XGETBV(void)
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	UINT32 lo, hi;
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((UINT64)hi << 32) | lo;
+#endif
+}
+
+#endif // DRAWSIMD_X86
+
+// ==========================================================================
+// NEON
+// ==========================================================================
+
+#ifdef DRAWSIMD_ARM
+
+static void R_TexelIndices_NEON(UINT32 *out, size_t count, UINT32 u, UINT32 v, UINT32 du, UINT32 dv, UINT32 xshift, UINT32 yshift, UINT32 ymask)
+{
+	// NEON only shifts right by immediates; a negative variable left shift is the same thing
+	const int32x4_t xs = vdupq_n_s32(-(INT32)xshift);
+	const int32x4_t ys = vdupq_n_s32(-(INT32)yshift);
+	const uint32x4_t mask = vdupq_n_u32(ymask);
+	const uint32x4_t ustep = vdupq_n_u32(du * 4);
+	const uint32x4_t vstep = vdupq_n_u32(dv * 4);
+	const UINT32 ulanes[4] = {u, u + du, u + du*2, u + du*3};
+	const UINT32 vlanes[4] = {v, v + dv, v + dv*2, v + dv*3};
+	uint32x4_t uu = vld1q_u32(ulanes);
+	uint32x4_t vv = vld1q_u32(vlanes);
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		uint32x4_t bits = vorrq_u32(vandq_u32(vshlq_u32(vv, ys), mask), vshlq_u32(uu, xs));
+		vst1q_u32(&out[i], bits);
+		uu = vaddq_u32(uu, ustep);
+		vv = vaddq_u32(vv, vstep);
+	}
+
+	R_TexelIndices_Scalar(&out[i], count - i, u + du*(UINT32)i, v + dv*(UINT32)i, du, dv, xshift, yshift, ymask);
+}
+
+static void R_TiltedLighting_NEON(INT32 *out, size_t count, fixed_t start, fixed_t step)
+{
+	const UINT32 s = (UINT32)start, d = (UINT32)step;
+	const int32x4_t zero = vdupq_n_s32(0);
+	const int32x4_t maxlight = vdupq_n_s32(MAXLIGHTSCALE-1);
+	const uint32x4_t lstep = vdupq_n_u32(d * 4);
+	const UINT32 lanes[4] = {s + d, s + d*2, s + d*3, s + d*4};
+	uint32x4_t light = vld1q_u32(lanes);
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		int32x4_t level = vshrq_n_s32(vreinterpretq_s32_u32(light), FRACBITS);
+		level = vminq_s32(vmaxq_s32(level, zero), maxlight);
+		vst1q_s32(&out[i], level);
+		light = vaddq_u32(light, lstep);
+	}
+
+	R_TiltedLighting_Scalar(&out[i], count - i, (fixed_t)(s + d*(UINT32)i), step);
+}
+
+#endif // DRAWSIMD_ARM
+
+// ==========================================================================
+// DISPATCH
+// ==========================================================================
+
+texelindexfunc_t R_TexelIndices = R_TexelIndices_Scalar;
+tiltlightfunc_t R_TiltedLighting = R_TiltedLighting_Scalar;
+
+static drawsimd_t drawsimd = DRAWSIMD_SCALAR;
+
+static const char *drawsimdnames[DRAWSIMD_MAX] = {"scalar", "SSE2", "AVX2", "NEON"};
+
+boolean R_DrawerSIMDSupported(drawsimd_t isa)
+{
+	switch (isa)
+	{
+		case DRAWSIMD_SCALAR:
+			return true;
+#ifdef DRAWSIMD_X86
+		case DRAWSIMD_SSE2:
+		{
+			UINT32 regs[4];
+			R_CPUID(1, 0, regs);
+			return (regs[3] & (1u << 26)) != 0;
+		}
+		case DRAWSIMD_AVX2:
+		{
+			UINT32 regs[4];
+			R_CPUID(0, 0, regs);
+			if (regs[0] < 7)
+			{
+				return false;
+			}
+
+			// AVX (and the OS saving YMM state through XSAVE) before AVX2 itself
+			R_CPUID(1, 0, regs);
+			if ((regs[2] & (1u << 27)) == 0 || (regs[2] & (1u << 28)) == 0)
+			{
+				return false;
+			}
+			if ((R_XGETBV() & 6) != 6)
+			{
+				return false;
+			}
+
+			R_CPUID(7, 0, regs);
+			return (regs[1] & (1u << 5)) != 0;
+		}
+#endif
+#ifdef DRAWSIMD_ARM
+		case DRAWSIMD_NEON:
+			return true;
+#endif
+		default:
+			return false;
+	}
+}
+
+void R_SetDrawerSIMD(drawsimd_t isa)
+{
+	if (!R_DrawerSIMDSupported(isa))
+	{
+		isa = DRAWSIMD_SCALAR;
+	}
+
+	switch (isa)
+	{
+#ifdef DRAWSIMD_X86
+		case DRAWSIMD_SSE2:
+			R_TexelIndices = R_TexelIndices_SSE2;
+			R_TiltedLighting = R_TiltedLighting_SSE2;
+			break;
+		case DRAWSIMD_AVX2:
+			R_TexelIndices = R_TexelIndices_AVX2;
+			R_TiltedLighting = R_TiltedLighting_AVX2;
+			break;
+#endif
+#ifdef DRAWSIMD_ARM
+		case DRAWSIMD_NEON:
+			R_TexelIndices = R_TexelIndices_NEON;
+			R_TiltedLighting = R_TiltedLighting_NEON;
+			break;
+#endif
+		default:
+			R_TexelIndices = R_TexelIndices_Scalar;
+			R_TiltedLighting = R_TiltedLighting_Scalar;
+			break;
+	}
+
+	drawsimd = isa;
+}
+
+drawsimd_t R_GetDrawerSIMD(void)
+{
+	return drawsimd;
+}
+
+const char *R_DrawerSIMDName(drawsimd_t isa)
+{
+	return (isa < DRAWSIMD_MAX) ? drawsimdnames[isa] : "unknown";
+}
+
+void R_InitDrawerSIMD(void)
+{
+	drawsimd_t best = DRAWSIMD_SCALAR;
+	INT32 i;
+
+	if (!M_CheckParm("-nosimd"))
+	{
+		for (i = DRAWSIMD_MAX-1; i > DRAWSIMD_SCALAR; i--)
+		{
+			if (R_DrawerSIMDSupported(static_cast<drawsimd_t>(i)))
+			{
+				best = static_cast<drawsimd_t>(i);
+				break;
+			}
+		}
+	}
+
+	R_SetDrawerSIMD(best);
+	CONS_Printf("R_InitDrawerSIMD(): using %s drawer kernels\n", R_DrawerSIMDName(best));
+}
+
+// ==========================================================================
+// TEST HARNESS
+// ==========================================================================
+
+namespace
+{
+
+struct DrawerSIMDRandom
+{
+	UINT32 state = 0x9E3779B9u;
+
+	UINT32 next()
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	INT32 range(INT32 lo, INT32 hi) { return lo + (INT32)(next() % (UINT32)(hi - lo + 1)); }
+	float unit() { return (next() >> 8) * (1.f / 16777216.f); }
+	void fill(std::vector<UINT8>& buf) { for (UINT8& b : buf) b = (UINT8)next(); }
+};
+
+enum DrawerSIMDCase
+{
+	DSC_SPAN,
+	DSC_TRANSLUCENTSPAN,
+	DSC_SPLAT,
+	DSC_WATERSPAN,
+	DSC_TILTEDSPAN,
+	DSC_TRANSLUCENTTILTEDSPAN,
+	DSC_COLUMN,
+	DSC_TRANSLUCENTCOLUMN,
+	DSC_TRANSLATEDCOLUMN,
+	DSC_2SMULTIPATCHCOLUMN,
+
+	DSC_MAX
+};
+
+const char *drawersimdcasenames[DSC_MAX] = {
+	"R_DrawSpan",
+	"R_DrawTranslucentSpan",
+	"R_DrawSplat",
+	"R_DrawTranslucentWaterSpan",
+	"R_DrawSpan_Tilted",
+	"R_DrawTranslucentSpan_Tilted",
+	"R_DrawColumn",
+	"R_DrawTranslucentColumn",
+	"R_DrawTranslatedColumn",
+	"R_Draw2sMultiPatchColumn",
+};
+
+// Compare the kernels directly on random coordinates, steps, shifts and lengths
+size_t DrawerSIMDTestKernels(drawsimd_t isa, size_t iterations, DrawerSIMDRandom& rng)
+{
+	std::vector<UINT32> ref(MAXVIDWIDTH), got(MAXVIDWIDTH);
+	std::vector<INT32> lref(MAXVIDWIDTH), lgot(MAXVIDWIDTH);
+	size_t failures = 0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++)
+	{
+		const size_t count = rng.next() % (MAXVIDWIDTH + 1);
+		const UINT32 u = rng.next(), v = rng.next(), du = rng.next() >> rng.range(0, 31), dv = rng.next() >> rng.range(0, 31);
+		const UINT32 xshift = rng.range(0, 31), yshift = rng.range(0, 31), ymask = rng.next() >> rng.range(0, 31);
+		const fixed_t start = (fixed_t)rng.next(), step = (fixed_t)(rng.next() >> rng.range(0, 31)) - (1 << 15);
+
+		R_SetDrawerSIMD(DRAWSIMD_SCALAR);
+		R_TexelIndices(ref.data(), count, u, v, du, dv, xshift, yshift, ymask);
+		R_TiltedLighting(lref.data(), count, start, step);
+
+		R_SetDrawerSIMD(isa);
+		R_TexelIndices(got.data(), count, u, v, du, dv, xshift, yshift, ymask);
+		R_TiltedLighting(lgot.data(), count, start, step);
+
+		if (!std::equal(ref.begin(), ref.begin() + count, got.begin()) ||
+			!std::equal(lref.begin(), lref.begin() + count, lgot.begin()))
+		{
+			if (failures++ == 0)
+			{
+				CONS_Printf("  %s kernel mismatch: count %s, u %08x v %08x du %08x dv %08x shifts %u/%u mask %08x\n",
+					R_DrawerSIMDName(isa), sizeu1(count), u, v, du, dv, xshift, yshift, ymask);
+			}
+		}
+	}
+
+	return failures;
+}
+
+struct DrawerSIMDTables
+{
+	std::vector<UINT8> source = std::vector<UINT8>(256*256);
+	std::vector<UINT8> colormap = std::vector<UINT8>(256);
+	std::vector<UINT8> translation = std::vector<UINT8>(256);
+	std::vector<UINT8> transmap = std::vector<UINT8>(256*256);
+	std::vector<UINT8> lighttables = std::vector<UINT8>(256*MAXLIGHTSCALE);
+	lighttable_t *planezlight[MAXLIGHTSCALE];
+};
+
+// Run one randomized drawer call with the given kernels; returns the pixels it touched
+std::vector<UINT8> DrawerSIMDRunCase(DrawerSIMDCase which, drawsimd_t isa, UINT32 seed, DrawerSIMDTables& tables)
+{
+	DrawerSIMDRandom rng;
+	rng.state = seed;
+
+	R_SetDrawerSIMD(isa);
+
+	const renderview_t *view = R_GetRenderView();
+	std::vector<UINT8> pixels;
+
+	if (which < DSC_COLUMN)
+	{
+		static const size_t flatsizes[] = {64, 256, 1024, 4096, 16384, 65536};
+		drawspandata_t ds {};
+
+		R_CheckFlatLength(&ds, flatsizes[rng.next() % (sizeof flatsizes / sizeof *flatsizes)]);
+		ds.y = rng.range(0, viewheight-1);
+		ds.x1 = rng.range(0, viewwidth-1);
+		ds.x2 = rng.range(ds.x1, viewwidth-1);
+		ds.xfrac = (fixed_t)rng.next();
+		ds.yfrac = (fixed_t)rng.next();
+		ds.xstep = rng.range(-4*FRACUNIT, 4*FRACUNIT);
+		ds.ystep = rng.range(-4*FRACUNIT, 4*FRACUNIT);
+		ds.waterofs = rng.range(0, 8) << FRACBITS;
+		ds.bgofs = 0;
+		ds.source = tables.source.data();
+		ds.colormap = colormaps;
+		ds.transmap = tables.transmap.data();
+		ds.planezlight = tables.planezlight;
+		ds.zeroheight = 1.f + rng.unit() * 1024.f;
+		ds.szp = {(rng.unit() - .5f) * 1e-3f, (rng.unit() - .5f) * 1e-3f, 1.f + rng.unit()};
+		ds.sup = {(rng.unit() - .5f) * 65536.f, (rng.unit() - .5f) * 65536.f, (rng.unit() - .5f) * 16777216.f};
+		ds.svp = {(rng.unit() - .5f) * 65536.f, (rng.unit() - .5f) * 65536.f, (rng.unit() - .5f) * 16777216.f};
+
+		UINT8 *dest = view->ylookup[ds.y] + columnofs[ds.x1];
+		const size_t length = ds.x2 - ds.x1 + 1;
+
+		switch (which)
+		{
+			case DSC_SPAN: R_DrawSpan(&ds); break;
+			case DSC_TRANSLUCENTSPAN: R_DrawTranslucentSpan(&ds); break;
+			case DSC_SPLAT: R_DrawSplat(&ds); break;
+			case DSC_WATERSPAN: R_DrawTranslucentWaterSpan(&ds); break;
+			case DSC_TILTEDSPAN: R_DrawSpan_Tilted(&ds); break;
+			default: R_DrawTranslucentSpan_Tilted(&ds); break;
+		}
+
+		pixels.assign(dest, dest + length);
+	}
+	else
+	{
+		drawcolumndata_t dc {};
+		INT32 y;
+
+		dc.x = rng.range(0, viewwidth-1);
+		dc.yl = rng.range(0, viewheight-1);
+		dc.yh = rng.range(dc.yl, viewheight-1);
+		dc.iscale = rng.range(FRACUNIT/8, 8*FRACUNIT);
+		dc.texturemid = rng.range(-256*FRACUNIT, 256*FRACUNIT);
+		dc.sourcelength = dc.texheight = 1 << rng.range(3, 10);
+		dc.source = tables.source.data();
+		dc.colormap = tables.colormap.data();
+		dc.translation = tables.translation.data();
+		dc.transmap = tables.transmap.data();
+
+		switch (which)
+		{
+			case DSC_COLUMN: R_DrawColumn(&dc); break;
+			case DSC_TRANSLUCENTCOLUMN: R_DrawTranslucentColumn(&dc); break;
+			case DSC_TRANSLATEDCOLUMN: R_DrawTranslatedColumn(&dc); break;
+			default: R_Draw2sMultiPatchColumn(&dc); break;
+		}
+
+		for (y = dc.yl; y <= dc.yh; y++)
+		{
+			pixels.push_back(view->topleft[y * vid.width + dc.x]);
+		}
+	}
+
+	return pixels;
+}
+
+// Draw the same random spans and columns with the scalar and the vectorized
+// kernels into the real framebuffer, and compare what landed there.
+size_t DrawerSIMDTestDrawers(drawsimd_t isa, size_t iterations, DrawerSIMDRandom& rng, size_t *casefailures)
+{
+	DrawerSIMDTables tables;
+	const size_t screensize = (size_t)vid.width * vid.height;
+	std::vector<UINT8> background(screens[0], screens[0] + screensize);
+	size_t failures = 0;
+	size_t i;
+
+	rng.fill(tables.source);
+	rng.fill(tables.colormap);
+	rng.fill(tables.translation);
+	rng.fill(tables.transmap);
+	rng.fill(tables.lighttables);
+	for (i = 0; i < MAXLIGHTSCALE; i++)
+	{
+		tables.planezlight[i] = &tables.lighttables[i*256];
+	}
+
+	for (i = 0; i < iterations; i++)
+	{
+		const DrawerSIMDCase which = static_cast<DrawerSIMDCase>(i % DSC_MAX);
+		const UINT32 seed = rng.next() | 1;
+
+		if (which == DSC_WATERSPAN && !screens[1])
+		{
+			continue;
+		}
+
+		std::copy(background.begin(), background.end(), screens[0]);
+		std::vector<UINT8> ref = DrawerSIMDRunCase(which, DRAWSIMD_SCALAR, seed, tables);
+
+		std::copy(background.begin(), background.end(), screens[0]);
+		std::vector<UINT8> got = DrawerSIMDRunCase(which, isa, seed, tables);
+
+		if (ref != got)
+		{
+			if (casefailures[which]++ == 0)
+			{
+				CONS_Printf("  %s %s mismatch (seed %08x)\n", R_DrawerSIMDName(isa), drawersimdcasenames[which], seed);
+			}
+			failures++;
+		}
+	}
+
+	std::copy(background.begin(), background.end(), screens[0]);
+	return failures;
+}
+
+// Texel indices per microsecond, in the 64-pixel batches the span drawer uses
+double DrawerSIMDBenchKernel(drawsimd_t isa)
+{
+	using Clock = std::chrono::steady_clock;
+	constexpr size_t kBatch = 64;
+	constexpr size_t kRounds = 200000;
+	UINT32 out[kBatch];
+	UINT32 sink = 0;
+	size_t i;
+
+	R_SetDrawerSIMD(isa);
+
+	auto start = Clock::now();
+	for (i = 0; i < kRounds; i++)
+	{
+		R_TexelIndices(out, kBatch, (UINT32)i << 10, (UINT32)i << 12, 0x12345, 0x6789, 26, 20, 0xFC0);
+		sink += out[i % kBatch];
+	}
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	volatile UINT32 keep = sink;
+	(void)keep;
+	return elapsed > 0 ? (double)(kRounds * kBatch) * 1000.0 / (double)elapsed : 0.0;
+}
+
+} // namespace
+
+void Command_DrawSIMDTest_f(void)
+{
+	const drawsimd_t active = R_GetDrawerSIMD();
+	const size_t iterations = COM_Argc() > 1 ? std::max(1, atoi(COM_Argv(1))) : 10000;
+	const boolean drawers = (rendermode == render_soft && screens[0] && viewwidth > 0 && viewheight > 0);
+	const renderview_t *previousview = R_GetRenderView();
+	DrawerSIMDRandom rng;
+	INT32 i;
+
+	if (drawers)
+	{
+		R_SetRenderView(&renderviews[0]);
+	}
+	else
+	{
+		CONS_Printf("drawsimd_test: not in software mode, only the kernels will be checked\n");
+	}
+
+	CONS_Printf("drawsimd_test: %s iterations, active kernels: %s\n", sizeu1(iterations), R_DrawerSIMDName(active));
+	CONS_Printf("  %-6s %8.1f texels/us\n", R_DrawerSIMDName(DRAWSIMD_SCALAR), DrawerSIMDBenchKernel(DRAWSIMD_SCALAR));
+
+	for (i = DRAWSIMD_SCALAR + 1; i < DRAWSIMD_MAX; i++)
+	{
+		const drawsimd_t isa = static_cast<drawsimd_t>(i);
+		size_t casefailures[DSC_MAX] = {};
+		size_t kernelfailures, drawerfailures = 0;
+
+		if (!R_DrawerSIMDSupported(isa))
+		{
+			continue;
+		}
+
+		kernelfailures = DrawerSIMDTestKernels(isa, iterations, rng);
+		if (drawers)
+		{
+			drawerfailures = DrawerSIMDTestDrawers(isa, iterations, rng, casefailures);
+		}
+
+		CONS_Printf("  %-6s %8.1f texels/us, %s kernel mismatches, %s drawer mismatches%s\n",
+			R_DrawerSIMDName(isa), DrawerSIMDBenchKernel(isa),
+			sizeu1(kernelfailures), sizeu2(drawerfailures),
+			(kernelfailures || drawerfailures) ? "" : " (bit-exact)");
+	}
+
+	R_SetDrawerSIMD(active);
+	R_SetRenderView(previousview);
+}
@@ -0,0 +1,58 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_draw_simd.h
+/// \brief Vectorized kernels for the software span and column drawers
+
+#ifndef __R_DRAW_SIMD__
+#define __R_DRAW_SIMD__
+
+#include "doomtype.h"
+#include "m_fixed.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+	DRAWSIMD_SCALAR,
+	DRAWSIMD_SSE2,
+	DRAWSIMD_AVX2,
+	DRAWSIMD_NEON,
+
+	DRAWSIMD_MAX
+} drawsimd_t;
+
+// out[i] = (((v + dv*i) >> yshift) & ymask) | ((u + du*i) >> xshift)
+// Shared by the power-of-two span, tilted span and column drawers.
+typedef void (*texelindexfunc_t)(UINT32 *out, size_t count, UINT32 u, UINT32 v, UINT32 du, UINT32 dv, UINT32 xshift, UINT32 yshift, UINT32 ymask);
+
+// out[i] = clamp((start + step*(i+1)) >> FRACBITS, 0, MAXLIGHTSCALE-1)
+typedef void (*tiltlightfunc_t)(INT32 *out, size_t count, fixed_t start, fixed_t step);
+
+extern texelindexfunc_t R_TexelIndices;
+extern tiltlightfunc_t R_TiltedLighting;
+
+// Pick the widest instruction set the CPU supports; -nosimd forces the scalar kernels
+void R_InitDrawerSIMD(void);
+
+boolean R_DrawerSIMDSupported(drawsimd_t isa);
+void R_SetDrawerSIMD(drawsimd_t isa);
+drawsimd_t R_GetDrawerSIMD(void);
+const char *R_DrawerSIMDName(drawsimd_t isa);
+
+/// Debug command: drawsimd_test [iterations]
+/// Compares every supported kernel set against the scalar reference, bit for bit.
+void Command_DrawSIMDTest_f(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __R_DRAW_SIMD__
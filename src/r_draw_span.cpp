@@ -20,12 +20,13 @@ using namespace libdivide;
 // ==========================================================================
 
 #define SPANSIZE 16
+#define SPANBATCH 64
 #define INVSPAN 0.0625f
 
 // <Callum> 4194303 = (2048x2048)-1 (2048x2048 is maximum flat size)
 #define MAXFLATBYTES 4194303
 
-#define PLANELIGHTFLOAT (BASEVIDWIDTH * BASEVIDWIDTH / vid.width / ds->zeroheight / 21.0f * FIXED_TO_FLOAT(fovtan[viewssnum]))
+#define PLANELIGHTFLOAT (BASEVIDWIDTH * BASEVIDWIDTH / vid.width / ds->zeroheight / 21.0f * FIXED_TO_FLOAT(view->fovtan))
 
 enum DrawSpanType
 {
@@ -140,6 +141,8 @@ static constexpr UINT8 R_DrawSpanPixel(drawspandata_t* ds, UINT8 *dsrc, UINT8 *c
 template<DrawSpanType Type>
 static void R_DrawSpanTemplate(drawspandata_t* ds)
 {
+	const renderview_t *view = R_GetRenderView();
+
 	fixed_t xposition;
 	fixed_t yposition;
 	fixed_t xstep, ystep;
@@ -171,7 +174,7 @@ static void R_DrawSpanTemplate(drawspandata_t* ds)
 	xposition <<= ds->nflatshiftup; yposition <<= ds->nflatshiftup;
 	xstep <<= ds->nflatshiftup; ystep <<= ds->nflatshiftup;
 
-	dest = ylookup[ds->y] + columnofs[ds->x1];
+	dest = view->ylookup[ds->y] + columnofs[ds->x1];
 	if constexpr (Type & DS_RIPPLE)
 	{
 		dsrc = screens[1] + (ds->y + ds->bgofs) * vid.width + ds->x1;
@@ -191,21 +194,24 @@ static void R_DrawSpanTemplate(drawspandata_t* ds)
 		// SoM: Why didn't I see this earlier? the spot variable is a waste now because we don't
 		// have the uber complicated math to calculate it now, so that was a memory write we didn't
 		// need!
+		// Texel indices for the whole run of 8-pixel groups come from the SIMD kernel.
+		UINT32 bits[SPANBATCH];
+		const size_t n = std::min<size_t>(count & ~static_cast<size_t>(7), SPANBATCH);
 
-		for (i = 0; i < 8; i++)
-		{
-			bit = (((UINT32)yposition >> ds->nflatyshift) & ds->nflatmask) | ((UINT32)xposition >> ds->nflatxshift);
-
-			dest[i] = R_DrawSpanPixel<Type>(ds, &dsrc[i], ds->colormap, bit);
+		R_TexelIndices(bits, n, xposition, yposition, xstep, ystep, ds->nflatxshift, ds->nflatyshift, ds->nflatmask);
 
-			xposition += xstep;
-			yposition += ystep;
+		for (i = 0; i < n; i++)
+		{
+			dest[i] = R_DrawSpanPixel<Type>(ds, &dsrc[i], ds->colormap, bits[i]);
 		}
 
-		dest += 8;
-		dsrc += 8;
+		xposition = (fixed_t)((UINT32)xposition + (UINT32)xstep * n);
+		yposition = (fixed_t)((UINT32)yposition + (UINT32)ystep * n);
 
-		count -= 8;
+		dest += n;
+		dsrc += n;
+
+		count -= n;
 	}
 
 	while (count-- && dest <= deststop)
@@ -228,31 +234,17 @@ static void R_CalcTiltedLighting(INT32 *lightbuffer, INT32 x1, INT32 x2, fixed_t
 {
 	// ZDoom uses a different lighting setup to us, and I couldn't figure out how to adapt their version
 	// of this function. Here's my own.
-	INT32 left = x1, right = x2;
 	fixed_t step = (end-start)/(x2 - x1 + 1);
-	INT32 i;
-
-	// I wanna do some optimizing by checking for out-of-range segments on either side to fill in all at once,
-	// but I'm too bad at coding to not crash the game trying to do that. I guess this is fast enough for now...
 
-	for (i = left; i <= right; i++)
-	{
-		lightbuffer[i] = (start += step) >> FRACBITS;
-
-		if (lightbuffer[i] < 0)
-		{
-			lightbuffer[i] = 0;
-		}
-		else if (lightbuffer[i] >= MAXLIGHTSCALE)
-		{
-			lightbuffer[i] = MAXLIGHTSCALE-1;
-		}
-	}
+	// Step, shift and clamp to [0, MAXLIGHTSCALE-1]; see r_draw_simd.cpp
+	R_TiltedLighting(&lightbuffer[x1], x2 - x1 + 1, start, step);
 }
 
 template<DrawSpanType Type>
 static void R_DrawTiltedSpanTemplate(drawspandata_t* ds)
 {
+	const renderview_t *view = R_GetRenderView();
+
 	// x1, x2 = ds_x1, ds_x2
 	int width = ds->x2 - ds->x1;
 	double iz, uz, vz;
@@ -275,7 +267,7 @@ static void R_DrawTiltedSpanTemplate(drawspandata_t* ds)
 	const INT32 nflatyshift = ds->nflatyshift;
 	const INT32 nflatmask = ds->nflatmask;
 
-	iz = ds->szp.z + ds->szp.y*(centery-ds->y) + ds->szp.x*(ds->x1-centerx);
+	iz = ds->szp.z + ds->szp.y*(view->centery-ds->y) + ds->szp.x*(ds->x1-view->centerx);
 
 	// Lighting is simple. It's just linear interpolation from start to end
 	if constexpr (!(Type & DS_SPRITE))
@@ -290,12 +282,12 @@ static void R_DrawTiltedSpanTemplate(drawspandata_t* ds)
 		//CONS_Printf("tilted lighting %f to %f (foc %f)\n", lightstart, lightend, focallengthf);
 	}
 
-	uz = ds->sup.z + ds->sup.y*(centery-ds->y) + ds->sup.x*(ds->x1-centerx);
-	vz = ds->svp.z + ds->svp.y*(centery-ds->y) + ds->svp.x*(ds->x1-centerx);
+	uz = ds->sup.z + ds->sup.y*(view->centery-ds->y) + ds->sup.x*(ds->x1-view->centerx);
+	vz = ds->svp.z + ds->svp.y*(view->centery-ds->y) + ds->svp.x*(ds->x1-view->centerx);
 
 	colormap = ds->colormap;
 
-	dest = ylookup[ds->y] + columnofs[ds->x1];
+	dest = view->ylookup[ds->y] + columnofs[ds->x1];
 	if constexpr (Type & DS_RIPPLE)
 	{
 		dsrc = screens[1] + (ds->y + ds->bgofs) * vid.width + ds->x1;
@@ -317,7 +309,7 @@ static void R_DrawTiltedSpanTemplate(drawspandata_t* ds)
 		bit = ((v >> nflatyshift) & nflatmask) | (u >> nflatxshift);
 		if constexpr (!(Type & DS_SPRITE))
 		{
-			colormap = planezlight[tiltlighting[ds->x1]] + (ds->colormap - colormaps);
+			colormap = planezlight[tiltlighting[ds->x1]] + (ds->colormap - view->colormaps);
 		}
 		*dest = R_DrawSpanPixel<Type>(ds, dsrc, colormap, bit);
 		dest++;
@@ -354,13 +346,16 @@ static void R_DrawTiltedSpanTemplate(drawspandata_t* ds)
 
 		x1 = ds->x1;
 
+		UINT32 bits[SPANSIZE];
+		R_TexelIndices(bits, SPANSIZE, u, v, stepu, stepv, nflatxshift, nflatyshift, nflatmask);
+
 		for (i = 0; i < SPANSIZE; i++)
 		{
-			bit = (((v + stepv * i) >> nflatyshift) & nflatmask) | ((u + stepu * i) >> nflatxshift);
+			bit = bits[i];
 
 			if constexpr (!(Type & DS_SPRITE))
 			{
-				colormap = ds->planezlight[tiltlighting[x1 + i]] + (ds->colormap - colormaps);
+				colormap = ds->planezlight[tiltlighting[x1 + i]] + (ds->colormap - view->colormaps);
 			}
 
 			dest[i] = R_DrawSpanPixel<Type>(ds, &dsrc[i], colormap, bit);
@@ -383,7 +378,7 @@ static void R_DrawTiltedSpanTemplate(drawspandata_t* ds)
 			bit = ((v >> nflatyshift) & nflatmask) | (u >> nflatxshift);
 			if constexpr (!(Type & DS_SPRITE))
 			{
-				colormap = ds->planezlight[tiltlighting[ds->x1]] + (ds->colormap - colormaps);
+				colormap = ds->planezlight[tiltlighting[ds->x1]] + (ds->colormap - view->colormaps);
 			}
 			*dest = R_DrawSpanPixel<Type>(ds, dsrc, colormap, bit);
 			ds->x1++;
@@ -404,19 +399,19 @@ static void R_DrawTiltedSpanTemplate(drawspandata_t* ds)
 			u = (INT64)(startu);
 			v = (INT64)(startv);
 
-			for (; width != 0; width--)
+			UINT32 bits[SPANSIZE];
+			R_TexelIndices(bits, width, u, v, stepu, stepv, nflatxshift, nflatyshift, nflatmask);
+
+			for (i = 0; i < width; i++)
 			{
-				bit = ((v >> ds->nflatyshift) & ds->nflatmask) | (u >> ds->nflatxshift);
 				if constexpr (!(Type & DS_SPRITE))
 				{
-					colormap = ds->planezlight[tiltlighting[ds->x1]] + (ds->colormap - colormaps);
+					colormap = ds->planezlight[tiltlighting[ds->x1]] + (ds->colormap - view->colormaps);
 				}
-				*dest = R_DrawSpanPixel<Type>(ds, dsrc, colormap, bit);
+				*dest = R_DrawSpanPixel<Type>(ds, dsrc, colormap, bits[i]);
 				dest++;
 				ds->x1++;
 				dsrc++;
-				u += stepu;
-				v += stepv;
 			}
 		}
 	}
@@ -429,6 +424,8 @@ static void R_DrawTiltedSpanTemplate(drawspandata_t* ds)
 template<DrawSpanType Type>
 static void R_DrawNPO2SpanTemplate(drawspandata_t* ds)
 {
+	const renderview_t *view = R_GetRenderView();
+
 	fixed_t xposition;
 	fixed_t yposition;
 	fixed_t xstep, ystep;
@@ -449,7 +446,7 @@ static void R_DrawNPO2SpanTemplate(drawspandata_t* ds)
 		yposition += ds->waterofs;
 	}
 
-	dest = ylookup[ds->y] + columnofs[ds->x1];
+	dest = view->ylookup[ds->y] + columnofs[ds->x1];
 
 	if constexpr (Type & DS_RIPPLE)
 	{
@@ -512,6 +509,8 @@ static void R_DrawNPO2SpanTemplate(drawspandata_t* ds)
 template<DrawSpanType Type>
 static void R_DrawTiltedNPO2SpanTemplate(drawspandata_t* ds)
 {
+	const renderview_t *view = R_GetRenderView();
+
 	// x1, x2 = ds_x1, ds_x2
 	int width = ds->x2 - ds->x1;
 	double iz, uz, vz;
@@ -531,7 +530,7 @@ static void R_DrawTiltedNPO2SpanTemplate(drawspandata_t* ds)
 	struct libdivide_u32_t x_divider = libdivide_u32_gen(ds->flatwidth);
 	struct libdivide_u32_t y_divider = libdivide_u32_gen(ds->flatheight);
 
-	iz = ds->szp.z + ds->szp.y*(centery-ds->y) + ds->szp.x*(ds->x1-centerx);
+	iz = ds->szp.z + ds->szp.y*(view->centery-ds->y) + ds->szp.x*(ds->x1-view->centerx);
 
 	// Lighting is simple. It's just linear interpolation from start to end
 	if constexpr (!(Type & DS_SPRITE))
@@ -546,12 +545,12 @@ static void R_DrawTiltedNPO2SpanTemplate(drawspandata_t* ds)
 		//CONS_Printf("tilted lighting %f to %f (foc %f)\n", lightstart, lightend, focallengthf);
 	}
 
-	uz = ds->sup.z + ds->sup.y*(centery-ds->y) + ds->sup.x*(ds->x1-centerx);
-	vz = ds->svp.z + ds->svp.y*(centery-ds->y) + ds->svp.x*(ds->x1-centerx);
+	uz = ds->sup.z + ds->sup.y*(view->centery-ds->y) + ds->sup.x*(ds->x1-view->centerx);
+	vz = ds->svp.z + ds->svp.y*(view->centery-ds->y) + ds->svp.x*(ds->x1-view->centerx);
 
 	colormap = ds->colormap;
 
-	dest = ylookup[ds->y] + columnofs[ds->x1];
+	dest = view->ylookup[ds->y] + columnofs[ds->x1];
 
 	if constexpr (Type & DS_RIPPLE)
 	{
@@ -573,7 +572,7 @@ static void R_DrawTiltedNPO2SpanTemplate(drawspandata_t* ds)
 
 		if constexpr (!(Type & DS_SPRITE))
 		{
-			colormap = ds->planezlight[tiltlighting[ds->x1++]] + (ds->colormap - colormaps);
+			colormap = ds->planezlight[tiltlighting[ds->x1++]] + (ds->colormap - view->colormaps);
 		}
 
 		// Lactozilla: Non-powers-of-two
@@ -628,7 +627,7 @@ static void R_DrawTiltedNPO2SpanTemplate(drawspandata_t* ds)
 		{
 			if constexpr (!(Type & DS_SPRITE))
 			{
-				colormap = ds->planezlight[tiltlighting[ds->x1++]] + (ds->colormap - colormaps);
+				colormap = ds->planezlight[tiltlighting[ds->x1++]] + (ds->colormap - view->colormaps);
 			}
 
 			// Lactozilla: Non-powers-of-two
@@ -666,7 +665,7 @@ static void R_DrawTiltedNPO2SpanTemplate(drawspandata_t* ds)
 
 			if constexpr (!(Type & DS_SPRITE))
 			{
-				colormap = ds->planezlight[tiltlighting[ds->x1++]] + (ds->colormap - colormaps);
+				colormap = ds->planezlight[tiltlighting[ds->x1++]] + (ds->colormap - view->colormaps);
 			}
 
 			// Lactozilla: Non-powers-of-two
@@ -707,7 +706,7 @@ static void R_DrawTiltedNPO2SpanTemplate(drawspandata_t* ds)
 			{
 				if constexpr (!(Type & DS_SPRITE))
 				{
-					colormap = ds->planezlight[tiltlighting[ds->x1++]] + (ds->colormap - colormaps);
+					colormap = ds->planezlight[tiltlighting[ds->x1++]] + (ds->colormap - view->colormaps);
 				}
 
 				// Lactozilla: Non-powers-of-two
@@ -767,6 +766,8 @@ void R_DrawFogSpan(drawspandata_t* ds)
 {
 	ZoneScoped;
 
+	const renderview_t *view = R_GetRenderView();
+
 	UINT8 *colormap;
 	UINT8 *dest;
 
@@ -775,7 +776,7 @@ void R_DrawFogSpan(drawspandata_t* ds)
 	colormap = ds->colormap;
 
 	//dest = ylookup[ds_y] + columnofs[ds_x1];
-	dest = &topleft[ds->y *vid.width + ds->x1];
+	dest = &view->topleft[ds->y *vid.width + ds->x1];
 
 	count = ds->x2 - ds->x1 + 1;
 
@@ -801,12 +802,14 @@ void R_DrawFogSpan_Tilted(drawspandata_t* ds)
 {
 	ZoneScoped;
 
+	const renderview_t *view = R_GetRenderView();
+
 	// x1, x2 = ds_x1, ds_x2
 	int width = ds->x2 - ds->x1;
-	double iz = ds->szp.z + ds->szp.y*(centery-ds->y) + ds->szp.x*(ds->x1-centerx);
+	double iz = ds->szp.z + ds->szp.y*(view->centery-ds->y) + ds->szp.x*(ds->x1-view->centerx);
 	INT32 tiltlighting[MAXVIDWIDTH];
 
-	UINT8 *dest = ylookup[ds->y] + columnofs[ds->x1];
+	UINT8 *dest = view->ylookup[ds->y] + columnofs[ds->x1];
 
 	// Lighting is simple. It's just linear interpolation from start to end
 	{
@@ -822,7 +825,7 @@ void R_DrawFogSpan_Tilted(drawspandata_t* ds)
 
 	do
 	{
-		UINT8 *colormap = ds->planezlight[tiltlighting[ds->x1++]] + (ds->colormap - colormaps);
+		UINT8 *colormap = ds->planezlight[tiltlighting[ds->x1++]] + (ds->colormap - view->colormaps);
 		*dest = colormap[*dest];
 		dest++;
 	}
@@ -833,7 +836,9 @@ void R_DrawSpan_Flat(drawspandata_t* ds)
 {
 	ZoneScoped;
 
-	UINT8 *dest = ylookup[ds->y] + columnofs[ds->x1];
+	const renderview_t *view = R_GetRenderView();
+
+	UINT8 *dest = view->ylookup[ds->y] + columnofs[ds->x1];
 	memset(dest, ds->colormap[ds->r8_flatcolor], (ds->x2 - ds->x1) + 1);
 }
 
@@ -841,12 +846,14 @@ void R_DrawTiltedSpan_Flat(drawspandata_t* ds)
 {
 	ZoneScoped;
 
+	const renderview_t *view = R_GetRenderView();
+
 	// x1, x2 = ds_x1, ds_x2
 	int width = ds->x2 - ds->x1;
-	double iz = ds->szp.z + ds->szp.y*(centery-ds->y) + ds->szp.x*(ds->x1-centerx);
+	double iz = ds->szp.z + ds->szp.y*(view->centery-ds->y) + ds->szp.x*(ds->x1-view->centerx);
 	INT32 tiltlighting[MAXVIDWIDTH];
 
-	UINT8 *dest = ylookup[ds->y];
+	UINT8 *dest = view->ylookup[ds->y];
 
 	// Lighting is simple. It's just linear interpolation from start to end
 	{
@@ -15,6 +15,10 @@
 ///        See tables.c, too.
 
 #include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <tracy/tracy/Tracy.hpp>
 
 #include "doomdef.h"
 #include "g_game.h"
@@ -41,6 +45,7 @@
 #include "doomstat.h" // MAXSPLITSCREENPLAYERS
 #include "r_fps.h" // Frame interpolation/uncapped
 #include "core/thread_pool.h"
+#include "r_draw_simd.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -126,6 +131,7 @@ precise_t ps_bsptime = 0;
 
 precise_t ps_sw_spritecliptime = 0;
 precise_t ps_sw_portaltime = 0;
+precise_t ps_sw_walltime = 0;
 precise_t ps_sw_planetime = 0;
 precise_t ps_sw_maskedtime = 0;
 
@@ -134,6 +140,10 @@ int ps_numsprites = 0;
 int ps_numdrawnodes = 0;
 int ps_numpolyobjects = 0;
 
+int ps_2d_numcmds = 0;
+int ps_2d_numunmerged = 0;
+int ps_2d_numdraws = 0;
+
 struct RenderStats g_renderstats;
 
 void SplitScreen_OnChange(void)
@@ -1044,19 +1054,6 @@ void R_ExecuteSetViewSize(void)
 	// setup sky scaling
 	R_SetSkyScale();
 
-	// planes
-	if (rendermode == render_soft)
-	{
-		if (ds_su)
-			Z_Free(ds_su);
-		if (ds_sv)
-			Z_Free(ds_sv);
-		if (ds_sz)
-			Z_Free(ds_sz);
-
-		ds_su = ds_sv = ds_sz = NULL;
-	}
-
 	memset(scalelight, 0xFF, sizeof(scalelight));
 
 	// Calculate the light levels to use for each level/scale combination.
@@ -1124,6 +1121,8 @@ void R_Init(void)
 
 	R_InitDrawNodes();
 
+	R_InitDrawerSIMD();
+
 	framecount = 0;
 }
 
@@ -1493,6 +1492,145 @@ static void R_RenderViewpoint(maskcount_t* mask, INT32 cachenum)
 	Mask_Post(mask);
 }
 
+// Recorded drawing work for one splitscreen view, see R_ScheduleDrawTask
+struct RenderViewPipeline
+{
+	std::vector<std::vector<std::function<void()>>> stages;
+	size_t stage = 0;
+	srb2::ThreadPool::Sema sema;
+	bool pending = false;
+};
+
+static RenderViewPipeline g_renderviewpipelines[MAXSPLITSCREENPLAYERS];
+static RenderViewPipeline *g_recordingview = nullptr;
+
+static bool R_CanPipelineRenderView(void)
+{
+	// The debug overlays are drawn straight over the finished view
+	return rendermode == render_soft && r_splitscreen > 0
+		&& cv_parallelviews.value && cv_parallelsoftware.value
+		&& !cv_debugrender_visplanes.value && !cv_debugrender_portal.value;
+}
+
+static void R_BeginRenderView(void)
+{
+	RenderViewPipeline *p = &g_renderviewpipelines[viewssnum];
+
+	// Only the previous frame could still be using it, and D_Display waited on that
+	I_Assert(!p->pending);
+
+	for (std::vector<std::function<void()>> &tasks : p->stages)
+	{
+		tasks.clear();
+	}
+	p->stage = 0;
+
+	g_recordingview = p;
+}
+
+static void R_RunRenderStages(RenderViewPipeline *p)
+{
+	ZoneScoped;
+
+	for (std::vector<std::function<void()>> &tasks : p->stages)
+	{
+		srb2::g_main_threadpool->parallel_for(0, tasks.size(), 1, [&tasks](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				tasks[i]();
+			}
+		});
+	}
+}
+
+static void R_SubmitRenderView(void)
+{
+	RenderViewPipeline *p = g_recordingview;
+
+	if (p == nullptr)
+	{
+		return;
+	}
+
+	g_recordingview = nullptr;
+
+	srb2::g_main_threadpool->begin_sema();
+	srb2::g_main_threadpool->schedule([p]() { R_RunRenderStages(p); });
+	p->sema = srb2::g_main_threadpool->end_sema();
+	p->pending = true;
+	srb2::g_main_threadpool->notify_sema(p->sema);
+}
+
+bool R_IsRecordingRenderView(void)
+{
+	return g_recordingview != nullptr;
+}
+
+void R_RecordRenderTask(std::function<void()> task)
+{
+	RenderViewPipeline *p = g_recordingview;
+
+	if (p->stages.size() <= p->stage)
+	{
+		p->stages.resize(p->stage + 1);
+	}
+
+	p->stages[p->stage].push_back(std::move(task));
+}
+
+void R_EndRenderStage(void)
+{
+	RenderViewPipeline *p = g_recordingview;
+
+	// Empty stages would only cost a barrier
+	if (p != nullptr && p->stage < p->stages.size() && !p->stages[p->stage].empty())
+	{
+		p->stage++;
+	}
+}
+
+void R_DrainRenderView(void)
+{
+	RenderViewPipeline *p = g_recordingview;
+
+	if (p == nullptr)
+	{
+		return;
+	}
+
+	g_recordingview = nullptr;
+	R_RunRenderStages(p);
+}
+
+void R_FinishRenderViews(void)
+{
+	ZoneScoped;
+
+	for (RenderViewPipeline &p : g_renderviewpipelines)
+	{
+		if (p.pending)
+		{
+			srb2::g_main_threadpool->wait_sema(p.sema);
+			p.pending = false;
+		}
+	}
+
+	R_ReleaseRetiredPlanes();
+}
+
+boolean R_RenderViewsPending(void)
+{
+	for (const RenderViewPipeline &p : g_renderviewpipelines)
+	{
+		if (p.pending)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 //                     FAB NOTE FOR WIN32 PORT !! I'm not finished already,
 // but I suspect network may have problems with the video buffer being locked
 // for all duration of rendering, and being released only once at the end..
@@ -1509,6 +1647,27 @@ void R_RenderPlayerView(void)
 	framecount++;
 	validcount++;
 
+	// Drawing tasks read the projection from here, not from the globals the next view overwrites
+	renderview_t *view = &renderviews[viewssnum];
+	view->centerx = centerx;
+	view->centery = centery;
+	view->centeryfrac = centeryfrac;
+	view->yslope = yslope;
+	view->focallengthf = focallengthf[viewssnum];
+	view->width = viewwidth;
+	view->height = viewheight;
+	view->fovtan = fovtan[viewssnum];
+	view->colormaps = colormaps;
+	view->encoremap = encoremap;
+	view->highlight = debugrender_highlight;
+	view->reducevfx = cv_reducevfx.value;
+	R_SetRenderView(view);
+
+	if (R_CanPipelineRenderView())
+	{
+		R_BeginRenderView();
+	}
+
 	memset(&g_renderstats, 0, sizeof g_renderstats);
 
 	// Clear buffers.
@@ -1528,6 +1687,7 @@ void R_RenderPlayerView(void)
 		R_ClearClipSegs();
 	}
 	R_ClearDrawSegs();
+	R_ClearWallColumns();
 	R_ClearSprites();
 	Portal_InitList();
 
@@ -1567,11 +1727,6 @@ void R_RenderPlayerView(void)
 	ps_sw_portaltime = I_GetPreciseTime();
 	if (portal_base && !cv_debugrender_portal.value)
 	{
-		// tp_sema = srb2::g_main_threadpool->end_sema();
-		// srb2::g_main_threadpool->notify_sema(tp_sema);
-		// srb2::g_main_threadpool->wait_sema(tp_sema);
-		// srb2::g_main_threadpool->begin_sema();
-
 		portal_t *portal;
 
 		for(portal = portal_base; portal; portal = portal_base)
@@ -1609,16 +1764,23 @@ void R_RenderPlayerView(void)
 
 			Portal_Remove(portal);
 		}
-
-		// tp_sema = srb2::g_main_threadpool->end_sema();
-		// srb2::g_main_threadpool->notify_sema(tp_sema);
-		// srb2::g_main_threadpool->wait_sema(tp_sema);
-		// srb2::g_main_threadpool->begin_sema();
 	}
 	ps_sw_portaltime = I_GetPreciseTime() - ps_sw_portaltime;
 
+	// Walls of every pass land before planes and masked draws touch the screen
+	// A pipelined view only records here, so these times cover recording, not drawing.
+	ps_sw_walltime = I_GetPreciseTime();
+	R_DrawWallColumns();
+	R_EndRenderStage();
+	tp_sema = srb2::g_main_threadpool->end_sema();
+	srb2::g_main_threadpool->notify_sema(tp_sema);
+	srb2::g_main_threadpool->wait_sema(tp_sema);
+	srb2::g_main_threadpool->begin_sema();
+	ps_sw_walltime = I_GetPreciseTime() - ps_sw_walltime;
+
 	ps_sw_planetime = I_GetPreciseTime();
 	R_DrawPlanes();
+	R_EndRenderStage();
 	tp_sema = srb2::g_main_threadpool->end_sema();
 	srb2::g_main_threadpool->notify_sema(tp_sema);
 	srb2::g_main_threadpool->wait_sema(tp_sema);
@@ -1628,6 +1790,7 @@ void R_RenderPlayerView(void)
 	// And now 3D floors/sides!
 	ps_sw_maskedtime = I_GetPreciseTime();
 	R_DrawMasked(masks, nummasks);
+	R_SubmitRenderView();
 	ps_sw_maskedtime = I_GetPreciseTime() - ps_sw_maskedtime;
 
 	if (cv_debugrender_visplanes.value)
@@ -104,6 +104,7 @@ extern precise_t ps_bsptime;
 
 extern precise_t ps_sw_spritecliptime;
 extern precise_t ps_sw_portaltime;
+extern precise_t ps_sw_walltime;
 extern precise_t ps_sw_planetime;
 extern precise_t ps_sw_maskedtime;
 
@@ -112,6 +113,10 @@ extern int ps_numsprites;
 extern int ps_numdrawnodes;
 extern int ps_numpolyobjects;
 
+extern int ps_2d_numcmds;
+extern int ps_2d_numunmerged;
+extern int ps_2d_numdraws;
+
 struct RenderStats
 {
 	size_t visplanes;
@@ -190,12 +195,56 @@ boolean R_IsViewpointThirdPerson(player_t *player, boolean skybox);
 
 // Called by D_Display.
 void R_RenderPlayerView(void);
+// Wait for every splitscreen view still drawing on the thread pool
+void R_FinishRenderViews(void);
+boolean R_RenderViewsPending(void);
 
 // add commands related to engine, at game startup
 void R_RegisterEngineStuff(void);
 
 #ifdef __cplusplus
 } // extern "C"
+
+#include <functional>
+
+#include "core/thread_pool.h"
+#include "r_draw.h"
+
+// With parallelviews on, a software splitscreen view's drawing tasks are
+// recorded into ordered stages (walls, planes, then masked columns) instead of
+// being scheduled, and the whole view is handed to the thread pool once its
+// masked pass is recorded. The next view's BSP traversal overlaps it.
+bool R_IsRecordingRenderView(void);
+void R_RecordRenderTask(std::function<void()> task);
+// Tasks recorded after this only start once the ones before it are done
+void R_EndRenderStage(void);
+// Draw everything recorded for this view so far, then stop recording it.
+// Needed before anything that draws straight to the screen.
+void R_DrainRenderView(void);
+
+// Schedule a drawing task for the calling thread's view, or record it if that view is pipelined
+template <typename F>
+void R_ScheduleDrawTask(F&& task)
+{
+	const renderview_t *view = R_GetRenderView();
+	auto bound = [view, task = std::forward<F>(task)]() mutable
+	{
+		const renderview_t *prev = R_GetRenderView();
+		R_SetRenderView(view);
+		task();
+		R_SetRenderView(prev);
+	};
+
+	if (R_IsRecordingRenderView())
+	{
+		R_RecordRenderTask(std::move(bound));
+	}
+	else
+	{
+		srb2::g_main_threadpool->schedule(std::move(bound));
+	}
+}
+
 #endif
 
 #endif
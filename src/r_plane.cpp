@@ -51,6 +51,9 @@ extern "C" consvar_t cv_debugfinishline;
 visplane_t *visplanes[MAXVISPLANES];
 static visplane_t *freetail;
 static visplane_t **freehead = &freetail;
+// Planes a pipelined view is still drawing are parked here until R_FinishRenderViews
+static visplane_t *retiredtail;
+static visplane_t **retiredhead = &retiredtail;
 
 visplane_t *floorplane;
 visplane_t *ceilingplane;
@@ -106,11 +109,12 @@ void R_InitPlanes(void)
 // ripples da water texture
 static fixed_t R_CalculateRippleOffset(drawspandata_t* ds, INT32 y)
 {
-	if (cv_reducevfx.value)
+	const renderview_t *view = R_GetRenderView();
+	if (view->reducevfx)
 	{
 		return 0;
 	}
-	fixed_t distance = FixedMul(ds->planeheight, yslope[y]);
+	fixed_t distance = FixedMul(ds->planeheight, view->yslope[y]);
 	const INT32 yay = (ds->planeripple.offset + (distance>>9)) & 8191;
 	return FixedDiv(FINESINE(yay), (1<<12) + (distance>>11));
 }
@@ -129,14 +133,14 @@ static void R_UpdatePlaneRipple(drawspandata_t* ds)
 	ds->planeripple.offset = (leveltime * 140);
 }
 
-static void R_SetSlopePlaneVectors(drawspandata_t* ds, visplane_t *pl, INT32 y, fixed_t xoff, fixed_t yoff);
+static void R_SetSlopePlaneVectors(drawspandata_t* ds, visplane_t *pl, fixed_t xoff, fixed_t yoff);
 
-static bool R_CheckMapPlane(const char* funcname, INT32 y, INT32 x1, INT32 x2)
+static bool R_CheckMapPlane(const char* funcname, const renderview_t *view, INT32 y, INT32 x1, INT32 x2)
 {
 	if (x1 == x2)
 		return true;
 
-	if (x1 < x2 && x1 >= 0 && x2 < viewwidth && y >= 0 && y < viewheight)
+	if (x1 < x2 && x1 >= 0 && x2 < view->width && y >= 0 && y < view->height)
 		return true;
 
 	CONS_Debug(DBG_RENDER, "%s: x1=%d, x2=%d at y=%d\n", funcname, x1, x2, y);
@@ -146,19 +150,20 @@ static bool R_CheckMapPlane(const char* funcname, INT32 y, INT32 x1, INT32 x2)
 static void R_MapPlane(drawspandata_t *ds, spandrawfunc_t *spanfunc, INT32 y, INT32 x1, INT32 x2, boolean allow_parallel)
 {
 	ZoneScoped;
+	const renderview_t *view = R_GetRenderView();
 	angle_t angle, planecos, planesin;
 	fixed_t distance = 0, span;
 	size_t pindex;
 
-	if (!R_CheckMapPlane(__func__, y, x1, x2))
+	if (!R_CheckMapPlane(__func__, view, y, x1, x2))
 		return;
 
 	angle = (ds->currentplane->viewangle + ds->currentplane->plangle)>>ANGLETOFINESHIFT;
 	planecos = FINECOSINE(angle);
 	planesin = FINESINE(angle);
 
-	distance = FixedMul(ds->planeheight, yslope[y]);
-	span = abs(centery - y);
+	distance = FixedMul(ds->planeheight, view->yslope[y]);
+	span = abs(view->centery - y);
 	if (span) // Don't divide by zero
 	{
 		ds->xstep = FixedMul(planesin, ds->planeheight) / span;
@@ -172,8 +177,8 @@ static void R_MapPlane(drawspandata_t *ds, spandrawfunc_t *spanfunc, INT32 y, IN
 	// to step from those to the proper texture coordinate to start drawing at.
 	// That way, the texture coordinate is always calculated by its position
 	// on the screen and not by its position relative to the edge of the visplane.
-	ds->xfrac = ds->xoffs + FixedMul(planecos, distance) + (x1 - centerx) * ds->xstep;
-	ds->yfrac = ds->yoffs - FixedMul(planesin, distance) + (x1 - centerx) * ds->ystep;
+	ds->xfrac = ds->xoffs + FixedMul(planecos, distance) + (x1 - view->centerx) * ds->xstep;
+	ds->yfrac = ds->yoffs - FixedMul(planesin, distance) + (x1 - view->centerx) * ds->ystep;
 
 	// Water ripple effect
 	if (ds->planeripple.active)
@@ -186,8 +191,8 @@ static void R_MapPlane(drawspandata_t *ds, spandrawfunc_t *spanfunc, INT32 y, IN
 		ds->yfrac += ds->planeripple.yfrac;
 		ds->bgofs >>= FRACBITS;
 
-		if ((y + ds->bgofs) >= viewheight)
-			ds->bgofs = viewheight-y-1;
+		if ((y + ds->bgofs) >= view->height)
+			ds->bgofs = view->height-y-1;
 		if ((y + ds->bgofs) < 0)
 			ds->bgofs = -y;
 	}
@@ -204,13 +209,13 @@ static void R_MapPlane(drawspandata_t *ds, spandrawfunc_t *spanfunc, INT32 y, IN
 
 		ds->colormap = ds->planezlight[pindex];
 
-		if (!debugrender_highlight)
+		if (!view->highlight)
 		{
 			if (ds->currentplane->extra_colormap)
-				ds->colormap = ds->currentplane->extra_colormap->colormap + (ds->colormap - colormaps);
+				ds->colormap = ds->currentplane->extra_colormap->colormap + (ds->colormap - view->colormaps);
 
-			ds->fullbright = colormaps;
-			if (encoremap && !ds->currentplane->noencore)
+			ds->fullbright = view->colormaps;
+			if (view->encoremap && !ds->currentplane->noencore)
 			{
 				ds->colormap += COLORMAP_REMAPOFFSET;
 				ds->fullbright += COLORMAP_REMAPOFFSET;
@@ -228,8 +233,9 @@ static void R_MapPlane(drawspandata_t *ds, spandrawfunc_t *spanfunc, INT32 y, IN
 static void R_MapTiltedPlane(drawspandata_t *ds, void(*spanfunc)(drawspandata_t*), INT32 y, INT32 x1, INT32 x2, boolean allow_parallel)
 {
 	ZoneScoped;
+	const renderview_t *view = R_GetRenderView();
 
-	if (!R_CheckMapPlane(__func__, y, x1, x2))
+	if (!R_CheckMapPlane(__func__, view, y, x1, x2))
 		return;
 
 	// Water ripple effect
@@ -237,15 +243,13 @@ static void R_MapTiltedPlane(drawspandata_t *ds, void(*spanfunc)(drawspandata_t*
 	{
 		ds->bgofs = R_CalculateRippleOffset(ds, y);
 
-		R_SetTiltedSpan(ds, std::clamp<INT32>(y, 0, viewheight));
-
 		R_CalculatePlaneRipple(ds, ds->currentplane->viewangle + ds->currentplane->plangle);
-		R_SetSlopePlaneVectors(ds, ds->currentplane, y, (ds->xoffs + ds->planeripple.xfrac), (ds->yoffs + ds->planeripple.yfrac));
+		R_SetSlopePlaneVectors(ds, ds->currentplane, (ds->xoffs + ds->planeripple.xfrac), (ds->yoffs + ds->planeripple.yfrac));
 
 		ds->bgofs >>= FRACBITS;
 
-		if ((y + ds->bgofs) >= viewheight)
-			ds->bgofs = viewheight-y-1;
+		if ((y + ds->bgofs) >= view->height)
+			ds->bgofs = view->height-y-1;
 		if ((y + ds->bgofs) < 0)
 			ds->bgofs = -y;
 	}
@@ -253,10 +257,10 @@ static void R_MapTiltedPlane(drawspandata_t *ds, void(*spanfunc)(drawspandata_t*
 	if (ds->currentplane->extra_colormap)
 		ds->colormap = ds->currentplane->extra_colormap->colormap;
 	else
-		ds->colormap = colormaps;
+		ds->colormap = view->colormaps;
 
-	ds->fullbright = colormaps;
-	if (encoremap && !ds->currentplane->noencore)
+	ds->fullbright = view->colormaps;
+	if (view->encoremap && !ds->currentplane->noencore)
 	{
 		ds->colormap += COLORMAP_REMAPOFFSET;
 		ds->fullbright += COLORMAP_REMAPOFFSET;
@@ -307,16 +311,30 @@ void R_ClearPlanes(void)
 		}
 	}
 
+	visplane_t **&head = R_RenderViewsPending() ? retiredhead : freehead;
+
 	for (i = 0; i < MAXVISPLANES; i++)
-	for (*freehead = visplanes[i], visplanes[i] = NULL;
-		freehead && *freehead ;)
+	for (*head = visplanes[i], visplanes[i] = NULL;
+		head && *head ;)
 	{
-		freehead = &(*freehead)->next;
+		head = &(*head)->next;
 	}
 
 	lastopening = openings;
 }
 
+void R_ReleaseRetiredPlanes(void)
+{
+	if (retiredtail == NULL)
+		return;
+
+	*freehead = retiredtail;
+	freehead = retiredhead;
+
+	retiredtail = NULL;
+	retiredhead = &retiredtail;
+}
+
 static visplane_t *new_visplane(unsigned hash)
 {
 	visplane_t *check = freetail;
@@ -613,7 +631,7 @@ static void R_MakeSpans(void (*mapfunc)(drawspandata_t* ds, void(*spanfunc)(draw
 		};
 		if (allow_parallel)
 		{
-			srb2::g_main_threadpool->schedule(std::move(task));
+			R_ScheduleDrawTask(std::move(task));
 		}
 		else
 		{
@@ -642,7 +660,7 @@ static void R_MakeSpans(void (*mapfunc)(drawspandata_t* ds, void(*spanfunc)(draw
 		};
 		if (allow_parallel)
 		{
-			srb2::g_main_threadpool->schedule(std::move(task));
+			R_ScheduleDrawTask(std::move(task));
 		}
 		else
 		{
@@ -719,10 +737,16 @@ static void R_DrawSkyPlane(visplane_t *pl, void(*colfunc)(drawcolumndata_t*), bo
 
 	x = pl->minx;
 
+	// The task may run after the next view has been set up
+	const UINT8 viewnum = viewssnum;
+	const INT32 skytex = texturetranslation[skytexture];
+	const INT32 skyoffset = skytextureoffset >> FRACBITS;
+	const fixed_t skyiscale = skyscale[viewnum];
+
 	// Precache the texture so we don't corrupt the zoned heap off-main thread
-	if (!texturecache[texturetranslation[skytexture]])
+	if (!texturecache[skytex])
 	{
-		R_GenerateTexture(texturetranslation[skytexture]);
+		R_GenerateTexture(skytex);
 	}
 
 	while (x <= pl->maxx)
@@ -742,13 +766,13 @@ static void R_DrawSkyPlane(visplane_t *pl, void(*colfunc)(drawcolumndata_t*), bo
 					continue;
 				}
 
-				INT32 angle = (pl->viewangle + xtoviewangle[viewssnum][x + i])>>ANGLETOSKYSHIFT;
-				angle -= (skytextureoffset >> FRACBITS);
+				INT32 angle = (pl->viewangle + xtoviewangle[viewnum][x + i])>>ANGLETOSKYSHIFT;
+				angle -= skyoffset;
 
-				dc.iscale = FixedMul(skyscale[viewssnum], FINECOSINE(xtoviewangle[viewssnum][x + i]>>ANGLETOFINESHIFT));
+				dc.iscale = FixedMul(skyiscale, FINECOSINE(xtoviewangle[viewnum][x + i]>>ANGLETOFINESHIFT));
 				dc.x = x + i;
 				dc.source =
-					R_GetColumn(texturetranslation[skytexture],
+					R_GetColumn(skytex,
 						-angle); // get negative of angle for each column to display sky correct way round! --Monster Iestyn 27/01/18
 				dc.brightmap = NULL;
 
@@ -758,7 +782,7 @@ static void R_DrawSkyPlane(visplane_t *pl, void(*colfunc)(drawcolumndata_t*), bo
 
 		if (allow_parallel)
 		{
-			srb2::g_main_threadpool->schedule(std::move(thunk));
+			R_ScheduleDrawTask(std::move(thunk));
 		}
 		else
 		{
@@ -862,6 +886,7 @@ void R_SetScaledSlopePlane(drawspandata_t* ds, pslope_t *slope, fixed_t xpos, fi
 
 void R_CalculateSlopeVectors(drawspandata_t* ds)
 {
+	const float focallength = R_GetRenderView()->focallengthf;
 	float sfmult = 65536.f;
 
 	// Eh. I tried making this stuff fixed-point and it exploded on me. Here's a macro for the only floating-point vector function I recall using.
@@ -874,9 +899,9 @@ d.z = (v1.x * v2.y) - (v1.y * v2.x)
 	CROSS(ds->szp, ds->slope_v, ds->slope_u);
 #undef CROSS
 
-	ds->sup.z *= focallengthf[viewssnum];
-	ds->svp.z *= focallengthf[viewssnum];
-	ds->szp.z *= focallengthf[viewssnum];
+	ds->sup.z *= focallength;
+	ds->svp.z *= focallength;
+	ds->szp.z *= focallength;
 
 	// Premultiply the texture vectors with the scale factors
 	if (ds->powersoftwo)
@@ -890,23 +915,8 @@ d.z = (v1.x * v2.y) - (v1.y * v2.x)
 	ds->svp.z *= sfmult;
 }
 
-void R_SetTiltedSpan(drawspandata_t* ds, INT32 span)
-{
-	if (ds_su == NULL)
-		ds_su = static_cast<floatv3_t*>(Z_Calloc(sizeof(*ds_su) * vid.height, PU_STATIC, NULL));
-	if (ds_sv == NULL)
-		ds_sv = static_cast<floatv3_t*>(Z_Calloc(sizeof(*ds_sv) * vid.height, PU_STATIC, NULL));
-	if (ds_sz == NULL)
-		ds_sz = static_cast<floatv3_t*>(Z_Calloc(sizeof(*ds_sz) * vid.height, PU_STATIC, NULL));
-
-	ds->sup = ds_su[span];
-	ds->svp = ds_sv[span];
-	ds->szp = ds_sz[span];
-}
-
-static void R_SetSlopePlaneVectors(drawspandata_t* ds, visplane_t *pl, INT32 y, fixed_t xoff, fixed_t yoff)
+static void R_SetSlopePlaneVectors(drawspandata_t* ds, visplane_t *pl, fixed_t xoff, fixed_t yoff)
 {
-	R_SetTiltedSpan(ds, y);
 	R_SetSlopePlane(ds, pl->slope, pl->viewx, pl->viewy, pl->viewz, xoff, yoff, pl->viewangle, pl->plangle);
 	R_CalculateSlopeVectors(ds);
 }
@@ -1194,11 +1204,11 @@ void R_DrawSinglePlane(drawspandata_t *ds, visplane_t *pl, boolean allow_paralle
 			{
 				ds->bgofs = R_CalculateRippleOffset(ds, x);
 				R_CalculatePlaneRipple(ds, pl->viewangle + pl->plangle);
-				R_SetSlopePlaneVectors(ds, pl, x, (ds->xoffs + ds->planeripple.xfrac), (ds->yoffs + ds->planeripple.yfrac));
+				R_SetSlopePlaneVectors(ds, pl, (ds->xoffs + ds->planeripple.xfrac), (ds->yoffs + ds->planeripple.yfrac));
 			}
 		}
 		else
-			R_SetSlopePlaneVectors(ds, pl, 0, ds->xoffs, ds->yoffs);
+			R_SetSlopePlaneVectors(ds, pl, ds->xoffs, ds->yoffs);
 
 		switch (spanfunctype)
 		{
@@ -81,6 +81,8 @@ extern fixed_t *yslope;
 
 void R_InitPlanes(void);
 void R_ClearPlanes(void);
+// Hand back the visplanes of views that finished drawing on the thread pool
+void R_ReleaseRetiredPlanes(void);
 void R_ClearFFloorClips (void);
 
 void R_DrawPlanes(void);
@@ -103,8 +105,6 @@ void R_SetSlopePlane(drawspandata_t* ds, pslope_t *slope, fixed_t xpos, fixed_t
 void R_SetScaledSlopePlane(drawspandata_t* ds, pslope_t *slope, fixed_t xpos, fixed_t ypos, fixed_t zpos, fixed_t xs, fixed_t ys, fixed_t xoff, fixed_t yoff, angle_t angle, angle_t plangle);
 void R_CalculateSlopeVectors(drawspandata_t* ds);
 
-// Sets the slope vector pointers for the current tilted span.
-void R_SetTiltedSpan(drawspandata_t* ds, INT32 span);
 
 // Returns a palette index or -1 if not highlighted
 INT16 R_PlaneIsHighlighted(const visplane_t *pl);
@@ -12,7 +12,9 @@
 /// \file  r_segs.c
 /// \brief All the clipping: columns, horizontal spans, sky columns
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 #include <tracy/tracy/Tracy.hpp>
 
@@ -91,6 +93,28 @@ static lighttable_t **walllights;
 static INT16 *maskedtexturecol;
 static fixed_t *maskedtextureheight = NULL;
 
+// Wall columns recorded during BSP traversal, drawn later in screen-column bands by R_DrawWallColumns
+struct WallColumn
+{
+	coldrawfunc_t* func;
+	drawcolumndata_t dc;
+};
+
+static constexpr INT32 kWallBandColumns = 16;
+
+struct WallColumnBuffer
+{
+	std::vector<WallColumn> columns;
+	std::vector<UINT32> order;
+	std::vector<UINT32> bandstarts;
+	std::vector<UINT32> bandcursor;
+};
+
+// One per splitscreen view, since a pipelined view's walls are drawn while the next view is traversed
+static WallColumnBuffer g_wallbuffers[MAXSPLITSCREENPLAYERS];
+static WallColumnBuffer *g_wallbuffer = &g_wallbuffers[0];
+static bool g_deferwallcolumns = false;
+
 // ==========================================================================
 // R_RenderMaskedSegRange
 // ==========================================================================
@@ -166,7 +190,7 @@ static void R_Render2sidedMultiPatchColumn(drawcolumndata_t* dc, column_t *colum
 			}
 		}
 
-		colfunccopy(const_cast<drawcolumndata_t*>(&dc_copy));
+		R_SubmitMaskedColumn(colfunccopy, &dc_copy);
 	}
 }
 
@@ -1389,9 +1413,88 @@ static void R_DrawWallColumn(drawcolumndata_t* dc, INT32 yl, INT32 yh, fixed_t m
 		dc_copy.colormap += COLORMAP_REMAPOFFSET;
 		dc_copy.fullbright += COLORMAP_REMAPOFFSET;
 	}
+
+	// Shadowed columns step their light list per column, so they can't be replayed later.
+	// Walls never overdraw each other, so drawing those right away doesn't change the result.
+	if (g_deferwallcolumns && dc_copy.numlights == 0)
+	{
+		g_wallbuffer->columns.push_back({colfunccopy, dc_copy});
+		return;
+	}
+
 	colfunccopy(const_cast<drawcolumndata_t*>(&dc_copy));
 }
 
+void R_ClearWallColumns(void)
+{
+	g_wallbuffer = &g_wallbuffers[viewssnum];
+	g_wallbuffer->columns.clear();
+	g_deferwallcolumns = cv_parallelsoftware.value;
+}
+
+void R_DrawWallColumns(void)
+{
+	ZoneScoped;
+
+	WallColumnBuffer *buffer = g_wallbuffer;
+	const std::vector<WallColumn> &columns = buffer->columns;
+
+	if (columns.empty())
+	{
+		return;
+	}
+
+	// Stable counting sort of the recorded columns into vertical screen bands, so every band
+	// replays its columns in the same order the BSP traversal produced them.
+	const size_t numbands = (std::max(viewwidth, 1) + kWallBandColumns - 1) / kWallBandColumns;
+	auto band_of = [numbands](const WallColumn& wc) -> size_t
+	{
+		return std::min(static_cast<size_t>(std::max(wc.dc.x, 0) / kWallBandColumns), numbands - 1);
+	};
+
+	std::vector<UINT32> &bandstarts = buffer->bandstarts;
+	std::vector<UINT32> &bandcursor = buffer->bandcursor;
+	std::vector<UINT32> &order = buffer->order;
+
+	bandstarts.assign(numbands + 1, 0);
+	for (const WallColumn& wc : columns)
+	{
+		bandstarts[band_of(wc) + 1]++;
+	}
+	for (size_t i = 1; i <= numbands; i++)
+	{
+		bandstarts[i] += bandstarts[i - 1];
+	}
+
+	bandcursor.assign(bandstarts.begin(), bandstarts.end() - 1);
+	order.resize(columns.size());
+	for (size_t i = 0; i < columns.size(); i++)
+	{
+		order[bandcursor[band_of(columns[i])]++] = static_cast<UINT32>(i);
+	}
+
+	for (size_t band = 0; band < numbands; band++)
+	{
+		const UINT32 first = bandstarts[band];
+		const UINT32 last = bandstarts[band + 1];
+		if (first == last)
+		{
+			continue;
+		}
+
+		R_ScheduleDrawTask([buffer, first, last]() {
+			ZoneScopedN("R_DrawWallColumns band");
+			for (UINT32 i = first; i < last; i++)
+			{
+				WallColumn& wc = buffer->columns[buffer->order[i]];
+				wc.func(&wc.dc);
+			}
+		});
+	}
+
+	// The columns are read by the scheduled bands, so they're only released when this view is cleared next frame
+}
+
 static void R_RenderSegLoop (drawcolumndata_t* dc)
 {
 	angle_t angle;
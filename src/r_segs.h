@@ -24,6 +24,14 @@ void R_RenderMaskedSegRange(drawseg_t *ds, INT32 x1, INT32 x2);
 void R_RenderThickSideRange(drawseg_t *ds, INT32 x1, INT32 x2, ffloor_t *pffloor);
 void R_StoreWallRange(INT32 start, INT32 stop);
 
+// Wall columns are recorded while the BSP is traversed and drawn afterwards, split into
+// screen-column bands on the thread pool. Solid walls never overdraw one another, so the
+// output is the same as drawing them immediately.
+void R_ClearWallColumns(void);
+// Schedules the recorded columns into the current thread pool sema group. Wait on it before
+// anything else draws over walls.
+void R_DrawWallColumns(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
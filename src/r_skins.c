@@ -392,6 +392,30 @@ engineclass_t R_GetEngineClass(SINT8 speed, SINT8 weight, skinflags_t flags)
 	return (speed + (3*weight));
 }
 
+// Start inflating a skin's sprites in the background, before it first gets drawn
+static void R_PrefetchSkinSprites(const skin_t *skin)
+{
+	size_t i, j, k;
+
+	if (dedicated || rendermode == render_none)
+		return;
+
+	for (i = 0; i < NUMPLAYERSPRITES*2; i++)
+	{
+		for (j = 0; j < skin->sprites[i].numframes; j++)
+		{
+			const spriteframe_t *sf = &skin->sprites[i].spriteframes[j];
+			for (k = 0; k < 16; k++)
+			{
+				if (sf->lumppat[k] != LUMPERROR)
+					W_PrefetchLumpNum(sf->lumppat[k]);
+			}
+		}
+	}
+
+	W_StartPrefetch();
+}
+
 // Auxillary function that actually sets the skin
 static void SetSkin(player_t *player, INT32 skinnum)
 {
@@ -400,6 +424,9 @@ static void SetSkin(player_t *player, INT32 skinnum)
 
 	skin_t *skin = &skins[skinnum];
 
+	if (player->skin != skinnum)
+		R_PrefetchSkinSprites(skin);
+
 	player->skin = skinnum;
 
 	player->followitem = skin->followitem;
@@ -13,6 +13,7 @@
 /// \brief Refresh of things, i.e. objects represented by sprites
 
 #include <algorithm>
+#include <vector>
 
 #include "doomdef.h"
 #include "console.h"
@@ -40,6 +41,7 @@
 #include "d_netfil.h" // blargh. for nameonly().
 #include "m_cheat.h" // objectplace
 #include "p_local.h" // stplyr
+#include "core/memory.h"
 #include "core/thread_pool.h"
 #ifdef HWRENDER
 #include "hardware/hw_md2.h"
@@ -639,6 +641,155 @@ INT16 *mceilingclip;
 fixed_t spryscale = 0, sprtopscreen = 0, sprbotscreen = 0;
 fixed_t windowtop = 0, windowbottom = 0;
 
+// While R_DrawMasked runs, masked columns are recorded instead of drawn, binned into
+// vertical screen strips and composited on the thread pool. Each strip replays its
+// columns in submission order, so painter's order is kept exactly. Anything that
+// doesn't go through a column drawer (planes, splats, bounding boxes) flushes first.
+struct MaskedColumn
+{
+	coldrawfunc_t* func;
+	drawcolumndata_t dc;
+};
+
+static constexpr INT32 kMaskedStripColumns = 32;
+static constexpr size_t kMaskedFlushThreshold = 16384;
+// Small batches aren't worth the scheduling
+static constexpr size_t kMaskedParallelMinimum = 64;
+
+struct MaskedColumnBuffer
+{
+	std::vector<MaskedColumn> columns;
+	size_t flushed = 0; // columns before this are already drawn or recorded
+};
+
+// One per splitscreen view, since a pipelined view's columns are drawn while the next view is set up
+static MaskedColumnBuffer g_maskedbuffers[MAXSPLITSCREENPLAYERS];
+static MaskedColumnBuffer *g_maskedbuffer = &g_maskedbuffers[0];
+static boolean g_binmaskedcolumns = false;
+
+// barrier: something is about to draw straight to the screen, so a pipelined view
+// has to catch up first and draws the rest of its masked pass directly.
+static void R_FlushMaskedColumns(boolean barrier)
+{
+	ZoneScoped;
+
+	MaskedColumnBuffer* buffer = g_maskedbuffer;
+	const size_t base = buffer->flushed;
+	const size_t count = buffer->columns.size() - base;
+	const bool recording = R_IsRecordingRenderView();
+
+	if (count > 0 && count < kMaskedParallelMinimum && !recording)
+	{
+		for (size_t i = base; i < buffer->columns.size(); i++)
+		{
+			MaskedColumn& mc = buffer->columns[i];
+			mc.func(&mc.dc);
+		}
+	}
+	else if (count > 0)
+	{
+		// Stable counting sort into strips; the bins live in per-frame memory
+		const size_t numstrips = (std::max(vid.width, 1) + kMaskedStripColumns - 1) / kMaskedStripColumns;
+		auto strip_of = [numstrips](const MaskedColumn& mc) -> size_t
+		{
+			return std::min(static_cast<size_t>(std::max(mc.dc.x, 0) / kMaskedStripColumns), numstrips - 1);
+		};
+
+		UINT32* starts = static_cast<UINT32*>(Z_Frame_Alloc(sizeof(UINT32) * (numstrips + 1)));
+		UINT32* cursor = static_cast<UINT32*>(Z_Frame_Alloc(sizeof(UINT32) * numstrips));
+		UINT32* order = static_cast<UINT32*>(Z_Frame_Alloc(sizeof(UINT32) * count));
+
+		std::fill(starts, starts + numstrips + 1, 0);
+		for (size_t i = base; i < buffer->columns.size(); i++)
+		{
+			starts[strip_of(buffer->columns[i]) + 1]++;
+		}
+		for (size_t i = 1; i <= numstrips; i++)
+		{
+			starts[i] += starts[i - 1];
+		}
+		std::copy(starts, starts + numstrips, cursor);
+		for (size_t i = base; i < buffer->columns.size(); i++)
+		{
+			order[cursor[strip_of(buffer->columns[i])]++] = static_cast<UINT32>(i);
+		}
+
+		if (!recording)
+		{
+			srb2::g_main_threadpool->begin_sema();
+		}
+		for (size_t strip = 0; strip < numstrips; strip++)
+		{
+			const UINT32 first = starts[strip];
+			const UINT32 last = starts[strip + 1];
+			if (first == last)
+			{
+				continue;
+			}
+
+			// Index through the buffer when the task runs; a recording view may still grow it
+			R_ScheduleDrawTask([buffer, order, first, last]() {
+				ZoneScopedN("R_FlushMaskedColumns strip");
+				for (UINT32 i = first; i < last; i++)
+				{
+					MaskedColumn& mc = buffer->columns[order[i]];
+					mc.func(&mc.dc);
+				}
+			});
+		}
+		if (recording)
+		{
+			R_EndRenderStage();
+		}
+		else
+		{
+			srb2::ThreadPool::Sema sema = srb2::g_main_threadpool->end_sema();
+			srb2::g_main_threadpool->notify_sema(sema);
+			srb2::g_main_threadpool->wait_sema(sema);
+		}
+	}
+
+	if (recording && !barrier)
+	{
+		buffer->flushed = buffer->columns.size();
+		return;
+	}
+
+	if (recording)
+	{
+		R_DrainRenderView();
+	}
+
+	buffer->columns.clear();
+	buffer->flushed = 0;
+}
+
+void R_SubmitMaskedColumn(coldrawfunc_t* func, drawcolumndata_t* dc)
+{
+	drawcolumndata_t dc_copy = *dc;
+
+	if (!g_binmaskedcolumns)
+	{
+		func(&dc_copy);
+		return;
+	}
+
+	// The shadowed drawer walks a light list that is stepped per column, so it can't be replayed
+	if (func == colfuncs[COLDRAWFUNC_SHADOWED] || func == colfuncs_bm[COLDRAWFUNC_SHADOWED])
+	{
+		R_FlushMaskedColumns(true);
+		func(&dc_copy);
+		return;
+	}
+
+	g_maskedbuffer->columns.push_back({func, dc_copy});
+
+	if (g_maskedbuffer->columns.size() - g_maskedbuffer->flushed >= kMaskedFlushThreshold)
+	{
+		R_FlushMaskedColumns(false);
+	}
+}
+
 void R_DrawMaskedColumn(drawcolumndata_t* dc, column_t *column, column_t *brightmap, INT32 baseclip)
 {
 	INT32 topscreen;
@@ -701,11 +852,9 @@ void R_DrawMaskedColumn(drawcolumndata_t* dc, column_t *column, column_t *bright
 			// This stuff is a likely cause of the splitscreen water crash bug.
 			// FIXTHIS: Figure out what "something more proper" is and do it.
 			// quick fix... something more proper should be done!!!
-			if (ylookup[dc->yl])
+			if (R_GetRenderView()->ylookup[dc->yl])
 			{
-				drawcolumndata_t dc_copy = *dc;
-				coldrawfunc_t* colfunccopy = colfunc;
-				colfunccopy(const_cast<drawcolumndata_t*>(&dc_copy));
+				R_SubmitMaskedColumn(colfunc, dc);
 			}
 #ifdef PARANOIA
 			else
@@ -774,14 +923,15 @@ void R_DrawFlippedMaskedColumn(drawcolumndata_t* dc, column_t *column, column_t
 
 		if (dc->yl <= dc->yh && dc->yh > 0 && column->length != 0)
 		{
-			dc->source = static_cast<UINT8*>(ZZ_Alloc(column->length));
+			// Per-frame memory, since a binned column is only drawn when the masked pass flushes
+			dc->source = static_cast<UINT8*>(Z_Frame_Alloc(column->length));
 			dc->sourcelength = column->length;
 			for (s = (UINT8 *)column+2+column->length, d = dc->source; d < dc->source+column->length; --s)
 				*d++ = *s;
 
 			if (brightmap != NULL)
 			{
-				dc->brightmap = static_cast<UINT8*>(ZZ_Alloc(brightmap->length));
+				dc->brightmap = static_cast<UINT8*>(Z_Frame_Alloc(brightmap->length));
 				for (s = (UINT8 *)brightmap+2+brightmap->length, d = dc->brightmap; d < dc->brightmap+brightmap->length; --s)
 					*d++ = *s;
 			}
@@ -789,17 +939,14 @@ void R_DrawFlippedMaskedColumn(drawcolumndata_t* dc, column_t *column, column_t
 			dc->texturemid = basetexturemid - (topdelta<<FRACBITS);
 
 			// Still drawn by R_DrawColumn.
-			if (ylookup[dc->yl])
+			if (R_GetRenderView()->ylookup[dc->yl])
 			{
-				drawcolumndata_t dc_copy = *dc;
-				coldrawfunc_t* colfunccopy = colfunc;
-				colfunccopy(const_cast<drawcolumndata_t*>(&dc_copy));
+				R_SubmitMaskedColumn(colfunc, dc);
 			}
 #ifdef PARANOIA
 			else
 				I_Error("R_DrawMaskedColumn: Invalid ylookup for dc_yl %d", dc->yl);
 #endif
-			Z_Free(dc->source);
 		}
 		column = (column_t *)((UINT8 *)column + column->length + 4);
 		if (brightmap != NULL)
@@ -3420,9 +3567,15 @@ static void R_DrawSprite(vissprite_t *spr)
 	R_CheckDebugHighlight(SW_HI_THINGS);
 
 	if (spr->cut & SC_BBOX)
+	{
+		R_FlushMaskedColumns(true);
 		R_DrawThingBoundingBox(spr);
+	}
 	else if (spr->cut & SC_SPLAT)
+	{
+		R_FlushMaskedColumns(true);
 		R_DrawFloorSplat(spr);
+	}
 	else
 		R_DrawVisSprite(spr);
 }
@@ -3909,6 +4062,7 @@ static void R_DrawMaskedList (drawnode_t* head)
 		{
 			drawspandata_t ds = {0};
 			next = r2->prev;
+			R_FlushMaskedColumns(true);
 			R_DrawSinglePlane(&ds, r2->plane, false);
 			R_DoneWithNode(r2);
 			r2 = next;
@@ -3989,6 +4143,12 @@ void R_DrawMasked(maskcount_t* masks, INT32 nummasks)
 	//for (i = 0; i < nummasks; i++)
 	//	CONS_Printf("Mask no.%d:\ndrawsegs: %d\n vissprites: %d\n\n", i, masks[i].drawsegs[1] - masks[i].drawsegs[0], masks[i].vissprites[1] - masks[i].vissprites[0]);
 
+	g_binmaskedcolumns = cv_parallelsoftware.value;
+	// Whatever a pipelined view recorded last frame has been drawn by now
+	g_maskedbuffer = &g_maskedbuffers[viewssnum];
+	g_maskedbuffer->columns.clear();
+	g_maskedbuffer->flushed = 0;
+
 	for (; nummasks > 0; nummasks--)
 	{
 		viewx = masks[nummasks - 1].viewx;
@@ -4000,5 +4160,9 @@ void R_DrawMasked(maskcount_t* masks, INT32 nummasks)
 		R_ClearDrawNodes(&heads[nummasks - 1]);
 	}
 
+	// A pipelined view keeps its columns until it's submitted
+	R_FlushMaskedColumns(false);
+	g_binmaskedcolumns = false;
+
 	free(heads);
 }
@@ -55,6 +55,9 @@ extern INT32 lengthcol;
 void R_DrawMaskedColumn(drawcolumndata_t* dc, column_t *column, column_t *brightmap, INT32 baseclip);
 void R_DrawFlippedMaskedColumn(drawcolumndata_t* dc, column_t *column, column_t *brightmap, INT32 baseclip);
 
+// Draws a masked column, or bins it by screen strip while R_DrawMasked composites strips in parallel
+void R_SubmitMaskedColumn(void (*func)(drawcolumndata_t*), drawcolumndata_t *dc);
+
 // ----------------
 // SPRITE RENDERING
 // ----------------
@@ -0,0 +1,713 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "null_rhi.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <fmt/format.h>
+
+using namespace srb2;
+using namespace rhi;
+
+// Keep the first few failures; a broken frame usually repeats the same mistake for every draw.
+static constexpr size_t kMaxValidationMessages = 16;
+
+#define NULL_CHECK(expr) check((expr), #expr)
+
+static uint32_t pixel_format_size(PixelFormat format)
+{
+	switch (format)
+	{
+	case PixelFormat::kR8:
+		return 1;
+	case PixelFormat::kRG8:
+		return 2;
+	case PixelFormat::kRGB8:
+		return 3;
+	case PixelFormat::kRGBA8:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+static TextureFormat pixel_format_texture_format(PixelFormat format)
+{
+	switch (format)
+	{
+	case PixelFormat::kR8:
+		return TextureFormat::kLuminance;
+	case PixelFormat::kRG8:
+		return TextureFormat::kLuminanceAlpha;
+	case PixelFormat::kRGB8:
+		return TextureFormat::kRGB;
+	default:
+		return TextureFormat::kRGBA;
+	}
+}
+
+NullRhi::NullRhi(uint32_t width, uint32_t height) : default_framebuffer_ {0, 0, width, height}
+{
+}
+
+NullRhi::~NullRhi() = default;
+
+bool NullRhi::check(bool condition, const char* what)
+{
+	if (condition)
+	{
+		return true;
+	}
+
+	stats_.validation_errors += 1;
+	if (validation_messages_.size() < kMaxValidationMessages)
+	{
+		validation_messages_.push_back(what);
+	}
+	return false;
+}
+
+bool NullRhi::check_context(Handle<GraphicsContext> ctx, bool needs_pipeline)
+{
+	bool ok = NULL_CHECK(graphics_context_active_ == true && graphics_context_generation_ == ctx.generation());
+	if (needs_pipeline)
+	{
+		ok = NULL_CHECK(current_render_pass_.has_value() == true && current_pipeline_.has_value() == true) && ok;
+	}
+	return ok;
+}
+
+void NullRhi::record(NullRhiCommandType type, uint32_t handle, uint32_t arg0, uint32_t arg1)
+{
+	if (recording_)
+	{
+		log_.push_back(NullRhiCommand {type, handle, arg0, arg1});
+	}
+}
+
+Rect NullRhi::current_target_dimensions()
+{
+	if (!current_render_pass_)
+	{
+		return default_framebuffer_;
+	}
+
+	auto render_pass_visitor = srb2::Overload {
+		[&](const DefaultRenderPassState& state) { return default_framebuffer_; },
+		[&](const RenderPassBeginInfo& state)
+		{
+			if (!texture_slab_.is_valid(state.color_attachment))
+			{
+				return default_framebuffer_;
+			}
+			auto& attach_tex = texture_slab_[state.color_attachment];
+			return Rect {0, 0, attach_tex.desc.width, attach_tex.desc.height};
+		}
+	};
+	return std::visit(render_pass_visitor, *current_render_pass_);
+}
+
+Handle<RenderPass> NullRhi::create_render_pass(const RenderPassDesc& desc)
+{
+	NullRenderPass pass;
+	pass.desc = desc;
+	Handle<RenderPass> handle = render_pass_slab_.insert(std::move(pass));
+	stats_.resources_created += 1;
+	record(NullRhiCommandType::kCreateResource, handle.id());
+	return handle;
+}
+
+void NullRhi::destroy_render_pass(Handle<RenderPass> handle)
+{
+	if (!NULL_CHECK(render_pass_slab_.is_valid(handle) == true))
+	{
+		return;
+	}
+	render_pass_slab_.remove(handle);
+	stats_.resources_destroyed += 1;
+	record(NullRhiCommandType::kDestroyResource, handle.id());
+}
+
+Handle<Pipeline> NullRhi::create_pipeline(const PipelineDesc& desc)
+{
+	const ProgramRequirements& reqs = program_requirements_for_program(desc.program);
+
+	for (auto& layout : desc.vertex_input.attr_layouts)
+	{
+		NULL_CHECK(layout.buffer_index < desc.vertex_input.buffer_layouts.size());
+	}
+	for (auto& attribute : reqs.vertex_input.attributes)
+	{
+		if (!attribute.required)
+		{
+			continue;
+		}
+		auto& layouts = desc.vertex_input.attr_layouts;
+		NULL_CHECK(
+			std::find_if(
+				layouts.begin(),
+				layouts.end(),
+				[&](const VertexAttributeLayoutDesc& l) { return l.name == attribute.name; }
+			) != layouts.end()
+		);
+	}
+	for (auto& sampler : reqs.samplers.samplers)
+	{
+		if (!sampler.required)
+		{
+			continue;
+		}
+		auto& enabled = desc.sampler_input.enabled_samplers;
+		NULL_CHECK(std::find(enabled.begin(), enabled.end(), sampler.name) != enabled.end());
+	}
+	NULL_CHECK(desc.uniform_input.enabled_uniforms.size() <= reqs.uniforms.uniform_groups.size());
+
+	NullPipeline pipeline;
+	pipeline.desc = desc;
+	Handle<Pipeline> handle = pipeline_slab_.insert(std::move(pipeline));
+	stats_.resources_created += 1;
+	record(NullRhiCommandType::kCreateResource, handle.id());
+	return handle;
+}
+
+void NullRhi::destroy_pipeline(Handle<Pipeline> handle)
+{
+	if (!NULL_CHECK(pipeline_slab_.is_valid(handle) == true))
+	{
+		return;
+	}
+	pipeline_slab_.remove(handle);
+	stats_.resources_destroyed += 1;
+	record(NullRhiCommandType::kDestroyResource, handle.id());
+}
+
+Handle<Texture> NullRhi::create_texture(const TextureDesc& desc)
+{
+	NULL_CHECK(desc.width > 0 && desc.height > 0);
+
+	NullTexture texture;
+	texture.desc = desc;
+	Handle<Texture> handle = texture_slab_.insert(std::move(texture));
+	stats_.resources_created += 1;
+	record(NullRhiCommandType::kCreateResource, handle.id(), desc.width, desc.height);
+	return handle;
+}
+
+void NullRhi::destroy_texture(Handle<Texture> handle)
+{
+	if (!NULL_CHECK(texture_slab_.is_valid(handle) == true))
+	{
+		return;
+	}
+	texture_slab_.remove(handle);
+	stats_.resources_destroyed += 1;
+	record(NullRhiCommandType::kDestroyResource, handle.id());
+}
+
+Handle<Buffer> NullRhi::create_buffer(const BufferDesc& desc)
+{
+	NullBuffer buffer;
+	buffer.desc = desc;
+	Handle<Buffer> handle = buffer_slab_.insert(std::move(buffer));
+	stats_.resources_created += 1;
+	record(NullRhiCommandType::kCreateResource, handle.id(), desc.size);
+	return handle;
+}
+
+void NullRhi::destroy_buffer(Handle<Buffer> handle)
+{
+	if (!NULL_CHECK(buffer_slab_.is_valid(handle) == true))
+	{
+		return;
+	}
+	buffer_slab_.remove(handle);
+	if (current_index_buffer_ == handle)
+	{
+		current_index_buffer_ = kNullHandle;
+	}
+	stats_.resources_destroyed += 1;
+	record(NullRhiCommandType::kDestroyResource, handle.id());
+}
+
+Handle<Renderbuffer> NullRhi::create_renderbuffer(const RenderbufferDesc& desc)
+{
+	NullRenderbuffer rb;
+	rb.desc = desc;
+	Handle<Renderbuffer> handle = renderbuffer_slab_.insert(std::move(rb));
+	stats_.resources_created += 1;
+	record(NullRhiCommandType::kCreateResource, handle.id(), desc.width, desc.height);
+	return handle;
+}
+
+void NullRhi::destroy_renderbuffer(Handle<Renderbuffer> handle)
+{
+	if (!NULL_CHECK(renderbuffer_slab_.is_valid(handle) == true))
+	{
+		return;
+	}
+	renderbuffer_slab_.remove(handle);
+	stats_.resources_destroyed += 1;
+	record(NullRhiCommandType::kDestroyResource, handle.id());
+}
+
+TextureDetails NullRhi::get_texture_details(Handle<Texture> texture)
+{
+	TextureDetails ret {};
+	if (!NULL_CHECK(texture_slab_.is_valid(texture)))
+	{
+		return ret;
+	}
+	auto& t = texture_slab_[texture];
+
+	ret.format = t.desc.format;
+	ret.width = t.desc.width;
+	ret.height = t.desc.height;
+
+	return ret;
+}
+
+Rect NullRhi::get_renderbuffer_size(Handle<Renderbuffer> renderbuffer)
+{
+	Rect ret {};
+	if (!NULL_CHECK(renderbuffer_slab_.is_valid(renderbuffer)))
+	{
+		return ret;
+	}
+	auto& rb = renderbuffer_slab_[renderbuffer];
+
+	ret.w = rb.desc.width;
+	ret.h = rb.desc.height;
+
+	return ret;
+}
+
+uint32_t NullRhi::get_buffer_size(Handle<Buffer> buffer)
+{
+	if (!NULL_CHECK(buffer_slab_.is_valid(buffer)))
+	{
+		return 0;
+	}
+	return buffer_slab_[buffer].desc.size;
+}
+
+void NullRhi::update_buffer(
+	Handle<GraphicsContext> ctx,
+	Handle<Buffer> buffer,
+	uint32_t offset,
+	tcb::span<const std::byte> data
+)
+{
+	check_context(ctx, false);
+
+	if (data.empty())
+	{
+		return;
+	}
+
+	if (!NULL_CHECK(buffer_slab_.is_valid(buffer) == true))
+	{
+		return;
+	}
+	auto& b = buffer_slab_[buffer];
+
+	NULL_CHECK(offset < b.desc.size && offset + data.size() <= b.desc.size);
+
+	stats_.buffer_uploads += 1;
+	stats_.buffer_upload_bytes += data.size();
+	record(NullRhiCommandType::kUpdateBuffer, buffer.id(), offset, static_cast<uint32_t>(data.size()));
+}
+
+void NullRhi::update_texture(
+	Handle<GraphicsContext> ctx,
+	Handle<Texture> texture,
+	Rect region,
+	srb2::rhi::PixelFormat data_format,
+	tcb::span<const std::byte> data
+)
+{
+	NULL_CHECK(graphics_context_active_ == true);
+
+	if (data.empty())
+	{
+		return;
+	}
+
+	if (!NULL_CHECK(texture_slab_.is_valid(texture) == true))
+	{
+		return;
+	}
+	auto& t = texture_slab_[texture];
+
+	uint32_t size = pixel_format_size(data_format);
+	NULL_CHECK(size != 0);
+	NULL_CHECK(pixel_format_texture_format(data_format) == t.desc.format);
+
+	// Each row of pixels must be on the unpack alignment boundary.
+	size_t expected_row_span =
+		(((size * region.w) + kPixelRowUnpackAlignment - 1) / kPixelRowUnpackAlignment) * kPixelRowUnpackAlignment;
+	NULL_CHECK(expected_row_span * region.h == data.size_bytes());
+	NULL_CHECK(region.x >= 0 && region.y >= 0);
+	NULL_CHECK(region.x + region.w <= t.desc.width && region.y + region.h <= t.desc.height);
+
+	stats_.texture_uploads += 1;
+	stats_.texture_upload_bytes += data.size_bytes();
+	record(NullRhiCommandType::kUpdateTexture, texture.id(), region.w * region.h, static_cast<uint32_t>(data.size()));
+}
+
+void NullRhi::update_texture_settings(
+	Handle<GraphicsContext> ctx,
+	Handle<Texture> texture,
+	TextureWrapMode u_wrap,
+	TextureWrapMode v_wrap,
+	TextureFilterMode min,
+	TextureFilterMode mag
+)
+{
+	NULL_CHECK(graphics_context_active_ == true);
+
+	if (!NULL_CHECK(texture_slab_.is_valid(texture) == true))
+	{
+		return;
+	}
+	auto& t = texture_slab_[texture];
+	t.desc.u_wrap = u_wrap;
+	t.desc.v_wrap = v_wrap;
+	t.desc.min = min;
+	t.desc.mag = mag;
+
+	record(NullRhiCommandType::kUpdateTextureSettings, texture.id());
+}
+
+Handle<UniformSet> NullRhi::create_uniform_set(Handle<GraphicsContext> ctx, const CreateUniformSetInfo& info)
+{
+	check_context(ctx, false);
+
+	NullUniformSet uniform_set;
+	uniform_set.formats.reserve(info.uniforms.size());
+	for (auto& uniform : info.uniforms)
+	{
+		uniform_set.formats.push_back(uniform_variant_format(uniform));
+	}
+
+	Handle<UniformSet> handle = uniform_set_slab_.insert(std::move(uniform_set));
+	record(NullRhiCommandType::kCreateUniformSet, handle.id(), static_cast<uint32_t>(info.uniforms.size()));
+	return handle;
+}
+
+Handle<BindingSet>
+NullRhi::create_binding_set(Handle<GraphicsContext> ctx, Handle<Pipeline> pipeline, const CreateBindingSetInfo& info)
+{
+	check_context(ctx, false);
+
+	NullBindingSet binding_set {};
+	binding_set.vertex_buffers = static_cast<uint32_t>(info.vertex_buffers.size());
+	binding_set.textures = static_cast<uint32_t>(info.sampler_textures.size());
+
+	if (NULL_CHECK(pipeline_slab_.is_valid(pipeline) == true))
+	{
+		auto& pl = pipeline_slab_[pipeline];
+
+		NULL_CHECK(info.vertex_buffers.size() == pl.desc.vertex_input.buffer_layouts.size());
+		NULL_CHECK(info.sampler_textures.size() <= pl.desc.sampler_input.enabled_samplers.size());
+
+		for (auto& vertex_buffer : info.vertex_buffers)
+		{
+			if (NULL_CHECK(buffer_slab_.is_valid(vertex_buffer.vertex_buffer)))
+			{
+				NULL_CHECK(buffer_slab_[vertex_buffer.vertex_buffer].desc.type == BufferType::kVertexBuffer);
+			}
+		}
+
+		for (size_t i = 0; i < info.sampler_textures.size() && i < pl.desc.sampler_input.enabled_samplers.size(); i++)
+		{
+			auto& binding = info.sampler_textures[i];
+			NULL_CHECK(binding.name == pl.desc.sampler_input.enabled_samplers[i]);
+			NULL_CHECK(texture_slab_.is_valid(binding.texture));
+		}
+	}
+
+	Handle<BindingSet> handle = binding_set_slab_.insert(std::move(binding_set));
+	record(NullRhiCommandType::kCreateBindingSet, handle.id(), pipeline.id());
+	return handle;
+}
+
+Handle<GraphicsContext> NullRhi::begin_graphics()
+{
+	NULL_CHECK(graphics_context_active_ == false);
+	graphics_context_active_ = true;
+	record(NullRhiCommandType::kBeginGraphics);
+	return Handle<GraphicsContext>(0, graphics_context_generation_);
+}
+
+void NullRhi::end_graphics(Handle<GraphicsContext> ctx)
+{
+	NULL_CHECK(graphics_context_active_ == true);
+	NULL_CHECK(current_pipeline_.has_value() == false && current_render_pass_.has_value() == false);
+	graphics_context_generation_ += 1;
+	if (graphics_context_generation_ == 0)
+	{
+		graphics_context_generation_ = 1;
+	}
+	graphics_context_active_ = false;
+	record(NullRhiCommandType::kEndGraphics);
+}
+
+void NullRhi::begin_default_render_pass(Handle<GraphicsContext> ctx, bool clear)
+{
+	check_context(ctx, false);
+	NULL_CHECK(current_render_pass_.has_value() == false);
+
+	current_render_pass_ = NullRhi::DefaultRenderPassState {};
+	stats_.render_passes += 1;
+	record(NullRhiCommandType::kBeginRenderPass, 0, clear);
+}
+
+void NullRhi::begin_render_pass(Handle<GraphicsContext> ctx, const RenderPassBeginInfo& info)
+{
+	check_context(ctx, false);
+	NULL_CHECK(current_render_pass_.has_value() == false);
+
+	if (NULL_CHECK(render_pass_slab_.is_valid(info.render_pass) == true))
+	{
+		auto& rp = render_pass_slab_[info.render_pass];
+		NULL_CHECK(rp.desc.use_depth_stencil == info.depth_stencil_attachment.has_value());
+	}
+	if (NULL_CHECK(texture_slab_.is_valid(info.color_attachment)))
+	{
+		NULL_CHECK(texture_slab_[info.color_attachment].desc.format == TextureFormat::kRGBA);
+	}
+	if (info.depth_stencil_attachment)
+	{
+		NULL_CHECK(renderbuffer_slab_.is_valid(*info.depth_stencil_attachment));
+	}
+
+	current_render_pass_ = info;
+	stats_.render_passes += 1;
+	record(NullRhiCommandType::kBeginRenderPass, info.render_pass.id(), info.color_attachment.id());
+}
+
+void NullRhi::end_render_pass(Handle<GraphicsContext> ctx)
+{
+	check_context(ctx, false);
+	NULL_CHECK(current_render_pass_.has_value() == true);
+
+	current_pipeline_ = std::nullopt;
+	current_render_pass_ = std::nullopt;
+	record(NullRhiCommandType::kEndRenderPass);
+}
+
+void NullRhi::bind_pipeline(Handle<GraphicsContext> ctx, Handle<Pipeline> pipeline)
+{
+	check_context(ctx, false);
+	NULL_CHECK(current_render_pass_.has_value() == true);
+	NULL_CHECK(pipeline_slab_.is_valid(pipeline) == true);
+
+	stats_.pipeline_binds += 1;
+	if (!current_pipeline_ || *current_pipeline_ != pipeline)
+	{
+		stats_.pipeline_changes += 1;
+	}
+	current_pipeline_ = pipeline;
+	record(NullRhiCommandType::kBindPipeline, pipeline.id());
+}
+
+void NullRhi::bind_uniform_set(Handle<GraphicsContext> ctx, uint32_t slot, Handle<UniformSet> set)
+{
+	stats_.uniform_set_binds += 1;
+	record(NullRhiCommandType::kBindUniformSet, set.id(), slot);
+
+	if (!check_context(ctx, true) || !NULL_CHECK(pipeline_slab_.is_valid(*current_pipeline_)))
+	{
+		return;
+	}
+	auto& pl = pipeline_slab_[*current_pipeline_];
+
+	if (!NULL_CHECK(uniform_set_slab_.is_valid(set)))
+	{
+		return;
+	}
+	auto& us = uniform_set_slab_[set];
+
+	auto& uniform_input = pl.desc.uniform_input;
+	if (!NULL_CHECK(slot < uniform_input.enabled_uniforms.size()) ||
+		!NULL_CHECK(us.formats.size() == uniform_input.enabled_uniforms[slot].size()))
+	{
+		return;
+	}
+
+	// Assert compatibility of uniform set with pipeline's set slot
+	for (size_t i = 0; i < us.formats.size(); i++)
+	{
+		NULL_CHECK(uniform_format(uniform_input.enabled_uniforms[slot][i]) == us.formats[i]);
+	}
+}
+
+void NullRhi::bind_binding_set(Handle<GraphicsContext> ctx, Handle<BindingSet> set)
+{
+	stats_.binding_set_binds += 1;
+	record(NullRhiCommandType::kBindBindingSet, set.id());
+
+	if (!check_context(ctx, true) || !NULL_CHECK(pipeline_slab_.is_valid(*current_pipeline_)))
+	{
+		return;
+	}
+	auto& pl = pipeline_slab_[*current_pipeline_];
+
+	if (!NULL_CHECK(binding_set_slab_.is_valid(set)))
+	{
+		return;
+	}
+	auto& bs = binding_set_slab_[set];
+
+	NULL_CHECK(bs.textures == pl.desc.sampler_input.enabled_samplers.size());
+	NULL_CHECK(bs.vertex_buffers == pl.desc.vertex_input.buffer_layouts.size());
+}
+
+void NullRhi::bind_index_buffer(Handle<GraphicsContext> ctx, Handle<Buffer> buffer)
+{
+	check_context(ctx, true);
+
+	stats_.index_buffer_binds += 1;
+	record(NullRhiCommandType::kBindIndexBuffer, buffer.id());
+
+	if (!NULL_CHECK(buffer_slab_.is_valid(buffer)))
+	{
+		return;
+	}
+	NULL_CHECK(buffer_slab_[buffer].desc.type == BufferType::kIndexBuffer);
+
+	current_index_buffer_ = buffer;
+}
+
+void NullRhi::set_scissor(Handle<GraphicsContext> ctx, const Rect& rect)
+{
+	check_context(ctx, true);
+	record(NullRhiCommandType::kSetScissor, 0, rect.w, rect.h);
+}
+
+void NullRhi::set_viewport(Handle<GraphicsContext> ctx, const Rect& rect)
+{
+	check_context(ctx, true);
+	record(NullRhiCommandType::kSetViewport, 0, rect.w, rect.h);
+}
+
+void NullRhi::draw(Handle<GraphicsContext> ctx, uint32_t vertex_count, uint32_t first_vertex)
+{
+	check_context(ctx, true);
+
+	stats_.draws += 1;
+	stats_.elements += vertex_count;
+	record(NullRhiCommandType::kDraw, current_pipeline_ ? current_pipeline_->id() : 0, vertex_count, first_vertex);
+}
+
+void NullRhi::draw_indexed(Handle<GraphicsContext> ctx, uint32_t index_count, uint32_t first_index)
+{
+	check_context(ctx, true);
+
+	if (NULL_CHECK(current_index_buffer_ != kNullHandle && buffer_slab_.is_valid(current_index_buffer_)))
+	{
+		auto& ib = buffer_slab_[current_index_buffer_];
+		NULL_CHECK((static_cast<uint64_t>(index_count) + first_index) * 2 <= ib.desc.size);
+	}
+
+	stats_.draws += 1;
+	stats_.indexed_draws += 1;
+	stats_.elements += index_count;
+	record(
+		NullRhiCommandType::kDrawIndexed,
+		current_pipeline_ ? current_pipeline_->id() : 0,
+		index_count,
+		first_index
+	);
+}
+
+void NullRhi::read_pixels(Handle<GraphicsContext> ctx, const Rect& rect, PixelFormat format, tcb::span<std::byte> out)
+{
+	check_context(ctx, false);
+	NULL_CHECK(current_render_pass_.has_value());
+
+	// Pack alignment comes into play.
+	uint32_t size = pixel_format_size(format);
+	uint32_t pack_stride = (rect.w * size + (kPixelRowPackAlignment - 1)) & ~(kPixelRowPackAlignment - 1);
+	NULL_CHECK(out.size_bytes() == pack_stride * rect.h);
+
+	Rect src_dim = current_target_dimensions();
+	NULL_CHECK(rect.x >= 0 && rect.y >= 0);
+	NULL_CHECK(rect.x + rect.w <= src_dim.w && rect.y + rect.h <= src_dim.h);
+
+	// There is nothing to read back; hand out black rather than stale memory.
+	std::memset(out.data(), 0, out.size_bytes());
+	record(NullRhiCommandType::kReadPixels, 0, rect.w, rect.h);
+}
+
+void NullRhi::copy_framebuffer_to_texture(
+	Handle<GraphicsContext> ctx,
+	Handle<Texture> dst_tex,
+	const Rect& dst_region,
+	const Rect& src_region
+)
+{
+	NULL_CHECK(graphics_context_active_ == true);
+	NULL_CHECK(current_render_pass_.has_value());
+	NULL_CHECK(dst_region.w == src_region.w && dst_region.h == src_region.h);
+
+	if (NULL_CHECK(texture_slab_.is_valid(dst_tex)))
+	{
+		auto& tex = texture_slab_[dst_tex];
+		NULL_CHECK(dst_region.x >= 0 && dst_region.y >= 0);
+		NULL_CHECK(dst_region.x + dst_region.w <= tex.desc.width && dst_region.y + dst_region.h <= tex.desc.height);
+	}
+
+	Rect src_dim = current_target_dimensions();
+	NULL_CHECK(src_region.x >= 0 && src_region.y >= 0);
+	NULL_CHECK(src_region.x + src_region.w <= src_dim.w && src_region.y + src_region.h <= src_dim.h);
+
+	record(NullRhiCommandType::kCopyFramebufferToTexture, dst_tex.id(), dst_region.w, dst_region.h);
+}
+
+void NullRhi::set_stencil_reference(Handle<GraphicsContext> ctx, CullMode face, uint8_t reference)
+{
+	NULL_CHECK(face != CullMode::kNone);
+	check_context(ctx, true);
+	record(NullRhiCommandType::kSetStencilState, 0, static_cast<uint32_t>(face), reference);
+}
+
+void NullRhi::set_stencil_compare_mask(Handle<GraphicsContext> ctx, CullMode face, uint8_t mask)
+{
+	NULL_CHECK(face != CullMode::kNone);
+	check_context(ctx, true);
+	record(NullRhiCommandType::kSetStencilState, 1, static_cast<uint32_t>(face), mask);
+}
+
+void NullRhi::set_stencil_write_mask(Handle<GraphicsContext> ctx, CullMode face, uint8_t mask)
+{
+	NULL_CHECK(face != CullMode::kNone);
+	check_context(ctx, true);
+	record(NullRhiCommandType::kSetStencilState, 2, static_cast<uint32_t>(face), mask);
+}
+
+void NullRhi::present()
+{
+	NULL_CHECK(graphics_context_active_ == false);
+	record(NullRhiCommandType::kPresent);
+}
+
+void NullRhi::finish()
+{
+	NULL_CHECK(graphics_context_active_ == false);
+
+	binding_set_slab_.clear();
+	uniform_set_slab_.clear();
+	record(NullRhiCommandType::kFinish);
+}
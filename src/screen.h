@@ -137,7 +137,7 @@ extern UINT8 *scr_borderpatch; // patch used to fill the view borders
 
 extern consvar_t cv_scr_width, cv_scr_height, cv_scr_depth, cv_renderview, cv_renderer, cv_renderhitbox, cv_fullscreen;
 extern consvar_t cv_scr_effect;
-extern consvar_t cv_parallelsoftware;
+extern consvar_t cv_parallelsoftware, cv_parallelviews;
 
 // wait for page flipping to end or not
 extern consvar_t cv_vidwait;
@@ -22,6 +22,7 @@
 
 #include "../rhi/rhi.hpp"
 #include "../rhi/gl2/gl2_rhi.hpp"
+#include "../rhi/null/null_rhi.hpp"
 #include "rhi_gl2_platform.hpp"
 
 #ifdef _MSC_VER
@@ -134,6 +135,8 @@ static       SDL_bool    mousegrabok = SDL_TRUE;
 static       SDL_bool    wrapmouseok = SDL_FALSE;
 static       SDL_bool    exposevideo = SDL_FALSE;
 static       SDL_bool    borderlesswindow = SDL_FALSE;
+// -nullrhi: no window or GL context, frames are recorded by the null RHI
+static       SDL_bool    nullrhi = SDL_FALSE;
 
 // SDL2 vars
 SDL_Window   *window;
@@ -202,6 +205,14 @@ static void SDLSetMode(int width, int height, SDL_bool fullscreen, SDL_bool repo
 	realwidth = vid.width;
 	realheight = vid.height;
 
+	if (nullrhi)
+	{
+		Impl_CreateWindow(fullscreen);
+		vid.realwidth = static_cast<uint32_t>(width);
+		vid.realheight = static_cast<uint32_t>(height);
+		return;
+	}
+
 	if (window)
 	{
 		if (fullscreen)
@@ -1416,6 +1427,18 @@ static void init_imgui()
 
 static SDL_bool Impl_CreateContext(void)
 {
+	if (nullrhi)
+	{
+		// Headless: the 2D and blit passes still run, against a backend that draws nothing
+		init_imgui();
+		if (!g_rhi)
+		{
+			g_rhi = std::make_unique<rhi::NullRhi>(realwidth, realheight);
+			g_rhi_generation += 1;
+		}
+		return SDL_TRUE;
+	}
+
 #ifdef HWRENDER
 	if (rendermode == render_opengl)
 	{
@@ -1481,6 +1504,9 @@ boolean VID_CheckRenderer(void)
 	if (dedicated)
 		return false;
 
+	if (nullrhi)
+		setrenderneeded = 0; // the null RHI only backs the software renderer
+
 	if (setrenderneeded)
 	{
 		rendermode = static_cast<rendermode_t>(setrenderneeded);
@@ -1579,6 +1605,9 @@ static SDL_bool Impl_CreateWindow(SDL_bool fullscreen)
 	if (rendermode == render_none) // dedicated
 		return SDL_TRUE; // Monster Iestyn -- not sure if it really matters what we return here tbh
 
+	if (nullrhi)
+		return Impl_CreateContext();
+
 	if (window != NULL)
 		return SDL_FALSE;
 
@@ -1647,11 +1676,13 @@ void I_StartupGraphics(void)
 	disable_mouse = static_cast<SDL_bool>(M_CheckParm("-nomouse"));
 	disable_fullscreen = M_CheckParm("-win") ? SDL_TRUE : SDL_FALSE;
 
+	nullrhi = M_CheckParm("-nullrhi") ? SDL_TRUE : SDL_FALSE;
+
 	keyboard_started = true;
 
 #if !defined(HAVE_TTF)
 	// Previously audio was init here for questionable reasons?
-	if (SDL_InitSubSystem(SDL_INIT_VIDEO) < 0)
+	if (!nullrhi && SDL_InitSubSystem(SDL_INIT_VIDEO) < 0)
 	{
 		CONS_Printf(M_GetText("Couldn't initialize SDL's Video System: %s\n"), SDL_GetError());
 		return;
@@ -1697,6 +1728,10 @@ void I_StartupGraphics(void)
 	if (chosenrendermode != render_none)
 		rendermode = chosenrendermode;
 
+	// No window, so no OpenGL
+	if (nullrhi)
+		rendermode = render_soft;
+
 	borderlesswindow = M_CheckParm("-borderless") ? SDL_TRUE : SDL_FALSE;
 
 	VID_Command_ModeList_f();
@@ -1728,12 +1763,16 @@ void I_StartupGraphics(void)
 	realheight = (Uint16)vid.height;
 
 	VID_Command_Info_f();
-	SDLdoUngrabMouse();
 
-	SDL_RaiseWindow(window);
+	if (window)
+	{
+		SDLdoUngrabMouse();
+
+		SDL_RaiseWindow(window);
 
-	if (mousegrabok && !disable_mouse)
-		SDLdoGrabMouse();
+		if (mousegrabok && !disable_mouse)
+			SDLdoGrabMouse();
+	}
 
 	graphics_started = true;
 }
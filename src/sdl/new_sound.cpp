@@ -9,6 +9,8 @@
 //-----------------------------------------------------------------------------
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <memory>
 
@@ -21,7 +23,9 @@
 #include "../audio/music_player.hpp"
 #include "../audio/resample.hpp"
 #include "../audio/sound_chunk.hpp"
+#include "../audio/sound_effect_mixer.hpp"
 #include "../audio/sound_effect_player.hpp"
+#include "../core/spsc_queue.hpp"
 #include "../cxxutil.hpp"
 #include "../io/streams.hpp"
 
@@ -29,6 +33,7 @@
 #include "../m_avrecorder.hpp"
 #endif
 
+#include "../command.h"
 #include "../doomdef.h"
 #include "../i_sound.h"
 #include "../s_sound.h"
@@ -48,6 +53,7 @@ using srb2::audio::MusicPlayer;
 using srb2::audio::Resampler;
 using srb2::audio::Sample;
 using srb2::audio::SoundChunk;
+using srb2::audio::SoundEffectMixer;
 using srb2::audio::SoundEffectPlayer;
 using srb2::audio::Source;
 using namespace srb2;
@@ -58,7 +64,7 @@ UINT8 sound_started = false;
 
 static unique_ptr<Gain<2>> master_gain;
 static shared_ptr<Mixer<2>> master;
-static shared_ptr<Mixer<2>> mixer_sound_effects;
+static shared_ptr<SoundEffectMixer> mixer_sound_effects;
 static shared_ptr<Mixer<2>> mixer_music;
 static shared_ptr<MusicPlayer> music_player;
 static shared_ptr<Resampler<2>> resample_music_player;
@@ -74,6 +80,253 @@ static shared_ptr<srb2::media::AVRecorder> av_recorder;
 
 static void (*music_fade_callback)();
 
+namespace
+{
+
+class SdlAudioLockHandle
+{
+public:
+	SdlAudioLockHandle() { SDL_LockAudio(); }
+	~SdlAudioLockHandle() { SDL_UnlockAudio(); }
+};
+
+// Sound effect and music control calls are posted to the audio callback through a lock-free ring
+// instead of taking the SDL audio lock every tic. The callback drains it before mixing each buffer.
+enum class AudioCommandType : uint8_t
+{
+	kStartSound,
+	kUpdateSound,
+	kStopSound,
+	kRetireChunk,
+	kSfxVolume,
+	kMasterVolume,
+	kMusicVolume,
+	kSongVolume,
+	kSongSpeed,
+	kPlaySong,
+	kStopSong,
+	kPauseSong,
+	kResumeSong,
+	kSongPosition,
+	kInternalMusicVolume,
+	kStopFade,
+	kFadeSongFrom,
+	kFadeSong,
+};
+
+struct AudioCommand
+{
+	AudioCommandType type;
+	bool looping;
+	uint32_t channel;
+	uint32_t generation;
+	const SoundChunk* chunk;
+	float params[3];
+};
+
+struct SoundChannelState
+{
+	// Game thread: bumped for every sound started on the channel
+	uint32_t generation = 0;
+	// Audio thread: generation the channel's player was last started with
+	uint32_t playing_generation = 0;
+	// Highest generation known to be over. Both threads raise it and it never goes down.
+	std::atomic<uint32_t> finished_generation {0};
+};
+
+struct RetiredChunk
+{
+	SoundChunk* chunk;
+	uint64_t sequence;
+};
+
+constexpr const size_t kAudioCommandCapacity = 1024;
+
+SpScQueue<AudioCommand> audio_commands {kAudioCommandCapacity};
+uint64_t audio_commands_posted = 0;
+std::atomic<uint64_t> audio_commands_drained {0};
+
+unique_ptr<SoundChannelState[]> sound_channel_states;
+
+// Freed sfx chunks wait here until the callback has drained the command that retired them
+vector<RetiredChunk> retired_chunks;
+
+// music_player->fading() as of the last drain or buffer, and the command that must be drained to trust it
+std::atomic<bool> music_fading_published {false};
+uint64_t music_fade_sequence = 0;
+
+void raise_finished_generation(SoundChannelState& state, uint32_t generation)
+{
+	uint32_t current = state.finished_generation.load(std::memory_order_relaxed);
+	while (current < generation &&
+		!state.finished_generation.compare_exchange_weak(current, generation, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+}
+
+void execute_audio_command(const AudioCommand& command)
+{
+	switch (command.type)
+	{
+	case AudioCommandType::kStartSound:
+		sound_effect_channels[command.channel]->start(command.chunk, command.params[0], command.params[1], command.params[2]);
+		sound_channel_states[command.channel].playing_generation = command.generation;
+		break;
+	case AudioCommandType::kUpdateSound:
+	{
+		SoundEffectPlayer& player = *sound_effect_channels[command.channel];
+		if (!player.finished() && sound_channel_states[command.channel].playing_generation == command.generation)
+		{
+			player.update(command.params[0], command.params[1], command.params[2]);
+		}
+		break;
+	}
+	case AudioCommandType::kStopSound:
+		sound_effect_channels[command.channel]->reset();
+		raise_finished_generation(sound_channel_states[command.channel], sound_channel_states[command.channel].playing_generation);
+		break;
+	case AudioCommandType::kRetireChunk:
+		// Stop any channels playing this chunk
+		for (size_t i = 0; i < sound_effect_channels.size(); i++)
+		{
+			if (sound_effect_channels[i]->is_playing_chunk(command.chunk))
+			{
+				sound_effect_channels[i]->reset();
+				raise_finished_generation(sound_channel_states[i], sound_channel_states[i].playing_generation);
+			}
+		}
+		break;
+	case AudioCommandType::kSfxVolume:
+		gain_sound_effects->gain(command.params[0]);
+		break;
+	case AudioCommandType::kMasterVolume:
+		master_gain->gain(command.params[0]);
+		break;
+	case AudioCommandType::kMusicVolume:
+		gain_music_channel->gain(command.params[0]);
+		break;
+	case AudioCommandType::kSongVolume:
+		gain_music_player->gain(command.params[0]);
+		break;
+	case AudioCommandType::kSongSpeed:
+		resample_music_player->ratio(command.params[0]);
+		break;
+	case AudioCommandType::kPlaySong:
+		music_player->play(command.looping);
+		break;
+	case AudioCommandType::kStopSong:
+		music_player->stop();
+		break;
+	case AudioCommandType::kPauseSong:
+		music_player->pause();
+		break;
+	case AudioCommandType::kResumeSong:
+		music_player->unpause();
+		break;
+	case AudioCommandType::kSongPosition:
+		music_player->seek(command.params[0]);
+		break;
+	case AudioCommandType::kInternalMusicVolume:
+		music_player->internal_gain(command.params[0]);
+		break;
+	case AudioCommandType::kStopFade:
+		music_player->stop_fade();
+		break;
+	case AudioCommandType::kFadeSongFrom:
+		music_player->fade_from_to(command.params[0], command.params[1], command.params[2]);
+		break;
+	case AudioCommandType::kFadeSong:
+		music_player->fade_to(command.params[0], command.params[1]);
+		break;
+	}
+}
+
+// Consumer side of the ring: the audio callback, or the game thread while it holds the SDL audio lock.
+void drain_audio_commands()
+{
+	uint64_t drained = 0;
+
+	while (std::optional<AudioCommand> command = audio_commands.pop())
+	{
+		execute_audio_command(*command);
+		drained++;
+	}
+
+	if (drained)
+	{
+		if (music_player)
+		{
+			music_fading_published.store(music_player->fading(), std::memory_order_relaxed);
+		}
+		audio_commands_drained.fetch_add(drained, std::memory_order_release);
+	}
+}
+
+// Takes the audio lock and applies everything posted so far, for calls that read audio state back
+class SdlAudioSyncHandle : public SdlAudioLockHandle
+{
+public:
+	SdlAudioSyncHandle() { drain_audio_commands(); }
+};
+
+void post_audio_command(const AudioCommand& command)
+{
+	if (!audio_commands.try_push(command))
+	{
+		// The callback has fallen behind; make room ourselves
+		SdlAudioLockHandle _;
+		drain_audio_commands();
+		audio_commands.try_push(command);
+	}
+
+	audio_commands_posted++;
+}
+
+void post_audio_command(AudioCommandType type, float param = 0.f)
+{
+	AudioCommand command {};
+	command.type = type;
+	command.params[0] = param;
+	post_audio_command(command);
+}
+
+void reclaim_retired_chunks()
+{
+	if (retired_chunks.empty())
+		return;
+
+	uint64_t drained = audio_commands_drained.load(std::memory_order_acquire);
+	auto done = std::remove_if(
+		retired_chunks.begin(),
+		retired_chunks.end(),
+		[drained](const RetiredChunk& retired)
+		{
+			if (retired.sequence > drained)
+				return false;
+			delete retired.chunk;
+			return true;
+		}
+	);
+	retired_chunks.erase(done, retired_chunks.end());
+}
+
+bool sound_channel_playing(size_t index)
+{
+	SoundChannelState& state = sound_channel_states[index];
+	return state.finished_generation.load(std::memory_order_acquire) < state.generation;
+}
+
+bool music_fading()
+{
+	// Until the callback has seen the latest fade, the published flag predates it
+	if (audio_commands_drained.load(std::memory_order_acquire) < music_fade_sequence)
+		return true;
+
+	return music_fading_published.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
 void* I_GetSfx(sfxinfo_t* sfx)
 {
 	if (sfx->lumpnum == LUMPERROR)
@@ -99,15 +352,19 @@ void I_FreeSfx(sfxinfo_t* sfx)
 	if (sfx->data)
 	{
 		SoundChunk* chunk = static_cast<SoundChunk*>(sfx->data);
-		auto _ = srb2::finally([chunk]() { delete chunk; });
 
-		// Stop any channels playing this chunk
-		for (auto& player : sound_effect_channels)
+		if (sound_effect_channels.empty())
 		{
-			if (player->is_playing_chunk(chunk))
-			{
-				player->reset();
-			}
+			delete chunk;
+		}
+		else
+		{
+			// The callback stops any channels playing this chunk; it is deleted once that has happened
+			AudioCommand command {};
+			command.type = AudioCommandType::kRetireChunk;
+			command.chunk = chunk;
+			post_audio_command(command);
+			retired_chunks.push_back({chunk, audio_commands_posted});
 		}
 	}
 	sfx->data = nullptr;
@@ -117,13 +374,6 @@ void I_FreeSfx(sfxinfo_t* sfx)
 namespace
 {
 
-class SdlAudioLockHandle
-{
-public:
-	SdlAudioLockHandle() { SDL_LockAudio(); }
-	~SdlAudioLockHandle() { SDL_UnlockAudio(); }
-};
-
 #ifdef TRACY_ENABLE
 static const char* kAudio = "Audio";
 #endif
@@ -149,8 +399,19 @@ void audio_callback(void* userdata, Uint8* buffer, int len)
 		if (!master_gain)
 			return;
 
+		drain_audio_commands();
+
 		master_gain->generate(tcb::span {float_buffer, float_len});
 
+		for (size_t i = 0; i < sound_effect_channels.size(); i++)
+		{
+			if (sound_effect_channels[i]->finished())
+			{
+				raise_finished_generation(sound_channel_states[i], sound_channel_states[i].playing_generation);
+			}
+		}
+		music_fading_published.store(music_player->fading(), std::memory_order_relaxed);
+
 		for (size_t i = 0; i < float_len; i++)
 		{
 			float_buffer[i] = {
@@ -202,7 +463,7 @@ void initialize_sound()
 		master_gain = make_unique<Gain<2>>();
 		master = make_shared<Mixer<2>>();
 		master_gain->bind(master);
-		mixer_sound_effects = make_shared<Mixer<2>>();
+		mixer_sound_effects = make_shared<SoundEffectMixer>();
 		mixer_music = make_shared<Mixer<2>>();
 		music_player = make_shared<MusicPlayer>();
 		resample_music_player = make_shared<Resampler<2>>(music_player, 1.f);
@@ -216,19 +477,98 @@ void initialize_sound()
 		master->add_source(gain_music_channel);
 		mixer_music->add_source(gain_music_player);
 		sound_effect_channels.clear();
+		sound_channel_states = make_unique<SoundChannelState[]>(cv_numChannels.value);
 		for (size_t i = 0; i < static_cast<size_t>(cv_numChannels.value); i++)
 		{
 			shared_ptr<SoundEffectPlayer> player = make_shared<SoundEffectPlayer>();
 			sound_effect_channels.push_back(player);
-			mixer_sound_effects->add_source(player);
+			mixer_sound_effects->add_channel(player);
 		}
 	}
 
 	sound_started = true;
 }
 
+// Same curve as the old software mixer: 128 plays at the chunk's own rate, every 64 steps is an octave
+float pitch_to_rate(UINT8 pitch)
+{
+	return std::exp2((static_cast<int>(pitch) - 128) / 64.f);
+}
+
 } // namespace
 
+// sfxmix_bench [channels] [seconds]
+// Mixes synthetic chunks through the sound effect mixer without an audio device.
+void Command_SfxMixBench_f(void)
+{
+	using Clock = std::chrono::steady_clock;
+
+	if (!sound_started)
+	{
+		CONS_Printf("sfxmix_bench: the sound mixer is not initialized, benchmarking a standalone mixer\n");
+	}
+
+	size_t channels = COM_Argc() > 1 ? std::max(1, atoi(COM_Argv(1))) : 64;
+	size_t seconds = COM_Argc() > 2 ? std::max(1, atoi(COM_Argv(2))) : 10;
+	size_t block = std::max(64, cv_soundmixingbuffersize.value);
+
+	// Half a second of noise per chunk, a few lengths so channels retrigger at different times
+	vector<SoundChunk> chunks(8);
+	uint32_t seed = 0x9E3779B9u;
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		chunks[i].samples.resize(audio::kSampleRate / 2 + i * 997);
+		for (auto& sample : chunks[i].samples)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			sample.amplitudes[0] = static_cast<float>(seed >> 8) / 8388608.f - 1.f;
+		}
+	}
+
+	SoundEffectMixer mixer;
+	vector<shared_ptr<SoundEffectPlayer>> players;
+	vector<float> rates(channels);
+	for (size_t i = 0; i < channels; i++)
+	{
+		// Every other channel is pitched, to exercise the resampling path
+		rates[i] = (i & 1) ? pitch_to_rate(static_cast<UINT8>(96 + (i * 37) % 64)) : 1.f;
+		players.push_back(make_shared<SoundEffectPlayer>());
+		mixer.add_channel(players.back());
+	}
+
+	vector<Sample<2>> buffer(block);
+	const size_t total = seconds * audio::kSampleRate;
+	Clock::duration elapsed {};
+	Clock::duration worst {};
+
+	for (size_t mixed = 0; mixed < total; mixed += block)
+	{
+		for (size_t i = 0; i < channels; i++)
+		{
+			if (players[i]->finished())
+			{
+				players[i]->start(&chunks[i % chunks.size()], 0.5f, (i % 17) / 8.f - 1.f, rates[i]);
+			}
+		}
+
+		auto start = Clock::now();
+		mixer.generate(buffer);
+		auto taken = Clock::now() - start;
+		elapsed += taken;
+		worst = std::max(worst, taken);
+	}
+
+	const size_t blocks = (total + block - 1) / block;
+	const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	const double budget_ns = 1e9 * block / audio::kSampleRate;
+
+	CONS_Printf("sfxmix_bench: %s channels, %s s, %s-sample blocks\n", sizeu1(channels), sizeu2(seconds), sizeu3(block));
+	CONS_Printf("  %.2f ns/sample, %.3f ns/channel-sample\n", ns / (blocks * block), ns / (blocks * block * channels));
+	CONS_Printf("  callback budget used: %.2f%% average, %.2f%% worst block\n",
+		100.0 * ns / blocks / budget_ns,
+		100.0 * std::chrono::duration_cast<std::chrono::nanoseconds>(worst).count() / budget_ns);
+}
+
 void I_StartupSound(void)
 {
 	if (!sound_started)
@@ -240,16 +580,21 @@ void I_ShutdownSound(void)
 	SDL_CloseAudio();
 	SDL_QuitSubSystem(SDL_INIT_AUDIO);
 
+	// The callback is gone, so nothing else can be consuming the ring
+	if (master_gain)
+	{
+		drain_audio_commands();
+	}
+	reclaim_retired_chunks();
+
 	sound_started = false;
 }
 
 void I_UpdateSound(void)
 {
-	// The SDL audio lock is re-entrant, so it is safe to lock twice
-	// for the "fade to stop music" callback later.
-	SdlAudioLockHandle _;
+	reclaim_retired_chunks();
 
-	if (music_fade_callback && !music_player->fading())
+	if (music_fade_callback && !music_fading())
 	{
 		auto old_callback = music_fade_callback;
 		music_fade_callback = nullptr;
@@ -264,52 +609,46 @@ void I_UpdateSound(void)
 
 INT32 I_StartSound(sfxenum_t id, UINT8 vol, UINT8 sep, UINT8 pitch, UINT8 priority, INT32 channel)
 {
-	(void) pitch;
 	(void) priority;
 
-	SdlAudioLockHandle _;
-
 	if (channel >= 0 && static_cast<size_t>(channel) >= sound_effect_channels.size())
 		return -1;
 
-	shared_ptr<SoundEffectPlayer> player_channel;
 	if (channel < 0)
 	{
 		// find a free sfx channel
 		for (size_t i = 0; i < sound_effect_channels.size(); i++)
 		{
-			if (sound_effect_channels[i]->finished())
+			if (!sound_channel_playing(i))
 			{
-				player_channel = sound_effect_channels[i];
 				channel = i;
 				break;
 			}
 		}
 	}
-	else
-	{
-		player_channel = sound_effect_channels[channel];
-	}
 
-	if (!player_channel)
+	if (channel < 0)
 		return -1;
 
 	SoundChunk* chunk = static_cast<SoundChunk*>(S_sfx[id].data);
 	if (chunk == nullptr)
 		return -1;
 
-	float vol_float = static_cast<float>(vol) / 255.f;
-	float sep_float = static_cast<float>(sep) / 127.f - 1.f;
-
-	player_channel->start(chunk, vol_float, sep_float);
+	AudioCommand command {};
+	command.type = AudioCommandType::kStartSound;
+	command.channel = channel;
+	command.generation = ++sound_channel_states[channel].generation;
+	command.chunk = chunk;
+	command.params[0] = static_cast<float>(vol) / 255.f;
+	command.params[1] = static_cast<float>(sep) / 127.f - 1.f;
+	command.params[2] = pitch_to_rate(pitch);
+	post_audio_command(command);
 
 	return channel;
 }
 
 void I_StopSound(INT32 handle)
 {
-	SdlAudioLockHandle _;
-
 	if (sound_effect_channels.empty())
 		return;
 
@@ -321,13 +660,17 @@ void I_StopSound(INT32 handle)
 	if (index >= sound_effect_channels.size())
 		return;
 
-	sound_effect_channels[index]->reset();
+	AudioCommand command {};
+	command.type = AudioCommandType::kStopSound;
+	command.channel = index;
+	post_audio_command(command);
+
+	// The channel is free as far as the game is concerned, even before the callback gets to it
+	raise_finished_generation(sound_channel_states[index], sound_channel_states[index].generation);
 }
 
 boolean I_SoundIsPlaying(INT32 handle)
 {
-	SdlAudioLockHandle _;
-
 	// Handle is channel index
 	if (sound_effect_channels.empty())
 		return 0;
@@ -340,15 +683,11 @@ boolean I_SoundIsPlaying(INT32 handle)
 	if (index >= sound_effect_channels.size())
 		return 0;
 
-	return sound_effect_channels[index]->finished() ? 0 : 1;
+	return sound_channel_playing(index) ? 1 : 0;
 }
 
 void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
 {
-	(void) pitch;
-
-	SdlAudioLockHandle _;
-
 	if (sound_effect_channels.empty())
 		return;
 
@@ -360,34 +699,36 @@ void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
 	if (index >= sound_effect_channels.size())
 		return;
 
-	shared_ptr<SoundEffectPlayer>& channel = sound_effect_channels[index];
-	if (!channel->finished())
+	if (sound_channel_playing(index))
 	{
-		float vol_float = static_cast<float>(vol) / 255.f;
-		float sep_float = static_cast<float>(sep) / 127.f - 1.f;
-		channel->update(vol_float, sep_float);
+		AudioCommand command {};
+		command.type = AudioCommandType::kUpdateSound;
+		command.channel = index;
+		command.generation = sound_channel_states[index].generation;
+		command.params[0] = static_cast<float>(vol) / 255.f;
+		command.params[1] = static_cast<float>(sep) / 127.f - 1.f;
+		command.params[2] = pitch_to_rate(pitch);
+		post_audio_command(command);
 	}
 }
 
 void I_SetSfxVolume(int volume)
 {
-	SdlAudioLockHandle _;
 	float vol = static_cast<float>(volume) / 100.f;
 
 	if (gain_sound_effects)
 	{
-		gain_sound_effects->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
+		post_audio_command(AudioCommandType::kSfxVolume, std::clamp(vol * vol * vol, 0.f, 1.f));
 	}
 }
 
 void I_SetMasterVolume(int volume)
 {
-	SdlAudioLockHandle _;
 	float vol = static_cast<float>(volume) / 100.f;
 
 	if (master_gain)
 	{
-		master_gain->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
+		post_audio_command(AudioCommandType::kMasterVolume, std::clamp(vol * vol * vol, 0.f, 1.f));
 	}
 }
 
@@ -400,7 +741,7 @@ void I_InitMusic(void)
 	if (!sound_started)
 		initialize_sound();
 
-	SdlAudioLockHandle _;
+	SdlAudioSyncHandle _;
 
 	if (music_player != nullptr)
 		*music_player = audio::MusicPlayer();
@@ -408,7 +749,7 @@ void I_InitMusic(void)
 
 void I_ShutdownMusic(void)
 {
-	SdlAudioLockHandle _;
+	SdlAudioSyncHandle _;
 
 	if (music_player)
 		*music_player = audio::MusicPlayer();
@@ -423,7 +764,7 @@ const char* I_SongType(void)
 	if (!music_player)
 		return nullptr;
 
-	SdlAudioLockHandle _;
+	SdlAudioSyncHandle _;
 
 	std::optional<audio::MusicType> music_type = music_player->music_type();
 
@@ -448,7 +789,7 @@ boolean I_SongPlaying(void)
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
+	SdlAudioSyncHandle _;
 
 	return music_player->music_type().has_value();
 }
@@ -458,7 +799,7 @@ boolean I_SongPaused(void)
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
+	SdlAudioSyncHandle _;
 
 	return !music_player->playing();
 }
@@ -471,7 +812,7 @@ boolean I_SetSongSpeed(float speed)
 {
 	if (resample_music_player)
 	{
-		resample_music_player->ratio(speed);
+		post_audio_command(AudioCommandType::kSongSpeed, speed);
 		return true;
 	}
 
@@ -487,7 +828,7 @@ UINT32 I_GetSongLength(void)
 	if (!music_player)
 		return 0;
 
-	SdlAudioLockHandle _;
+	SdlAudioSyncHandle _;
 
 	std::optional<float> duration = music_player->duration_seconds();
 
@@ -502,7 +843,7 @@ boolean I_SetSongLoopPoint(UINT32 looppoint)
 	if (!music_player)
 		return 0;
 
-	SdlAudioLockHandle _;
+	SdlAudioSyncHandle _;
 
 	if (music_player->music_type() == audio::MusicType::kOgg)
 	{
@@ -518,7 +859,7 @@ UINT32 I_GetSongLoopPoint(void)
 	if (!music_player)
 		return 0;
 
-	SdlAudioLockHandle _;
+	SdlAudioSyncHandle _;
 
 	std::optional<float> loop_point_seconds = music_player->loop_point_seconds();
 
@@ -533,9 +874,7 @@ boolean I_SetSongPosition(UINT32 position)
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	music_player->seek(position / 1000.f);
+	post_audio_command(AudioCommandType::kSongPosition, position / 1000.f);
 	return true;
 }
 
@@ -544,7 +883,7 @@ UINT32 I_GetSongPosition(void)
 	if (!music_player)
 		return 0;
 
-	SdlAudioLockHandle _;
+	SdlAudioSyncHandle _;
 
 	std::optional<float> position_seconds = music_player->position_seconds();
 
@@ -612,29 +951,32 @@ boolean I_LoadSong(char* data, size_t len)
 		return false;
 	}
 
-	if (music_fade_callback && music_player->fading())
+	if (music_fade_callback && music_fading())
 	{
 		auto old_callback = music_fade_callback;
 		music_fade_callback = nullptr;
 		(old_callback)();
 	}
 
-	SdlAudioLockHandle _;
-
-	try
 	{
-		*music_player = std::move(new_player);
-	}
-	catch (const std::exception& ex)
-	{
-		print_ex(ex);
-		return false;
-	}
+		SdlAudioSyncHandle _;
 
-	if (gain_music_player)
-	{
-		// Reset song volume to 1.0 for newly loaded songs.
-		gain_music_player->gain(1.0);
+		try
+		{
+			// The outgoing song is destroyed after the lock is released
+			std::swap(*music_player, new_player);
+		}
+		catch (const std::exception& ex)
+		{
+			print_ex(ex);
+			return false;
+		}
+
+		if (gain_music_player)
+		{
+			// Reset song volume to 1.0 for newly loaded songs.
+			gain_music_player->gain(1.0);
+		}
 	}
 
 	return true;
@@ -645,16 +987,18 @@ void I_UnloadSong(void)
 	if (!music_player)
 		return;
 
-	if (music_fade_callback && music_player->fading())
+	if (music_fade_callback && music_fading())
 	{
 		auto old_callback = music_fade_callback;
 		music_fade_callback = nullptr;
 		(old_callback)();
 	}
 
-	SdlAudioLockHandle _;
+	audio::MusicPlayer old_player;
+
+	SdlAudioSyncHandle _;
 
-	*music_player = audio::MusicPlayer();
+	std::swap(*music_player, old_player);
 }
 
 boolean I_PlaySong(boolean looping)
@@ -662,9 +1006,10 @@ boolean I_PlaySong(boolean looping)
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	music_player->play(looping);
+	AudioCommand command {};
+	command.type = AudioCommandType::kPlaySong;
+	command.looping = looping;
+	post_audio_command(command);
 
 	return true;
 }
@@ -674,9 +1019,7 @@ void I_StopSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->stop();
+	post_audio_command(AudioCommandType::kStopSong);
 }
 
 void I_PauseSong(void)
@@ -684,9 +1027,7 @@ void I_PauseSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->pause();
+	post_audio_command(AudioCommandType::kPauseSong);
 }
 
 void I_ResumeSong(void)
@@ -694,9 +1035,7 @@ void I_ResumeSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->unpause();
+	post_audio_command(AudioCommandType::kResumeSong);
 }
 
 void I_SetMusicVolume(int volume)
@@ -707,7 +1046,7 @@ void I_SetMusicVolume(int volume)
 	{
 		// Music channel volume is interpreted as logarithmic rather than linear.
 		// We approximate by cubing the gain level so vol 50 roughly sounds half as loud.
-		gain_music_channel->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
+		post_audio_command(AudioCommandType::kMusicVolume, std::clamp(vol * vol * vol, 0.f, 1.f));
 	}
 }
 
@@ -718,7 +1057,7 @@ void I_SetCurrentSongVolume(int volume)
 	if (gain_music_player)
 	{
 		// However, different from music channel volume, musicdef volumes are explicitly linear.
-		gain_music_player->gain(std::max(vol, 0.f));
+		post_audio_command(AudioCommandType::kSongVolume, std::max(vol, 0.f));
 	}
 }
 
@@ -737,10 +1076,8 @@ void I_SetInternalMusicVolume(UINT8 volume)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
 	float gain = volume / 100.f;
-	music_player->internal_gain(gain);
+	post_audio_command(AudioCommandType::kInternalMusicVolume, gain);
 }
 
 void I_StopFadingSong(void)
@@ -748,9 +1085,7 @@ void I_StopFadingSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->stop_fade();
+	post_audio_command(AudioCommandType::kStopFade);
 }
 
 boolean I_FadeSongFromVolume(UINT8 target_volume, UINT8 source_volume, UINT32 ms, void (*callback)(void))
@@ -758,13 +1093,13 @@ boolean I_FadeSongFromVolume(UINT8 target_volume, UINT8 source_volume, UINT32 ms
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	float source_gain = source_volume / 100.f;
-	float target_gain = target_volume / 100.f;
-	float seconds = ms / 1000.f;
-
-	music_player->fade_from_to(source_gain, target_gain, seconds);
+	AudioCommand command {};
+	command.type = AudioCommandType::kFadeSongFrom;
+	command.params[0] = source_volume / 100.f;
+	command.params[1] = target_volume / 100.f;
+	command.params[2] = ms / 1000.f;
+	post_audio_command(command);
+	music_fade_sequence = audio_commands_posted;
 
 	if (music_fade_callback)
 		music_fade_callback();
@@ -778,12 +1113,12 @@ boolean I_FadeSong(UINT8 target_volume, UINT32 ms, void (*callback)(void))
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	float target_gain = target_volume / 100.f;
-	float seconds = ms / 1000.f;
-
-	music_player->fade_to(target_gain, seconds);
+	AudioCommand command {};
+	command.type = AudioCommandType::kFadeSong;
+	command.params[0] = target_volume / 100.f;
+	command.params[1] = ms / 1000.f;
+	post_audio_command(command);
+	music_fade_sequence = audio_commands_posted;
 
 	if (music_fade_callback)
 		music_fade_callback();
@@ -797,9 +1132,7 @@ static void stop_song_cb(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->stop();
+	post_audio_command(AudioCommandType::kStopSong);
 }
 
 boolean I_FadeOutStopSong(UINT32 ms)
@@ -42,76 +42,924 @@
 #endif
 
 #include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined (_WIN32)
+#define RPC_NO_WINDOWS_H
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#define HAVE_LUMPMAPPING
+#elif defined (__unix__) || defined (__APPLE__) || defined (__HAIKU__)
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+#define HAVE_LUMPMAPPING
+#define HAVE_PREAD
+#endif
 #include <cstddef>
 
-#include "doomdef.h"
-#include "doomstat.h"
-#include "doomtype.h"
+#include "doomdef.h"
+#include "doomstat.h"
+#include "doomtype.h"
+
+#include "w_wad.h"
+#include "z_zone.h"
+#include "fastcmp.h"
+
+#include "g_game.h" // G_LoadGameData
+#include "m_cond.h" // gamedata itself
+#include "filesrch.h"
+
+#include "i_video.h" // rendermode
+#include "d_netfil.h"
+#include "deh_soc.h"
+#include "d_clisrv.h"
+#include "r_defs.h"
+#include "r_data.h"
+#include "r_textures.h"
+#include "r_patch.h"
+#include "r_picformats.h"
+#include "i_time.h"
+#include "i_system.h"
+#include "md5.h"
+#include "lua_script.h"
+#include "d_main.h" // srb2home
+#include "core/memory.h"
+#include "core/thread_pool.h"
+#include "command.h"
+#include "m_argv.h"
+#include "g_game.h" // G_SetGameModified
+
+#include "k_terrain.h"
+
+#ifdef HWRENDER
+#include "hardware/hw_main.h"
+#include "hardware/hw_glob.h"
+#endif
+
+#ifdef _DEBUG
+#include "console.h"
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+
+typedef struct
+{
+	const char *name;
+	size_t len;
+} lumpchecklist_t;
+
+// Must be a power of two
+#define LUMPNUMCACHESIZE 64
+#define LUMPNUMCACHENAME 32
+
+typedef struct lumpnum_cache_s
+{
+	char lumpname[LUMPNUMCACHENAME];
+	UINT32 lumphash;
+	lumpnum_t lumpnum;
+} lumpnum_cache_t;
+
+static lumpnum_cache_t lumpnumcache[LUMPNUMCACHESIZE];
+static UINT16 lumpnumcacheindex = 0;
+
+//===========================================================================
+//                                                                    GLOBALS
+//===========================================================================
+UINT16 numwadfiles = 0; // number of active wadfiles
+wadfile_t *wadfiles[MAX_WADFILES]; // 0 to numwadfiles-1 are valid
+
+//===========================================================================
+//                                                           LUMP NAME INDEX
+//===========================================================================
+
+// Each wad gets name lookup tables when it is added, so the *Pwad searches
+// don't have to walk every lump. The open-addressing tables map a name to the
+// lowest lump carrying it, and lumps sharing a name are chained in ascending
+// order, so searches with a 'startlump' still find the first match at or
+// after it. Full PK3 paths are looked up by prefix, which a hash can't do;
+// those use an array of lumps sorted by path instead.
+
+#define LUMPINDEXEMPTY UINT16_MAX
+
+struct lumpnametable_t
+{
+	UINT32 *hashes;
+	UINT16 *heads; // first lump with this name, LUMPINDEXEMPTY for a free slot
+	UINT16 *next;  // per lump: next lump with the same name
+};
+
+struct lumpindex_t
+{
+	UINT32 mask; // table size - 1
+	lumpnametable_t shortnames;
+	lumpnametable_t longnames;
+	UINT16 *fullsorted; // every lump, ordered by fullname
+};
+
+static std::chrono::steady_clock::duration lumpindexbuildtime {}; // every index built so far
+
+static inline UINT32 W_LumpIndexSlot(UINT32 hash)
+{
+	// quickncasehash is weak in the low bits, stir it before masking
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3b;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+static inline UINT32 W_LongNameHash(const char *name)
+{
+	return quickncasehash(name, strlen(name));
+}
+
+static boolean W_LumpIndexNameMatch(const lumpinfo_t *lump_p, const char *name, boolean longname)
+{
+	if (longname)
+		return !strcasecmp(lump_p->longname, name);
+	return !strncasecmp(lump_p->name, name, 8);
+}
+
+static UINT16 W_LumpIndexHead(const lumpindex_t *index, const lumpnametable_t *table, const lumpinfo_t *lumpinfo, const char *name, UINT32 hash, boolean longname)
+{
+	UINT32 slot;
+
+	for (slot = W_LumpIndexSlot(hash) & index->mask;
+		table->heads[slot] != LUMPINDEXEMPTY;
+		slot = (slot + 1) & index->mask)
+	{
+		if (table->hashes[slot] == hash && W_LumpIndexNameMatch(&lumpinfo[table->heads[slot]], name, longname))
+			return table->heads[slot];
+	}
+
+	return LUMPINDEXEMPTY;
+}
+
+static void W_LumpIndexInsert(lumpindex_t *index, lumpnametable_t *table, const lumpinfo_t *lumpinfo, UINT16 lump, const char *name, UINT32 hash, boolean longname)
+{
+	UINT32 slot;
+
+	for (slot = W_LumpIndexSlot(hash) & index->mask;
+		table->heads[slot] != LUMPINDEXEMPTY;
+		slot = (slot + 1) & index->mask)
+	{
+		if (table->hashes[slot] == hash && W_LumpIndexNameMatch(&lumpinfo[table->heads[slot]], name, longname))
+			break;
+	}
+
+	// Lumps are inserted back to front, so the head is always the lowest
+	table->next[lump] = table->heads[slot];
+	table->heads[slot] = lump;
+	table->hashes[slot] = hash;
+}
+
+static lumpindex_t *W_BuildLumpIndex(const lumpinfo_t *lumpinfo, UINT16 numlumps)
+{
+	lumpindex_t *index;
+	UINT32 tablesize = 16;
+	auto start = std::chrono::steady_clock::now();
+	INT32 i;
+
+	while (tablesize < 2u * numlumps)
+		tablesize <<= 1;
+
+	index = static_cast<lumpindex_t*>(Z_Malloc(sizeof (*index), PU_STATIC, NULL));
+	index->mask = tablesize - 1;
+
+	index->shortnames.hashes = static_cast<UINT32*>(Z_Malloc(tablesize * sizeof (UINT32), PU_STATIC, NULL));
+	index->shortnames.heads = static_cast<UINT16*>(Z_Malloc(tablesize * sizeof (UINT16), PU_STATIC, NULL));
+	index->shortnames.next = static_cast<UINT16*>(Z_Malloc((numlumps + 1) * sizeof (UINT16), PU_STATIC, NULL));
+	index->longnames.hashes = static_cast<UINT32*>(Z_Malloc(tablesize * sizeof (UINT32), PU_STATIC, NULL));
+	index->longnames.heads = static_cast<UINT16*>(Z_Malloc(tablesize * sizeof (UINT16), PU_STATIC, NULL));
+	index->longnames.next = static_cast<UINT16*>(Z_Malloc((numlumps + 1) * sizeof (UINT16), PU_STATIC, NULL));
+	index->fullsorted = static_cast<UINT16*>(Z_Malloc((numlumps + 1) * sizeof (UINT16), PU_STATIC, NULL));
+
+	memset(index->shortnames.heads, 0xFF, tablesize * sizeof (UINT16));
+	memset(index->longnames.heads, 0xFF, tablesize * sizeof (UINT16));
+
+	for (i = numlumps - 1; i >= 0; i--)
+	{
+		const lumpinfo_t *lump_p = &lumpinfo[i];
+		W_LumpIndexInsert(index, &index->shortnames, lumpinfo, (UINT16)i, lump_p->name, quickncasehash(lump_p->name, 8), false);
+		W_LumpIndexInsert(index, &index->longnames, lumpinfo, (UINT16)i, lump_p->longname, W_LongNameHash(lump_p->longname), true);
+		index->fullsorted[i] = (UINT16)i;
+	}
+
+	std::stable_sort(index->fullsorted, index->fullsorted + numlumps, [lumpinfo](UINT16 a, UINT16 b)
+	{
+		return strcasecmp(lumpinfo[a].fullname, lumpinfo[b].fullname) < 0;
+	});
+
+	lumpindexbuildtime += std::chrono::steady_clock::now() - start;
+
+	return index;
+}
+
+static void W_FreeLumpIndex(lumpindex_t *index)
+{
+	if (index == NULL)
+		return;
+
+	Z_Free(index->shortnames.hashes);
+	Z_Free(index->shortnames.heads);
+	Z_Free(index->shortnames.next);
+	Z_Free(index->longnames.hashes);
+	Z_Free(index->longnames.heads);
+	Z_Free(index->longnames.next);
+	Z_Free(index->fullsorted);
+	Z_Free(index);
+}
+
+// Lowest lump at or after startlump whose fullname starts with name, or LUMPINDEXEMPTY
+static UINT16 W_LumpIndexFindPrefix(const wadfile_t *wad, const char *name, UINT16 startlump)
+{
+	const lumpinfo_t *lumpinfo = wad->lumpinfo;
+	const UINT16 *begin = wad->lumpindex->fullsorted;
+	const UINT16 *end = begin + wad->numlumps;
+	const size_t name_length = strlen(name);
+	const UINT16 *it;
+	UINT16 found = LUMPINDEXEMPTY;
+
+	// Every path starting with name sorts at or after it, and they sort together
+	it = std::lower_bound(begin, end, name, [lumpinfo](UINT16 lump, const char *key)
+	{
+		return strcasecmp(lumpinfo[lump].fullname, key) < 0;
+	});
+
+	for (; it != end && !strnicmp(name, lumpinfo[*it].fullname, name_length); it++)
+	{
+		if (*it >= startlump && *it < found)
+			found = *it;
+	}
+
+	return found;
+}
+
+//===========================================================================
+//                                                              FILE MAPPING
+//===========================================================================
+
+// Where the platform allows it, each resource file is mapped read-only when it
+// is added. Stored lumps can then be handed out as views straight into the
+// mapping (W_LumpViewPwad), and compressed ones are inflated from it without
+// an intermediate copy. Without a mapping, lumps are read with positioned
+// reads instead of seeking the shared FILE *, so any thread can read lumps.
+
+#if !defined (HAVE_PREAD) && !defined (_WIN32)
+static std::mutex wadreadmutex; // guards the FILE * position when nothing better exists
+#endif
+
+// Maps size bytes of an open file read-only, returns NULL if that isn't possible
+static const UINT8 *W_MapHandle(FILE *handle, size_t size, void **mappinghandle)
+{
+	*mappinghandle = NULL;
+
+	if (!size)
+		return NULL;
+
+#if defined (_WIN32)
+	{
+		HANDLE file = (HANDLE)_get_osfhandle(_fileno(handle));
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		void *view;
+
+		if (mapping == NULL)
+			return NULL;
+
+		view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == NULL)
+		{
+			CloseHandle(mapping);
+			return NULL;
+		}
+
+		*mappinghandle = mapping;
+		return static_cast<const UINT8*>(view);
+	}
+#elif defined (HAVE_LUMPMAPPING)
+	{
+		// May fail on 32-bit address spaces for huge files; then we just read instead
+		void *view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(handle), 0);
+
+		if (view == MAP_FAILED)
+			return NULL;
+
+		return static_cast<const UINT8*>(view);
+	}
+#else
+	(void)handle;
+	return NULL;
+#endif
+}
+
+static void W_UnmapHandle(const UINT8 *view, size_t size, void *mappinghandle)
+{
+	if (view == NULL)
+		return;
+
+#if defined (_WIN32)
+	(void)size;
+	UnmapViewOfFile(view);
+	CloseHandle(static_cast<HANDLE>(mappinghandle));
+#elif defined (HAVE_LUMPMAPPING)
+	(void)mappinghandle;
+	munmap(const_cast<UINT8*>(view), size);
+#endif
+}
+
+static void W_MapFile(wadfile_t *wad)
+{
+	wad->mapping = NULL;
+	wad->mappinghandle = NULL;
+
+	if (M_CheckParm("-nommap"))
+		return;
+
+	wad->mapping = W_MapHandle(wad->handle, wad->filesize, &wad->mappinghandle);
+}
+
+static void W_UnmapFile(wadfile_t *wad)
+{
+	W_UnmapHandle(wad->mapping, wad->filesize, wad->mappinghandle);
+	wad->mapping = NULL;
+	wad->mappinghandle = NULL;
+}
+
+// Reads size bytes at position from the file, returns how many were actually read
+static size_t W_ReadFileAt(const wadfile_t *wad, void *dest, size_t size, unsigned long position)
+{
+	size_t total = 0;
+
+	if (wad->mapping)
+	{
+		if (position >= wad->filesize)
+			return 0;
+
+		size = std::min<size_t>(size, wad->filesize - position);
+		M_Memcpy(dest, wad->mapping + position, size);
+		return size;
+	}
+
+#if defined (_WIN32)
+	{
+		HANDLE file = (HANDLE)_get_osfhandle(_fileno(wad->handle));
+
+		while (total < size)
+		{
+			OVERLAPPED overlapped = {};
+			DWORD chunk = static_cast<DWORD>(std::min<size_t>(size - total, 1u << 30));
+			DWORD got = 0;
+
+			overlapped.Offset = static_cast<DWORD>(position + total);
+			if (!ReadFile(file, static_cast<UINT8*>(dest) + total, chunk, &got, &overlapped) || got == 0)
+				break;
+			total += got;
+		}
+	}
+#elif defined (HAVE_PREAD)
+	{
+		int fd = fileno(wad->handle);
+
+		while (total < size)
+		{
+			ssize_t got = pread(fd, static_cast<UINT8*>(dest) + total, size - total, static_cast<off_t>(position + total));
+
+			if (got < 0 && errno == EINTR)
+				continue;
+			if (got <= 0)
+				break;
+			total += static_cast<size_t>(got);
+		}
+	}
+#else
+	{
+		std::lock_guard<std::mutex> lock(wadreadmutex);
+
+		if (fseek(wad->handle, (long)position, SEEK_SET) == 0)
+			total = fread(dest, 1, size, wad->handle);
+	}
+#endif
+
+	return total;
+}
+
+//===========================================================================
+//                                                    DEFLATE PREFETCH/CACHE
+//===========================================================================
+
+// Inflating is the slow part of caching a PK3 lump, and a lump purged from
+// PU_CACHE gets inflated all over again. Two things keep that off the main
+// thread at the point of use:
+//  - W_PrefetchLumpNum queues lumps to be inflated on the thread pool ahead
+//    of time, and the next read of each lump takes the finished copy.
+//  - With -lumpcache, every deflate lump of a PK3 is inflated once in the
+//    background into a pack under srb2home/cache, named after the file's
+//    MD5. Later launches map the pack and never inflate those lumps again.
+
+#ifdef HAVE_ZLIB
+
+enum
+{
+	PREFETCH_IDLE,
+	PREFETCH_QUEUED,
+	PREFETCH_RUNNING,
+	PREFETCH_READY,
+	PREFETCH_TAKING, // claimed out of READY by one reader, IDLE again once the buffer is freed
+};
+
+#define PREFETCHBUDGET (64<<20) // inflated bytes allowed to wait for their reader
+
+#define LUMPPACKMAGIC "RRLP"
+#define LUMPPACKVERSION 1
+
+// The pack is only ever read by the machine that wrote it, so it's in native byte order.
+struct lumppackheader_t
+{
+	char magic[4];
+	UINT32 version;
+	UINT32 numlumps;
+	UINT32 reserved;
+};
+
+struct lumppackentry_t
+{
+	UINT32 offset; // from the start of the pack, 0 if the lump isn't in it
+	UINT32 size;
+};
+
+struct lumpprefetch_t
+{
+	std::unique_ptr<std::atomic<UINT8>[]> state;
+	std::unique_ptr<std::atomic<UINT8*>[]> data;
+
+	// -lumpcache pack, mapped read-only
+	FILE *packhandle = NULL;
+	const UINT8 *pack = NULL;
+	size_t packsize = 0;
+	void *packmapping = NULL;
+	const lumppackentry_t *packentries = NULL;
+
+	std::thread packbuilder;
+	std::atomic<bool> cancel {false};
+};
+
+static std::atomic<size_t> prefetchbytes {0};
+
+// Inflates the start of a deflate lump into dest, which holds size bytes.
+// Safe on any thread. Returns the zlib result, or Z_ERRNO if the compressed data couldn't be read.
+static int W_InflateLump(const wadfile_t *wadfile, const lumpinfo_t *l, UINT8 *dest, size_t size)
+{
+	const UINT8 *rawData; // The lump's raw data.
+	UINT8 *rawCopy = NULL; // Our own copy of it, when the file isn't mapped.
+	unsigned long rawSize = l->disksize;
+	z_stream strm;
+	int zErr;
+	srb2::ArenaScope arena;
+
+	if (wadfile->mapping && l->position + rawSize <= wadfile->filesize)
+		rawData = wadfile->mapping + l->position;
+	else
+	{
+		rawCopy = static_cast<UINT8*>(Z_Arena_Alloc(rawSize));
+		if (!rawCopy || W_ReadFileAt(wadfile, rawCopy, rawSize, l->position) < rawSize)
+		{
+			return Z_ERRNO;
+		}
+		rawData = rawCopy;
+	}
+
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+
+	strm.total_in = strm.avail_in = rawSize;
+	strm.total_out = strm.avail_out = size;
+
+	strm.next_in = const_cast<UINT8*>(rawData); // zlib never writes through next_in
+	strm.next_out = dest;
+
+	zErr = inflateInit2(&strm, -15);
+	if (zErr == Z_OK)
+	{
+		zErr = inflate(&strm, Z_SYNC_FLUSH);
+		(void)inflateEnd(&strm);
+	}
+
+	return zErr;
+}
+
+static void W_PrefetchTask(const wadfile_t *wadfile, UINT16 lump)
+{
+	lumpprefetch_t *prefetch = wadfile->prefetch;
+	const lumpinfo_t *l = &wadfile->lumpinfo[lump];
+	UINT8 state = PREFETCH_QUEUED;
+	UINT8 *buffer;
+	int zErr;
+
+	// The reader got here first and took the lump back
+	if (!prefetch->state[lump].compare_exchange_strong(state, PREFETCH_RUNNING, std::memory_order_acq_rel))
+		return;
+
+	buffer = static_cast<UINT8*>(malloc(l->size));
+	zErr = buffer ? W_InflateLump(wadfile, l, buffer, l->size) : Z_MEM_ERROR;
+
+	if (zErr == Z_OK || zErr == Z_STREAM_END)
+	{
+		prefetch->data[lump].store(buffer, std::memory_order_relaxed);
+		prefetch->state[lump].store(PREFETCH_READY, std::memory_order_release);
+	}
+	else
+	{
+		// Leave it to the reader, which reports the error on the main thread
+		free(buffer);
+		prefetchbytes.fetch_sub(l->size, std::memory_order_relaxed);
+		prefetch->state[lump].store(PREFETCH_IDLE, std::memory_order_release);
+	}
+}
+
+// Copies an already inflated lump out of the pack or the prefetcher, if either has it
+static boolean W_ReadInflatedLump(const wadfile_t *wadfile, UINT16 lump, void *dest, size_t size, size_t offset)
+{
+	lumpprefetch_t *prefetch = wadfile->prefetch;
+	const lumpinfo_t *l = &wadfile->lumpinfo[lump];
+
+	if (prefetch == NULL)
+		return false;
+
+	if (prefetch->packentries && prefetch->packentries[lump].offset)
+	{
+		M_Memcpy(dest, prefetch->pack + prefetch->packentries[lump].offset + offset, size);
+		return true;
+	}
+
+	for (;;)
+	{
+		UINT8 state = prefetch->state[lump].load(std::memory_order_acquire);
+
+		switch (state)
+		{
+			case PREFETCH_IDLE:
+				return false;
+
+			case PREFETCH_QUEUED:
+				// Not started yet, cheaper to inflate it ourselves than to wait in line
+				if (prefetch->state[lump].compare_exchange_strong(state, PREFETCH_IDLE, std::memory_order_acq_rel))
+				{
+					prefetchbytes.fetch_sub(l->size, std::memory_order_relaxed);
+					return false;
+				}
+				break;
+
+			case PREFETCH_RUNNING:
+				std::this_thread::yield();
+				break;
+
+			case PREFETCH_READY:
+			{
+				UINT8 *buffer;
+				boolean taken;
+
+				// Readers on other threads and W_DropPrefetchedLumps may want it too
+				if (!prefetch->state[lump].compare_exchange_strong(state, PREFETCH_TAKING, std::memory_order_acq_rel))
+					break;
+
+				buffer = prefetch->data[lump].exchange(NULL, std::memory_order_relaxed);
+				taken = (buffer != NULL);
+				if (taken)
+					M_Memcpy(dest, buffer + offset, size);
+				free(buffer);
+				prefetchbytes.fetch_sub(l->size, std::memory_order_relaxed);
+				prefetch->state[lump].store(PREFETCH_IDLE, std::memory_order_release);
+				return taken;
+			}
+
+			default:
+				// Someone else is taking it, read it ourselves
+				return false;
+		}
+	}
+}
+
+// Checks the pack against the file it was made from, then keeps it mapped
+static boolean W_OpenLumpPack(wadfile_t *wadfile, const char *path)
+{
+	lumpprefetch_t *prefetch = wadfile->prefetch;
+	const lumppackheader_t *header;
+	const lumppackentry_t *entries;
+	FILE *handle = fopen(path, "rb");
+	size_t size;
+	void *mapping;
+	const UINT8 *pack;
+	UINT16 i;
+
+	if (handle == NULL)
+		return false;
+
+	fseek(handle, 0, SEEK_END);
+	size = (size_t)ftell(handle);
+	pack = W_MapHandle(handle, size, &mapping);
+
+	if (pack == NULL)
+	{
+		fclose(handle);
+		return false;
+	}
+
+	header = reinterpret_cast<const lumppackheader_t*>(pack);
+	entries = reinterpret_cast<const lumppackentry_t*>(pack + sizeof (*header));
+
+	if (size < sizeof (*header)
+		|| memcmp(header->magic, LUMPPACKMAGIC, 4)
+		|| header->version != LUMPPACKVERSION
+		|| header->numlumps != wadfile->numlumps
+		|| size < sizeof (*header) + wadfile->numlumps * sizeof (*entries))
+	{
+		goto invalid;
+	}
+
+	for (i = 0; i < wadfile->numlumps; i++)
+	{
+		const lumpinfo_t *l = &wadfile->lumpinfo[i];
+
+		if (!entries[i].offset)
+			continue;
+
+		if (l->compression != CM_DEFLATE
+			|| entries[i].size != l->size
+			|| (size_t)entries[i].offset + entries[i].size > size)
+		{
+			goto invalid;
+		}
+	}
+
+	prefetch->packhandle = handle;
+	prefetch->pack = pack;
+	prefetch->packsize = size;
+	prefetch->packmapping = mapping;
+	prefetch->packentries = entries;
+	return true;
+
+invalid:
+	W_UnmapHandle(pack, size, mapping);
+	fclose(handle);
+	return false;
+}
+
+// Runs on its own thread, so that the pool's workers stay free for short jobs
+static void W_BuildLumpPack(wadfile_t *wadfile, std::string path)
+{
+	lumpprefetch_t *prefetch = wadfile->prefetch;
+	std::string temppath = path + ".tmp";
+	std::vector<lumppackentry_t> entries(wadfile->numlumps);
+	std::vector<UINT8> buffer;
+	lumppackheader_t header = {};
+	UINT64 position = sizeof (header) + entries.size() * sizeof (lumppackentry_t);
+	boolean ok = true;
+	FILE *handle = fopen(temppath.c_str(), "wb");
+	UINT16 i;
+
+	if (handle == NULL)
+		return;
+
+	memcpy(header.magic, LUMPPACKMAGIC, 4);
+	header.version = LUMPPACKVERSION;
+	header.numlumps = wadfile->numlumps;
+
+	// The table is written again once the offsets are known
+	if (fwrite(&header, sizeof (header), 1, handle) != 1
+		|| fwrite(entries.data(), sizeof (lumppackentry_t), entries.size(), handle) != entries.size())
+	{
+		ok = false;
+	}
+
+	for (i = 0; ok && i < wadfile->numlumps; i++)
+	{
+		const lumpinfo_t *l = &wadfile->lumpinfo[i];
+		int zErr;
+
+		if (prefetch->cancel.load(std::memory_order_relaxed))
+		{
+			ok = false;
+			break;
+		}
+
+		if (l->compression != CM_DEFLATE || !l->size)
+			continue;
+
+		// Offsets are 32-bit; whatever doesn't fit just keeps being inflated
+		if (position + l->size > UINT32_MAX)
+			break;
+
+		buffer.resize(l->size);
+		zErr = W_InflateLump(wadfile, l, buffer.data(), l->size);
+		if (zErr != Z_OK && zErr != Z_STREAM_END)
+			continue;
+
+		if (fwrite(buffer.data(), 1, l->size, handle) != l->size)
+		{
+			ok = false;
+			break;
+		}
+
+		entries[i].offset = (UINT32)position;
+		entries[i].size = (UINT32)l->size;
+		position += l->size;
+	}
+
+	if (ok)
+	{
+		ok = (fseek(handle, sizeof (header), SEEK_SET) == 0
+			&& fwrite(entries.data(), sizeof (lumppackentry_t), entries.size(), handle) == entries.size());
+	}
+
+	if (fclose(handle) != 0)
+		ok = false;
+
+	if (ok)
+	{
+		remove(path.c_str());
+		ok = (rename(temppath.c_str(), path.c_str()) == 0);
+	}
+
+	if (!ok)
+		remove(temppath.c_str());
+}
+
+static lumpprefetch_t *W_InitLumpPrefetch(wadfile_t *wadfile)
+{
+	lumpprefetch_t *prefetch;
+	UINT16 i;
+
+	for (i = 0; i < wadfile->numlumps; i++)
+	{
+		if (wadfile->lumpinfo[i].compression == CM_DEFLATE)
+			break;
+	}
+
+	// Nothing to inflate
+	if (i == wadfile->numlumps)
+		return NULL;
+
+	prefetch = new lumpprefetch_t;
+	prefetch->state = std::make_unique<std::atomic<UINT8>[]>(wadfile->numlumps);
+	prefetch->data = std::make_unique<std::atomic<UINT8*>[]>(wadfile->numlumps);
+	wadfile->prefetch = prefetch;
+
+	if (M_CheckParm("-lumpcache") && wadfile->type == RET_PK3 && wadfile->mapping)
+	{
+		char dir[MAX_WADPATH];
+		char path[MAX_WADPATH];
+		char md5[33];
+
+		for (i = 0; i < 16; i++)
+			sprintf(&md5[i*2], "%02x", wadfile->md5sum[i]);
+
+		snprintf(dir, sizeof dir, "%s" PATHSEP "cache", srb2home);
+		snprintf(path, sizeof path, "%s" PATHSEP "%s.lmp", dir, md5);
+
+		if (W_OpenLumpPack(wadfile, path))
+		{
+			CONS_Printf(M_GetText("Using inflated lump cache %s\n"), path);
+		}
+		else
+		{
+			I_mkdir(dir, 0755);
+			prefetch->packbuilder = std::thread(W_BuildLumpPack, wadfile, std::string(path));
+		}
+	}
+
+	return prefetch;
+}
+
+static void W_ShutdownLumpPrefetch(wadfile_t *wadfile)
+{
+	lumpprefetch_t *prefetch = wadfile->prefetch;
+	UINT16 i;
+
+	if (prefetch == NULL)
+		return;
 
-#include "w_wad.h"
-#include "z_zone.h"
-#include "fastcmp.h"
+	if (prefetch->packbuilder.joinable())
+	{
+		prefetch->cancel.store(true, std::memory_order_relaxed);
+		prefetch->packbuilder.join();
+	}
 
-#include "g_game.h" // G_LoadGameData
-#include "m_cond.h" // gamedata itself
-#include "filesrch.h"
+	if (prefetch->pack)
+	{
+		W_UnmapHandle(prefetch->pack, prefetch->packsize, prefetch->packmapping);
+		fclose(prefetch->packhandle);
+	}
 
-#include "i_video.h" // rendermode
-#include "d_netfil.h"
-#include "deh_soc.h"
-#include "d_clisrv.h"
-#include "r_defs.h"
-#include "r_data.h"
-#include "r_textures.h"
-#include "r_patch.h"
-#include "r_picformats.h"
-#include "i_time.h"
-#include "i_system.h"
-#include "md5.h"
-#include "lua_script.h"
-#include "g_game.h" // G_SetGameModified
+	// The pool has been shut down by now, so nothing is still running
+	for (i = 0; i < wadfile->numlumps; i++)
+		free(prefetch->data[i].load(std::memory_order_relaxed));
 
-#include "k_terrain.h"
+	delete prefetch;
+	wadfile->prefetch = NULL;
+}
 
-#ifdef HWRENDER
-#include "hardware/hw_main.h"
-#include "hardware/hw_glob.h"
-#endif
+#endif // HAVE_ZLIB
 
-#ifdef _DEBUG
-#include "console.h"
-#endif
+void W_DropPrefetchedLumps(void)
+{
+#ifdef HAVE_ZLIB
+	UINT16 wad, lump;
 
-#ifndef O_BINARY
-#define O_BINARY 0
-#endif
+	for (wad = 0; wad < numwadfiles; wad++)
+	{
+		lumpprefetch_t *prefetch = wadfiles[wad]->prefetch;
 
+		if (prefetch == NULL)
+			continue;
 
-typedef struct
-{
-	const char *name;
-	size_t len;
-} lumpchecklist_t;
+		for (lump = 0; lump < wadfiles[wad]->numlumps; lump++)
+		{
+			UINT8 state = prefetch->state[lump].load(std::memory_order_acquire);
 
-// Must be a power of two
-#define LUMPNUMCACHESIZE 64
-#define LUMPNUMCACHENAME 32
+			// Running ones are left to finish; they're dropped next time if still unread
+			if (state == PREFETCH_QUEUED)
+			{
+				if (!prefetch->state[lump].compare_exchange_strong(state, PREFETCH_IDLE, std::memory_order_acq_rel))
+					continue;
+			}
+			else if (state == PREFETCH_READY)
+			{
+				if (!prefetch->state[lump].compare_exchange_strong(state, PREFETCH_TAKING, std::memory_order_acq_rel))
+					continue;
 
-typedef struct lumpnum_cache_s
+				free(prefetch->data[lump].exchange(NULL, std::memory_order_relaxed));
+				prefetch->state[lump].store(PREFETCH_IDLE, std::memory_order_release);
+			}
+			else
+				continue;
+
+			prefetchbytes.fetch_sub(wadfiles[wad]->lumpinfo[lump].size, std::memory_order_relaxed);
+		}
+	}
+#endif
+}
+
+void W_PrefetchLumpNum(lumpnum_t lumpnum)
 {
-	char lumpname[LUMPNUMCACHENAME];
-	UINT32 lumphash;
-	lumpnum_t lumpnum;
-} lumpnum_cache_t;
+#ifdef HAVE_ZLIB
+	UINT16 wad = WADFILENUM(lumpnum);
+	UINT16 lump = LUMPNUM(lumpnum);
+	const wadfile_t *wadfile;
+	lumpprefetch_t *prefetch;
+	const lumpinfo_t *l;
+	UINT8 state = PREFETCH_IDLE;
+
+	if (wad >= numwadfiles || lump >= wadfiles[wad]->numlumps)
+		return;
 
-static lumpnum_cache_t lumpnumcache[LUMPNUMCACHESIZE];
-static UINT16 lumpnumcacheindex = 0;
+	wadfile = wadfiles[wad];
+	prefetch = wadfile->prefetch;
+	l = &wadfile->lumpinfo[lump];
 
-//===========================================================================
-//                                                                    GLOBALS
-//===========================================================================
-UINT16 numwadfiles = 0; // number of active wadfiles
-wadfile_t *wadfiles[MAX_WADFILES]; // 0 to numwadfiles-1 are valid
+	if (prefetch == NULL || l->compression != CM_DEFLATE || !l->size)
+		return;
+
+	// Only worth it with threads to spare
+	if (!srb2::g_main_threadpool || srb2::g_main_threadpool->worker_count() <= 1)
+		return;
+
+	// Already free to read?
+	if ((prefetch->packentries && prefetch->packentries[lump].offset)
+		|| wadfile->lumpcache[lump] || wadfile->patchcache[lump])
+	{
+		return;
+	}
+
+	if (prefetchbytes.load(std::memory_order_relaxed) + l->size > PREFETCHBUDGET)
+		return;
+
+	if (!prefetch->state[lump].compare_exchange_strong(state, PREFETCH_QUEUED, std::memory_order_acq_rel))
+		return;
+
+	prefetchbytes.fetch_add(l->size, std::memory_order_relaxed);
+	srb2::g_main_threadpool->schedule([wadfile, lump]() { W_PrefetchTask(wadfile, lump); });
+#else
+	(void)lumpnum;
+#endif
+}
+
+void W_StartPrefetch(void)
+{
+#ifdef HAVE_ZLIB
+	if (srb2::g_main_threadpool)
+		srb2::g_main_threadpool->notify();
+#endif
+}
 
 // W_Shutdown
 // Closes all of the WAD files before quitting
@@ -124,6 +972,10 @@ void W_Shutdown(void)
 	{
 		wadfile_t *wad = wadfiles[numwadfiles];
 
+#ifdef HAVE_ZLIB
+		W_ShutdownLumpPrefetch(wad);
+#endif
+		W_UnmapFile(wad);
 		fclose(wad->handle);
 		Z_Free(wad->filename);
 		while (wad->numlumps--)
@@ -135,6 +987,7 @@ void W_Shutdown(void)
 			}
 		}
 
+		W_FreeLumpIndex(wad->lumpindex);
 		Z_Free(wad->lumpinfo);
 		Z_Free(wad);
 	}
@@ -905,6 +1758,8 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	fseek(handle, 0, SEEK_END);
 	wadfile->filesize = (unsigned)ftell(handle);
 	wadfile->type = type;
+	W_MapFile(wadfile);
+	wadfile->prefetch = NULL;
 
 	// already generated, just copy it over
 	M_Memcpy(&wadfile->md5sum, &md5sum, 16);
@@ -915,6 +1770,18 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	Z_Calloc(numlumps * sizeof (*wadfile->lumpcache), PU_STATIC, &wadfile->lumpcache);
 	Z_Calloc(numlumps * sizeof (*wadfile->patchcache), PU_STATIC, &wadfile->patchcache);
 
+	//
+	// index the lump names for the lookups below
+	//
+	wadfile->lumpindex = W_BuildLumpIndex(lumpinfo, wadfile->numlumps);
+
+#ifdef HAVE_ZLIB
+	//
+	// set up background inflating, and the inflated lump cache
+	//
+	W_InitLumpPrefetch(wadfile);
+#endif
+
 	//
 	// add the wadfile
 	//
@@ -1074,8 +1941,15 @@ UINT16 W_CheckNumForMapPwad(const char *name, UINT32 hash, UINT16 wad, UINT16 st
 
 	if (wadfiles[wad]->type == RET_WAD)
 	{
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++)
+		const lumpindex_t *index = wadfiles[wad]->lumpindex;
+
+		for (i = W_LumpIndexHead(index, &index->longnames, wadfiles[wad]->lumpinfo, name, W_LongNameHash(name), true);
+			i != LUMPINDEXEMPTY;
+			i = index->longnames.next[i])
 		{
+			if (i < startlump)
+				continue;
+
 			// Not the hash?
 			if ((wadfiles[wad]->lumpinfo + i)->hash != hash)
 				continue;
@@ -1144,12 +2018,15 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	//
 	if (startlump < wadfiles[wad]->numlumps)
 	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
+		const lumpindex_t *index = wadfiles[wad]->lumpindex;
+		for (i = W_LumpIndexHead(index, &index->shortnames, wadfiles[wad]->lumpinfo, name, hash, false);
+			i != LUMPINDEXEMPTY;
+			i = index->shortnames.next[i])
 		{
-			if (lump_p->hash != hash)
+			if (i < startlump)
 				continue;
-			if (strncasecmp(lump_p->name, name, 8))
+			// WADNAME lumps take their hash from the long name
+			if (wadfiles[wad]->lumpinfo[i].hash != hash)
 				continue;
 			return i;
 		}
@@ -1180,12 +2057,14 @@ UINT16 W_CheckNumForLongNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	//
 	if (startlump < wadfiles[wad]->numlumps)
 	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
+		const lumpindex_t *index = wadfiles[wad]->lumpindex;
+		for (i = W_LumpIndexHead(index, &index->longnames, wadfiles[wad]->lumpinfo, name, W_LongNameHash(name), true);
+			i != LUMPINDEXEMPTY;
+			i = index->longnames.next[i])
 		{
-			if (lump_p->hash != hash)
+			if (i < startlump)
 				continue;
-			if (strcasecmp(lump_p->longname, name))
+			if (wadfiles[wad]->lumpinfo[i].hash != hash)
 				continue;
 			return i;
 		}
@@ -1208,20 +2087,15 @@ W_CheckNumForMarkerStartPwad (const char *name, UINT16 wad, UINT16 startlump)
 // Look for the first lump from a folder.
 UINT16 W_CheckNumForFolderStartPK3(const char *name, UINT16 wad, UINT16 startlump)
 {
-	size_t name_length;
-	INT32 i;
-	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-	name_length = strlen(name);
-	for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-	{
-		if (strnicmp(name, lump_p->fullname, name_length) == 0)
-		{
-			/* SLADE is special and puts a single directory entry. Skip that. */
-			if (strlen(lump_p->fullname) == name_length)
-				i++;
-			break;
-		}
-	}
+	UINT16 i = W_LumpIndexFindPrefix(wadfiles[wad], name, startlump);
+
+	if (i == LUMPINDEXEMPTY)
+		return std::max(startlump, wadfiles[wad]->numlumps);
+
+	/* SLADE is special and puts a single directory entry. Skip that. */
+	if (strlen(wadfiles[wad]->lumpinfo[i].fullname) == strlen(name))
+		i++;
+
 	return i;
 }
 
@@ -1244,17 +2118,13 @@ UINT16 W_CheckNumForFolderEndPK3(const char *name, UINT16 wad, UINT16 startlump)
 // Returns lump position in PK3's lumpinfo, or INT16_MAX if not found.
 UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
 {
-	INT32 i;
-	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-	for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-	{
-		if (!strnicmp(name, lump_p->fullname, strlen(name)))
-		{
-			return i;
-		}
-	}
+	UINT16 i = W_LumpIndexFindPrefix(wadfiles[wad], name, startlump);
+
 	// Not found at all?
-	return INT16_MAX;
+	if (i == LUMPINDEXEMPTY)
+		return INT16_MAX;
+
+	return i;
 }
 
 //
@@ -1634,7 +2504,7 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 {
 	size_t lumpsize;
 	lumpinfo_t *l;
-	FILE *handle;
+	const wadfile_t *wadfile;
 
 	if (!TestValidLump(wad,lump))
 		return 0;
@@ -1649,10 +2519,9 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 		size = lumpsize - offset;
 
 	// Let's get the raw lump data.
-	// We setup the desired file handle to read the lump data.
+	// Nothing here touches the zone or the shared file position, so this is safe off the main thread.
 	l = wadfiles[wad]->lumpinfo + lump;
-	handle = wadfiles[wad]->handle;
-	fseek(handle, (long)(l->position + offset), SEEK_SET);
+	wadfile = wadfiles[wad];
 
 	// But let's not copy it yet. We support different compression formats on lumps, so we need to take that into account.
 	switch(wadfiles[wad]->lumpinfo[lump].compression)
@@ -1660,26 +2529,39 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 	case CM_NOCOMPRESSION:		// If it's uncompressed, we directly write the data into our destination, and return the bytes read.
 #ifdef NO_PNG_LUMPS
 		{
-			size_t bytesread = fread(dest, 1, size, handle);
+			size_t bytesread = W_ReadFileAt(wadfile, dest, size, l->position + offset);
 			if (Picture_IsLumpPNG((UINT8 *)dest, bytesread))
 				Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
 			return bytesread;
 		}
 #else
-		return fread(dest, 1, size, handle);
+		return W_ReadFileAt(wadfile, dest, size, l->position + offset);
 #endif
 	case CM_LZF:		// Is it LZF compressed? Used by ZWADs.
 		{
 #ifdef ZWAD
-			char *rawData; // The lump's raw data.
+			const char *rawData; // The lump's raw data.
+			char *rawCopy = NULL; // Our own copy of it, when the file isn't mapped.
 			char *decData; // Lump's decompressed real data.
 			size_t retval; // Helper var, lzf_decompress returns 0 when an error occurs.
+			srb2::ArenaScope arena; // Both copies are scratch, freed when we're done
 
-			rawData = static_cast<char*>(Z_Malloc(l->disksize, PU_STATIC, NULL));
-			decData = static_cast<char*>(Z_Malloc(l->size, PU_STATIC, NULL));
+			if (wadfile->mapping && l->position + l->disksize <= wadfile->filesize)
+				rawData = (const char *)(wadfile->mapping + l->position);
+			else
+			{
+				rawCopy = static_cast<char*>(Z_Arena_Alloc(l->disksize));
+				if (!rawCopy || W_ReadFileAt(wadfile, rawCopy, l->disksize, l->position) < l->disksize)
+					I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+				rawData = rawCopy;
+			}
+			decData = static_cast<char*>(Z_Arena_Alloc(l->size));
+
+			if (!decData) // Did we get no data at all?
+			{
+				return 0;
+			}
 
-			if (fread(rawData, 1, l->disksize, handle) < l->disksize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
 			retval = lzf_decompress(rawData, l->disksize, decData, l->size);
 #ifndef AVOID_ERRNO
 			if (retval == 0) // If this was returned, check if errno was set
@@ -1697,11 +2579,7 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 				I_Error("wad %d, lump %d: decompressed to wrong number of bytes (expected %s, got %s)", wad, lump, sizeu1(l->size), sizeu2(retval));
 			}
 
-			if (!decData) // Did we get no data at all?
-				return 0;
 			M_Memcpy(dest, decData + offset, size);
-			Z_Free(rawData);
-			Z_Free(decData);
 #ifdef NO_PNG_LUMPS
 			if (Picture_IsLumpPNG((UINT8 *)dest, size))
 				Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
@@ -1716,48 +2594,32 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 #ifdef HAVE_ZLIB
 	case CM_DEFLATE: // Is it compressed via DEFLATE? Very common in ZIPs/PK3s, also what most doom-related editors support.
 		{
-			UINT8 *rawData; // The lump's raw data.
-			UINT8 *decData; // Lump's decompressed real data.
-
 			int zErr; // Helper var.
-			z_stream strm;
-			unsigned long rawSize = l->disksize;
-			unsigned long decSize = size;
-
-			rawData = static_cast<UINT8*>(Z_Malloc(rawSize, PU_STATIC, NULL));
-			decData = static_cast<UINT8*>(dest);
 
-			if (fread(rawData, 1, rawSize, handle) < rawSize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
-
-			strm.zalloc = Z_NULL;
-			strm.zfree = Z_NULL;
-			strm.opaque = Z_NULL;
+			if (!W_ReadInflatedLump(wadfile, lump, dest, size, offset))
+			{
+				// Inflate up to the end of what was asked for, and skip the offset
+				srb2::ArenaScope arena;
+				UINT8 *decData = offset ? static_cast<UINT8*>(Z_Arena_Alloc(offset + size)) : static_cast<UINT8*>(dest);
 
-			strm.total_in = strm.avail_in = rawSize;
-			strm.total_out = strm.avail_out = decSize;
+				if (!decData)
+					I_Error("wad %d, lump %d: out of memory inflating", wad, lump);
 
-			strm.next_in = rawData;
-			strm.next_out = decData;
+				zErr = W_InflateLump(wadfile, l, decData, offset + size);
+				if (zErr == Z_ERRNO)
+					I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
 
-			zErr = inflateInit2(&strm, -15);
-			if (zErr == Z_OK)
-			{
-				zErr = inflate(&strm, Z_SYNC_FLUSH);
 				if (zErr != Z_OK && zErr != Z_STREAM_END)
 				{
 					size = 0;
 					zerr(zErr);
 				}
-				(void)inflateEnd(&strm);
-			}
-			else
-			{
-				size = 0;
-				zerr(zErr);
-			}
 
-			Z_Free(rawData);
+				if (offset)
+				{
+					M_Memcpy(dest, decData + offset, size);
+				}
+			}
 
 #ifdef NO_PNG_LUMPS
 			if (Picture_IsLumpPNG((UINT8 *)dest, size))
@@ -1794,6 +2656,39 @@ void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest)
 	W_ReadLumpHeaderPwad(wad, lump, dest, 0, 0);
 }
 
+// ==========================================================================
+// W_LumpView
+// ==========================================================================
+const void *W_LumpViewPwad(UINT16 wad, UINT16 lump)
+{
+	const wadfile_t *wadfile;
+	const lumpinfo_t *l;
+
+	if (!TestValidLump(wad, lump))
+		return NULL;
+
+	wadfile = wadfiles[wad];
+	l = &wadfile->lumpinfo[lump];
+
+	if (wadfile->mapping == NULL || l->compression != CM_NOCOMPRESSION || !l->size)
+		return NULL;
+
+	if (l->position + l->size > wadfile->filesize)
+		return NULL;
+
+#ifdef NO_PNG_LUMPS
+	if (Picture_IsLumpPNG(wadfile->mapping + l->position, l->size))
+		Picture_ThrowPNGError(l->fullname, wadfile->filename);
+#endif
+
+	return wadfile->mapping + l->position;
+}
+
+const void *W_LumpView(lumpnum_t lumpnum)
+{
+	return W_LumpViewPwad(WADFILENUM(lumpnum), LUMPNUM(lumpnum));
+}
+
 // ==========================================================================
 // W_CacheLumpNum
 // ==========================================================================
@@ -1974,13 +2869,23 @@ void *W_CacheSoftwarePatchNumPwad(UINT16 wad, UINT16 lump, INT32 tag)
 	if (!lumpcache[lump])
 	{
 		size_t len = W_LumpLengthPwad(wad, lump);
-		void *lumpdata = Z_Malloc(len, PU_STATIC, NULL);
+		const void *view = W_LumpViewPwad(wad, lump);
+
+		if (view)
+		{
+			// MakePatch only reads its input, so convert straight from the file
+			MakePatch(const_cast<void*>(view), len, tag, &lumpcache[lump]);
+		}
+		else
+		{
+			void *lumpdata = Z_Malloc(len, PU_STATIC, NULL);
 
-		// read the lump in full
-		W_ReadLumpHeaderPwad(wad, lump, lumpdata, 0, 0);
+			// read the lump in full
+			W_ReadLumpHeaderPwad(wad, lump, lumpdata, 0, 0);
 
-		MakePatch(lumpdata, len, tag, &lumpcache[lump]);
-		Z_Free(lumpdata);
+			MakePatch(lumpdata, len, tag, &lumpcache[lump]);
+			Z_Free(lumpdata);
+		}
 	}
 	else
 		Z_ChangeTag(lumpcache[lump], tag);
@@ -2449,7 +3354,9 @@ virtres_t* vres_GetMap(lumpnum_t lumpnum)
 		size_t *vsizecache;
 
 		// Remember that we're assuming that the WAD will have a specific set of lumps in a specific order.
-		UINT8 *wadData = static_cast<UINT8*>(W_CacheLumpNum(lumpnum, PU_LEVEL));
+		// A stored map WAD can be used in place; its lumps then point into the mapped file.
+		const UINT8 *wadView = static_cast<const UINT8*>(W_LumpView(lumpnum));
+		UINT8 *wadData = wadView ? const_cast<UINT8*>(wadView) : static_cast<UINT8*>(W_CacheLumpNum(lumpnum, PU_LEVEL));
 		filelump_t *fileinfo = (filelump_t *)(wadData + LONG(((wadinfo_t *)wadData)->infotableofs));
 
 		i = LONG(((wadinfo_t *)wadData)->numlumps);
@@ -2476,15 +3383,24 @@ virtres_t* vres_GetMap(lumpnum_t lumpnum)
 			// Play it safe with the name in this case.
 			memcpy(vlumps[i].name, (fileinfo + realentry)->name, 8);
 			vlumps[i].name[8] = '\0';
-			vlumps[i].data = static_cast<UINT8*>(
-				Z_Malloc(vlumps[i].size, PU_LEVEL, NULL) // This is memory inefficient, sorry about that.
-			);
-			memcpy(vlumps[i].data, wadData + LONG((fileinfo + realentry)->filepos), vlumps[i].size);
+			vlumps[i].view = (wadView != NULL);
+			if (vlumps[i].view)
+			{
+				vlumps[i].data = wadData + LONG((fileinfo + realentry)->filepos);
+			}
+			else
+			{
+				vlumps[i].data = static_cast<UINT8*>(
+					Z_Malloc(vlumps[i].size, PU_LEVEL, NULL) // This is memory inefficient, sorry about that.
+				);
+				memcpy(vlumps[i].data, wadData + LONG((fileinfo + realentry)->filepos), vlumps[i].size);
+			}
 			i++;
 		}
 
 		Z_Free(vsizecache);
-		Z_Free(wadData);
+		if (!wadView)
+			Z_Free(wadData);
 	}
 	else
 	{
@@ -2505,7 +3421,10 @@ virtres_t* vres_GetMap(lumpnum_t lumpnum)
 			vlumps[i].size = W_LumpLength(lumpnum);
 			memcpy(vlumps[i].name, W_CheckNameForNum(lumpnum), 8);
 			vlumps[i].name[8] = '\0';
-			vlumps[i].data = static_cast<UINT8*>(W_CacheLumpNum(lumpnum, PU_LEVEL));
+			vlumps[i].data = static_cast<UINT8*>(const_cast<void*>(W_LumpView(lumpnum)));
+			vlumps[i].view = (vlumps[i].data != NULL);
+			if (!vlumps[i].view)
+				vlumps[i].data = static_cast<UINT8*>(W_CacheLumpNum(lumpnum, PU_LEVEL));
 		}
 	}
 	vres = static_cast<virtres_t*>(Z_Malloc(sizeof(virtres_t), PU_LEVEL, NULL));
@@ -2529,7 +3448,7 @@ void vres_Free(virtres_t* vres)
 
 	while (vres->numlumps--)
 	{
-		if (vres->vlumps[vres->numlumps].data)
+		if (vres->vlumps[vres->numlumps].data && !vres->vlumps[vres->numlumps].view)
 		{
 			Z_Free(vres->vlumps[vres->numlumps].data);
 		}
@@ -2591,3 +3510,130 @@ void *vres_GetPatch(virtlump_t *vlump, INT32 tag)
 	return (void *)patch;
 #endif
 }
+
+// Reference versions of the indexed searches, for lumpindex_bench to check and time against
+static UINT16 W_ScanNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump, boolean longname)
+{
+	UINT32 hash = quickncasehash(name, 8);
+	UINT16 i;
+
+	for (i = startlump; i < wadfiles[wad]->numlumps; i++)
+	{
+		const lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + i;
+		if (lump_p->hash == hash && W_LumpIndexNameMatch(lump_p, name, longname))
+			return i;
+	}
+	return INT16_MAX;
+}
+
+static UINT16 W_ScanNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
+{
+	size_t name_length = strlen(name);
+	UINT16 i;
+
+	for (i = startlump; i < wadfiles[wad]->numlumps; i++)
+	{
+		if (!strnicmp(name, wadfiles[wad]->lumpinfo[i].fullname, name_length))
+			return i;
+	}
+	return INT16_MAX;
+}
+
+void Command_LumpIndexBench_f(void)
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Query
+	{
+		UINT16 wad;
+		UINT16 startlump;
+		const char *name;
+		const char *longname;
+		const char *fullname;
+	};
+
+	size_t passes = COM_Argc() > 1 ? std::max(1, atoi(COM_Argv(1))) : 4;
+	std::vector<Query> queries;
+	size_t mismatches = 0;
+	UINT16 w;
+
+	// Look up every lump in every file, both from the top and from just past itself
+	for (w = 0; w < numwadfiles; w++)
+	{
+		UINT16 i;
+		for (i = 0; i < wadfiles[w]->numlumps; i++)
+		{
+			const lumpinfo_t *lump_p = &wadfiles[w]->lumpinfo[i];
+			queries.push_back({w, 0, lump_p->name, lump_p->longname, lump_p->fullname});
+			queries.push_back({w, static_cast<UINT16>(i + 1), lump_p->name, lump_p->longname, lump_p->fullname});
+		}
+		queries.push_back({w, 0, "NOTALUMP", "NOTALUMPATALL", "notafolder/notalump"});
+	}
+
+	if (queries.empty())
+	{
+		return;
+	}
+
+	// Rebuild the indices from scratch to time construction on its own
+	Clock::duration build {};
+	for (size_t p = 0; p < passes; p++)
+	{
+		for (w = 0; w < numwadfiles; w++)
+		{
+			auto start = Clock::now();
+			lumpindex_t *index = W_BuildLumpIndex(wadfiles[w]->lumpinfo, wadfiles[w]->numlumps);
+			build += Clock::now() - start;
+			W_FreeLumpIndex(index);
+		}
+	}
+
+	auto run = [&](bool indexed) -> Clock::duration
+	{
+		volatile UINT32 sink = 0;
+		auto start = Clock::now();
+		for (size_t p = 0; p < passes; p++)
+		{
+			for (const Query& q : queries)
+			{
+				if (indexed)
+				{
+					sink = sink + W_CheckNumForNamePwad(q.name, q.wad, q.startlump);
+					sink = sink + W_CheckNumForLongNamePwad(q.longname, q.wad, q.startlump);
+					sink = sink + W_CheckNumForFullNamePK3(q.fullname, q.wad, q.startlump);
+				}
+				else
+				{
+					sink = sink + W_ScanNumForNamePwad(q.name, q.wad, q.startlump, false);
+					sink = sink + W_ScanNumForNamePwad(q.longname, q.wad, q.startlump, true);
+					sink = sink + W_ScanNumForFullNamePK3(q.fullname, q.wad, q.startlump);
+				}
+			}
+		}
+		return Clock::now() - start;
+	};
+
+	for (const Query& q : queries)
+	{
+		if (W_CheckNumForNamePwad(q.name, q.wad, q.startlump) != W_ScanNumForNamePwad(q.name, q.wad, q.startlump, false)
+			|| W_CheckNumForLongNamePwad(q.longname, q.wad, q.startlump) != W_ScanNumForNamePwad(q.longname, q.wad, q.startlump, true)
+			|| W_CheckNumForFullNamePK3(q.fullname, q.wad, q.startlump) != W_ScanNumForFullNamePK3(q.fullname, q.wad, q.startlump))
+		{
+			if (mismatches++ < 8)
+				CONS_Printf("  mismatch: %s/%s/%s in file %d from lump %d\n", q.name, q.longname, q.fullname, q.wad, q.startlump);
+		}
+	}
+
+	Clock::duration scanned = run(false);
+	Clock::duration indexed = run(true);
+
+	auto to_us = [](Clock::duration d) { return static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(d).count()); };
+	auto to_ns = [](Clock::duration d) { return static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()); };
+	const size_t lookups = passes * queries.size() * 3;
+
+	CONS_Printf("lumpindex_bench: %d files, %s queries, %s passes\n", numwadfiles, sizeu1(queries.size()), sizeu2(passes));
+	CONS_Printf("  index build: %lld us at startup, %lld us/pass rebuilt\n", to_us(lumpindexbuildtime), to_us(build) / static_cast<long long>(passes));
+	CONS_Printf("  linear scan: %lld ns/lookup\n", to_ns(scanned) / static_cast<long long>(lookups));
+	CONS_Printf("  indexed:     %lld ns/lookup\n", to_ns(indexed) / static_cast<long long>(lookups));
+	CONS_Printf("  %s mismatches\n", sizeu1(mismatches));
+}
@@ -83,6 +83,7 @@ struct virtlump_t {
 	char name[9];
 	UINT8* data;
 	size_t size;
+	boolean view; // data points into a file mapping, so treat it as read-only and don't free it
 };
 
 struct virtres_t {
@@ -124,6 +125,10 @@ struct wadfile_t
 	lumpinfo_t *lumpinfo;
 	lumpcache_t *lumpcache;
 	lumpcache_t *patchcache;
+	const UINT8 *mapping; // the whole file, read-only; NULL if it couldn't be mapped
+	void *mappinghandle; // platform mapping object, if any
+	struct lumpindex_t *lumpindex; // name lookup tables, see W_CheckNumForNamePwad
+	struct lumpprefetch_t *prefetch; // background inflating, NULL if nothing is compressed
 	UINT16 numlumps; // this wad's number of resources
 	FILE *handle;
 	UINT32 filesize; // for network
@@ -170,6 +175,10 @@ UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump);
 UINT16 W_CheckNumForFolderStartPK3(const char *name, UINT16 wad, UINT16 startlump);
 UINT16 W_CheckNumForFolderEndPK3(const char *name, UINT16 wad, UINT16 startlump);
 
+/// Debug command: lumpindex_bench [passes]
+/// Times the lump name index against a plain scan of every loaded file, and checks they agree.
+void Command_LumpIndexBench_f(void);
+
 lumpnum_t W_CheckNumForMap(const char *name, boolean checktofirst);
 lumpnum_t W_CheckNumForName(const char *name);
 lumpnum_t W_CheckNumForLongName(const char *name);
@@ -198,6 +207,21 @@ void *W_CacheLumpNumPwad(UINT16 wad, UINT16 lump, INT32 tag);
 void *W_CacheLumpNum(lumpnum_t lump, INT32 tag);
 void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag);
 
+// Read-only pointer straight into the mapped file for a stored (uncompressed) lump,
+// or NULL if the lump is compressed, empty, or its file couldn't be mapped.
+// Valid until the file is closed. Never write through it or Z_Free it.
+const void *W_LumpViewPwad(UINT16 wad, UINT16 lump);
+const void *W_LumpView(lumpnum_t lumpnum);
+
+// Queue a compressed lump to be inflated on the thread pool, ahead of it being cached.
+// Call W_StartPrefetch after queueing a batch. Main thread only.
+void W_PrefetchLumpNum(lumpnum_t lumpnum);
+void W_StartPrefetch(void);
+
+// Throw away every prefetched lump nobody has read yet, and the ones still waiting
+// in the queue, so they stop counting against the budget. Call on level change.
+void W_DropPrefetchedLumps(void);
+
 boolean W_IsLumpCached(lumpnum_t lump, void *ptr);
 boolean W_IsPatchCached(lumpnum_t lump, void *ptr);
 